@@ -2,8 +2,8 @@
 # Copyright 2010-2012 RethinkDB, all rights reserved.
 import sys
 
-"""This script is used to generate the RDB_MAKE_SEMILATTICE_JOINABLE_*() macro
-definitions.
+"""This script is used to generate the RDB_MAKE_SEMILATTICE_JOINABLE_*() and
+RDB_MAKE_SEMILATTICE_DELTA_*() macro definitions.
 
 This script is meant to be run as follows (assuming you are in the
 "rethinkdb/src" directory):
@@ -23,6 +23,17 @@ def generate_make_semilattice_joinable_macro(nfields):
     # Putting this here makes us require a semicolon after macro invocation.
     print "    extern int semilattice_joinable_force_semicolon_declaration"
 
+def generate_make_semilattice_delta_macro(nfields):
+    print "#define RDB_MAKE_SEMILATTICE_DELTA_%d(type_t%s) \\" % \
+        (nfields, "".join(", field%d" % (i+1) for i in xrange(nfields)))
+    unused = "UNUSED " if nfields == 0 else ""
+    print "    inline void semilattice_delta(%sconst type_t &_old_, %sconst type_t &_new_, %stype_t *_delta_) { \\" % (unused, unused, unused)
+    for i in xrange(nfields):
+        print "        semilattice_delta(_old_.field%d, _new_.field%d, &_delta_->field%d); \\" % (i + 1, i + 1, i + 1)
+    print "    } \\"
+    # Putting this here makes us require a semicolon after macro invocation.
+    print "    extern int semilattice_joinable_force_semicolon_declaration"
+
 def generate_make_equality_comparable_macro(nfields):
     print "#define RDB_MAKE_EQUALITY_COMPARABLE_%d(type_t%s) \\" % \
         (nfields, "".join(", field%d" % (i+1) for i in xrange(nfields)))
@@ -43,6 +54,9 @@ if __name__ == "__main__":
     print "#define RPC_SEMILATTICE_JOINS_MACROS_HPP_"
     print
 
+    print "#include \"rpc/semilattice/joins/delta.hpp\""
+    print
+
     print "/* This file is automatically generated by '%s'." % " ".join(sys.argv)
     print "Please modify '%s' instead of modifying this file.*/" % sys.argv[0]
     print
@@ -68,12 +82,16 @@ You can also use this with templated types, but it's pretty hacky:
     };
     template<class T>
     RDB_MAKE_SEMILATTICE_JOINABLE_2(pair_t<T>, a, b)
+
+`RDB_MAKE_SEMILATTICE_DELTA_[n]()` takes the same parameters and defines
+`semilattice_delta()` (see "rpc/semilattice/joins/delta.hpp") field by field.
 */
     """.strip()
     print
 
     for nfields in xrange(0, 20):
         generate_make_semilattice_joinable_macro(nfields)
+        generate_make_semilattice_delta_macro(nfields)
         generate_make_equality_comparable_macro(nfields)
         print
 
@@ -3,6 +3,9 @@
 
 #include <string.h>
 
+#include "arch/runtime/runtime_stats.hpp"
+#include "perfmon/perfmon.hpp"
+
 __thread int thread_is_blocker_pool_thread = 0;
 
 // IO thread function
@@ -47,7 +50,9 @@ void* blocker_pool_t::event_loop(void *arg) {
             or_lock.unlock();
 
             // Perform the request. It may block. This is the raison d'etre for blocker_pool_t.
+            request->started_time = get_ticks();
             request->run();
+            request->finished_time = get_ticks();
 
             // Notify that the request is done
             {
@@ -104,6 +109,8 @@ blocker_pool_t::~blocker_pool_t() {
 }
 
 void blocker_pool_t::do_job(job_t *job) {
+    ++pm_blocker_pool_outstanding_jobs;
+    job->enqueued_time = get_ticks();
 
     system_mutex_t::lock_t or_lock(&or_mutex);
     outstanding_requests.push_back(job);
@@ -123,7 +130,11 @@ void blocker_pool_t::on_event(DEBUG_VAR int event) {
     }
 
     for (size_t i = 0; i < local_completed_events.size(); ++i) {
-        local_completed_events[i]->done();
+        job_t *job = local_completed_events[i];
+        --pm_blocker_pool_outstanding_jobs;
+        pm_blocker_pool_queue_time.record(ticks_to_secs(job->started_time - job->enqueued_time));
+        pm_blocker_pool_run_time.record(ticks_to_secs(job->finished_time - job->started_time));
+        job->done();
     }
 }
 
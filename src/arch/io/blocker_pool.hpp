@@ -17,6 +17,8 @@ struct blocker_pool_t :
     ~blocker_pool_t();
 
     struct job_t {
+        job_t() : enqueued_time(0), started_time(0), finished_time(0) { }
+
         /* run() will not be run within the main thread pool. It may call blocking system calls and
         the like without disrupting performance of the main server thread pool. */
         virtual void run() = 0;
@@ -26,6 +28,12 @@ struct blocker_pool_t :
 
     protected:
         virtual ~job_t() {}
+
+    private:
+        friend struct blocker_pool_t;
+
+        // Set by the pool, so that it can report how long jobs queue and run for
+        ticks_t enqueued_time, started_time, finished_time;
     };
     void do_job(job_t *job);
 
@@ -70,8 +70,8 @@ public:
         rassert(outstanding_txn == 0, "Closing a file with outstanding txns\n");
     }
 
-    void *create_account(int pri, int outstanding_requests_limit) {
-        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit);
+    void *create_account(int pri, int outstanding_requests_limit, io_account_stats_t *stats) {
+        return new accounting_diskmgr_t::account_t(&accounter, pri, outstanding_requests_limit, stats);
     }
 
     void delayed_destroy(void *_account) {
@@ -262,8 +262,8 @@ bool linux_file_t::coop_lock_and_check() {
     return true;
 }
 
-void *linux_file_t::create_account(int priority, int outstanding_requests_limit) {
-    return diskmgr->create_account(priority, outstanding_requests_limit);
+void *linux_file_t::create_account(int priority, int outstanding_requests_limit, io_account_stats_t *stats) {
+    return diskmgr->create_account(priority, outstanding_requests_limit, stats);
 }
 
 void linux_file_t::destroy_account(void *account) {
@@ -80,7 +80,7 @@ public:
 
     bool coop_lock_and_check();
 
-    void *create_account(int priority, int outstanding_requests_limit);
+    void *create_account(int priority, int outstanding_requests_limit, io_account_stats_t *stats);
     void destroy_account(void *account);
 
     ~linux_file_t();
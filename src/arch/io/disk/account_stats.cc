@@ -0,0 +1,57 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "arch/io/disk/account_stats.hpp"
+
+io_account_stats_t::io_account_stats_t(perfmon_collection_t *parent, const std::string &name,
+                                       io_account_stats_t *_totals)
+    : collection(),
+      collection_membership(parent, &collection, name),
+      queued(),
+      in_flight(),
+      reads(),
+      writes(),
+      read_bytes(),
+      written_bytes(),
+      queue_time(secs_to_ticks(1), false, 1e-6),
+      device_time(secs_to_ticks(1), false, 1e-6),
+      stats_membership(&collection,
+          &queued, "queued",
+          &in_flight, "in_flight",
+          &reads, "reads",
+          &writes, "writes",
+          &read_bytes, "read_bytes",
+          &written_bytes, "written_bytes",
+          &queue_time, "queue_time",
+          &device_time, "device_time",
+          NULLPTR),
+      totals(_totals) { }
+
+void io_account_stats_t::on_queued() {
+    ++queued;
+    if (totals != NULL) {
+        totals->on_queued();
+    }
+}
+
+void io_account_stats_t::on_dispatched(ticks_t wait) {
+    --queued;
+    ++in_flight;
+    queue_time.record(ticks_to_secs(wait));
+    if (totals != NULL) {
+        totals->on_dispatched(wait);
+    }
+}
+
+void io_account_stats_t::on_done(bool is_read, size_t bytes, ticks_t device) {
+    --in_flight;
+    if (is_read) {
+        ++reads;
+        read_bytes += bytes;
+    } else {
+        ++writes;
+        written_bytes += bytes;
+    }
+    device_time.record(ticks_to_secs(device));
+    if (totals != NULL) {
+        totals->on_done(is_read, bytes, device);
+    }
+}
@@ -0,0 +1,43 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef ARCH_IO_DISK_ACCOUNT_STATS_HPP_
+#define ARCH_IO_DISK_ACCOUNT_STATS_HPP_
+
+#include <string>
+
+#include "perfmon/perfmon.hpp"
+
+/* `io_account_stats_t` keeps the stats of the disk operations done through one
+or more `file_account_t`s: how long they waited in their account's queue for
+`accounting_diskmgr_t` to let them through, how long the disk then took, how many
+there were and how many bytes they moved, and how many are queued or in flight
+right now. The times are in seconds.
+
+If `totals` isn't `NULL`, everything is recorded there too, so that a file can
+have stats for each of its accounts and for all of them together. The stats are
+recorded on the disk manager's thread; they must outlive the accounts that use
+them. */
+
+class io_account_stats_t {
+public:
+    io_account_stats_t(perfmon_collection_t *parent, const std::string &name,
+                       io_account_stats_t *totals = NULL);
+
+    void on_queued();
+    void on_dispatched(ticks_t queue_time);
+    void on_done(bool is_read, size_t bytes, ticks_t device_time);
+
+private:
+    perfmon_collection_t collection;
+    perfmon_membership_t collection_membership;
+
+    perfmon_counter_t queued, in_flight;
+    perfmon_counter_t reads, writes, read_bytes, written_bytes;
+    perfmon_histogram_t queue_time, device_time;
+    perfmon_multi_membership_t stats_membership;
+
+    io_account_stats_t *const totals;
+
+    DISABLE_COPYING(io_account_stats_t);
+};
+
+#endif /* ARCH_IO_DISK_ACCOUNT_STATS_HPP_ */
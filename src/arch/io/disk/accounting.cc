@@ -1,5 +1,7 @@
 #include "arch/io/disk/accounting.hpp"
 
+#include "arch/io/disk/account_stats.hpp"
+
 /* Each account on the `accounting_diskmgr_t` has its own
    `unlimited_fifo_queue_t` associated with it. Operations for that account
    queue up on that queue while they wait for the `accounting_queue_t` on the
@@ -47,8 +49,9 @@ private:
 
 accounting_diskmgr_account_t::accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                                            int _pri,
-                                                           int _outstanding_requests_limit)
-        : par(_par), pri(_pri),
+                                                           int _outstanding_requests_limit,
+                                                           io_account_stats_t *_stats)
+        : stats(_stats), par(_par), pri(_pri),
           outstanding_requests_limit(_outstanding_requests_limit) { }
 
 accounting_diskmgr_account_t::~accounting_diskmgr_account_t() {
@@ -94,12 +97,29 @@ accounting_diskmgr_t::~accounting_diskmgr_t() {
 }
 
 void accounting_diskmgr_t::submit(action_t *a) {
+    if (a->account->stats != NULL) {
+        a->queued_time = get_ticks();
+        a->account->stats->on_queued();
+    }
     a->account->push(a);
 }
 
+accounting_payload_t *accounting_diskmgr_t::dispatcher_t::produce_next_value() {
+    action_t *a = source->pop();
+    if (a->account->stats != NULL) {
+        a->dispatched_time = get_ticks();
+        a->account->stats->on_dispatched(a->dispatched_time - a->queued_time);
+    }
+    return a;
+}
+
 void accounting_diskmgr_t::done(accounting_payload_t *p) {
     // p really is an action_t...
     action_t *a = static_cast<action_t *>(p);
+    if (a->account->stats != NULL) {
+        a->account->stats->on_done(a->get_is_read(), a->get_count(),
+                                   get_ticks() - a->dispatched_time);
+    }
     a->account->get_outstanding_requests_limiter()->unlock(1);
     done_fun(static_cast<action_t *>(p));
 }
@@ -14,26 +14,12 @@
 #include "arch/io/disk.hpp"
 #include "arch/io/disk/stats.hpp"
 
-/* `casting_passive_producer_t` is useful when you have a
-`passive_producer_t<X>` but you need a `passive_producer_t<Y>`, where `X` can
-be cast to `Y`. */
-
-template <class input_t, class output_t>
-struct casting_passive_producer_t : public passive_producer_t<output_t> {
-    explicit casting_passive_producer_t(passive_producer_t<input_t> *_source) :
-        passive_producer_t<output_t>(_source->available), source(_source) { }
-
-    output_t produce_next_value() {
-        /* Implicit cast from `input_t` to `output_t` in return */
-        return source->pop();
-    }
-
-private:
-    passive_producer_t<input_t> *source;
-};
+class io_account_stats_t;
 
 /* `accounting_diskmgr_t` shares disk throughput proportionally between a
-number of different "accounts". */
+number of different "accounts". An account may have an `io_account_stats_t`,
+which then gets told when its operations are queued, when they leave the queue
+for the disk, and when they are done. */
 
 typedef stats_diskmgr_2_t::action_t accounting_payload_t;
 
@@ -48,7 +34,8 @@ struct accounting_diskmgr_account_t {
 
     accounting_diskmgr_account_t(accounting_diskmgr_t *_par,
                                  int _pri,
-                                 int _outstanding_requests_limit);
+                                 int _outstanding_requests_limit,
+                                 io_account_stats_t *_stats);
 
     ~accounting_diskmgr_account_t();
 
@@ -56,6 +43,9 @@ struct accounting_diskmgr_account_t {
     void on_semaphore_available();
     semaphore_t *get_outstanding_requests_limiter();
 
+    // May be `NULL`
+    io_account_stats_t *const stats;
+
 private:
     typedef accounting_diskmgr_eager_account_t eager_account_t;
 
@@ -73,6 +63,10 @@ struct accounting_diskmgr_action_t
     : public intrusive_list_node_t<accounting_diskmgr_action_t>,
       public accounting_payload_t {
     accounting_diskmgr_account_t *account;
+
+    // When the action was queued on its account and when it left the queue,
+    // if the account has stats
+    ticks_t queued_time, dispatched_time;
 };
 
 void debug_print(printf_buffer_t *buf,
@@ -81,9 +75,9 @@ void debug_print(printf_buffer_t *buf,
 class accounting_diskmgr_t : public home_thread_mixin_t {
 public:
     explicit accounting_diskmgr_t(int batch_factor)
-        : producer(&caster),
+        : producer(&dispatcher),
           queue(batch_factor),
-          caster(&queue),
+          dispatcher(&queue),
           auto_drainer(new auto_drainer_t()) { }
 
     ~accounting_diskmgr_t();
@@ -106,8 +100,22 @@ public:
 private:
     friend struct accounting_diskmgr_eager_account_t;
 
+    /* Hands the actions that the accounting queue picks to the layer below,
+    noting in their accounts' stats that they are no longer queued. */
+    class dispatcher_t : public passive_producer_t<accounting_payload_t *> {
+    public:
+        explicit dispatcher_t(passive_producer_t<action_t *> *_source)
+            : passive_producer_t<accounting_payload_t *>(_source->available),
+              source(_source) { }
+
+    private:
+        accounting_payload_t *produce_next_value();
+
+        passive_producer_t<action_t *> *source;
+    };
+
     accounting_queue_t<action_t *> queue;
-    casting_passive_producer_t<action_t *, accounting_payload_t *> caster;
+    dispatcher_t dispatcher;
     scoped_ptr_t<auto_drainer_t> auto_drainer;
 
     DISABLE_COPYING(accounting_diskmgr_t);
@@ -20,11 +20,17 @@
 #include "arch/timing.hpp"
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/printf_buffer.hpp"
 #include "logger.hpp"
 #include "perfmon/perfmon.hpp"
 
+// Older C library headers don't define this even when the kernel supports it.
+#ifndef SO_REUSEPORT
+#define SO_REUSEPORT 15
+#endif
+
 /* Network connection object */
 
 linux_tcp_conn_t::linux_tcp_conn_t(const ip_address_t &host, int port, signal_t *interruptor, int local_port) THROWS_ONLY(connect_failed_exc_t, interrupted_exc_t) :
@@ -577,10 +583,12 @@ void linux_tcp_conn_descriptor_t::make_overcomplicated(linux_tcp_conn_t **tcp_co
 
 linux_nonthrowing_tcp_listener_t::linux_nonthrowing_tcp_listener_t(
         const std::set<ip_address_t> &bind_addresses, int _port,
-        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &cb) :
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &cb,
+        bool _reuse_port) :
     callback(cb),
     local_addresses(bind_addresses),
     port(_port),
+    reuse_port(_reuse_port),
     bound(false),
     socks(std::max<size_t>(bind_addresses.size(), 1)), // Without a bind address, we still want a socket
     last_used_socket_index(0),
@@ -644,6 +652,11 @@ void linux_nonthrowing_tcp_listener_t::init_sockets() {
         int res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEADDR, &sockoptval, sizeof(sockoptval));
         guarantee_err(res != -1, "Could not set REUSEADDR option");
 
+        if (reuse_port) {
+            res = setsockopt(sock_fd, SOL_SOCKET, SO_REUSEPORT, &sockoptval, sizeof(sockoptval));
+            guarantee_err(res != -1, "Could not set REUSEPORT option (it needs Linux 3.9 or later)");
+        }
+
         /* XXX Making our socket NODELAY prevents the problem where responses to
          * pipelined requests are delayed, since the TCP Nagle algorithm will
          * notice when we send multiple small packets and try to coalesce them. But
@@ -813,6 +826,72 @@ void linux_nonthrowing_tcp_listener_t::on_event(int) {
     via event_listener.watch(). */
 }
 
+linux_nonthrowing_per_thread_tcp_listener_t::linux_nonthrowing_per_thread_tcp_listener_t(
+        const std::set<ip_address_t> &bind_addresses, int _port,
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &_callback) :
+    local_addresses(bind_addresses),
+    requested_port(_port),
+    port(_port),
+    callback(_callback),
+    listeners(get_num_db_threads()),
+    listening(false)
+{ }
+
+linux_nonthrowing_per_thread_tcp_listener_t::~linux_nonthrowing_per_thread_tcp_listener_t() {
+    destroy_listeners();
+}
+
+bool linux_nonthrowing_per_thread_tcp_listener_t::begin_listening() {
+    rassert(!listening);
+
+    // Bind one thread at a time, so that if we were asked for any port, the
+    // first listener picks it and the others bind to the same one.
+    for (ssize_t thread = 0; thread < listeners.size(); ++thread) {
+        bool bound;
+        create_and_bind(thread, &bound);
+        if (!bound) {
+            destroy_listeners();
+            port = requested_port;
+            return false;
+        }
+    }
+
+    pmap(listeners.size(), boost::bind(&linux_nonthrowing_per_thread_tcp_listener_t::start_accepting,
+                                       this, _1));
+    listening = true;
+    return true;
+}
+
+int linux_nonthrowing_per_thread_tcp_listener_t::get_port() const {
+    return port;
+}
+
+void linux_nonthrowing_per_thread_tcp_listener_t::create_and_bind(int thread, bool *bound_out) {
+    on_thread_t th(thread);
+    listeners[thread].init(new linux_nonthrowing_tcp_listener_t(local_addresses, port, callback, true));
+    *bound_out = listeners[thread]->bind_sockets();
+    if (*bound_out) {
+        port = listeners[thread]->get_port();
+    }
+}
+
+void linux_nonthrowing_per_thread_tcp_listener_t::start_accepting(int thread) {
+    on_thread_t th(thread);
+    // The sockets are already bound, so this can't fail.
+    guarantee(listeners[thread]->begin_listening());
+}
+
+void linux_nonthrowing_per_thread_tcp_listener_t::destroy(int thread) {
+    on_thread_t th(thread);
+    listeners[thread].reset();
+}
+
+void linux_nonthrowing_per_thread_tcp_listener_t::destroy_listeners() {
+    pmap(listeners.size(), boost::bind(&linux_nonthrowing_per_thread_tcp_listener_t::destroy,
+                                       this, _1));
+    listening = false;
+}
+
 void noop_fun(UNUSED const scoped_ptr_t<linux_tcp_conn_descriptor_t>& arg) { }
 
 linux_tcp_bound_socket_t::linux_tcp_bound_socket_t(const std::set<ip_address_t> &bind_addresses, int port) :
@@ -828,11 +907,18 @@ int linux_tcp_bound_socket_t::get_port() const {
 }
 
 linux_tcp_listener_t::linux_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
-    const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback) :
-        listener(new linux_nonthrowing_tcp_listener_t(bind_addresses, port, callback))
-{
-    if (!listener->begin_listening()) {
-        throw address_in_use_exc_t("localhost", listener->get_port());
+    const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback,
+    tcp_accept_mode_t accept_mode) {
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        per_thread_listener.init(new linux_nonthrowing_per_thread_tcp_listener_t(bind_addresses, port, callback));
+        if (!per_thread_listener->begin_listening()) {
+            throw address_in_use_exc_t("localhost", per_thread_listener->get_port());
+        }
+    } else {
+        listener.init(new linux_nonthrowing_tcp_listener_t(bind_addresses, port, callback));
+        if (!listener->begin_listening()) {
+            throw address_in_use_exc_t("localhost", listener->get_port());
+        }
     }
 }
 
@@ -848,18 +934,27 @@ linux_tcp_listener_t::linux_tcp_listener_t(
 }
 
 int linux_tcp_listener_t::get_port() const {
-    return listener->get_port();
+    return per_thread_listener.has() ? per_thread_listener->get_port() : listener->get_port();
 }
 
 linux_repeated_nonthrowing_tcp_listener_t::linux_repeated_nonthrowing_tcp_listener_t(
     const std::set<ip_address_t> &bind_addresses,
     int port,
-    const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback) :
-        listener(bind_addresses, port, callback)
-{ }
+    const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback,
+    tcp_accept_mode_t accept_mode) {
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        per_thread_listener.init(new linux_nonthrowing_per_thread_tcp_listener_t(bind_addresses, port, callback));
+    } else {
+        listener.init(new linux_nonthrowing_tcp_listener_t(bind_addresses, port, callback));
+    }
+}
 
 int linux_repeated_nonthrowing_tcp_listener_t::get_port() const {
-    return listener.get_port();
+    return per_thread_listener.has() ? per_thread_listener->get_port() : listener->get_port();
+}
+
+bool linux_repeated_nonthrowing_tcp_listener_t::begin_listening() {
+    return per_thread_listener.has() ? per_thread_listener->begin_listening() : listener->begin_listening();
 }
 
 void linux_repeated_nonthrowing_tcp_listener_t::begin_repeated_listening_attempts() {
@@ -870,16 +965,16 @@ void linux_repeated_nonthrowing_tcp_listener_t::begin_repeated_listening_attempt
 
 void linux_repeated_nonthrowing_tcp_listener_t::retry_loop(auto_drainer_t::lock_t lock) {
     try {
-        bool bound = listener.begin_listening();
+        bool bound = begin_listening();
 
         for (int retry_interval = 1;
              !bound;
              retry_interval = std::min(10, retry_interval + 2)) {
             logINF("Will retry binding to port %d in %d seconds.\n",
-                    listener.get_port(),
+                    get_port(),
                     retry_interval);
             nap(retry_interval * 1000, lock.get_drain_signal());
-            bound = listener.begin_listening();
+            bound = begin_listening();
         }
 
         bound_cond.pulse();
@@ -331,8 +331,12 @@ the provided callback will be called in a new coroutine every time something con
 
 class linux_nonthrowing_tcp_listener_t : private linux_event_callback_t {
 public:
+    /* If `reuse_port` is true, the sockets are bound with `SO_REUSEPORT`, so that
+    several listeners can share the port and the kernel spreads incoming
+    connections over them. */
     linux_nonthrowing_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int _port,
-        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback);
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback,
+        bool reuse_port = false);
 
     ~linux_nonthrowing_tcp_listener_t();
 
@@ -343,6 +347,7 @@ public:
 protected:
     friend class linux_tcp_listener_t;
     friend class linux_tcp_bound_socket_t;
+    friend class linux_nonthrowing_per_thread_tcp_listener_t;
 
     MUST_USE bool bind_sockets();
 
@@ -372,6 +377,9 @@ private:
     // The port we're asked to bind to
     int port;
 
+    // Whether to bind with SO_REUSEPORT
+    bool reuse_port;
+
     // Inidicates successful binding to a port
     bool bound;
 
@@ -387,6 +395,39 @@ private:
     bool log_next_error;
 };
 
+/* `linux_nonthrowing_per_thread_tcp_listener_t` listens on the same port from
+every DB thread, with one `SO_REUSEPORT` listener per thread, so that accepting
+connections is spread over all the threads instead of being done by one. Each
+connection is handed to the callback on the thread that accepted it, so the
+callback must be safe to call on any thread. Requires Linux 3.9 or later. */
+class linux_nonthrowing_per_thread_tcp_listener_t {
+public:
+    linux_nonthrowing_per_thread_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int _port,
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &_callback);
+
+    ~linux_nonthrowing_per_thread_tcp_listener_t();
+
+    MUST_USE bool begin_listening();
+    int get_port() const;
+
+private:
+    void create_and_bind(int thread, bool *bound_out);
+    void start_accepting(int thread);
+    void destroy(int thread);
+    void destroy_listeners();
+
+    std::set<ip_address_t> local_addresses;
+    int requested_port;
+    int port;
+    boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> callback;
+
+    // One listener per DB thread, each created and destroyed on its own thread
+    scoped_array_t<scoped_ptr_t<linux_nonthrowing_tcp_listener_t> > listeners;
+    bool listening;
+
+    DISABLE_COPYING(linux_nonthrowing_per_thread_tcp_listener_t);
+};
+
 /* Used by the old style tcp listener */
 class linux_tcp_bound_socket_t {
 public:
@@ -404,19 +445,23 @@ public:
     linux_tcp_listener_t(linux_tcp_bound_socket_t *bound_socket,
         const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback);
     linux_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
-        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback);
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback,
+        tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD);
 
     int get_port() const;
 
 private:
+    // Exactly one of these is set, depending on the accept mode
     scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
+    scoped_ptr_t<linux_nonthrowing_per_thread_tcp_listener_t> per_thread_listener;
 };
 
 /* Like a linux tcp listener but repeatedly tries to bind to its port until successful */
 class linux_repeated_nonthrowing_tcp_listener_t {
 public:
     linux_repeated_nonthrowing_tcp_listener_t(const std::set<ip_address_t> &bind_addresses, int port,
-        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback);
+        const boost::function<void(scoped_ptr_t<linux_tcp_conn_descriptor_t>&)> &callback,
+        tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD);
     void begin_repeated_listening_attempts();
 
     signal_t *get_bound_signal();
@@ -424,8 +469,11 @@ public:
 
 private:
     void retry_loop(auto_drainer_t::lock_t lock);
+    bool begin_listening();
 
-    linux_nonthrowing_tcp_listener_t listener;
+    // Exactly one of these is set, depending on the accept mode
+    scoped_ptr_t<linux_nonthrowing_tcp_listener_t> listener;
+    scoped_ptr_t<linux_nonthrowing_per_thread_tcp_listener_t> per_thread_listener;
     cond_t bound_cond;
     auto_drainer_t drainer;
 };
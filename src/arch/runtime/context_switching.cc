@@ -12,6 +12,7 @@
 #include <valgrind/valgrind.h>
 #endif
 
+#include "containers/scoped.hpp"
 #include "utils.hpp"
 
 /* We have a custom implementation of `swapcontext()` that doesn't swap the
@@ -32,13 +33,19 @@ bool context_ref_t::is_nil() {
 }
 
 artificial_stack_t::artificial_stack_t(void (*initial_fun)(void), size_t _stack_size)
-    : stack_size(_stack_size) {
-    /* Allocate the stack */
-    stack = malloc_aligned(stack_size, getpagesize());
+    : stack_size(ceil_aligned(_stack_size, getpagesize())) {
+    /* Reserve the stack. We map it directly rather than going through
+    `malloc()` so that the kernel only commits pages once the coroutine
+    actually touches them; most coroutines use a small fraction of their
+    stack. */
+    stack = mmap(NULL, stack_size, PROT_READ | PROT_WRITE,
+                 MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+    guarantee_err(stack != MAP_FAILED, "could not allocate coroutine stack");
 
     /* Protect the end of the stack so that we crash when we get a stack
     overflow instead of corrupting memory. */
-    mprotect(stack, getpagesize(), PROT_NONE);
+    int res = mprotect(stack, getpagesize(), PROT_NONE);
+    guarantee_err(res == 0, "could not protect coroutine stack guard page");
 
     /* Register our stack with Valgrind so that it understands what's going on
     and doesn't create spurious errors */
@@ -124,11 +131,38 @@ artificial_stack_t::~artificial_stack_t() {
 #endif
 #endif
 
-    /* Undo protections changes */
-    mprotect(stack, getpagesize(), PROT_READ | PROT_WRITE);
+    /* Release the stack we allocated, including its protection page */
+    int res = munmap(stack, stack_size);
+    guarantee_err(res == 0, "could not release coroutine stack");
+}
+
+void artificial_stack_t::release_unused_pages() {
+    rassert(!context.is_nil(), "cannot release the pages of a running stack");
+    rassert(address_in_stack(context.pointer));
+
+    /* Everything below the saved stack pointer is garbage left over from
+    earlier calls. Keep the page the stack pointer is on, since the saved
+    registers live there. */
+    uintptr_t start = uintptr_t(stack) + getpagesize();
+    uintptr_t end = floor_aligned(uintptr_t(context.pointer), getpagesize());
+    if (end > start) {
+        int res = madvise(reinterpret_cast<void *>(start), end - start, MADV_DONTNEED);
+        guarantee_err(res == 0, "could not release unused coroutine stack pages");
+    }
+}
 
-    /* Release the stack we allocated */
-    free(stack);
+size_t artificial_stack_t::committed_size() {
+    const size_t page_size = getpagesize();
+    const size_t num_pages = stack_size / page_size;
+    scoped_array_t<unsigned char> residency(num_pages);
+    int res = mincore(stack, stack_size, residency.data());
+    guarantee_err(res == 0, "could not query coroutine stack residency");
+
+    size_t committed_pages = 0;
+    for (size_t i = 0; i < num_pages; ++i) {
+        committed_pages += residency[i] & 1;
+    }
+    return committed_pages * page_size;
 }
 
 bool artificial_stack_t::address_in_stack(void *addr) {
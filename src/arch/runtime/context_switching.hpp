@@ -58,6 +58,20 @@ public:
     /* Returns the end of the stack */
     void* get_stack_bound() { return stack; }
 
+    /* The stack's memory is reserved when the stack is created but pages are
+    only committed by the kernel when they are first touched. When the stack is
+    idle, `release_unused_pages()` hands the pages below the saved context back
+    to the OS, so that a stack that once ran deep doesn't hold on to its memory
+    forever. It may only be called while the stack is switched out (i.e.
+    `context` is non-nil). */
+    void release_unused_pages();
+
+    /* Returns the number of bytes of the stack that are currently backed by
+    physical memory. Since pages are committed on demand, this is a cheap upper
+    bound on how deep the stack has run since it was created or last had its
+    unused pages released. */
+    size_t committed_size();
+
 private:
     void *stack;
     size_t stack_size;
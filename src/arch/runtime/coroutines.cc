@@ -4,6 +4,8 @@
 #include <stdio.h>
 #include <string.h>
 
+#include <algorithm>
+
 #ifndef NDEBUG
 #include <stack>   /* the data structure, not the run-time concept */
 #endif
@@ -20,10 +22,11 @@
 #include "perfmon/perfmon.hpp"
 #include "utils.hpp"
 
-static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines;
+static perfmon_counter_t pm_active_coroutines, pm_allocated_coroutines, pm_trimmed_coroutines;
 static perfmon_multi_membership_t pm_coroutines_membership(&get_global_perfmon_collection(),
     &pm_active_coroutines, "active_coroutines",
     &pm_allocated_coroutines, "allocated_coroutines",
+    &pm_trimmed_coroutines, "trimmed_coroutines",
     NULLPTR);
 
 size_t coro_stack_size = COROUTINE_STACK_SIZE; //Default, setable by command-line parameter
@@ -44,9 +47,20 @@ struct coro_globals_t {
     /* The previous context. */
     coro_t *prev_coro;
 
-    /* A list of coro_t objects that are not in use. */
+    /* A list of coro_t objects that are not in use. The most recently used
+    coroutines are at the tail. At most `COROUTINE_HOT_FREE_LIST_SIZE` of them
+    are kept here; the rest are moved to `trimmed_free_coros`. */
     intrusive_list_t<coro_t> free_coros;
 
+    /* Coroutines that are not in use and whose unused stack pages have been
+    released to the OS. We only reuse them once `free_coros` is empty. */
+    intrusive_list_t<coro_t> trimmed_free_coros;
+
+    /* How many coroutines this thread has handed out, and how many of them
+    have been returned to its free lists. */
+    int64_t spawned_coros;
+    int64_t finished_coros;
+
 #ifndef NDEBUG
 
     /* An integer counting the number of coros on this thread */
@@ -63,7 +77,7 @@ struct coro_globals_t {
     std::stack<std::pair<std::string, int> > finite_waiting_call_sites;
 
     std::map<std::string, size_t> running_coroutine_counts;
-    std::map<std::string, size_t> total_coroutine_counts;
+    std::map<std::string, coroutine_type_summary_t> coroutine_summaries;
 
     std::set<coro_t*> active_coroutines;
 
@@ -72,6 +86,8 @@ struct coro_globals_t {
     coro_globals_t()
         : current_coro(NULL)
         , prev_coro(NULL)
+        , spawned_coros(0)
+        , finished_coros(0)
 #ifndef NDEBUG
         , coro_count(0)
         , assert_no_coro_waiting_counter(0)
@@ -88,6 +104,11 @@ struct coro_globals_t {
             free_coros.remove(s);
             delete s;
         }
+        while (coro_t *s = trimmed_free_coros.head()) {
+            trimmed_free_coros.remove(s);
+            --pm_trimmed_coroutines;
+            delete s;
+        }
     }
 
 };
@@ -105,10 +126,16 @@ coro_runtime_t::~coro_runtime_t() {
     cglobals = NULL;
 }
 
+void coro_runtime_t::get_coroutine_counts(coroutine_counts_t *counts_out) {
+    counts_out->spawned = cglobals->spawned_coros;
+    counts_out->active = cglobals->spawned_coros - cglobals->finished_coros;
+    counts_out->free = cglobals->free_coros.size() + cglobals->trimmed_free_coros.size();
+}
+
 #ifndef NDEBUG
-void coro_runtime_t::get_coroutine_counts(std::map<std::string, size_t> *dest) {
+void coro_runtime_t::get_coroutine_summaries(std::map<std::string, coroutine_type_summary_t> *dest) {
     dest->clear();
-    dest->insert(cglobals->total_coroutine_counts.begin(), cglobals->total_coroutine_counts.end());
+    dest->insert(cglobals->coroutine_summaries.begin(), cglobals->coroutine_summaries.end());
 }
 #endif
 
@@ -125,6 +152,7 @@ coro_t::coro_t() :
     waiting_(false)
 #ifndef NDEBUG
     , selfname_number(get_thread_id() + MAX_THREADS * ++coro_selfname_counter)
+    , measure_stack_usage(false)
 #endif
 {
     ++pm_allocated_coroutines;
@@ -139,6 +167,20 @@ coro_t::coro_t() :
 
 void coro_t::return_coro_to_free_list(coro_t *coro) {
     cglobals->free_coros.push_back(coro);
+    ++cglobals->finished_coros;
+
+    /* If a burst of activity left us with more idle coroutines than we are
+    likely to need soon, give the stack memory of the least recently used one
+    back to the OS. `coro` itself may still be running on its stack at this
+    point, but it is at the tail so we never touch it here. */
+    if (cglobals->free_coros.size() > COROUTINE_HOT_FREE_LIST_SIZE) {
+        coro_t *cold_coro = cglobals->free_coros.head();
+        rassert(cold_coro != coro);
+        cglobals->free_coros.remove(cold_coro);
+        cold_coro->stack.release_unused_pages();
+        cglobals->trimmed_free_coros.push_back(cold_coro);
+        ++pm_trimmed_coroutines;
+    }
 }
 
 coro_t::~coro_t() {
@@ -169,7 +211,7 @@ void coro_t::run() {
 #ifndef NDEBUG
         // Keep track of how many coroutines of each type ran
         cglobals->running_coroutine_counts[coro->coroutine_type.c_str()]++;
-        cglobals->total_coroutine_counts[coro->coroutine_type.c_str()]++;
+        cglobals->coroutine_summaries[coro->coroutine_type.c_str()].count++;
         cglobals->active_coroutines.insert(coro);
 #endif
         coro->action_wrapper.run();
@@ -178,6 +220,14 @@ void coro_t::run() {
         pet_watchdog();
         cglobals->running_coroutine_counts[coro->coroutine_type.c_str()]--;
         cglobals->active_coroutines.erase(coro);
+
+        // Record how much stack this type of coroutine needs, so that spawn
+        // sites with shallow stacks can be identified.
+        if (coro->measure_stack_usage) {
+            coroutine_type_summary_t *summary = &cglobals->coroutine_summaries[coro->coroutine_type.c_str()];
+            summary->max_stack_usage = std::max(summary->max_stack_usage,
+                                                coro->stack.committed_size());
+        }
 #endif
 
         rassert(coro->current_thread_ == get_thread_id());
@@ -352,11 +402,15 @@ coro_t * coro_t::get_coro() {
     rassert(coroutines_have_been_initialized());
     coro_t *coro;
 
-    if (cglobals->free_coros.size() == 0) {
-        coro = new coro_t();
-    } else {
+    if (cglobals->free_coros.size() != 0) {
         coro = cglobals->free_coros.tail();
         cglobals->free_coros.remove(coro);
+    } else if (cglobals->trimmed_free_coros.size() != 0) {
+        coro = cglobals->trimmed_free_coros.tail();
+        cglobals->trimmed_free_coros.remove(coro);
+        --pm_trimmed_coroutines;
+    } else {
+        coro = new coro_t();
     }
 
     rassert(!coro->intrusive_list_node_t<coro_t>::in_a_list());
@@ -365,7 +419,20 @@ coro_t * coro_t::get_coro() {
     coro->notified_ = false;
     coro->waiting_ = true;
 
+#ifndef NDEBUG
+    // Measuring a coroutine's stack usage takes a couple of system calls, so
+    // only a sample of coroutines is measured. A reused stack still has the
+    // pages that earlier, possibly deeper, coroutines committed, so those are
+    // released first and only what this run touches is counted.
+    coro->measure_stack_usage =
+        cglobals->spawned_coros % COROUTINE_STACK_USAGE_SAMPLE_INTERVAL == 0;
+    if (coro->measure_stack_usage) {
+        coro->stack.release_unused_pages();
+    }
+#endif
+
     ++pm_active_coroutines;
+    ++cglobals->spawned_coros;
     return coro;
 }
 
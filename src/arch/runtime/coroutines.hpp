@@ -156,6 +156,9 @@ private:
     int64_t selfname_number;
     std::string coroutine_type;
     void parse_coroutine_type(const char *coroutine_function);
+
+    // Whether to record this run's stack usage in the coroutine summary.
+    bool measure_stack_usage;
 #endif
 
     DISABLE_COPYING(coro_t);
@@ -46,7 +46,7 @@ int epoll_to_user(int mode) {
 }
 
 epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
-    : parent(_parent) {
+    : parent(_parent), spin_limit(0), nevents(0) {
     // Create a poll fd
 
     epoll_fd = epoll_create1(0);
@@ -56,10 +56,19 @@ epoll_event_queue_t::epoll_event_queue_t(linux_queue_parent_t *_parent)
 void epoll_event_queue_t::run() {
     int res;
 
+    spin_limit = parent->get_spin_budget();
+
     // Now, start the loop
+    ticks_t wait_start = get_ticks();
     while (!parent->should_shut_down()) {
+        bool messages_pending = false;
+
         // Grab the events from the kernel!
-        res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        if (spin_limit > 0) {
+            res = spin_for_events(&messages_pending);
+        } else {
+            res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+        }
 
         // epoll_wait might return with EINTR in some cases (in
         // particular under GDB), we just need to retry.
@@ -75,6 +84,9 @@ void epoll_event_queue_t::run() {
         // new descriptor (which we probably can't at this point).
         guarantee_err(res != -1, "Waiting for epoll events failed");
 
+        const ticks_t busy_start = get_ticks();
+        parent->record_wait_interval(wait_start, busy_start);
+
         // nevents might be used by forget_resource during the loop
         nevents = res;
 
@@ -118,10 +130,66 @@ void epoll_event_queue_t::run() {
 
         nevents = 0;
 
+        if (messages_pending) {
+            parent->deliver_incoming_messages();
+        }
+
         parent->pump();
+
+        wait_start = get_ticks();
+        parent->record_busy_interval(busy_start, wait_start);
     }
 }
 
+int epoll_event_queue_t::spin_for_events(bool *messages_pending_out) {
+    const ticks_t spin_budget = parent->get_spin_budget();
+    const ticks_t spin_start = get_ticks();
+    const ticks_t spin_deadline = spin_start + spin_limit;
+
+    // Other threads stop writing to our notify eventfds from here on, so the
+    // incoming message queue has to be watched directly.
+    parent->begin_spinning();
+
+    int res = 0;
+    ticks_t now = spin_start;
+    for (int i = 0; ; ++i) {
+        if (parent->has_incoming_messages()) {
+            break;
+        }
+        if (i % EVENT_LOOP_SPIN_EPOLL_INTERVAL == 0) {
+            res = epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, 0);
+            if (res != 0) {
+                break;
+            }
+            // If there are more runnable threads than cores, the work we are
+            // waiting for may be stuck behind us.
+            sched_yield();
+        }
+        now = get_ticks();
+        if (now >= spin_deadline) {
+            break;
+        }
+#if defined(__i386__) || defined(__x86_64__)
+        __builtin_ia32_pause();
+#endif
+    }
+
+    parent->end_spinning();
+    parent->record_spin_interval(spin_start, std::max(now, spin_start));
+
+    *messages_pending_out = parent->has_incoming_messages();
+    if (res != 0 || *messages_pending_out) {
+        // The spin paid off, so allow longer ones again.
+        spin_limit = std::min(spin_budget, spin_limit * 2);
+        return res;
+    }
+
+    // Nothing came along; spin less next time so a thread that stays idle
+    // doesn't keep burning its whole budget, then go to sleep.
+    spin_limit = std::max(spin_budget / EVENT_LOOP_SPIN_MIN_FRACTION, spin_limit / 2);
+    return epoll_wait(epoll_fd, events, MAX_IO_EVENT_PROCESSING_BATCH_SIZE, -1);
+}
+
 epoll_event_queue_t::~epoll_event_queue_t() {
     DEBUG_VAR int res = close(epoll_fd);
     rassert_err(res == 0, "Could not close epoll_fd");
@@ -26,8 +26,18 @@ public:
     void forget_resource(fd_t resource, linux_event_callback_t *cb);
 
 private:
+    /* Busy polls for events and incoming messages for up to `spin_limit`
+    ticks, then sleeps in `epoll_wait()` if nothing turned up. Returns what
+    `epoll_wait()` returned, and sets `*messages_pending_out` if there are
+    incoming messages that have to be delivered. */
+    int spin_for_events(bool *messages_pending_out);
+
     linux_queue_parent_t *parent;
 
+    // How long the next busy poll may last; adapts between a fraction of the
+    // parent's spin budget and the whole budget. Zero disables busy polling.
+    ticks_t spin_limit;
+
     fd_t epoll_fd;
 
     // We store this as a class member because forget_resource needs
@@ -98,6 +98,7 @@ void poll_event_queue_t::run() {
 #endif  // RDB_TIMER_PROVIDER
 
     // Now, start the loop
+    ticks_t wait_start = get_ticks();
     while (!parent->should_shut_down()) {
         // Grab the events from the kernel!
 #ifndef RDB_TIMER_PROVIDER
@@ -117,6 +118,9 @@ void poll_event_queue_t::run() {
         // have no way of handling, and it's probably fatal.
         guarantee_err(res != -1, "Waiting for poll events failed");
 
+        const ticks_t busy_start = get_ticks();
+        parent->record_wait_interval(wait_start, busy_start);
+
         block_pm_duration event_loop_timer(&pm_eventloop);
 
         int count = 0;
@@ -144,6 +148,9 @@ void poll_event_queue_t::run() {
 #endif  // RDB_TIMER_PROVIDER
 
         parent->pump();
+
+        wait_start = get_ticks();
+        parent->record_busy_interval(busy_start, wait_start);
     }
 }
 
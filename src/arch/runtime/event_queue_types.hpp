@@ -4,6 +4,8 @@
 
 #include <signal.h>
 
+#include "utils.hpp"
+
 // Types that are used, in particular, by poll.hpp and epoll.hpp.
 
 // Event queue callback
@@ -15,6 +17,25 @@ struct linux_event_callback_t {
 struct linux_queue_parent_t {
     virtual void pump() = 0;
     virtual bool should_shut_down() = 0;
+    // Called after each round of processing events, with the time the queue woke up and the time
+    // it finished (including `pump()`).
+    virtual void record_busy_interval(ticks_t start, ticks_t end) = 0;
+    // Called after each wait for events, with the time the queue finished the previous round and
+    // the time it woke up.
+    virtual void record_wait_interval(ticks_t start, ticks_t end) = 0;
+
+    // Busy polling. Before going to sleep, the queue may spin for up to `get_spin_budget()` ticks
+    // (zero means never). It calls `begin_spinning()` first, so that other threads can hand it
+    // messages without waking it up through the kernel, and `end_spinning()` once it stops. While
+    // spinning, and again after it stops, it checks `has_incoming_messages()` and calls
+    // `deliver_incoming_messages()` to run any.
+    virtual ticks_t get_spin_budget() = 0;
+    virtual void begin_spinning() = 0;
+    virtual void end_spinning() = 0;
+    virtual bool has_incoming_messages() = 0;
+    virtual void deliver_incoming_messages() = 0;
+    // Called after each spin with the time it started and ended.
+    virtual void record_spin_interval(ticks_t start, ticks_t end) = 0;
     virtual ~linux_queue_parent_t() {}
 };
 
@@ -6,8 +6,10 @@
 
 #include "config/args.hpp"
 #include "arch/runtime/event_queue.hpp"
+#include "arch/runtime/runtime_stats.hpp"
 #include "arch/runtime/thread_pool.hpp"
 #include "logger.hpp"
+#include "perfmon/perfmon.hpp"
 
 // Set this to 1 if you would like some "unordered" messages to be unordered.
 #ifndef NDEBUG
@@ -15,7 +17,9 @@
 #endif
 
 linux_message_hub_t::linux_message_hub_t(linux_event_queue_t *queue, linux_thread_pool_t *thread_pool, int current_thread)
-    : queue_(queue), thread_pool_(thread_pool), current_thread_(current_thread) {
+    : queue_(queue), thread_pool_(thread_pool), has_incoming_messages_(false),
+      spinning_(false), messages_sent_(0), messages_received_(0),
+      current_thread_(current_thread) {
 
     // We have to do this through dynamically, otherwise we might
     // allocate far too many file descriptors since this is what the
@@ -85,6 +89,7 @@ void linux_message_hub_t::insert_external_message(linux_thread_message_t *msg) {
     {
         spinlock_acq_t acq(&incoming_messages_lock_);
         incoming_messages_.push_back(msg);
+        has_incoming_messages_ = true;
     }
 
     // Wakey wakey eggs and bakey
@@ -101,12 +106,33 @@ void linux_message_hub_t::notify_t::on_event(int events) {
     // don't pester us and use 100% cpu
     event.consume_wakey_wakeys();
 
+    parent->deliver_incoming_messages();
+}
+
+void linux_message_hub_t::begin_spinning() {
+    spinning_ = true;
+}
+
+void linux_message_hub_t::end_spinning() {
+    spinning_ = false;
+    // Pairs with the barrier in `push_messages()`: either the sender sees that
+    // we stopped spinning and wakes us up, or our next look at
+    // `has_incoming_messages_` sees its messages.
+    __sync_synchronize();
+}
+
+bool linux_message_hub_t::has_incoming_messages() const {
+    return has_incoming_messages_;
+}
+
+void linux_message_hub_t::deliver_incoming_messages() {
     msg_list_t msg_list;
 
     // Pull the messages
     {
-        spinlock_acq_t acq(&parent->incoming_messages_lock_);
-        msg_list.append_and_clear(&parent->incoming_messages_);
+        spinlock_acq_t acq(&incoming_messages_lock_);
+        msg_list.append_and_clear(&incoming_messages_);
+        has_incoming_messages_ = false;
     }
 
 #ifndef NDEBUG
@@ -118,11 +144,12 @@ void linux_message_hub_t::notify_t::on_event(int events) {
 #ifndef NDEBUG
         if (m->reloop_count_ > 0) {
             --m->reloop_count_;
-            parent->do_store_message(parent->current_thread_, m);
+            do_store_message(current_thread_, m);
             continue;
         }
 #endif
 
+        ++messages_received_;
         m->on_thread_switch();
 
 #ifndef NDEBUG
@@ -140,20 +167,32 @@ void linux_message_hub_t::push_messages() {
         thread_queue_t *queue = &queues_[i];
         if (!queue->msg_local_list.empty()) {
             // Transfer messages to the other core
+            const unsigned int count = queue->msg_local_list.size();
+            messages_sent_ += count;
+            pm_thread_messages.record(count);
 
+            linux_message_hub_t *other = &thread_pool_->threads[i]->message_hub;
             bool do_wake_up;
             {
-                spinlock_acq_t acq(&thread_pool_->threads[i]->message_hub.incoming_messages_lock_);
+                spinlock_acq_t acq(&other->incoming_messages_lock_);
 
                 //We only need to do a wake up if the global
-                do_wake_up = thread_pool_->threads[i]->message_hub.incoming_messages_.empty();
+                do_wake_up = other->incoming_messages_.empty();
 
-                thread_pool_->threads[i]->message_hub.incoming_messages_.append_and_clear(&queue->msg_local_list);
+                other->incoming_messages_.append_and_clear(&queue->msg_local_list);
+                other->has_incoming_messages_ = true;
+            }
+
+            // A thread that is busy polling will find the messages by itself.
+            // See `end_spinning()` for why the barrier is needed.
+            if (do_wake_up) {
+                __sync_synchronize();
+                do_wake_up = !other->spinning_;
             }
 
             // Wakey wakey, perhaps eggs and bakey
             if (do_wake_up) {
-                thread_pool_->threads[i]->message_hub.notify_[current_thread_].event.wakey_wakey();
+                other->notify_[current_thread_].event.wakey_wakey();
             }
         }
     }
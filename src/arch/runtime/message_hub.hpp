@@ -45,6 +45,24 @@ public:
     // (which does not have an event queue)
     void insert_external_message(linux_thread_message_t *msg);
 
+    /* While this thread's event queue is busy polling, other threads hand it
+    messages without writing to its notify eventfds. `end_spinning()` must be
+    followed by a check of `has_incoming_messages()` before the thread sleeps. */
+    void begin_spinning();
+    void end_spinning();
+
+    /* Can be called without holding the lock; it may spuriously say there are
+    messages that another call has already delivered. */
+    bool has_incoming_messages() const;
+
+    /* Runs the messages that other threads have sent to this one. */
+    void deliver_incoming_messages();
+
+    /* How many messages this thread has handed to other threads (or to itself
+    through the hub), and how many it has run. Only valid on this thread. */
+    int64_t get_messages_sent() const { return messages_sent_; }
+    int64_t get_messages_received() const { return messages_received_; }
+
     ~linux_message_hub_t();
 
 private:
@@ -74,6 +92,14 @@ private:
     msg_list_t incoming_messages_;
     spinlock_t incoming_messages_lock_;
 
+    /* Set whenever `incoming_messages_` is nonempty, so that a spinning
+    thread can poll it without taking the lock. */
+    volatile bool has_incoming_messages_;
+
+    /* Whether this thread is busy polling, in which case senders don't need
+    to wake it up. */
+    volatile bool spinning_;
+
     /* We keep one notify_t for each other message hub that we interact with. When it has
     messages for us, it signals the appropriate notify_t from our set of notify_ts. We get
     the notification and call push_messages on the sender in reply. */
@@ -95,6 +121,9 @@ private:
     };
     notify_t *notify_;
 
+    int64_t messages_sent_;
+    int64_t messages_received_;
+
     /* The thread that we queue messages originating from. (Recall that there is one
     message_hub_t per thread.) */
     const unsigned int current_thread_;
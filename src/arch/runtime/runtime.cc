@@ -16,6 +16,25 @@ int get_num_threads() {
     return linux_thread_pool_t::thread_pool->n_threads;
 }
 
+double get_thread_load(int thread) {
+    assert_good_thread_id(thread);
+    // The thread may already have shut down.
+    linux_thread_t *t = linux_thread_pool_t::thread_pool->threads[thread];
+    return t == NULL ? 0 : t->load.get_recent_load();
+}
+
+double get_thread_busy_secs(int thread) {
+    assert_good_thread_id(thread);
+    linux_thread_t *t = linux_thread_pool_t::thread_pool->threads[thread];
+    return t == NULL ? 0 : ticks_to_secs(t->load.get_total_busy_ticks());
+}
+
+double get_thread_spin_secs(int thread) {
+    assert_good_thread_id(thread);
+    linux_thread_t *t = linux_thread_pool_t::thread_pool->threads[thread];
+    return t == NULL ? 0 : ticks_to_secs(t->load.get_total_spin_ticks());
+}
+
 #ifndef NDEBUG
 void assert_good_thread_id(int thread) {
     rassert(thread >= 0, "(thread = %d)", thread);
@@ -55,8 +74,8 @@ private:
 };
 
 // Runs the action 'fun()' on thread zero.
-void run_in_thread_pool(const boost::function<void()>& fun, int worker_threads) {
-    linux_thread_pool_t thread_pool(worker_threads, false);
+void run_in_thread_pool(const boost::function<void()>& fun, int worker_threads, int spin_usecs) {
+    linux_thread_pool_t thread_pool(worker_threads, false, spin_usecs);
     starter_t starter(&thread_pool, fun);
     thread_pool.run_thread_pool(&starter);
 }
@@ -12,6 +12,18 @@ int get_thread_id();
 
 int get_num_threads();
 
+// Returns the fraction (between 0 and 1) of recent time that the given thread's event loop spent
+// running callbacks rather than waiting for events. Can be called from any thread.
+double get_thread_load(int thread);
+
+// Returns the total number of seconds the given thread's event loop has spent running callbacks.
+// Can be called from any thread.
+double get_thread_busy_secs(int thread);
+
+// Returns the total number of seconds the given thread's event loop has spent busy polling for
+// work (see `run_in_thread_pool()`). Can be called from any thread.
+double get_thread_spin_secs(int thread);
+
 #ifndef NDEBUG
 void assert_good_thread_id(int thread);
 #else
@@ -0,0 +1,146 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#define __STDC_FORMAT_MACROS
+
+#include "arch/runtime/runtime_stats.hpp"
+
+#include <inttypes.h>
+
+#include <memory>
+
+#include "arch/runtime/thread_pool.hpp"
+#include "perfmon/perfmon.hpp"
+
+/* Reports each thread's counters, which are read on the thread itself. */
+class runtime_threads_perfmon_t : public perfmon_t {
+public:
+    runtime_threads_perfmon_t() { }
+
+    void *begin_stats() {
+        return new thread_stats_t[get_num_threads()];
+    }
+
+    void visit_stats(void *data) {
+        thread_stats_t *stats = &static_cast<thread_stats_t *>(data)[get_thread_id()];
+        linux_thread_t *thread = linux_thread_pool_t::thread;
+        stats->busy_ticks = thread->load.get_total_busy_ticks();
+        stats->wait_ticks = thread->load.get_total_wait_ticks();
+        stats->spin_ticks = thread->load.get_total_spin_ticks();
+        stats->load = thread->load.get_recent_load();
+        thread->coro_runtime.get_coroutine_counts(&stats->coroutines);
+        stats->messages_sent = thread->message_hub.get_messages_sent();
+        stats->messages_received = thread->message_hub.get_messages_received();
+    }
+
+    scoped_ptr_t<perfmon_result_t> end_stats(void *data) {
+        std::unique_ptr<thread_stats_t[]> stats(static_cast<thread_stats_t *>(data));
+
+        scoped_ptr_t<perfmon_result_t> result = perfmon_result_t::alloc_map_result();
+        for (int i = 0; i < get_num_threads(); ++i) {
+            const thread_stats_t &s = stats[i];
+            scoped_ptr_t<perfmon_result_t> thread = perfmon_result_t::alloc_map_result();
+            thread->insert("busy_time", new perfmon_result_t(strprintf("%f", ticks_to_secs(s.busy_ticks))));
+            thread->insert("wait_time", new perfmon_result_t(strprintf("%f", ticks_to_secs(s.wait_ticks))));
+            thread->insert("spin_time", new perfmon_result_t(strprintf("%f", ticks_to_secs(s.spin_ticks))));
+            thread->insert("load", new perfmon_result_t(strprintf("%f", s.load)));
+            thread->insert("coroutines_active", new perfmon_result_t(strprintf("%" PRIi64, s.coroutines.active)));
+            thread->insert("coroutines_free", new perfmon_result_t(strprintf("%" PRIi64, s.coroutines.free)));
+            thread->insert("coroutines_spawned", new perfmon_result_t(strprintf("%" PRIi64, s.coroutines.spawned)));
+            thread->insert("messages_sent", new perfmon_result_t(strprintf("%" PRIi64, s.messages_sent)));
+            thread->insert("messages_received", new perfmon_result_t(strprintf("%" PRIi64, s.messages_received)));
+            result->insert(strprintf("%d", i), thread.release());
+        }
+        return result;
+    }
+
+private:
+    struct thread_stats_t {
+        thread_stats_t()
+            : busy_ticks(0), wait_ticks(0), spin_ticks(0), load(0),
+              messages_sent(0), messages_received(0) { }
+        ticks_t busy_ticks, wait_ticks, spin_ticks;
+        double load;
+        coroutine_counts_t coroutines;
+        int64_t messages_sent, messages_received;
+    };
+
+    DISABLE_COPYING(runtime_threads_perfmon_t);
+};
+
+/* Reports how many coroutines each thread has been spawning per second, from
+the thread's running count of spawned coroutines, so that spawning a coroutine
+costs nothing extra. Each thread keeps two samples of the count, at least
+`length` apart, and the rate is taken over the time since the older one. */
+class coroutine_spawn_rate_perfmon_t : public perfmon_perthread_t<double> {
+public:
+    explicit coroutine_spawn_rate_perfmon_t(ticks_t _length) : length(_length) {
+        // The threads haven't started yet, so none of them has spawned anything.
+        const ticks_t now = get_ticks();
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            samples[i].value.older = samples[i].value.newer = sample_t(0, now);
+        }
+    }
+
+private:
+    struct sample_t {
+        sample_t() : spawned(0), ticks(0) { }
+        sample_t(int64_t _spawned, ticks_t _ticks) : spawned(_spawned), ticks(_ticks) { }
+        int64_t spawned;
+        ticks_t ticks;
+    };
+    struct thread_samples_t {
+        sample_t older, newer;
+    };
+
+    void get_thread_stat(double *stat) {
+        coroutine_counts_t counts;
+        linux_thread_pool_t::thread->coro_runtime.get_coroutine_counts(&counts);
+        const ticks_t now = get_ticks();
+
+        thread_samples_t *s = &samples[get_thread_id()].value;
+        if (now - s->newer.ticks >= length) {
+            s->older = s->newer;
+            s->newer = sample_t(counts.spawned, now);
+        }
+        const ticks_t elapsed = now - s->older.ticks;
+        *stat = elapsed == 0 ? 0 : (counts.spawned - s->older.spawned) / ticks_to_secs(elapsed);
+    }
+
+    double combine_stats(const double *stats) {
+        double total = 0;
+        for (int i = 0; i < get_num_threads(); ++i) {
+            total += stats[i];
+        }
+        return total;
+    }
+
+    scoped_ptr_t<perfmon_result_t> output_stat(const double &stat) {
+        return make_scoped<perfmon_result_t>(strprintf("%.8f", stat));
+    }
+
+    ticks_t length;
+    cache_line_padded_t<thread_samples_t> samples[MAX_THREADS];
+
+    DISABLE_COPYING(coroutine_spawn_rate_perfmon_t);
+};
+
+static perfmon_collection_t pm_runtime_collection;
+static perfmon_membership_t pm_runtime_collection_membership(&get_global_perfmon_collection(),
+    &pm_runtime_collection, "runtime");
+
+perfmon_histogram_t pm_eventloop_lag(secs_to_ticks(1), false, 1e-6);
+perfmon_rate_monitor_t pm_thread_messages(secs_to_ticks(1));
+perfmon_counter_t pm_blocker_pool_outstanding_jobs;
+perfmon_histogram_t pm_blocker_pool_queue_time(secs_to_ticks(1), true, 1e-6);
+perfmon_histogram_t pm_blocker_pool_run_time(secs_to_ticks(1), false, 1e-6);
+static coroutine_spawn_rate_perfmon_t pm_coroutine_spawns(secs_to_ticks(1));
+static runtime_threads_perfmon_t pm_runtime_threads;
+
+static perfmon_multi_membership_t pm_runtime_membership(&pm_runtime_collection,
+    &pm_eventloop_lag, "eventloop_lag",
+    &pm_coroutine_spawns, "coroutines_spawned",
+    &pm_thread_messages, "messages_sent",
+    &pm_blocker_pool_outstanding_jobs, "blocker_pool_jobs",
+    &pm_blocker_pool_queue_time, "blocker_pool_queue_time",
+    &pm_blocker_pool_run_time, "blocker_pool_run_time",
+    &pm_runtime_threads, "threads",
+    NULLPTR);
@@ -0,0 +1,40 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_RUNTIME_STATS_HPP_
+#define ARCH_RUNTIME_RUNTIME_STATS_HPP_
+
+#include "perfmon/types.hpp"
+
+/* These perfmons make up the `runtime` perfmon collection, which tells how
+the runtime itself is doing: whether the threads are saturated with callbacks
+or waiting on I/O, how late their event loops notice events, and how busy the
+coroutines, the cross-thread messages and the blocker pools are. Besides these,
+the collection has a `threads` entry with each thread's own counters, read on
+that thread:
+
+  - `busy_time`, `wait_time` and `spin_time`: the seconds its event loop has
+    spent running callbacks, waiting for events (including busy polling) and
+    busy polling;
+  - `load`: the fraction of recent time it spent running callbacks;
+  - `coroutines_active`, `coroutines_free` and `coroutines_spawned`: see
+    `coroutine_counts_t`;
+  - `messages_sent` and `messages_received`: the messages it has handed to
+    other threads and the ones it has run.
+
+The top-level `coroutines_spawned` rate is worked out from the threads'
+`coroutines_spawned` counts when the stats are read.
+
+All of them are cheap to record and none of them take locks. */
+
+// How late each thread's event loop handles its timer, in seconds. A
+// saturated thread has a large lag; one waiting on I/O has hardly any.
+extern perfmon_histogram_t pm_eventloop_lag;
+
+extern perfmon_rate_monitor_t pm_thread_messages;
+
+// The blocker pool jobs that have been handed out and not finished, how long
+// they waited for a blocker thread, and how long they ran for, in seconds.
+extern perfmon_counter_t pm_blocker_pool_outstanding_jobs;
+extern perfmon_histogram_t pm_blocker_pool_queue_time;
+extern perfmon_histogram_t pm_blocker_pool_run_time;
+
+#endif  // ARCH_RUNTIME_RUNTIME_STATS_HPP_
@@ -9,8 +9,9 @@
 
 /* `run_in_thread_pool()` starts a RethinkDB thread pool, runs the given
 function in a coroutine inside of it, waits for the function to return, and then
-shuts down the thread pool. */
+shuts down the thread pool. If `spin_usecs` is nonzero, idle threads busy poll
+for up to that many microseconds before going to sleep. */
 
-void run_in_thread_pool(const boost::function<void()>& fun, int worker_threads);
+void run_in_thread_pool(const boost::function<void()>& fun, int worker_threads, int spin_usecs = 0);
 
 #endif  // ARCH_RUNTIME_STARTER_HPP_
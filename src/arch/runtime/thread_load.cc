@@ -0,0 +1,114 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "arch/runtime/thread_load.hpp"
+
+#include <algorithm>
+
+#include "config/args.hpp"
+
+static const ticks_t load_window_ticks = THREAD_LOAD_WINDOW_MS * MILLION;
+
+thread_load_t::thread_load_t()
+    : window_start(get_ticks()),
+      window_busy_ticks(0),
+      last_window_load_ppm(0),
+      total_busy_ticks(0),
+      total_spin_ticks(0),
+      total_wait_ticks(0) { }
+
+void thread_load_t::record_busy_interval(ticks_t start, ticks_t end) {
+    rassert(end >= start);
+    window_busy_ticks += end - start;
+    total_busy_ticks += end - start;
+
+    const ticks_t window_length = end - window_start;
+    if (window_length >= load_window_ticks) {
+        last_window_load_ppm = std::min<ticks_t>(MILLION, window_busy_ticks * MILLION / window_length);
+        window_start = end;
+        window_busy_ticks = 0;
+    }
+}
+
+double thread_load_t::get_recent_load() const {
+    const ticks_t start = window_start;
+    const ticks_t busy = window_busy_ticks;
+    const ticks_t now = get_ticks();
+
+    // A thread that hasn't closed a window for a while has been sleeping in
+    // its event queue, so its last complete window no longer says much. Look
+    // at the current window instead.
+    if (now > start && now - start >= 2 * load_window_ticks) {
+        return std::min<double>(1.0, static_cast<double>(busy) / (now - start));
+    }
+    return last_window_load_ppm / static_cast<double>(MILLION);
+}
+
+ticks_t thread_load_t::get_total_busy_ticks() const {
+    return total_busy_ticks;
+}
+
+void thread_load_t::record_spin_interval(ticks_t start, ticks_t end) {
+    rassert(end >= start);
+    total_spin_ticks += end - start;
+}
+
+ticks_t thread_load_t::get_total_spin_ticks() const {
+    return total_spin_ticks;
+}
+
+void thread_load_t::record_wait_interval(ticks_t start, ticks_t end) {
+    rassert(end >= start);
+    total_wait_ticks += end - start;
+}
+
+ticks_t thread_load_t::get_total_wait_ticks() const {
+    return total_wait_ticks;
+}
+
+conn_placement_t::conn_placement_t(int num_threads)
+    : conns_per_thread(num_threads, 0), next_thread(0) { }
+
+int conn_placement_t::choose_thread_for_new_conn(const std::vector<double> &loads) {
+    rassert(!loads.empty() && loads.size() <= conns_per_thread.size());
+    // Start the search at the next thread in round-robin order, so that threads with equal load
+    // and equal numbers of connections still take turns.
+    const int num_threads = loads.size();
+    const int first = (next_thread++) % num_threads;
+    int best = first;
+    for (int i = 1; i < num_threads; ++i) {
+        const int candidate = (first + i) % num_threads;
+        const double load_difference = loads[candidate] - loads[best];
+        if (load_difference < -CLIENT_CONN_PLACEMENT_LOAD_SLACK ||
+            (load_difference < CLIENT_CONN_PLACEMENT_LOAD_SLACK &&
+             conns_per_thread[candidate] < conns_per_thread[best])) {
+            best = candidate;
+        }
+    }
+    return best;
+}
+
+int conn_placement_t::choose_thread_for_idle_conn(int current_thread, const std::vector<double> &loads) const {
+    rassert(current_thread >= 0 && static_cast<size_t>(current_thread) < loads.size());
+    const double current_load = loads[current_thread];
+    int best = current_thread;
+    double best_load = current_load;
+    for (size_t i = 0; i < loads.size(); ++i) {
+        if (loads[i] < best_load) {
+            best = i;
+            best_load = loads[i];
+        }
+    }
+    return current_load - best_load >= CLIENT_CONN_MIGRATION_LOAD_GAP ? best : current_thread;
+}
+
+int conn_placement_t::get_num_conns(int thread) const {
+    return conns_per_thread[thread];
+}
+
+conn_placement_t::conn_t::conn_t(conn_placement_t *parent, int thread)
+    : count(&parent->conns_per_thread[thread]) {
+    __sync_add_and_fetch(count, 1);
+}
+
+conn_placement_t::conn_t::~conn_t() {
+    __sync_sub_and_fetch(count, 1);
+}
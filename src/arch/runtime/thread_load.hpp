@@ -0,0 +1,99 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef ARCH_RUNTIME_THREAD_LOAD_HPP_
+#define ARCH_RUNTIME_THREAD_LOAD_HPP_
+
+#include <vector>
+
+#include "utils.hpp"
+
+/* `thread_load_t` keeps track of how much of its time a thread's event loop
+spends running callbacks, as opposed to waiting for events. It is written only
+by the thread it belongs to, but it may be read from any thread; readers may
+see slightly stale values, which is fine for placement decisions and stats. */
+
+class thread_load_t {
+public:
+    thread_load_t();
+
+    /* Called by the event loop after each round of processing events. */
+    void record_busy_interval(ticks_t start, ticks_t end);
+
+    /* Returns the fraction (between 0 and 1) of recent wall-clock time that
+    the thread was busy. */
+    double get_recent_load() const;
+
+    /* Returns the total time the thread has been busy since it started. */
+    ticks_t get_total_busy_ticks() const;
+
+    /* Called by the event loop after each time it busy polled for work.
+    Spinning counts as idle time in the load, since the thread would have been
+    asleep otherwise. */
+    void record_spin_interval(ticks_t start, ticks_t end);
+
+    /* Returns the total time the thread has spent busy polling. */
+    ticks_t get_total_spin_ticks() const;
+
+    /* Called by the event loop with the time it spent waiting for events
+    between two rounds of processing them, including any time it spent busy
+    polling. */
+    void record_wait_interval(ticks_t start, ticks_t end);
+
+    /* Returns the total time the thread has spent waiting for events. */
+    ticks_t get_total_wait_ticks() const;
+
+private:
+    // When the current measurement window started, and how long the thread
+    // has been busy since then.
+    volatile ticks_t window_start;
+    volatile ticks_t window_busy_ticks;
+
+    // The load during the last complete window, in millionths.
+    volatile uint32_t last_window_load_ppm;
+
+    volatile ticks_t total_busy_ticks;
+    volatile ticks_t total_spin_ticks;
+    volatile ticks_t total_wait_ticks;
+
+    DISABLE_COPYING(thread_load_t);
+};
+
+/* `conn_placement_t` decides which thread serves each client connection,
+given the threads' loads. A new connection goes to the least loaded thread;
+threads whose loads are within `CLIENT_CONN_PLACEMENT_LOAD_SLACK` of each other
+count as equally loaded, and the one serving fewer connections wins, with
+round-robin order breaking any remaining ties. */
+
+class conn_placement_t {
+public:
+    explicit conn_placement_t(int num_threads);
+
+    /* `loads[i]` is the recent load of thread `i`; only those threads are
+    considered. */
+    int choose_thread_for_new_conn(const std::vector<double> &loads);
+
+    /* Returns the thread an idle connection on `current_thread` should move
+    to, which is `current_thread` unless some thread's load is lower by at
+    least `CLIENT_CONN_MIGRATION_LOAD_GAP`. */
+    int choose_thread_for_idle_conn(int current_thread, const std::vector<double> &loads) const;
+
+    int get_num_conns(int thread) const;
+
+    /* Counts a connection as served by `thread` for as long as it exists. May
+    be created and destroyed on any thread. */
+    class conn_t {
+    public:
+        conn_t(conn_placement_t *parent, int thread);
+        ~conn_t();
+    private:
+        int *count;
+        DISABLE_COPYING(conn_t);
+    };
+
+private:
+    std::vector<int> conns_per_thread;
+    unsigned next_thread;
+
+    DISABLE_COPYING(conn_placement_t);
+};
+
+#endif  // ARCH_RUNTIME_THREAD_LOAD_HPP_
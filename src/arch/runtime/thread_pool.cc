@@ -7,6 +7,8 @@
 #include <unistd.h>
 #include <sys/time.h>
 
+#include <algorithm>
+
 #include "arch/barrier.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/runtime/event_queue.hpp"
@@ -20,17 +22,19 @@ __thread linux_thread_pool_t *linux_thread_pool_t::thread_pool;
 __thread int linux_thread_pool_t::thread_id;
 __thread linux_thread_t *linux_thread_pool_t::thread;
 
-linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity) :
+linux_thread_pool_t::linux_thread_pool_t(int worker_threads, bool _do_set_affinity, int _spin_usecs) :
 #ifndef NDEBUG
       coroutine_summary(false),
 #endif
       interrupt_message(NULL),
       generic_blocker_pool(NULL),
       n_threads(worker_threads + 1),    // we create an extra utility thread
-      do_set_affinity(_do_set_affinity)
+      do_set_affinity(_do_set_affinity),
+      spin_usecs(_spin_usecs)
 {
     rassert(n_threads > 1);             // we want at least one non-utility thread
     rassert(n_threads <= MAX_THREADS);
+    rassert(spin_usecs >= 0 && spin_usecs <= MAX_EVENT_LOOP_SPIN_USECS);
 
     int res;
 
@@ -244,14 +248,14 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
 
 #ifndef NDEBUG
     // Save each thread's coroutine counters before shutting down
-    std::vector<std::map<std::string, size_t> > coroutine_counts(n_threads);
+    std::vector<std::map<std::string, coroutine_type_summary_t> > coroutine_summaries(n_threads);
 #endif
 
     // Shut down child threads
     for (int i = 0; i < n_threads; i++) {
         // Cause child thread to break out of its loop
 #ifndef NDEBUG
-        threads[i]->initiate_shut_down(&coroutine_counts[i]);
+        threads[i]->initiate_shut_down(&coroutine_summaries[i]);
 #else
         threads[i]->initiate_shut_down();
 #endif
@@ -271,18 +275,21 @@ void linux_thread_pool_t::run_thread_pool(linux_thread_message_t *initial_messag
 #ifndef NDEBUG
     if (coroutine_summary)
     {
-        // Combine coroutine counts from each thread, and log the totals
-        std::map<std::string, size_t> total_coroutine_counts;
+        // Combine coroutine summaries from each thread, and log the totals
+        std::map<std::string, coroutine_type_summary_t> total_coroutine_summaries;
         for (int i = 0; i < n_threads; ++i) {
-            for (std::map<std::string, size_t>::iterator j = coroutine_counts[i].begin();
-                 j != coroutine_counts[i].end(); ++j) {
-                total_coroutine_counts[j->first] += j->second;
+            for (std::map<std::string, coroutine_type_summary_t>::iterator j = coroutine_summaries[i].begin();
+                 j != coroutine_summaries[i].end(); ++j) {
+                coroutine_type_summary_t *total = &total_coroutine_summaries[j->first];
+                total->count += j->second.count;
+                total->max_stack_usage = std::max(total->max_stack_usage, j->second.max_stack_usage);
             }
         }
 
-        for (std::map<std::string, size_t>::iterator i = total_coroutine_counts.begin();
-             i != total_coroutine_counts.end(); ++i) {
-            logDBG("%zu coroutines ran with type %s", i->second, i->first.c_str());
+        for (std::map<std::string, coroutine_type_summary_t>::iterator i = total_coroutine_summaries.begin();
+             i != total_coroutine_summaries.end(); ++i) {
+            logDBG("%zu coroutines ran with type %s, using at most %zu bytes of stack",
+                   i->second.count, i->first.c_str(), i->second.max_stack_usage);
         }
     }
 #endif  // NDEBUG
@@ -355,9 +362,10 @@ linux_thread_t::linux_thread_t(linux_thread_pool_t *parent_pool, int thread_id)
     : queue(this),
       message_hub(&queue, parent_pool, thread_id),
       timer_handler(&queue),
+      spin_budget(parent_pool->spin_usecs * THOUSAND),
       do_shutdown(false)
 #ifndef NDEBUG
-      , coroutine_counts_at_shutdown(NULL)
+      , coroutine_summaries_at_shutdown(NULL)
 #endif
 {
     // Initialize the mutex which synchronizes access to the do_shutdown variable
@@ -371,10 +379,10 @@ linux_thread_t::linux_thread_t(linux_thread_pool_t *parent_pool, int thread_id)
 linux_thread_t::~linux_thread_t() {
 
 #ifndef NDEBUG
-    // Save the coroutine counts before they're deleted, should be ready at shutdown
-    rassert(coroutine_counts_at_shutdown != NULL);
-    coroutine_counts_at_shutdown->clear();
-    coro_runtime.get_coroutine_counts(coroutine_counts_at_shutdown);
+    // Save the coroutine summaries before they're deleted, should be ready at shutdown
+    rassert(coroutine_summaries_at_shutdown != NULL);
+    coroutine_summaries_at_shutdown->clear();
+    coro_runtime.get_coroutine_summaries(coroutine_summaries_at_shutdown);
 #endif
 
     int res = pthread_mutex_destroy(&do_shutdown_mutex);
@@ -385,6 +393,38 @@ void linux_thread_t::pump() {
     message_hub.push_messages();
 }
 
+void linux_thread_t::record_busy_interval(ticks_t start, ticks_t end) {
+    load.record_busy_interval(start, end);
+}
+
+void linux_thread_t::record_wait_interval(ticks_t start, ticks_t end) {
+    load.record_wait_interval(start, end);
+}
+
+ticks_t linux_thread_t::get_spin_budget() {
+    return spin_budget;
+}
+
+void linux_thread_t::begin_spinning() {
+    message_hub.begin_spinning();
+}
+
+void linux_thread_t::end_spinning() {
+    message_hub.end_spinning();
+}
+
+bool linux_thread_t::has_incoming_messages() {
+    return message_hub.has_incoming_messages();
+}
+
+void linux_thread_t::deliver_incoming_messages() {
+    message_hub.deliver_incoming_messages();
+}
+
+void linux_thread_t::record_spin_interval(ticks_t start, ticks_t end) {
+    load.record_spin_interval(start, end);
+}
+
 void linux_thread_t::on_event(int events) {
     // No-op. This is just to make sure that the event queue wakes up
     // so it can shut down.
@@ -404,14 +444,14 @@ bool linux_thread_t::should_shut_down() {
 }
 
 #ifndef NDEBUG
-void linux_thread_t::initiate_shut_down(std::map<std::string, size_t> *coroutine_counts) {
+void linux_thread_t::initiate_shut_down(std::map<std::string, coroutine_type_summary_t> *coroutine_summaries) {
 #else
 void linux_thread_t::initiate_shut_down() {
 #endif
     int res = pthread_mutex_lock(&do_shutdown_mutex);
     guarantee_xerr(res == 0, res, "could not lock do_shutdown_mutex");
 #ifndef NDEBUG
-    coroutine_counts_at_shutdown = coroutine_counts;
+    coroutine_summaries_at_shutdown = coroutine_summaries;
 #endif
     do_shutdown = true;
     shutdown_notify_event.wakey_wakey();
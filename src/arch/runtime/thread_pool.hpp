@@ -12,6 +12,7 @@
 #include "arch/runtime/system_event.hpp"
 #include "arch/runtime/message_hub.hpp"
 #include "arch/runtime/coroutines.hpp"
+#include "arch/runtime/thread_load.hpp"
 #include "arch/io/blocker_pool.hpp"
 #include "arch/io/timer_provider.hpp"
 #include "arch/timer.hpp"
@@ -22,12 +23,36 @@ class linux_thread_t;
 construct one coro_runtime_t per thread. Coroutines can only be used
 when a coro_runtime_t exists. It exists to take advantage of RAII. */
 
+#ifndef NDEBUG
+/* Per-type coroutine statistics, collected in debug mode and logged at
+shutdown when the coroutine summary is enabled. `max_stack_usage` is the
+largest number of stack bytes that a sampled coroutine of that type committed
+during its run (see `COROUTINE_STACK_USAGE_SAMPLE_INTERVAL`). */
+struct coroutine_type_summary_t {
+    coroutine_type_summary_t() : count(0), max_stack_usage(0) { }
+    size_t count;
+    size_t max_stack_usage;
+};
+#endif
+
+/* How many coroutines a thread has spawned in all, how many of those haven't
+finished yet (wherever they are running now), and how many idle ones it keeps
+for reuse. */
+struct coroutine_counts_t {
+    coroutine_counts_t() : spawned(0), active(0), free(0) { }
+    int64_t spawned;
+    int64_t active;
+    int64_t free;
+};
+
 struct coro_runtime_t {
     coro_runtime_t();
     ~coro_runtime_t();
 
+    void get_coroutine_counts(coroutine_counts_t *counts_out);
+
 #ifndef NDEBUG
-    void get_coroutine_counts(std::map<std::string, size_t> *dest);
+    void get_coroutine_summaries(std::map<std::string, coroutine_type_summary_t> *dest);
 #endif
 };
 
@@ -38,7 +63,9 @@ and shutting down the threads and event queues. */
 
 class linux_thread_pool_t {
 public:
-    linux_thread_pool_t(int worker_threads, bool do_set_affinity);
+    // If `spin_usecs` is nonzero, idle threads busy poll for up to that many microseconds before
+    // going to sleep, trading CPU time for lower wakeup latency.
+    linux_thread_pool_t(int worker_threads, bool do_set_affinity, int spin_usecs = 0);
 
     // When the process receives a SIGINT or SIGTERM, interrupt_message will be delivered to the
     // same thread that initial_message was delivered to, and interrupt_message will be set to
@@ -90,6 +117,7 @@ public:
 
     int n_threads;
     bool do_set_affinity;
+    int spin_usecs;
     // The thread_pool that started the thread we are currently in
     static __thread linux_thread_pool_t *thread_pool;
     // The ID of the thread we are currently in
@@ -156,22 +184,37 @@ public:
     for coroutines. */
     coro_runtime_t coro_runtime;
 
+    // Written by this thread's event queue, may be read from any thread.
+    thread_load_t load;
+
     void pump();   // Called by the event queue
     bool should_shut_down();   // Called by the event queue
+    void record_busy_interval(ticks_t start, ticks_t end);   // Called by the event queue
+    void record_wait_interval(ticks_t start, ticks_t end);   // Called by the event queue
+
+    // Busy polling, see `linux_queue_parent_t`. Called by the event queue.
+    ticks_t get_spin_budget();
+    void begin_spinning();
+    void end_spinning();
+    bool has_incoming_messages();
+    void deliver_incoming_messages();
+    void record_spin_interval(ticks_t start, ticks_t end);
 #ifndef NDEBUG
-    void initiate_shut_down(std::map<std::string, size_t> *coroutine_counts); // Can be called from any thread
+    void initiate_shut_down(std::map<std::string, coroutine_type_summary_t> *coroutine_summaries); // Can be called from any thread
 #else
     void initiate_shut_down(); // Can be called from any thread
 #endif
     void on_event(int events);
 
 private:
+    const ticks_t spin_budget;
+
     volatile bool do_shutdown;
     pthread_mutex_t do_shutdown_mutex;
     system_event_t shutdown_notify_event;
 
 #ifndef NDEBUG
-    std::map<std::string, size_t> *coroutine_counts_at_shutdown;
+    std::map<std::string, coroutine_type_summary_t> *coroutine_summaries_at_shutdown;
 #endif
 };
 
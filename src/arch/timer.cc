@@ -1,70 +1,88 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "arch/timer.hpp"
+#include "arch/runtime/runtime_stats.hpp"
 #include "arch/runtime/thread_pool.hpp"
+#include "config/args.hpp"
+#include "perfmon/perfmon.hpp"
 #include "utils.hpp"
 
-class timer_token_t : public intrusive_priority_queue_node_t<timer_token_t> {
+class timer_token_t : public intrusive_timer_wheel_node_t<timer_token_t> {
     friend class timer_handler_t;
 
 private:
-    timer_token_t() : interval_nanos(-1), next_time_in_nanos(-1), callback(NULL) { }
-
-    friend bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right);
+    timer_token_t() : interval_nanos(-1), callback(NULL) { }
 
     // The time between rings, if a repeating timer, otherwise zero.
     int64_t interval_nanos;
 
-    // The time of the next 'ring'.
-    int64_t next_time_in_nanos;
-
     // The callback we call upon each 'ring'.
     timer_callback_t *callback;
 
     DISABLE_COPYING(timer_token_t);
 };
 
-bool left_is_higher_priority(const timer_token_t *left, const timer_token_t *right) {
-    return left->next_time_in_nanos < right->next_time_in_nanos;
+// Converts a time to the first wheel tick that is not earlier than it, so that timers never ring
+// early.
+static int64_t nanos_to_wheel_tick(int64_t nanos) {
+    return (nanos + TIMER_WHEEL_TICK_NANOS - 1) / TIMER_WHEEL_TICK_NANOS;
 }
 
 timer_handler_t::timer_handler_t(linux_event_queue_t *queue)
     : timer_provider(queue),
-      expected_oneshot_time_in_nanos(0) {
+      scheduled_tick(-1),
+      token_wheel(static_cast<int64_t>(get_ticks()) / TIMER_WHEEL_TICK_NANOS) {
     // Right now, we have no tokens.  So we don't ask the timer provider to do anything for us.
 }
 
 timer_handler_t::~timer_handler_t() {
-    guarantee(token_queue.empty());
+    guarantee(token_wheel.empty());
 }
 
 void timer_handler_t::on_oneshot() {
     // If the timer_provider tends to return its callback a touch early, we don't want to make a
     // bunch of calls to it, returning a tad early over and over again, leading up to a ticks
-    // threshold.  So we bump the real time up to the threshold when processing the priority queue.
-    int64_t real_ticks = get_ticks();
-    int64_t ticks = std::max(real_ticks, expected_oneshot_time_in_nanos);
+    // threshold.  So we bump the real time up to the threshold when processing the wheel.
+    const int64_t real_ticks = get_ticks();
+    const int64_t now_tick = std::max<int64_t>(real_ticks / TIMER_WHEEL_TICK_NANOS, scheduled_tick);
+
+    // The OS timer became ready at the scheduled tick, so however much later we got here is how
+    // long the event loop was too busy to notice.
+    if (scheduled_tick != -1) {
+        const int64_t lag = real_ticks - scheduled_tick * TIMER_WHEEL_TICK_NANOS;
+        pm_eventloop_lag.record(lag > 0 ? ticks_to_secs(lag) : 0);
+    }
+    scheduled_tick = -1;
 
-    while (!token_queue.empty() && token_queue.peek()->next_time_in_nanos <= ticks) {
-        timer_token_t *token = token_queue.pop();
+    while (timer_token_t *token = token_wheel.pop_expired(now_tick)) {
+        // The callback may cancel (and thereby delete) a repeating timer, so we must not look at
+        // the token after calling it unless we know that we still own it.
+        const bool once = token->interval_nanos == 0;
 
-        // Put the repeating timer back on the queue before the callback can be called (so that it
+        // Put the repeating timer back on the wheel before the callback can be called (so that it
         // may be canceled).
-        if (token->interval_nanos != 0) {
-            token->next_time_in_nanos = real_ticks + token->interval_nanos;
-            token_queue.push(token);
+        if (!once) {
+            token_wheel.add(token, nanos_to_wheel_tick(real_ticks + token->interval_nanos));
         }
 
         token->callback->on_timer();
 
         // Delete nonrepeating timer tokens.
-        if (token->interval_nanos == 0) {
+        if (once) {
             delete token;
         }
     }
 
     // We've processed young tokens.  Now schedule a new one-shot (if necessary).
-    if (!token_queue.empty()) {
-        timer_provider.schedule_oneshot(token_queue.peek()->next_time_in_nanos, this);
+    if (!token_wheel.empty()) {
+        schedule_next_oneshot();
+    }
+}
+
+void timer_handler_t::schedule_next_oneshot() {
+    const int64_t next_tick = token_wheel.next_tick_lower_bound();
+    if (scheduled_tick == -1 || next_tick < scheduled_tick) {
+        timer_provider.schedule_oneshot(next_tick * TIMER_WHEEL_TICK_NANOS, this);
+        scheduled_tick = next_tick;
     }
 }
 
@@ -72,28 +90,25 @@ timer_token_t *timer_handler_t::add_timer_internal(const int64_t ms, timer_callb
     const int64_t nanos = ms * MILLION;
     rassert(nanos > 0);
 
-    const int64_t next_time_in_nanos = get_ticks() + nanos;
-
     timer_token_t *const token = new timer_token_t;
     token->interval_nanos = once ? 0 : nanos;
-    token->next_time_in_nanos = next_time_in_nanos;
     token->callback = callback;
 
-    const timer_token_t *top_entry = token_queue.peek();
-    token_queue.push(token);
-
-    if (top_entry == NULL || next_time_in_nanos < top_entry->next_time_in_nanos) {
-        timer_provider.schedule_oneshot(next_time_in_nanos, this);
-    }
+    token_wheel.add(token, nanos_to_wheel_tick(get_ticks() + nanos));
+    schedule_next_oneshot();
 
     return token;
 }
 
 void timer_handler_t::cancel_timer(timer_token_t *token) {
-    token_queue.remove(token);
+    token_wheel.remove(token);
+    delete token;
 
-    if (token_queue.empty()) {
+    // If timers remain, the provider may ring for a tick at which there is nothing left to do.
+    // That's cheaper than recomputing the next tick on every cancellation.
+    if (token_wheel.empty()) {
         timer_provider.unschedule_oneshot();
+        scheduled_tick = -1;
     }
 }
 
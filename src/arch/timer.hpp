@@ -2,7 +2,7 @@
 #ifndef ARCH_TIMER_HPP_
 #define ARCH_TIMER_HPP_
 
-#include "containers/intrusive_priority_queue.hpp"
+#include "containers/intrusive_timer_wheel.hpp"
 #include "arch/io/timer_provider.hpp"
 
 class timer_token_t;
@@ -14,7 +14,11 @@ struct timer_callback_t {
 
 /* This timer class uses the underlying OS timer provider to get one-shot timing events. It then
  * manages a list of application timers based on that lower level interface. Everyone who needs a
- * timer should use this class (through the thread pool). */
+ * timer should use this class (through the thread pool).
+ *
+ * Application timers are kept in a hierarchical timer wheel with a resolution of
+ * `TIMER_WHEEL_TICK_NANOS`, so adding and canceling a timer is O(1) no matter how many timers are
+ * live. The OS timer is armed for the nearest tick at which the wheel has work to do. */
 class timer_handler_t : private timer_provider_callback_t {
 public:
     explicit timer_handler_t(linux_event_queue_t *queue);
@@ -29,12 +33,16 @@ private:
     // The timer provider, a platform-dependent typedef for interfacing with the OS.
     timer_provider_t timer_provider;
 
-    // The expected time of the next on_oneshot call.  If the oneshot arrived earlier than this
-    // time, we pretend that it had arrived on time.
-    int64_t expected_oneshot_time_in_nanos;
+    // Arms the timer provider for the wheel's next tick, unless it is already armed for that tick
+    // or an earlier one.
+    void schedule_next_oneshot();
 
-    // A priority queue of timer tokens, ordered by the soonest.
-    intrusive_priority_queue_t<timer_token_t> token_queue;
+    // The tick for which the timer provider is armed, or -1 if it isn't armed.  If the oneshot
+    // arrives earlier than this tick, we pretend that it had arrived on time.
+    int64_t scheduled_tick;
+
+    // The timer tokens, filed by the tick at which they next ring.
+    intrusive_timer_wheel_t<timer_token_t> token_wheel;
 
     DISABLE_COPYING(timer_handler_t);
 };
@@ -69,12 +69,25 @@ typedef linux_tcp_bound_socket_t tcp_bound_socket_t;
 class linux_nonthrowing_tcp_listener_t;
 typedef linux_nonthrowing_tcp_listener_t non_throwing_tcp_listener_t;
 
+class linux_nonthrowing_per_thread_tcp_listener_t;
+typedef linux_nonthrowing_per_thread_tcp_listener_t nonthrowing_per_thread_tcp_listener_t;
+
+/* Says which threads a TCP listener accepts connections on. */
+enum tcp_accept_mode_t {
+    // Accept on the thread the listener was created on.
+    ACCEPT_ON_HOME_THREAD,
+    // Accept on every DB thread, see `linux_nonthrowing_per_thread_tcp_listener_t`.
+    ACCEPT_ON_EVERY_THREAD
+};
+
 class linux_tcp_listener_t;
 typedef linux_tcp_listener_t tcp_listener_t;
 
 class linux_repeated_nonthrowing_tcp_listener_t;
 typedef linux_repeated_nonthrowing_tcp_listener_t repeated_nonthrowing_tcp_listener_t;
 
+class io_account_stats_t;
+
 class linux_tcp_conn_descriptor_t;
 typedef linux_tcp_conn_descriptor_t tcp_conn_descriptor_t;
 
@@ -96,7 +109,8 @@ public:
     virtual void read_blocking(size_t offset, size_t length, void *buf) = 0;
     virtual void write_blocking(size_t offset, size_t length, const void *buf) = 0;
 
-    virtual void *create_account(int priority, int outstanding_requests_limit) = 0;
+    // `stats` may be `NULL`
+    virtual void *create_account(int priority, int outstanding_requests_limit, io_account_stats_t *stats) = 0;
     virtual void destroy_account(void *account) = 0;
 
     virtual bool coop_lock_and_check() = 0;
@@ -104,7 +118,8 @@ public:
 
 class file_account_t {
 public:
-    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS);
+    file_account_t(file_t *f, int p, int outstanding_requests_limit = UNLIMITED_OUTSTANDING_REQUESTS,
+                   io_account_stats_t *stats = NULL);
     ~file_account_t();
     void *get_account() { return account; }
 
@@ -1,8 +1,13 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "btree/btree_store.hpp"
 
+#include <algorithm>
+
+#include "btree/get_distribution.hpp"
 #include "btree/operations.hpp"
 #include "btree/secondary_operations.hpp"
+#include "btree/superblock.hpp"
+#include "concurrency/contention.hpp"
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/vector_stream.hpp"
 #include "serializer/config.hpp"
@@ -20,6 +25,11 @@ const char* sindex_not_post_constructed_exc_t::what() const throw() {
 
 sindex_not_post_constructed_exc_t::~sindex_not_post_constructed_exc_t() throw() { }
 
+// Contention profiler sites for the FIFOs that the store's read and write
+// tokens go through
+static contention_site_t main_token_contention_site("btree store main token");
+static contention_site_t sindex_token_contention_site("btree store sindex token");
+
 template <class protocol_t>
 btree_store_t<protocol_t>::btree_store_t(serializer_t *serializer,
                                          const std::string &perfmon_name,
@@ -30,6 +40,8 @@ btree_store_t<protocol_t>::btree_store_t(serializer_t *serializer,
                                          io_backender_t *io_backender,
                                          const base_path_t &base_path)
     : store_view_t<protocol_t>(protocol_t::region_t::universe()),
+      main_token_sink(&main_token_contention_site),
+      sindex_token_sink(&sindex_token_contention_site),
       perfmon_collection(),
       io_backender_(io_backender), base_path_(base_path),
       perfmon_collection_membership(parent_perfmon_collection, &perfmon_collection, perfmon_name)
@@ -141,6 +153,38 @@ void btree_store_t<protocol_t>::write(
     protocol_write(write, response, timestamp, btree.get(), txn.get(), &superblock, token_pair, interruptor);
 }
 
+/* Splits every region of `start_point` at those of `split_keys` (which must be
+sorted) that fall inside it, keeping the pieces in key order. At most
+`BACKFILL_MAX_PIECES` evenly spaced split keys are used. */
+template <class protocol_t>
+region_map_t<protocol_t, state_timestamp_t> split_backfill_start_point(
+        const region_map_t<protocol_t, state_timestamp_t> &start_point,
+        const std::vector<store_key_t> &split_keys) {
+    std::vector<store_key_t> used_keys;
+    size_t stride = split_keys.size() / BACKFILL_MAX_PIECES + 1;
+    for (size_t i = stride - 1; i < split_keys.size(); i += stride) {
+        used_keys.push_back(split_keys[i]);
+    }
+
+    std::vector<std::pair<typename protocol_t::region_t, state_timestamp_t> > pieces;
+    for (typename region_map_t<protocol_t, state_timestamp_t>::const_iterator it = start_point.begin();
+         it != start_point.end();
+         ++it) {
+        const typename protocol_t::region_t &region = it->first;
+        key_range_t rest = region.inner;
+        for (size_t i = 0; i < used_keys.size(); ++i) {
+            if (rest.left < used_keys[i] && rest.contains_key(used_keys[i])) {
+                key_range_t piece = rest;
+                piece.right = key_range_t::right_bound_t(used_keys[i]);
+                pieces.push_back(std::make_pair(typename protocol_t::region_t(region.beg, region.end, piece), it->second));
+                rest.left = used_keys[i];
+            }
+        }
+        pieces.push_back(std::make_pair(typename protocol_t::region_t(region.beg, region.end, rest), it->second));
+    }
+    return region_map_t<protocol_t, state_timestamp_t>(pieces.begin(), pieces.end());
+}
+
 // TODO: Figure out wtf does the backfill filtering, figure out wtf constricts delete range operations to hit only a certain hash-interval, figure out what filters keys.
 template <class protocol_t>
 bool btree_store_t<protocol_t>::send_backfill(
@@ -163,7 +207,17 @@ bool btree_store_t<protocol_t>::send_backfill(
     get_metainfo_internal(txn.get(), superblock->get(), &unmasked_metainfo);
     region_map_t<protocol_t, binary_blob_t> metainfo = unmasked_metainfo.mask(start_point.get_domain());
     if (send_backfill_cb->should_backfill(metainfo)) {
-        protocol_send_backfill(start_point, send_backfill_cb, superblock.get(), sindex_block.get(), btree.get(), txn.get(), progress, interruptor);
+        /* The backfill goes through the start point in pieces, one after
+        another, and reports each one to `finish_region()` when it's done. The
+        keys in the root node make for pieces of roughly equal size. */
+        refcount_superblock_t refcount_wrapper(superblock.get(), 2);
+        std::vector<store_key_t> split_keys;
+        int64_t key_count;
+        get_btree_key_distribution(btree.get(), txn.get(), &refcount_wrapper, 1, &key_count, &split_keys);
+        std::sort(split_keys.begin(), split_keys.end());
+
+        protocol_send_backfill(split_backfill_start_point(start_point, split_keys),
+                               send_backfill_cb, &refcount_wrapper, sindex_block.get(), btree.get(), txn.get(), progress, interruptor);
         return true;
     }
     return false;
@@ -13,6 +13,7 @@
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include "btree/erase_range.hpp"
+#include "btree/key_traffic.hpp"
 #include "btree/operations.hpp"
 #include "btree/secondary_operations.hpp"
 #include "buffer_cache/mirrored/config.hpp"  // TODO: Move to buffer_cache/config.hpp or something.
@@ -422,6 +423,10 @@ public:
 
     boost::ptr_map<const std::string, btree_slice_t> secondary_index_slices;
 
+    /* The protocol's read and write visitors record the keys they touch here,
+    so that distribution reads can report where the load is. */
+    key_traffic_sampler_t key_traffic;
+
     std::vector<internal_disk_backed_queue_t *> sindex_queues;
     mutex_t sindex_queue_mutex;
 
@@ -0,0 +1,44 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "btree/key_traffic.hpp"
+
+#include <algorithm>
+
+key_traffic_sampler_t::key_traffic_sampler_t()
+    : ops_since_sample(0), next_sample(0), start_time(get_ticks()) {
+    samples.reserve(KEY_TRAFFIC_SAMPLE_SIZE);
+}
+
+void key_traffic_sampler_t::add_sample(const store_key_t &key) {
+    sample_t sample;
+    sample.key = key;
+    sample.time = get_ticks();
+    if (samples.size() < KEY_TRAFFIC_SAMPLE_SIZE) {
+        samples.push_back(sample);
+    } else {
+        samples[next_sample] = sample;
+        next_sample = (next_sample + 1) % KEY_TRAFFIC_SAMPLE_SIZE;
+    }
+}
+
+void key_traffic_sampler_t::get_rates(ticks_t now, std::map<store_key_t, double> *rates_out) const {
+    if (samples.empty()) {
+        return;
+    }
+
+    /* The samples stand for the traffic since the start of the window, or
+    since the oldest sample if we've had to throw older ones away. */
+    ticks_t window_start = std::max(start_time, now - std::min(now, secs_to_ticks(KEY_TRAFFIC_WINDOW_SECS)));
+    if (samples.size() == KEY_TRAFFIC_SAMPLE_SIZE) {
+        window_start = std::max(window_start, samples[next_sample].time);
+    }
+    if (now <= window_start) {
+        return;
+    }
+    double ops_per_sample_per_sec = KEY_TRAFFIC_SAMPLE_INTERVAL / ticks_to_secs(now - window_start);
+
+    for (std::vector<sample_t>::const_iterator it = samples.begin(); it != samples.end(); ++it) {
+        if (it->time >= window_start) {
+            (*rates_out)[it->key] += ops_per_sample_per_sec;
+        }
+    }
+}
@@ -0,0 +1,53 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef BTREE_KEY_TRAFFIC_HPP_
+#define BTREE_KEY_TRAFFIC_HPP_
+
+#include <map>
+#include <vector>
+
+#include "btree/keys.hpp"
+#include "config/args.hpp"
+#include "utils.hpp"
+
+/* `key_traffic_sampler_t` keeps a sample of the keys that queries on a store
+have touched lately, so that we can tell which parts of the key space are hot.
+One in every `KEY_TRAFFIC_SAMPLE_INTERVAL` operations is recorded, and the last
+`KEY_TRAFFIC_SAMPLE_SIZE` recorded ones are kept. It isn't thread-safe; it's
+only used on the store's home thread. */
+class key_traffic_sampler_t {
+public:
+    key_traffic_sampler_t();
+
+    /* Call this once for every operation, with the first key it touches */
+    void record(const store_key_t &key) {
+        if (++ops_since_sample >= KEY_TRAFFIC_SAMPLE_INTERVAL) {
+            ops_since_sample = 0;
+            add_sample(key);
+        }
+    }
+
+    /* Adds to `rates_out` an estimate of how many operations per second have
+    touched each sampled key over the last `KEY_TRAFFIC_WINDOW_SECS`. Keys
+    that were sampled more than once get the sum. */
+    void get_rates(ticks_t now, std::map<store_key_t, double> *rates_out) const;
+
+private:
+    struct sample_t {
+        store_key_t key;
+        ticks_t time;
+    };
+
+    void add_sample(const store_key_t &key);
+
+    int ops_since_sample;
+
+    /* A ring buffer; `next_sample` is the oldest sample once it's full */
+    std::vector<sample_t> samples;
+    size_t next_sample;
+
+    ticks_t start_time;
+
+    DISABLE_COPYING(key_traffic_sampler_t);
+};
+
+#endif  // BTREE_KEY_TRAFFIC_HPP_
@@ -6,6 +6,7 @@
 #include <boost/bind.hpp>
 
 #include "arch/arch.hpp"
+#include "concurrency/contention.hpp"
 #include "do_on_thread.hpp"
 #include "serializer/serializer.hpp"
 #include "protocol_api.hpp"
@@ -14,6 +15,11 @@
  * Buffer implementation.
  */
 
+// Contention profiler sites for the blocks' locks and the FIFO that write
+// transactions go through when they begin
+static contention_site_t block_lock_contention_site("buffer cache block");
+static contention_site_t write_throttle_contention_site("buffer cache write transaction begin");
+
 // Types of snapshots
 
 // In order for snapshots to get deleted properly, they must obey the invariant that, after
@@ -183,7 +189,7 @@ mc_inner_buf_t::mc_inner_buf_t(mc_cache_t *_cache, block_id_t _block_id, file_ac
       subtree_recency(repli_timestamp_t::invalid),  // Gets initialized by load_inner_buf
       data(_cache->serializer->malloc()),
       version_id(_cache->get_min_snapshot_version(_cache->get_current_version_id())),
-      lock(),
+      lock(&block_lock_contention_site),
       refcount(0),
       do_delete(false),
       cow_refcount(0),
@@ -217,7 +223,7 @@ mc_inner_buf_t::mc_inner_buf_t(mc_cache_t *_cache, block_id_t _block_id, void *_
       data(_buf),
       version_id(_cache->get_min_snapshot_version(_cache->get_current_version_id())),
       data_token(token),
-      lock(),
+      lock(&block_lock_contention_site),
       refcount(0),
       do_delete(false),
       cow_refcount(0),
@@ -291,7 +297,7 @@ mc_inner_buf_t::mc_inner_buf_t(mc_cache_t *_cache, block_id_t _block_id, version
     : evictable_t(_cache),
       writeback_t::local_buf_t(),
       block_id(_block_id),
-      lock(),
+      lock(&block_lock_contention_site),
       refcount(0) {
 
     rassert(_snapshot_version != faux_version_id);
@@ -489,8 +495,10 @@ mc_buf_lock_t::mc_buf_lock_t(mc_transaction_t *transaction,
     // unloaded), or else inner_buf could be selected for deletion from the cache, then recreated,
     // and we'd have two inner_bufs corresponding to the same block id floating around.
 
+    ++transaction->num_blocks_acquired;
     if (!inner_buf) {
         /* The buf isn't in the cache and must be loaded from disk */
+        ++transaction->num_blocks_loaded;
         // We are either not snapshotted or our snapshot is consistent with the latest version;
         // otherwise, the inner buf would be around to keep track of the snapshotted version. Thus,
         // it is not wasteful to load the latest version if should_load is true.
@@ -508,6 +516,7 @@ mc_buf_lock_t::mc_buf_lock_t(mc_transaction_t *transaction,
             // The inner_buf doesn't have any data currently. We need the data though,
             // so load it!
             inner_buf->data.init_malloc(transaction->cache->serializer);
+            ++transaction->num_blocks_loaded;
 
             // Please keep in mind that this is blocking...
             inner_buf->load_inner_buf(true, transaction->get_io_account());
@@ -892,6 +901,8 @@ mc_transaction_t::mc_transaction_t(mc_cache_t *_cache, access_t _access, int _ex
       snapshotted(false),
       cache_account(NULL),
       num_buf_locks_acquired(0),
+      num_blocks_acquired(0),
+      num_blocks_loaded(0),
       is_writeback_transaction(false),
       durability(_durability),
       token_pair(NULL) {
@@ -924,6 +935,8 @@ mc_transaction_t::mc_transaction_t(mc_cache_t *_cache, access_t _access, UNUSED
       snapshotted(false),
       cache_account(NULL),
       num_buf_locks_acquired(0),
+      num_blocks_acquired(0),
+      num_blocks_loaded(0),
       is_writeback_transaction(false),
       durability(WRITE_DURABILITY_INVALID),
       token_pair(NULL) {
@@ -949,6 +962,8 @@ mc_transaction_t::mc_transaction_t(mc_cache_t *_cache, access_t _access, UNUSED
     snapshotted(false),
     cache_account(NULL),
     num_buf_locks_acquired(0),
+    num_blocks_acquired(0),
+    num_blocks_loaded(0),
     is_writeback_transaction(true),
     durability(WRITE_DURABILITY_INVALID),
     token_pair(NULL) {
@@ -1137,7 +1152,8 @@ mc_cache_t::mc_cache_t(serializer_t *_serializer,
     num_live_non_writeback_transactions(0),
     to_pulse_when_last_transaction_commits(NULL),
     read_ahead_registered(false),
-    next_snapshot_version(mc_inner_buf_t::faux_version_id+1) {
+    next_snapshot_version(mc_inner_buf_t::faux_version_id+1),
+    co_begin_coro_fifo_(&write_throttle_contention_site) {
 
     {
         on_thread_t thread_switcher(serializer->home_thread());
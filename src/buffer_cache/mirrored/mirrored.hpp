@@ -247,6 +247,12 @@ public:
 
     void set_token_pair(write_token_pair_t *_token_pair);
 
+    /* How many blocks the transaction has acquired so far, and how many of
+    those weren't in the cache and had to be read from disk. Query profiles
+    report these. */
+    int64_t get_num_blocks_acquired() const { return num_blocks_acquired; }
+    int64_t get_num_blocks_loaded() const { return num_blocks_loaded; }
+
 private:
     void register_buf_snapshot(mc_inner_buf_t *inner_buf, mc_inner_buf_t::buf_snapshot_t *snap);
 
@@ -272,6 +278,9 @@ private:
 
     int64_t num_buf_locks_acquired;
 
+    int64_t num_blocks_acquired;
+    int64_t num_blocks_loaded;
+
     const bool is_writeback_transaction;
 
     const write_durability_t durability;
@@ -110,6 +110,9 @@ public:
         inner_transaction.set_token_pair(token_pair); 
     }
 
+    int64_t get_num_blocks_acquired() const { return inner_transaction.get_num_blocks_acquired(); }
+    int64_t get_num_blocks_loaded() const { return inner_transaction.get_num_blocks_loaded(); }
+
 private:
     bool snapshotted; // Disables CRC checks
 
@@ -0,0 +1,191 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/administration/auto_sharder.hpp"
+
+#include "clustering/administration/logger.hpp"
+#include "clustering/administration/suggester.hpp"
+#include "clustering/suggester/suggester.hpp"
+
+auto_sharder_t::auto_sharder_t(
+        const boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> > &_semilattice_view,
+        const clone_ptr_t<watchable_t<std::map<peer_id_t, cluster_directory_metadata_t> > > &_directory_view,
+        namespace_repo_t<rdb_protocol_t> *_namespace_repo,
+        const machine_id_t &_us) :
+    semilattice_view(_semilattice_view),
+    directory_view(_directory_view),
+    namespace_repo(_namespace_repo),
+    us(_us),
+    check_in_progress(false),
+    timer(AUTO_SHARD_CHECK_INTERVAL_MS, this)
+{ }
+
+void auto_sharder_t::on_ring() {
+    if (!check_in_progress) {
+        check_in_progress = true;
+        coro_t::spawn_sometime(boost::bind(&auto_sharder_t::check_tables, this,
+                                           auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+namespace {
+
+bool has_pinnings(const namespace_semilattice_metadata_t<rdb_protocol_t> &ns) {
+    if (ns.primary_pinnings.in_conflict() || ns.secondary_pinnings.in_conflict()) {
+        return true;
+    }
+    const region_map_t<rdb_protocol_t, machine_id_t> &primaries = ns.primary_pinnings.get();
+    for (region_map_t<rdb_protocol_t, machine_id_t>::const_iterator it = primaries.begin(); it != primaries.end(); ++it) {
+        if (!it->second.is_nil()) {
+            return true;
+        }
+    }
+    const region_map_t<rdb_protocol_t, std::set<machine_id_t> > &secondaries = ns.secondary_pinnings.get();
+    for (region_map_t<rdb_protocol_t, std::set<machine_id_t> >::const_iterator it = secondaries.begin(); it != secondaries.end(); ++it) {
+        if (!it->second.empty()) {
+            return true;
+        }
+    }
+    return false;
+}
+
+}  // namespace
+
+void auto_sharder_t::check_tables(auto_drainer_t::lock_t keepalive) {
+    /* Decide which tables to look at up front; the metadata may change while
+    we're doing distribution reads. */
+    std::map<namespace_id_t, nonoverlapping_regions_t<rdb_protocol_t> > candidates;
+    {
+        cluster_semilattice_metadata_t metadata = semilattice_view->get();
+        const namespaces_semilattice_metadata_t<rdb_protocol_t>::namespace_map_t &namespaces =
+            metadata.rdb_namespaces->namespaces;
+        ticks_t now = get_ticks();
+        for (namespaces_semilattice_metadata_t<rdb_protocol_t>::namespace_map_t::const_iterator it = namespaces.begin();
+             it != namespaces.end();
+             ++it) {
+            if (it->second.is_deleted()) {
+                continue;
+            }
+            const namespace_semilattice_metadata_t<rdb_protocol_t> &ns = it->second.get_ref();
+            if (ns.shards.in_conflict() || ns.shards.get().size() < 2 || has_pinnings(ns)) {
+                continue;
+            }
+            std::map<namespace_id_t, ticks_t>::const_iterator last_change = last_change_times.find(it->first);
+            if (last_change != last_change_times.end() &&
+                now - last_change->second < secs_to_ticks(AUTO_SHARD_MIN_CHANGE_INTERVAL_SECS)) {
+                continue;
+            }
+            candidates.insert(std::make_pair(it->first, ns.shards.get()));
+        }
+    }
+
+    try {
+        for (std::map<namespace_id_t, nonoverlapping_regions_t<rdb_protocol_t> >::const_iterator it = candidates.begin();
+             it != candidates.end();
+             ++it) {
+            nonoverlapping_regions_t<rdb_protocol_t> new_shards;
+            if (suggest_new_shards(it->first, it->second, &new_shards, keepalive.get_drain_signal())) {
+                apply_new_shards(it->first, it->second, new_shards);
+            }
+        }
+    } catch (const interrupted_exc_t &) {
+        return;
+    }
+
+    check_in_progress = false;
+}
+
+bool auto_sharder_t::suggest_new_shards(const namespace_id_t &ns_id,
+                                        const nonoverlapping_regions_t<rdb_protocol_t> &shards,
+                                        nonoverlapping_regions_t<rdb_protocol_t> *shards_out,
+                                        signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t) {
+    rdb_protocol_t::distribution_read_response_t distribution;
+    try {
+        namespace_repo_t<rdb_protocol_t>::access_t ns_access(namespace_repo, ns_id, interruptor);
+        /* This goes to the primaries, which see all the writes and the
+        up-to-date reads. */
+        rdb_protocol_t::read_t read(rdb_protocol_t::distribution_read_t(AUTO_SHARD_DISTRIBUTION_DEPTH,
+                                                                        AUTO_SHARD_DISTRIBUTION_LIMIT));
+        rdb_protocol_t::read_response_t response;
+        ns_access.get_namespace_if()->read(read, &response, order_token_t::ignore, interruptor);
+        distribution = boost::get<rdb_protocol_t::distribution_read_response_t>(response.response);
+    } catch (const cannot_perform_query_exc_t &) {
+        /* Some shard is unavailable; try again next time. */
+        return false;
+    }
+
+    std::vector<store_key_t> current_split_points;
+    for (nonoverlapping_regions_t<rdb_protocol_t>::iterator it = shards.begin(); it != shards.end(); ++it) {
+        if (it->inner.left != store_key_t::min()) {
+            current_split_points.push_back(it->inner.left);
+        }
+    }
+    std::sort(current_split_points.begin(), current_split_points.end());
+
+    std::vector<store_key_t> new_split_points = suggest_split_points(
+        distribution.key_counts, distribution.traffic, shards.size(), SHARD_SPLIT_LOAD_WEIGHT);
+    if (new_split_points.size() != current_split_points.size() ||
+        new_split_points == current_split_points) {
+        return false;
+    }
+
+    double current_imbalance = estimate_shard_imbalance(
+        distribution.key_counts, distribution.traffic, current_split_points, SHARD_SPLIT_LOAD_WEIGHT);
+    double new_imbalance = estimate_shard_imbalance(
+        distribution.key_counts, distribution.traffic, new_split_points, SHARD_SPLIT_LOAD_WEIGHT);
+    if (current_imbalance < AUTO_SHARD_IMBALANCE_THRESHOLD ||
+        new_imbalance * AUTO_SHARD_MIN_IMPROVEMENT > current_imbalance) {
+        return false;
+    }
+
+    std::vector<rdb_protocol_t::region_t> regions;
+    store_key_t left = store_key_t::min();
+    for (size_t i = 0; i < new_split_points.size(); ++i) {
+        key_range_t range;
+        range.left = left;
+        range.right = key_range_t::right_bound_t(new_split_points[i]);
+        regions.push_back(rdb_protocol_t::region_t(range));
+        left = new_split_points[i];
+    }
+    key_range_t last_range;
+    last_range.left = left;
+    regions.push_back(rdb_protocol_t::region_t(last_range));
+
+    bool success = shards_out->set_regions(regions);
+    guarantee(success);
+
+    logINF("Resharding table %s to even out its load: imbalance %.2f, expected %.2f afterwards",
+           uuid_to_str(ns_id).c_str(), current_imbalance, new_imbalance);
+    return true;
+}
+
+void auto_sharder_t::apply_new_shards(const namespace_id_t &ns_id,
+                                      const nonoverlapping_regions_t<rdb_protocol_t> &old_shards,
+                                      const nonoverlapping_regions_t<rdb_protocol_t> &new_shards) {
+    cluster_semilattice_metadata_t metadata = semilattice_view->get();
+    {
+        cow_ptr_t<namespaces_semilattice_metadata_t<rdb_protocol_t> >::change_t change(&metadata.rdb_namespaces);
+        namespaces_semilattice_metadata_t<rdb_protocol_t>::namespace_map_t::iterator it =
+            change.get()->namespaces.find(ns_id);
+        if (it == change.get()->namespaces.end() || it->second.is_deleted()) {
+            return;
+        }
+        namespace_semilattice_metadata_t<rdb_protocol_t> *ns = it->second.get_mutable();
+
+        /* Someone else may have changed the table while we were reading */
+        if (ns->shards.in_conflict() || !(ns->shards.get() == old_shards) || has_pinnings(*ns)) {
+            return;
+        }
+        ns->shards = ns->shards.make_new_version(new_shards, us);
+    }
+
+    try {
+        fill_in_blueprints(&metadata, directory_view->get(), us, false);
+    } catch (const missing_machine_exc_t &) {
+        logWRN("Not resharding table %s because a server is missing",
+               uuid_to_str(ns_id).c_str());
+        return;
+    }
+
+    semilattice_view->join(metadata);
+    last_change_times[ns_id] = get_ticks();
+}
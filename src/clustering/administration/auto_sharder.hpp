@@ -0,0 +1,74 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_AUTO_SHARDER_HPP_
+#define CLUSTERING_ADMINISTRATION_AUTO_SHARDER_HPP_
+
+#include <map>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/shared_ptr.hpp>
+
+#include "arch/timing.hpp"
+#include "clustering/administration/metadata.hpp"
+#include "clustering/administration/namespace_interface_repository.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/watchable.hpp"
+#include "rdb_protocol/protocol.hpp"
+#include "rpc/semilattice/view.hpp"
+
+/* `auto_sharder_t` periodically moves the shard boundaries of every table
+with more than one shard so that each shard gets a similar share of the keys
+and of the recent load, as measured by a distribution read (see
+`suggest_split_points()`). It keeps the number of shards the same and leaves
+alone tables that have pinnings, since it would have to throw them away.
+
+Moving a boundary means backfilling the keys in between, so a table is only
+reshaped if its shards are at least `AUTO_SHARD_IMBALANCE_THRESHOLD` times as
+uneven as they should be and the new boundaries make them
+`AUTO_SHARD_MIN_IMPROVEMENT` times less so, and at most once every
+`AUTO_SHARD_MIN_CHANGE_INTERVAL_SECS`. The sharder only looks at rdb tables.
+It is off by default; when it's turned on, it should be on just one server in
+the cluster, or servers will fight over the boundaries. */
+class auto_sharder_t : private repeating_timer_callback_t {
+public:
+    auto_sharder_t(
+        const boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> > &semilattice_view,
+        const clone_ptr_t<watchable_t<std::map<peer_id_t, cluster_directory_metadata_t> > > &directory_view,
+        namespace_repo_t<rdb_protocol_t> *namespace_repo,
+        const machine_id_t &us);
+
+private:
+    void on_ring();
+
+    /* `check_tables()` runs in a coroutine. Only one runs at a time. */
+    void check_tables(auto_drainer_t::lock_t keepalive);
+
+    /* Returns true and puts the new shards in `shards_out` if `ns_id` should
+    be resharded. */
+    bool suggest_new_shards(const namespace_id_t &ns_id,
+                            const nonoverlapping_regions_t<rdb_protocol_t> &shards,
+                            nonoverlapping_regions_t<rdb_protocol_t> *shards_out,
+                            signal_t *interruptor)
+        THROWS_ONLY(interrupted_exc_t);
+
+    void apply_new_shards(const namespace_id_t &ns_id,
+                          const nonoverlapping_regions_t<rdb_protocol_t> &old_shards,
+                          const nonoverlapping_regions_t<rdb_protocol_t> &new_shards);
+
+    boost::shared_ptr<semilattice_readwrite_view_t<cluster_semilattice_metadata_t> > semilattice_view;
+    clone_ptr_t<watchable_t<std::map<peer_id_t, cluster_directory_metadata_t> > > directory_view;
+    namespace_repo_t<rdb_protocol_t> *namespace_repo;
+    machine_id_t us;
+
+    /* When we last changed the shards of each table */
+    std::map<namespace_id_t, ticks_t> last_change_times;
+
+    bool check_in_progress;
+
+    auto_drainer_t drainer;
+    repeating_timer_t timer;
+
+    DISABLE_COPYING(auto_sharder_t);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_AUTO_SHARDER_HPP_ */
@@ -2012,20 +2012,29 @@ void admin_cluster_link_t::do_admin_create_table(const admin_command_parser_t::c
         port = 0;
     }
 
+    uint64_t cpu_sharding_factor = DEFAULT_CPU_SHARDING_FACTOR;
+    if (data.params.find("cpu-sharding-factor") != data.params.end()) {
+        std::string factor_str = guarantee_param_0(data.params, "cpu-sharding-factor");
+        if (!strtou64_strict(factor_str, 10, &cpu_sharding_factor) ||
+            cpu_sharding_factor < 1 || cpu_sharding_factor > MAX_CPU_SHARDING_FACTOR) {
+            throw admin_parse_exc_t(strprintf("cpu-sharding-factor must be a number between 1 and %d", MAX_CPU_SHARDING_FACTOR));
+        }
+    }
+
     if (database_info->path[0] != "databases") {
         throw admin_parse_exc_t("specified database is not a database: " + database_id);
     }
 
     if (protocol == "rdb") {
         cow_ptr_t<namespaces_semilattice_metadata_t<rdb_protocol_t> >::change_t change(&cluster_metadata.rdb_namespaces);
-        new_id = do_admin_create_table_internal(name, port, primary, primary_key, database, change.get());
+        new_id = do_admin_create_table_internal(name, port, primary, primary_key, database, cpu_sharding_factor, change.get());
     } else if (protocol == "memcached") {
         cow_ptr_t<namespaces_semilattice_metadata_t<memcached_protocol_t> >::change_t change(&cluster_metadata.memcached_namespaces);
-        new_id = do_admin_create_table_internal(name, port, primary, primary_key, database, change.get());
+        new_id = do_admin_create_table_internal(name, port, primary, primary_key, database, cpu_sharding_factor, change.get());
 #ifndef NO_DUMMY
     } else if (protocol == "dummy") {
         cow_ptr_t<namespaces_semilattice_metadata_t<mock::dummy_protocol_t> >::change_t change(&cluster_metadata.dummy_namespaces);
-        new_id = do_admin_create_table_internal(name, port, primary, primary_key, database, change.get());
+        new_id = do_admin_create_table_internal(name, port, primary, primary_key, database, cpu_sharding_factor, change.get());
 #endif
     } else {
         throw admin_parse_exc_t("unrecognized protocol: " + protocol);
@@ -2042,6 +2051,7 @@ namespace_id_t admin_cluster_link_t::do_admin_create_table_internal(const name_s
                                                                     const datacenter_id_t& primary,
                                                                     const std::string& primary_key,
                                                                     const database_id_t& database,
+                                                                    int cpu_sharding_factor,
                                                                     namespaces_semilattice_metadata_t<protocol_t> *ns) {
     namespace_id_t id = generate_uuid();
     namespace_semilattice_metadata_t<protocol_t> *obj = ns->namespaces[id].get_mutable();
@@ -2058,6 +2068,9 @@ namespace_id_t admin_cluster_link_t::do_admin_create_table_internal(const name_s
     obj->port.get_mutable() = port;
     obj->port.upgrade_version(change_request_id);
 
+    obj->cpu_sharding_factor.get_mutable() = cpu_sharding_factor;
+    obj->cpu_sharding_factor.upgrade_version(change_request_id);
+
     nonoverlapping_regions_t<protocol_t> shards;
     bool add_success = shards.add_region(protocol_t::region_t::universe());
     guarantee(add_success);
@@ -165,6 +165,7 @@ private:
                                                   const datacenter_id_t& primary,
                                                   const std::string& primary_key,
                                                   const database_id_t& database,
+                                                  int cpu_sharding_factor,
                                                   namespaces_semilattice_metadata_t<protocol_t> *ns);
 
     template <class obj_map>
@@ -85,7 +85,7 @@ const char *set_database_usage = "<TABLE> <DATABASE>";
 const char *set_auth_usage = "<KEY>";
 const char *unset_auth_usage = "";
 // TODO: fix this once multiple protocols are supported again
-const char *create_table_usage = "<NAME> --database <DATABASE> [--primary <DATACENTER>] [--primary-key <KEY>]";
+const char *create_table_usage = "<NAME> --database <DATABASE> [--primary <DATACENTER>] [--primary-key <KEY>] [--cpu-sharding-factor <N>]";
 // const char *create_table_usage = "<NAME> --port <PORT> --protocol <PROTOCOL> --database <DATABASE> [--primary <DATACENTER>]";
 const char *create_datacenter_usage = "<NAME>";
 const char *create_database_usage = "<NAME>";
@@ -134,6 +134,7 @@ const char *create_table_name_option = "<NAME>";
 // const char *create_table_protocol_option = "--protocol <PROTOCOL>";
 const char *create_table_primary_option = "--primary <DATACENTER>";
 const char *create_table_primary_key_option = "--primary-key <KEY>";
+const char *create_table_cpu_sharding_factor_option = "--cpu-sharding-factor <N>";
 const char *create_table_database_option = "--database <DATABASE>";
 const char *create_datacenter_name_option = "<NAME>";
 const char *create_database_name_option = "<NAME>";
@@ -183,6 +184,7 @@ const char *create_table_name_option_desc = "the name of the new table";
 // const char *create_table_protocol_option_desc = "the protocol for the table to use, either 'rdb' or 'memcached'";
 const char *create_table_primary_option_desc = "the primary datacenter of the new table, this datacenter will host the master replicas of each shard";
 const char *create_table_primary_key_option_desc = "the field to use as the primary key in the new table";
+const char *create_table_cpu_sharding_factor_option_desc = "how many stores, each on its own thread, every machine keeps for the new table; this can't be changed later";
 const char *create_table_database_option_desc = "the database that the table will exist in, client requests must be directed to this database";
 const char *create_datacenter_name_option_desc = "the name of the new datacenter";
 const char *create_database_name_option_desc = "the name of the new database";
@@ -640,6 +642,7 @@ void admin_command_parser_t::build_command_descriptions() {
     // info->add_flag("port", 1, true);
     info->add_flag("primary", 1, false)->add_option("!datacenter");
     info->add_flag("primary-key", 1, false);
+    info->add_flag("cpu-sharding-factor", 1, false);
     info->add_flag("database", 1, true)->add_option("!database");
 
     info = add_command(create_datacenter_command, create_datacenter_command, create_datacenter_usage, &admin_cluster_link_t::do_admin_create_datacenter, &commands);
@@ -1275,6 +1278,7 @@ void admin_command_parser_t::do_admin_help(const command_data_t& data) {
                 options.push_back(std::make_pair(create_table_database_option, create_table_database_option_desc));
                 options.push_back(std::make_pair(create_table_primary_option, create_table_primary_option_desc));
                 options.push_back(std::make_pair(create_table_primary_key_option, create_table_primary_key_option_desc));
+                options.push_back(std::make_pair(create_table_cpu_sharding_factor_option, create_table_cpu_sharding_factor_option_desc));
                 do_usage_internal(helps, options, "create table - add a new table to the cluster", console_mode);
             } else if (subcommand == "datacenter") {
                 helps.push_back(admin_help_info_t(create_datacenter_command, create_datacenter_usage, create_datacenter_description));
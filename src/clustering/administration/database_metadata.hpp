@@ -45,6 +45,7 @@ public:
 };
 
 RDB_MAKE_SEMILATTICE_JOINABLE_1(databases_semilattice_metadata_t, databases);
+RDB_MAKE_SEMILATTICE_DELTA_1(databases_semilattice_metadata_t, databases);
 RDB_MAKE_EQUALITY_COMPARABLE_1(databases_semilattice_metadata_t, databases);
 
 //json adapter concept for databases_semilattice_metadata_t
@@ -43,6 +43,7 @@ public:
 };
 
 RDB_MAKE_SEMILATTICE_JOINABLE_1(datacenters_semilattice_metadata_t, datacenters);
+RDB_MAKE_SEMILATTICE_DELTA_1(datacenters_semilattice_metadata_t, datacenters);
 RDB_MAKE_EQUALITY_COMPARABLE_1(datacenters_semilattice_metadata_t, datacenters);
 
 //json adapter concept for datacenters_semilattice_metadata_t
@@ -0,0 +1,49 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/administration/http/contention_app.hpp"
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "concurrency/contention.hpp"
+#include "http/json.hpp"
+
+contention_http_app_t::contention_http_app_t() { }
+
+void contention_http_app_t::get_root(scoped_cJSON_t *json_out) {
+    std::vector<std::pair<std::string, contention_stats_t> > stats = get_contention_stats();
+
+    json_out->reset(cJSON_CreateObject());
+    json_out->AddItemToObject("enabled", cJSON_CreateBool(global_profile_contention));
+    scoped_cJSON_t sites(cJSON_CreateArray());
+    for (auto it = stats.begin(); it != stats.end(); ++it) {
+        const contention_stats_t &s = it->second;
+        scoped_cJSON_t site(cJSON_CreateObject());
+        site.AddItemToObject("site", cJSON_CreateString(it->first.c_str()));
+        site.AddItemToObject("waits", cJSON_CreateNumber(s.waits));
+        site.AddItemToObject("wait_time", cJSON_CreateNumber(ticks_to_secs(s.wait_ticks)));
+        site.AddItemToObject("mean_wait", cJSON_CreateNumber(
+            s.waits == 0 ? 0.0 : ticks_to_secs(s.wait_ticks) / s.waits));
+        site.AddItemToObject("max_wait", cJSON_CreateNumber(ticks_to_secs(s.max_wait_ticks)));
+        site.AddItemToObject("waiters", cJSON_CreateNumber(s.waiters));
+        site.AddItemToObject("max_waiters", cJSON_CreateNumber(s.max_waiters));
+        sites.AddItemToArray(site.release());
+    }
+    json_out->AddItemToObject("sites", sites.release());
+}
+
+http_res_t contention_http_app_t::handle(const http_req_t &req) {
+    if (req.method != GET) {
+        return http_res_t(HTTP_METHOD_NOT_ALLOWED);
+    }
+
+    std::string resource = req.resource.as_string();
+    if (resource != "/" && resource != "") {
+        return http_res_t(HTTP_NOT_FOUND);
+    }
+
+    scoped_cJSON_t json(NULL);
+    get_root(&json);
+
+    return http_json_res(json.get());
+}
@@ -0,0 +1,21 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_CONTENTION_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_CONTENTION_APP_HPP_
+
+#include "http/http.hpp"
+#include "http/json/cJSON.hpp"
+
+/* Serves this server's contention profiler stats (see
+`concurrency/contention.hpp`): whether the profiler is on, and the sites that
+have been waited at, most total wait time first. Times are in seconds. */
+class contention_http_app_t : public http_json_app_t {
+public:
+    contention_http_app_t();
+    http_res_t handle(const http_req_t &);
+    void get_root(scoped_cJSON_t *json_out);
+
+private:
+    DISABLE_COPYING(contention_http_app_t);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_CONTENTION_APP_HPP_ */
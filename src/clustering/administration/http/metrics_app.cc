@@ -0,0 +1,75 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/administration/http/metrics_app.hpp"
+
+#include <set>
+#include <string>
+
+#include "errors.hpp"
+#include <boost/tokenizer.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "config/args.hpp"
+#include "perfmon/collect.hpp"
+#include "perfmon/text.hpp"
+
+metrics_http_app_t::metrics_http_app_t() : snapshot_time(0) { }
+
+metrics_http_app_t::~metrics_http_app_t() { }
+
+scoped_ptr_t<perfmon_result_t> metrics_http_app_t::get_snapshot() {
+    assert_thread();
+    // Scrapes that come in while a snapshot is being taken wait for it instead
+    // of taking their own.
+    mutex_t::acq_t acq(&snapshot_mutex);
+    const ticks_t now = get_ticks();
+    if (!snapshot.has()
+        || now - snapshot_time > static_cast<ticks_t>(METRICS_SNAPSHOT_MAX_AGE_MS) * MILLION) {
+        snapshot = perfmon_get_stats();
+        snapshot_time = now;
+    }
+    return scoped_ptr_t<perfmon_result_t>(new perfmon_result_t(*snapshot));
+}
+
+http_res_t metrics_http_app_t::handle(const http_req_t &req) {
+    if (req.method != GET) {
+        return http_res_t(HTTP_METHOD_NOT_ALLOWED);
+    }
+
+    std::string resource = req.resource.as_string();
+    if (resource != "/" && resource != "") {
+        return http_res_t(HTTP_NOT_FOUND);
+    }
+
+    typedef boost::escaped_list_separator<char> separator_t;
+    typedef boost::tokenizer<separator_t> tokenizer_t;
+    separator_t commas("\\", ",", "");
+
+    std::set<std::string> filter_paths;
+    for (auto it = req.query_params.begin(); it != req.query_params.end(); ++it) {
+        if (it->key != "filter") {
+            return http_error_res("Invalid parameter: " + it->key + "=" + it->val);
+        }
+        try {
+            tokenizer_t t(it->val, commas);
+            for (tokenizer_t::const_iterator s = t.begin(); s != t.end(); ++s) {
+                filter_paths.insert(*s);
+            }
+        } catch (const boost::escaped_list_error &e) {
+            return http_error_res("Boost tokenizer error: " + std::string(e.what())
+                                  + " (" + it->key + "=" + it->val + ")");
+        }
+    }
+
+    std::string body;
+    {
+        on_thread_t th(home_thread());
+        scoped_ptr_t<perfmon_result_t> stats = get_snapshot();
+        if (!filter_paths.empty()) {
+            perfmon_filter_t filter(filter_paths);
+            filter.filter(&stats);
+        }
+        body = perfmon_result_to_text(*stats, "rethinkdb");
+    }
+
+    return http_res_t(HTTP_OK, "text/plain; version=0.0.4", body);
+}
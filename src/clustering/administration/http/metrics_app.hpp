@@ -0,0 +1,37 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_
+#define CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_
+
+#include "concurrency/mutex.hpp"
+#include "containers/scoped.hpp"
+#include "http/http.hpp"
+
+class perfmon_result_t;
+
+/* Serves this server's stats at /metrics in the text format that Prometheus
+scrapes (see `perfmon/text.hpp`). Unlike /ajax/stat, it doesn't ask the other
+servers for their stats: it reads the local perfmons directly, and it reuses the
+stats it read for up to `METRICS_SNAPSHOT_MAX_AGE_MS`, so frequent scrapes cost
+next to nothing. Like /ajax/stat, it takes a `filter` query parameter of
+comma-separated paths of regular expressions, such as
+`filter=runtime/eventloop_lag,contention`. */
+class metrics_http_app_t : public http_app_t, public home_thread_mixin_t {
+public:
+    metrics_http_app_t();
+    ~metrics_http_app_t();
+
+    http_res_t handle(const http_req_t &req);
+
+private:
+    /* Returns a copy of the latest snapshot of the stats, taking a new one if
+    it's too old */
+    scoped_ptr_t<perfmon_result_t> get_snapshot();
+
+    mutex_t snapshot_mutex;
+    scoped_ptr_t<perfmon_result_t> snapshot;
+    ticks_t snapshot_time;
+
+    DISABLE_COPYING(metrics_http_app_t);
+};
+
+#endif /* CLUSTERING_ADMINISTRATION_HTTP_METRICS_APP_HPP_ */
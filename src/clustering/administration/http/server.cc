@@ -1,12 +1,14 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/administration/http/server.hpp"
 
+#include "clustering/administration/http/contention_app.hpp"
 #include "clustering/administration/http/cyanide.hpp"
 #include "clustering/administration/http/directory_app.hpp"
 #include "clustering/administration/http/distribution_app.hpp"
 #include "clustering/administration/http/issues_app.hpp"
 #include "clustering/administration/http/last_seen_app.hpp"
 #include "clustering/administration/http/log_app.hpp"
+#include "clustering/administration/http/metrics_app.hpp"
 #include "clustering/administration/http/progress_app.hpp"
 #include "clustering/administration/http/semilattice_app.hpp"
 #include "clustering/administration/http/stat_app.hpp"
@@ -44,8 +46,10 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
         namespace_repo_t<rdb_protocol_t> *_rdb_namespace_repo,
         admin_tracker_t *_admin_tracker,
         http_app_t *reql_app,
+        http_app_t *slow_query_app,
         uuid_u _us,
-        std::string path)
+        std::string path,
+        tcp_accept_mode_t accept_mode)
 {
     std::set<std::string> white_list;
     white_list.insert("/cluster.css");
@@ -232,6 +236,8 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
     progress_app.init(new progress_app_t(_directory_metadata, mbox_manager));
     distribution_app.init(new distribution_app_t(metadata_field(&cluster_semilattice_metadata_t::memcached_namespaces, _semilattice_metadata), _namespace_repo,
                                                  metadata_field(&cluster_semilattice_metadata_t::rdb_namespaces, _semilattice_metadata), _rdb_namespace_repo));
+    contention_app.init(new contention_http_app_t);
+    metrics_app.init(new metrics_http_app_t);
 
 #ifndef NDEBUG
     cyanide_app.init(new cyanide_http_app_t);
@@ -248,6 +254,8 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
     ajax_routes["semilattice"] = cluster_semilattice_app.get();
     ajax_routes["auth"] = auth_semilattice_app.get();
     ajax_routes["reql"] = reql_app;
+    ajax_routes["slow_queries"] = slow_query_app;
+    ajax_routes["contention"] = contention_app.get();
     DEBUG_ONLY_CODE(ajax_routes["cyanide"] = cyanide_app.get());
 
     std::map<std::string, http_json_app_t *> default_views;
@@ -263,9 +271,10 @@ administrative_http_server_manager_t::administrative_http_server_manager_t(
 
     std::map<std::string, http_app_t *> root_routes;
     root_routes["ajax"] = ajax_routing_app.get();
+    root_routes["metrics"] = metrics_app.get();
     root_routing_app.init(new routing_http_app_t(file_app.get(), root_routes));
 
-    server.init(new http_server_t(local_addresses, port, root_routing_app.get()));
+    server.init(new http_server_t(local_addresses, port, root_routing_app.get(), accept_mode));
 }
 
 administrative_http_server_manager_t::~administrative_http_server_manager_t() {
@@ -23,10 +23,12 @@ class directory_http_app_t;
 class issues_http_app_t;
 class stat_http_app_t;
 class last_seen_http_app_t;
+class metrics_http_app_t;
 class log_http_app_t;
 class progress_app_t;
 class stat_manager_t;
 class distribution_app_t;
+class contention_http_app_t;
 class cyanide_http_app_t;
 class combining_http_app_t;
 
@@ -45,8 +47,10 @@ public:
         namespace_repo_t<rdb_protocol_t> *_rdb_namespace_repo,
         admin_tracker_t *_admin_tracker,
         http_app_t *reql_app,
+        http_app_t *slow_query_app,
         uuid_u _us,
-        std::string _path);
+        std::string _path,
+        tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD);
     ~administrative_http_server_manager_t();
 
     int get_port() const;
@@ -63,6 +67,8 @@ private:
     scoped_ptr_t<progress_app_t> progress_app;
     scoped_ptr_t<distribution_app_t> distribution_app;
     scoped_ptr_t<combining_http_app_t> combining_app;
+    scoped_ptr_t<contention_http_app_t> contention_app;
+    scoped_ptr_t<metrics_http_app_t> metrics_app;
 #ifndef NDEBUG
     scoped_ptr_t<cyanide_http_app_t> cyanide_app;
 #endif
@@ -27,6 +27,7 @@
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/logger.hpp"
 #include "clustering/administration/persist.hpp"
+#include "concurrency/contention.hpp"
 #include "logger.hpp"
 #include "extproc/spawner.hpp"
 #include "mock/dummy_protocol.hpp"
@@ -308,18 +309,21 @@ public:
                  const std::vector<host_and_port_t> &_joins,
                  service_address_ports_t _ports,
                  std::string _web_assets,
-                 boost::optional<std::string> _config_file):
+                 boost::optional<std::string> _config_file,
+                 const std::vector<base_path_t> &_stripe_paths):
         spawner_info(_spawner_info),
         joins(&_joins),
         ports(_ports),
         web_assets(_web_assets),
-        config_file(_config_file) { }
+        config_file(_config_file),
+        stripe_paths(_stripe_paths) { }
 
     extproc::spawner_info_t *spawner_info;
     const std::vector<host_and_port_t> *joins;
     service_address_ports_t ports;
     std::string web_assets;
     boost::optional<std::string> config_file;
+    std::vector<base_path_t> stripe_paths;
 };
 
 // Used for options that don't take parameters, such as --help or --exit-failure, tells whether the
@@ -494,6 +498,19 @@ int offseted_port(const int port, const int port_offset) {
     return port == 0 ? 0 : port + port_offset;
 }
 
+slow_query_log_config_t get_slow_query_log_config(const std::map<std::string, options::values_t> &opts) {
+    const int threshold_ms = get_single_int(opts, "--slow-query-threshold-ms");
+    if (threshold_ms < 0) {
+        throw std::runtime_error("ERROR: --slow-query-threshold-ms must not be negative");
+    }
+    const int sample_every = get_single_int(opts, "--slow-query-sample-every");
+    if (sample_every < 0) {
+        throw std::runtime_error("ERROR: --slow-query-sample-every must not be negative");
+    }
+    return slow_query_log_config_t(threshold_ms, sample_every,
+                                   exists_option(opts, "--log-slow-queries"));
+}
+
 service_address_ports_t get_service_address_ports(const std::map<std::string, options::values_t> &opts) {
     const int port_offset = get_single_int(opts, "--port-offset");
     return service_address_ports_t(get_local_addresses(all_options(opts, "--bind")),
@@ -506,7 +523,13 @@ service_address_ports_t get_service_address_ports(const std::map<std::string, op
                                    exists_option(opts, "--no-http-admin"),
                                    offseted_port(get_single_int(opts, "--http-port"), port_offset),
                                    offseted_port(get_single_int(opts, "--driver-port"), port_offset),
-                                   port_offset);
+                                   port_offset,
+                                   exists_option(opts, "--rebalance-client-connections"),
+                                   exists_option(opts, "--accept-on-every-thread")
+                                       ? ACCEPT_ON_EVERY_THREAD : ACCEPT_ON_HOME_THREAD,
+                                   exists_option(opts, "--cluster-compression"),
+                                   exists_option(opts, "--auto-shard"),
+                                   get_slow_query_log_config(opts));
 }
 
 
@@ -686,6 +709,7 @@ void run_rethinkdb_serve(const base_path_t &base_path,
         *result_out = serve(serve_info.spawner_info,
                             &io_backender,
                             base_path,
+                            serve_info.stripe_paths,
                             cluster_metadata_file.get(),
                             auth_metadata_file.get(),
                             look_up_peers_addresses(*serve_info.joins),
@@ -697,6 +721,10 @@ void run_rethinkdb_serve(const base_path_t &base_path,
     } catch (const metadata_persistence::file_in_use_exc_t &ex) {
         logINF("Directory '%s' is in use by another rethinkdb process.\n", base_path.path().c_str());
         *result_out = false;
+    } catch (const metadata_persistence::file_format_exc_t &ex) {
+        logERR("The metadata file in directory '%s' has an unrecognized format. "
+               "It may have been written by a newer version of RethinkDB.\n", base_path.path().c_str());
+        *result_out = false;
     } catch (const host_lookup_exc_t &ex) {
         logERR("%s\n", ex.what());
         *result_out = false;
@@ -785,12 +813,17 @@ options::help_section_t get_log_options(std::vector<options::option_t> *options_
 }
 
 
-options::help_section_t get_file_options(std::vector<options::option_t> *options_out) {
+options::help_section_t get_file_options(bool serving, std::vector<options::option_t> *options_out) {
     options::help_section_t help("File path options");
     options_out->push_back(options::option_t(options::names_t("--directory", "-d"),
                                              options::OPTIONAL,
                                              "rethinkdb_data"));
     help.add("-d [ --directory ] path", "specify directory to store data and metadata");
+    if (serving) {
+        options_out->push_back(options::option_t(options::names_t("--stripe-directory"),
+                                                 options::OPTIONAL_REPEAT));
+        help.add("--stripe-directory path", "another directory to store table data in, ideally on another device; each new table is spread over the data directory and the stripe directories");
+    }
     options_out->push_back(options::option_t(options::names_t("--io-threads"),
                                              options::OPTIONAL,
                                              strprintf("%d", DEFAULT_MAX_CONCURRENT_IO_REQUESTS)));
@@ -859,6 +892,10 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              strprintf("%d", port_defaults::peer_port)));
     help.add("--cluster-port port", "port for receiving connections from other nodes");
 
+    options_out->push_back(options::option_t(options::names_t("--cluster-compression"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--cluster-compression", "compress large messages to other nodes that also use this option");
+
 #ifndef NDEBUG
     options_out->push_back(options::option_t(options::names_t("--client-port"),
                                              options::OPTIONAL,
@@ -871,6 +908,14 @@ options::help_section_t get_network_options(const bool join_required, std::vecto
                                              strprintf("%d", port_defaults::reql_port)));
     help.add("--driver-port port", "port for rethinkdb protocol client drivers");
 
+    options_out->push_back(options::option_t(options::names_t("--rebalance-client-connections"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--rebalance-client-connections", "move idle client driver connections off of busy threads");
+
+    options_out->push_back(options::option_t(options::names_t("--accept-on-every-thread"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--accept-on-every-thread", "accept driver, memcached and web connections on every thread using SO_REUSEPORT (needs Linux 3.9 or later)");
+
     options_out->push_back(options::option_t(options::names_t("--port-offset", "-o"),
                                              options::OPTIONAL,
                                              strprintf("%d", port_defaults::port_offset)));
@@ -889,6 +934,10 @@ options::help_section_t get_cpu_options(std::vector<options::option_t> *options_
                                              options::OPTIONAL,
                                              strprintf("%d", get_cpu_count())));
     help.add("-c [ --cores ] n", "the number of cores to use");
+    options_out->push_back(options::option_t(options::names_t("--busy-poll-usecs"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--busy-poll-usecs n", "spin for up to n microseconds waiting for work before putting an idle thread to sleep; uses more CPU for lower latency (0 disables)");
     return help;
 }
 
@@ -903,6 +952,66 @@ MUST_USE bool parse_cores_option(const std::map<std::string, options::values_t>
     return true;
 }
 
+/* Checks that the stripe directories exist and gets them ready for use. */
+MUST_USE bool parse_stripe_directory_options(const std::map<std::string, options::values_t> &opts,
+                                             std::vector<base_path_t> *stripe_paths_out) {
+    const std::vector<std::string> &paths = all_options(opts, "--stripe-directory");
+    for (auto it = paths.begin(); it != paths.end(); ++it) {
+        base_path_t stripe_path(*it);
+        if (!check_existence(stripe_path)) {
+            fprintf(stderr, "ERROR: The stripe directory '%s' does not exist.\n", stripe_path.path().c_str());
+            return false;
+        }
+        recreate_temporary_directory(stripe_path);
+        stripe_path.make_absolute();
+        stripe_paths_out->push_back(stripe_path);
+    }
+    return true;
+}
+
+MUST_USE bool parse_busy_poll_option(const std::map<std::string, options::values_t> &opts,
+                                     int *spin_usecs_out) {
+    int spin_usecs = get_single_int(opts, "--busy-poll-usecs");
+    if (spin_usecs < 0 || spin_usecs > MAX_EVENT_LOOP_SPIN_USECS) {
+        fprintf(stderr, "ERROR: number specified for busy poll microseconds must be between 0 and %d\n", MAX_EVENT_LOOP_SPIN_USECS);
+        return false;
+    }
+    *spin_usecs_out = spin_usecs;
+    return true;
+}
+
+options::help_section_t get_sharding_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Sharding options");
+    options_out->push_back(options::option_t(options::names_t("--auto-shard"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--auto-shard", "move shard boundaries now and then to even out the keys and load of each table's shards; use it on only one server in the cluster");
+    return help;
+}
+
+options::help_section_t get_slow_query_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Slow query log options");
+    options_out->push_back(options::option_t(options::names_t("--slow-query-threshold-ms"),
+                                             options::OPTIONAL,
+                                             strprintf("%d", DEFAULT_SLOW_QUERY_THRESHOLD_MS)));
+    help.add("--slow-query-threshold-ms ms", "record driver requests that take at least this long in the slow query log (/ajax/slow_queries)");
+    options_out->push_back(options::option_t(options::names_t("--slow-query-sample-every"),
+                                             options::OPTIONAL,
+                                             "0"));
+    help.add("--slow-query-sample-every n", "also record one in n of the other requests, picked at random (0 records none)");
+    options_out->push_back(options::option_t(options::names_t("--log-slow-queries"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--log-slow-queries", "write the slow requests to the log file as well");
+    return help;
+}
+
+options::help_section_t get_profiling_options(std::vector<options::option_t> *options_out) {
+    options::help_section_t help("Profiling options");
+    options_out->push_back(options::option_t(options::names_t("--profile-contention"),
+                                             options::OPTIONAL_NO_PARAMETER));
+    help.add("--profile-contention", "record how long requests wait for the busiest locks and queues (in the contention stats and /ajax/contention)");
+    return help;
+}
+
 options::help_section_t get_service_options(std::vector<options::option_t> *options_out) {
     options::help_section_t help("Service options");
     options_out->push_back(options::option_t(options::names_t("--pid-file"),
@@ -939,7 +1048,7 @@ options::help_section_t get_help_options(std::vector<options::option_t> *options
 
 void get_rethinkdb_create_options(std::vector<options::help_section_t> *help_out,
                                   std::vector<options::option_t> *options_out) {
-    help_out->push_back(get_file_options(options_out));
+    help_out->push_back(get_file_options(false, options_out));
     help_out->push_back(get_machine_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -949,10 +1058,13 @@ void get_rethinkdb_create_options(std::vector<options::help_section_t> *help_out
 
 void get_rethinkdb_serve_options(std::vector<options::help_section_t> *help_out,
                                  std::vector<options::option_t> *options_out) {
-    help_out->push_back(get_file_options(options_out));
+    help_out->push_back(get_file_options(true, options_out));
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_sharding_options(options_out));
+    help_out->push_back(get_slow_query_options(options_out));
+    help_out->push_back(get_profiling_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -964,6 +1076,8 @@ void get_rethinkdb_proxy_options(std::vector<options::help_section_t> *help_out,
                                  std::vector<options::option_t> *options_out) {
     help_out->push_back(get_network_options(true, options_out));
     help_out->push_back(get_web_options(options_out));
+    help_out->push_back(get_slow_query_options(options_out));
+    help_out->push_back(get_profiling_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1037,11 +1151,14 @@ void get_rethinkdb_import_options(std::vector<options::help_section_t> *help_out
 
 void get_rethinkdb_porcelain_options(std::vector<options::help_section_t> *help_out,
                                      std::vector<options::option_t> *options_out) {
-    help_out->push_back(get_file_options(options_out));
+    help_out->push_back(get_file_options(true, options_out));
     help_out->push_back(get_machine_options(options_out));
     help_out->push_back(get_network_options(false, options_out));
     help_out->push_back(get_web_options(options_out));
     help_out->push_back(get_cpu_options(options_out));
+    help_out->push_back(get_sharding_options(options_out));
+    help_out->push_back(get_slow_query_options(options_out));
+    help_out->push_back(get_profiling_options(options_out));
     help_out->push_back(get_service_options(options_out));
     help_out->push_back(get_setuser_options(options_out));
     help_out->push_back(get_help_options(options_out));
@@ -1215,6 +1332,8 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
 
         options::verify_option_counts(options, opts);
 
+        global_profile_contention = exists_option(opts, "--profile-contention");
+
         set_user_group(opts);
 
         base_path_t base_path(get_single_option(opts, "--directory"));
@@ -1230,6 +1349,11 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        int spin_usecs;
+        if (!parse_busy_poll_option(opts, &spin_usecs)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -1245,6 +1369,11 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         base_path.make_absolute();
         initialize_logfile(opts, base_path);
 
+        std::vector<base_path_t> stripe_paths;
+        if (!parse_stripe_directory_options(opts, &stripe_paths)) {
+            return EXIT_FAILURE;
+        }
+
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
         }
@@ -1262,7 +1391,8 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
         extproc::spawner_t::create(&spawner_info);
 
         serve_info_t serve_info(&spawner_info, joins, address_ports, web_path,
-                                get_optional_option(opts, "--config-file"));
+                                get_optional_option(opts, "--config-file"),
+                                stripe_paths);
 
         bool result;
         run_in_thread_pool(boost::bind(&run_rethinkdb_serve, base_path,
@@ -1271,7 +1401,7 @@ int main_rethinkdb_serve(int argc, char *argv[]) {
                                        static_cast<machine_id_t*>(NULL),
                                        static_cast<cluster_semilattice_metadata_t*>(NULL),
                                        &result),
-                           num_workers);
+                           num_workers, spin_usecs);
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
         output_named_error(ex, help);
@@ -1340,6 +1470,8 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
 
         options::verify_option_counts(options, opts);
 
+        global_profile_contention = exists_option(opts, "--profile-contention");
+
         const std::vector<host_and_port_t> joins = parse_join_options(opts);
 
         if (joins.empty()) {
@@ -1376,7 +1508,8 @@ int main_rethinkdb_proxy(int argc, char *argv[]) {
         extproc::spawner_t::create(&spawner_info);
 
         serve_info_t serve_info(&spawner_info, joins, address_ports, web_path,
-                                get_optional_option(opts, "--config-file"));
+                                get_optional_option(opts, "--config-file"),
+                                std::vector<base_path_t>());
 
         bool result;
         run_in_thread_pool(boost::bind(&run_rethinkdb_proxy, serve_info, &result),
@@ -1536,6 +1669,8 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
 
         options::verify_option_counts(options, opts);
 
+        global_profile_contention = exists_option(opts, "--profile-contention");
+
         set_user_group(opts);
 
         base_path_t base_path(get_single_option(opts, "--directory"));
@@ -1558,6 +1693,11 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
             return EXIT_FAILURE;
         }
 
+        int spin_usecs;
+        if (!parse_busy_poll_option(opts, &spin_usecs)) {
+            return EXIT_FAILURE;
+        }
+
         int max_concurrent_io_requests;
         if (!parse_io_threads_option(opts, &max_concurrent_io_requests)) {
             return EXIT_FAILURE;
@@ -1579,6 +1719,11 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         base_path.make_absolute();
         initialize_logfile(opts, base_path);
 
+        std::vector<base_path_t> stripe_paths;
+        if (!parse_stripe_directory_options(opts, &stripe_paths)) {
+            return EXIT_FAILURE;
+        }
+
         if (check_pid_file(opts) != EXIT_SUCCESS) {
             return EXIT_FAILURE;
         }
@@ -1596,7 +1741,8 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
         extproc::spawner_t::create(&spawner_info);
 
         serve_info_t serve_info(&spawner_info, joins, address_ports, web_path,
-                                get_optional_option(opts, "--config-file"));
+                                get_optional_option(opts, "--config-file"),
+                                stripe_paths);
 
         bool result;
         run_in_thread_pool(boost::bind(&run_rethinkdb_porcelain,
@@ -1606,7 +1752,7 @@ int main_rethinkdb_porcelain(int argc, char *argv[]) {
                                        new_directory,
                                        serve_info,
                                        &result),
-                           num_workers);
+                           num_workers, spin_usecs);
 
         return result ? EXIT_SUCCESS : EXIT_FAILURE;
     } catch (const options::named_error_t &ex) {
@@ -1,9 +1,11 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/administration/main/file_based_svs_by_namespace.hpp"
 
+#include <algorithm>
+
 #include "clustering/immediate_consistency/branch/multistore.hpp"
-#include "clustering/reactor/reactor.hpp"
 #include "serializer/config.hpp"
+#include "serializer/log/log_serializer.hpp"
 #include "serializer/translator.hpp"
 #include "utils.hpp"
 
@@ -13,11 +15,12 @@
 template <class protocol_t>
 struct store_args_t {
     store_args_t(io_backender_t *_io_backender, const base_path_t &_base_path,
-            namespace_id_t _namespace_id, int64_t _cache_size,
+            namespace_id_t _namespace_id, int64_t _cache_size, int _first_thread,
             perfmon_collection_t *_serializers_perfmon_collection, typename
             protocol_t::context_t *_ctx)
         : io_backender(_io_backender), base_path(_base_path),
           namespace_id(_namespace_id), cache_size(_cache_size),
+          first_thread(_first_thread),
           serializers_perfmon_collection(_serializers_perfmon_collection),
           ctx(_ctx)
     { }
@@ -26,6 +29,7 @@ struct store_args_t {
     base_path_t base_path;
     namespace_id_t namespace_id;
     int64_t cache_size;
+    int first_thread;
     perfmon_collection_t *serializers_perfmon_collection;
     typename protocol_t::context_t *ctx;
 };
@@ -45,12 +49,7 @@ void do_construct_existing_store(int i,
     // TODO: Exceptions?  Can exceptions happen, and then this doesn't
     // catch it, and the caller doesn't handle it.
 
-    // TODO: A problem with this is that all the stores get
-    // created on low-number threads.  What if there are
-    // multiple namespaces?  We need a global
-    // thread-distributor that evenly distributes stores about
-    // threads.
-    on_thread_t th(i % num_db_threads);
+    on_thread_t th((store_args.first_thread + i) % num_db_threads);
 
     // TODO: Can we pass serializers_perfmon_collection across threads like this?
     typename protocol_t::store_t *store = new typename protocol_t::store_t(multiplexer->proxies[i], hash_shard_perfmon_name(i),
@@ -67,8 +66,7 @@ void do_create_new_store(int i,
                          int num_db_threads,
                          stores_lifetimer_t<protocol_t> *stores_out,
                          store_view_t<protocol_t> **store_views) {
-    // TODO: See the todo about thread distribution in do_construct_existing_store.  It is applicable here, too.
-    on_thread_t th(i % num_db_threads);
+    on_thread_t th((store_args.first_thread + i) % num_db_threads);
 
     typename protocol_t::store_t *store = new typename protocol_t::store_t(multiplexer->proxies[i], hash_shard_perfmon_name(i),
                                                                            store_args.cache_size, true, store_args.serializers_perfmon_collection,
@@ -77,12 +75,58 @@ void do_create_new_store(int i,
     store_views[i] = store;
 }
 
+template <class protocol_t>
+file_based_svs_by_namespace_t<protocol_t>::file_based_svs_by_namespace_t(
+        io_backender_t *io_backender,
+        const base_path_t &base_path,
+        const std::vector<base_path_t> &stripe_paths)
+    : io_backender_(io_backender), next_thread_(0), next_directory_(0) {
+    directories_.push_back(base_path);
+    directories_.insert(directories_.end(), stripe_paths.begin(), stripe_paths.end());
+}
+
+/* Opens (or, if `create` is true, creates) the serializer files at
+`filepaths`, and gives them to `stores_out`. The file openers are returned in
+`openers_out` because new files still have to be moved to their permanent
+locations once the stores are set up. */
+template <class protocol_t>
+void open_serializer_files(const std::vector<serializer_filepath_t> &filepaths,
+                           bool create,
+                           io_backender_t *io_backender,
+                           perfmon_collection_t *serializers_perfmon_collection,
+                           stores_lifetimer_t<protocol_t> *stores_out,
+                           scoped_array_t<scoped_ptr_t<filepath_file_opener_t> > *openers_out,
+                           std::vector<standard_serializer_t *> *serializers_out) {
+    const int num_files = filepaths.size();
+    openers_out->init(num_files);
+    stores_out->files()->init(num_files);
+    for (int i = 0; i < num_files; ++i) {
+        (*openers_out)[i].init(new filepath_file_opener_t(filepaths[i], io_backender));
+        if (create) {
+            standard_serializer_t::create((*openers_out)[i].get(),
+                                          standard_serializer_t::static_config_t());
+        }
+
+        // TODO: Could we handle failure when loading the serializer?  Right now, we don't.
+        serializer_file_t *file = new serializer_file_t(serializers_perfmon_collection,
+                                                        num_files == 1 ? "" : strprintf("file_%d", i));
+        (*stores_out->files())[i].init(file);
+        standard_serializer_t *serializer
+            = new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
+                                        (*openers_out)[i].get(),
+                                        &file->perfmon_collection);
+        file->serializer.init(serializer);
+        serializers_out->push_back(serializer);
+    }
+}
+
 template <class protocol_t>
 void
 file_based_svs_by_namespace_t<protocol_t>::get_svs(
             perfmon_collection_t *serializers_perfmon_collection,
             namespace_id_t namespace_id,
             int64_t cache_size,
+            int cpu_sharding_factor,
             stores_lifetimer_t<protocol_t> *stores_out,
             scoped_ptr_t<multistore_ptr_t<protocol_t> > *svs_out,
             typename protocol_t::context_t *ctx) {
@@ -96,30 +140,37 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
     // exists and then assume it exists or does not exist when
     // loading or creating it.
 
-    // TODO: We should use N slices on M serializers, not N slices
-    // on N serializers.
-
-    const int num_stores = CLUSTER_CPU_SHARDING_FACTOR;
-
-    const serializer_filepath_t serializer_filepath = file_name_for(namespace_id);
+    guarantee(cpu_sharding_factor >= 1 && cpu_sharding_factor <= MAX_CPU_SHARDING_FACTOR);
+
+    // A table's files are numbered from zero. The first one is created last,
+    // so if it exists, all of them do.
+    std::vector<serializer_filepath_t> filepaths;
+    for (;;) {
+        const std::string name = file_name_for(namespace_id, filepaths.size());
+        base_path_t directory("");
+        if (!find_file(name, &directory)) {
+            break;
+        }
+        filepaths.push_back(serializer_filepath_t(directory, name));
+    }
 
-    scoped_ptr_t<standard_serializer_t> serializer;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer;
-
-    int res = access(serializer_filepath.permanent_path().c_str(), R_OK | W_OK);
-    store_args_t<protocol_t> store_args(io_backender_, base_path_,
-            namespace_id, cache_size, serializers_perfmon_collection, ctx);
-    if (res == 0) {
-        filepath_file_opener_t file_opener(serializer_filepath, io_backender_);
-
-        // TODO: Could we handle failure when loading the serializer?  Right now, we don't.
-        serializer.init(new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
-                                                  &file_opener,
-                                                  serializers_perfmon_collection));
-
-        std::vector<standard_serializer_t *> ptrs;
-        ptrs.push_back(serializer.get());
-        multiplexer.init(new serializer_multiplexer_t(ptrs));
+    scoped_array_t<scoped_ptr_t<filepath_file_opener_t> > file_openers;
+    std::vector<standard_serializer_t *> serializers;
+
+    if (!filepaths.empty()) {
+        // If some of the files are missing, because one of the directories
+        // wasn't given this time, the multiplexer fails with an error saying so.
+        open_serializer_files(filepaths, false, io_backender_, serializers_perfmon_collection,
+                              stores_out, &file_openers, &serializers);
+        multiplexer.init(new serializer_multiplexer_t(serializers));
+
+        // The file decides how many stores there are, whatever the table's
+        // metadata says now.
+        const int num_stores = multiplexer->proxies.size();
+        store_args_t<protocol_t> store_args(io_backender_, directories_[0],
+                namespace_id, cache_size, pick_first_thread(num_stores),
+                serializers_perfmon_collection, ctx);
 
         // The files already exist, thus we don't create them.
         scoped_array_t<store_view_t<protocol_t> *> store_views(num_stores);
@@ -136,20 +187,24 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
 
         svs_out->init(new multistore_ptr_t<protocol_t>(store_views.data(), num_stores));
     } else {
+        const int num_stores = cpu_sharding_factor;
+        store_args_t<protocol_t> store_args(io_backender_, directories_[0],
+                namespace_id, cache_size, pick_first_thread(num_stores),
+                serializers_perfmon_collection, ctx);
         stores_out->stores()->init(num_stores);
 
-        filepath_file_opener_t file_opener(serializer_filepath, io_backender_);
-        standard_serializer_t::create(&file_opener,
-                                      standard_serializer_t::static_config_t());
-
-        serializer.init(new standard_serializer_t(standard_serializer_t::dynamic_config_t(),
-                                                  &file_opener,
-                                                  serializers_perfmon_collection));
+        // A file with no stores on it would be useless.
+        const int num_files = std::min<int>(num_stores, directories_.size());
+        const int first_directory = pick_first_directory(num_files);
+        for (int i = 0; i < num_files; ++i) {
+            filepaths.push_back(serializer_filepath_t(directories_[(first_directory + i) % directories_.size()],
+                                                      file_name_for(namespace_id, i)));
+        }
 
-        std::vector<standard_serializer_t *> ptrs;
-        ptrs.push_back(serializer.get());
-        serializer_multiplexer_t::create(ptrs, num_stores);
-        multiplexer.init(new serializer_multiplexer_t(ptrs));
+        open_serializer_files(filepaths, true, io_backender_, serializers_perfmon_collection,
+                              stores_out, &file_openers, &serializers);
+        serializer_multiplexer_t::create(serializers, num_stores);
+        multiplexer.init(new serializer_multiplexer_t(serializers));
 
 
         // TODO: How do we specify what the stores' regions are?
@@ -157,7 +212,6 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
         // TODO: Exceptions?  Can exceptions happen, and then store_views' values would leak.
 
         // The files do not exist, create them.
-        // TODO: This should use pmap.
         scoped_array_t<store_view_t<protocol_t> *> store_views(num_stores);
 
         pmap(num_stores, boost::bind(do_create_new_store<protocol_t>,
@@ -181,25 +235,69 @@ file_based_svs_by_namespace_t<protocol_t>::get_svs(
                                  &write_token,
                                  &dummy_interruptor);
 
-        // Finally, the store is created.
-        file_opener.move_serializer_file_to_permanent_location();
+        // Finally, the store is created. The first file goes last, because
+        // its existence is what says that the table has been created.
+        for (int i = num_files - 1; i >= 0; --i) {
+            file_openers[i]->move_serializer_file_to_permanent_location();
+        }
     }
 
-    stores_out->serializer()->init(serializer.release());
     stores_out->multiplexer()->init(multiplexer.release());
 }
 
+template <class protocol_t>
+int file_based_svs_by_namespace_t<protocol_t>::pick_first_thread(int num_stores) {
+    assert_thread();
+    const int first_thread = next_thread_;
+    next_thread_ = (next_thread_ + num_stores) % get_num_db_threads();
+    return first_thread;
+}
+
+template <class protocol_t>
+int file_based_svs_by_namespace_t<protocol_t>::pick_first_directory(int num_files) {
+    assert_thread();
+    const int first_directory = next_directory_;
+    next_directory_ = (next_directory_ + num_files) % directories_.size();
+    return first_directory;
+}
+
 template <class protocol_t>
 void file_based_svs_by_namespace_t<protocol_t>::destroy_svs(namespace_id_t namespace_id) {
     // TODO: Handle errors?  It seems like we can't really handle the error so let's just ignore it?
-    const std::string filepath = file_name_for(namespace_id).permanent_path();
-    const int res = ::unlink(filepath.c_str());
-    guarantee_err(res == 0 || errno == ENOENT, "unlink failed for file %s", filepath.c_str());
+
+    // The first file goes first, so that if we get killed part way through,
+    // the table doesn't look like it still exists.
+    for (int i = 0; ; ++i) {
+        const std::string name = file_name_for(namespace_id, i);
+        base_path_t directory("");
+        if (!find_file(name, &directory)) {
+            break;
+        }
+        const std::string filepath = serializer_filepath_t(directory, name).permanent_path();
+        const int res = ::unlink(filepath.c_str());
+        guarantee_err(res == 0 || errno == ENOENT, "unlink failed for file %s", filepath.c_str());
+    }
+}
+
+template <class protocol_t>
+std::string file_based_svs_by_namespace_t<protocol_t>::file_name_for(namespace_id_t namespace_id, int file_number) {
+    if (file_number == 0) {
+        return uuid_to_str(namespace_id);
+    } else {
+        return strprintf("%s_%d", uuid_to_str(namespace_id).c_str(), file_number);
+    }
 }
 
 template <class protocol_t>
-serializer_filepath_t file_based_svs_by_namespace_t<protocol_t>::file_name_for(namespace_id_t namespace_id) {
-    return serializer_filepath_t(base_path_, uuid_to_str(namespace_id));
+bool file_based_svs_by_namespace_t<protocol_t>::find_file(const std::string &name,
+                                                          base_path_t *directory_out) const {
+    for (auto it = directories_.begin(); it != directories_.end(); ++it) {
+        if (access(serializer_filepath_t(*it, name).permanent_path().c_str(), R_OK | W_OK) == 0) {
+            *directory_out = *it;
+            return true;
+        }
+    }
+    return false;
 }
 
 #include "mock/dummy_protocol.hpp"
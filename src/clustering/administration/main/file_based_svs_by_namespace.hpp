@@ -3,28 +3,62 @@
 #define CLUSTERING_ADMINISTRATION_MAIN_FILE_BASED_SVS_BY_NAMESPACE_HPP_
 
 #include <string>
+#include <vector>
 
 #include "clustering/administration/reactor_driver.hpp"
 
+/* Keeps each table's data in serializer files. A table has as many files as it
+has stores, up to the number of data directories (`base_path` plus
+`stripe_paths`), and the files of one table go in different directories, so a
+busy table can use the bandwidth of several devices. Stores are assigned to
+files round-robin by `serializer_multiplexer_t`.
+
+Files are looked for in every data directory, so they can be moved from one
+directory to another while the server is stopped. When a directory is added,
+new tables start using it; existing tables keep the files they were created
+with. */
 template <class protocol_t>
-class file_based_svs_by_namespace_t : public svs_by_namespace_t<protocol_t> {
+class file_based_svs_by_namespace_t : public svs_by_namespace_t<protocol_t>, public home_thread_mixin_t {
 public:
-    file_based_svs_by_namespace_t(io_backender_t *io_backender, const base_path_t& base_path) : io_backender_(io_backender), base_path_(base_path) { }
+    file_based_svs_by_namespace_t(io_backender_t *io_backender, const base_path_t& base_path,
+                                  const std::vector<base_path_t> &stripe_paths = std::vector<base_path_t>());
 
     void get_svs(perfmon_collection_t *serializers_perfmon_collection, namespace_id_t namespace_id,
                  int64_t cache_size,
+                 int cpu_sharding_factor,
                  stores_lifetimer_t<protocol_t> *stores_out,
                  scoped_ptr_t<multistore_ptr_t<protocol_t> > *svs_out,
                  typename protocol_t::context_t *);
 
     void destroy_svs(namespace_id_t namespace_id);
 
-    serializer_filepath_t file_name_for(namespace_id_t namespace_id);
-
 private:
+    /* The name of the `file_number`th file of a table. The first one is named
+    after the table alone, as it was when tables only had one file. */
+    static std::string file_name_for(namespace_id_t namespace_id, int file_number);
+
+    /* Looks for a file in all of the data directories. */
+    bool find_file(const std::string &name, base_path_t *directory_out) const;
+
+    /* Returns the thread for the first of `num_stores` new stores, and moves
+    `next_thread_` past them. */
+    int pick_first_thread(int num_stores);
+
+    /* Likewise for the directory of the first of `num_files` new files. */
+    int pick_first_directory(int num_files);
 
     io_backender_t *io_backender_;
-    const base_path_t base_path_;
+
+    /* `base_path` followed by the stripe paths */
+    std::vector<base_path_t> directories_;
+
+    /* The thread to put the next table's first store on. Each table's stores
+    go on consecutive threads starting from here, so that tables don't all
+    crowd onto the low-numbered threads. */
+    int next_thread_;
+
+    /* The same thing for the directories of new tables' files */
+    int next_directory_;
 
     DISABLE_COPYING(file_based_svs_by_namespace_t);
 };
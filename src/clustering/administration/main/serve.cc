@@ -7,6 +7,7 @@
 #include "arch/os_signal.hpp"
 #include "clustering/administration/admin_tracker.hpp"
 #include "clustering/administration/auto_reconnect.hpp"
+#include "clustering/administration/auto_sharder.hpp"
 #include "clustering/administration/http/server.hpp"
 #include "clustering/administration/issues/local.hpp"
 #include "clustering/administration/logger.hpp"
@@ -67,6 +68,7 @@ bool do_serve(
     bool i_am_a_server,
     // NB. filepath & persistent_file are used iff i_am_a_server is true.
     const base_path_t &base_path,
+    const std::vector<base_path_t> &stripe_paths,
     metadata_persistence::cluster_persistent_file_t *cluster_metadata_file,
     metadata_persistence::auth_persistent_file_t *auth_metadata_file,
     const peer_address_set_t &joins,
@@ -116,6 +118,9 @@ bool do_serve(
         semilattice_manager_t<auth_semilattice_metadata_t> auth_manager_cluster(&auth_manager_client, auth_metadata);
         message_multiplexer_t::client_t::run_t auth_manager_client_run(&auth_manager_client, &auth_manager_cluster);
 
+        perfmon_membership_t semilattice_stats_membership(&get_global_perfmon_collection(), semilattice_manager_cluster.get_stats(), "semilattice");
+        perfmon_membership_t auth_semilattice_stats_membership(&get_global_perfmon_collection(), auth_manager_cluster.get_stats(), "auth_semilattice");
+
         log_server_t log_server(&mailbox_manager, &log_writer);
 
         // Initialize the stat manager before the directory manager so that we
@@ -141,6 +146,7 @@ bool do_serve(
         directory_write_manager_t<cluster_directory_metadata_t> directory_write_manager(&directory_manager_client, our_root_directory_variable.get_watchable());
         directory_read_manager_t<cluster_directory_metadata_t> directory_read_manager(connectivity_cluster.get_connectivity_service());
         message_multiplexer_t::client_t::run_t directory_manager_client_run(&directory_manager_client, &directory_read_manager);
+        perfmon_membership_t directory_stats_membership(&get_global_perfmon_collection(), directory_write_manager.get_stats(), "directory");
 
         network_logger_t network_logger(
             connectivity_cluster.get_me(),
@@ -153,7 +159,8 @@ bool do_serve(
                                                                address_ports.port,
                                                                &message_multiplexer_run,
                                                                address_ports.client_port,
-                                                               &heartbeat_manager);
+                                                               &heartbeat_manager,
+                                                               address_ports.cluster_compression);
 
         // If (0 == port), then we asked the OS to give us a port number.
         if (address_ports.port != 0) {
@@ -227,11 +234,18 @@ bool do_serve(
         //This is an annoying chicken and egg problem here
         rdb_ctx.ns_repo = &rdb_namespace_repo;
 
+        scoped_ptr_t<auto_sharder_t> auto_sharder(
+            !i_am_a_server || !address_ports.auto_shard ? NULL :
+                new auto_sharder_t(semilattice_manager_cluster.get_root_view(),
+                                   directory_read_manager.get_root_view(),
+                                   &rdb_namespace_repo,
+                                   machine_id));
+
         {
             // Reactor drivers
 
             // Dummy
-            file_based_svs_by_namespace_t<mock::dummy_protocol_t> dummy_svs_source(io_backender, base_path);
+            file_based_svs_by_namespace_t<mock::dummy_protocol_t> dummy_svs_source(io_backender, base_path, stripe_paths);
             scoped_ptr_t<reactor_driver_t<mock::dummy_protocol_t> > dummy_reactor_driver(!i_am_a_server ? NULL :
                 new reactor_driver_t<mock::dummy_protocol_t>(
                     base_path,
@@ -255,7 +269,7 @@ bool do_serve(
                         &our_root_directory_variable));
 
             // Memcached
-            file_based_svs_by_namespace_t<memcached_protocol_t> memcached_svs_source(io_backender, base_path);
+            file_based_svs_by_namespace_t<memcached_protocol_t> memcached_svs_source(io_backender, base_path, stripe_paths);
             scoped_ptr_t<reactor_driver_t<memcached_protocol_t> > memcached_reactor_driver(!i_am_a_server ? NULL :
                 new reactor_driver_t<memcached_protocol_t>(
                     base_path,
@@ -279,7 +293,7 @@ bool do_serve(
                         &our_root_directory_variable));
 
             // RDB
-            file_based_svs_by_namespace_t<rdb_protocol_t> rdb_svs_source(io_backender, base_path);
+            file_based_svs_by_namespace_t<rdb_protocol_t> rdb_svs_source(io_backender, base_path, stripe_paths);
             scoped_ptr_t<reactor_driver_t<rdb_protocol_t> > rdb_reactor_driver(!i_am_a_server ? NULL :
                 new reactor_driver_t<rdb_protocol_t>(
                     base_path,
@@ -310,7 +324,8 @@ bool do_serve(
                     address_ports.port_offset,
                     &dummy_namespace_repo,
                     &local_issue_tracker,
-                    &perfmon_repo);
+                    &perfmon_repo,
+                    address_ports.accept_mode);
 
                 parser_maker_t<memcached_protocol_t, memcache_listener_t> memcached_parser_maker(
                     &mailbox_manager,
@@ -319,12 +334,16 @@ bool do_serve(
                     address_ports.port_offset,
                     &memcached_namespace_repo,
                     &local_issue_tracker,
-                    &perfmon_repo);
+                    &perfmon_repo,
+                    address_ports.accept_mode);
 
                 rdb_protocol::query_http_app_t rdb_parser(semilattice_manager_cluster.get_root_view(), &rdb_namespace_repo);
 
                 query2_server_t rdb_pb2_server(address_ports.local_addresses,
-                                               address_ports.reql_port, &rdb_ctx);
+                                               address_ports.reql_port, &rdb_ctx,
+                                               address_ports.rebalance_client_conns,
+                                               address_ports.accept_mode,
+                                               address_ports.slow_queries);
                 logINF("Listening for client driver connections on port %d\n",
                        rdb_pb2_server.get_port());
 
@@ -360,8 +379,10 @@ bool do_serve(
                                 &rdb_namespace_repo,
                                 &admin_tracker,
                                 rdb_pb2_server.get_http_app(),
+                                rdb_pb2_server.get_slow_query_app(),
                                 machine_id,
-                                web_assets));
+                                web_assets,
+                                address_ports.accept_mode));
                         logINF("Listening for administrative HTTP connections on port %d\n", admin_server_ptr->get_port());
                     }
 
@@ -408,6 +429,7 @@ bool do_serve(
 bool serve(extproc::spawner_info_t *spawner_info,
            io_backender_t *io_backender,
            const base_path_t &base_path,
+           const std::vector<base_path_t> &stripe_paths,
            metadata_persistence::cluster_persistent_file_t *cluster_persistent_file,
            metadata_persistence::auth_persistent_file_t *auth_persistent_file,
            const peer_address_set_t &joins,
@@ -419,6 +441,7 @@ bool serve(extproc::spawner_info_t *spawner_info,
                     io_backender,
                     true,
                     base_path,
+                    stripe_paths,
                     cluster_persistent_file,
                     auth_persistent_file,
                     joins,
@@ -440,6 +463,7 @@ bool serve_proxy(extproc::spawner_info_t *spawner_info,
                     NULL,
                     false,
                     base_path_t(""),
+                    std::vector<base_path_t>(),
                     NULL,
                     NULL,
                     joins,
@@ -4,10 +4,12 @@
 
 #include <set>
 #include <string>
+#include <vector>
 
 #include "clustering/administration/metadata.hpp"
 #include "clustering/administration/persist.hpp"
 #include "arch/address.hpp"
+#include "rdb_protocol/slow_query_log.hpp"
 
 namespace extproc { class spawner_info_t; }
 
@@ -29,7 +31,11 @@ struct service_address_ports_t {
         client_port(0),
         http_port(0),
         reql_port(0),
-        port_offset(0) { }
+        port_offset(0),
+        rebalance_client_conns(false),
+        accept_mode(ACCEPT_ON_HOME_THREAD),
+        cluster_compression(false),
+        auto_shard(false) { }
 
     service_address_ports_t(const std::set<ip_address_t> &_local_addresses,
                             int _port,
@@ -37,14 +43,24 @@ struct service_address_ports_t {
                             bool _http_admin_is_disabled,
                             int _http_port,
                             int _reql_port,
-                            int _port_offset) :
+                            int _port_offset,
+                            bool _rebalance_client_conns,
+                            tcp_accept_mode_t _accept_mode,
+                            bool _cluster_compression,
+                            bool _auto_shard,
+                            const slow_query_log_config_t &_slow_queries) :
         local_addresses(_local_addresses),
         port(_port),
         client_port(_client_port),
         http_admin_is_disabled(_http_admin_is_disabled),
         http_port(_http_port),
         reql_port(_reql_port),
-        port_offset(_port_offset)
+        port_offset(_port_offset),
+        rebalance_client_conns(_rebalance_client_conns),
+        accept_mode(_accept_mode),
+        cluster_compression(_cluster_compression),
+        auto_shard(_auto_shard),
+        slow_queries(_slow_queries)
     {
             sanitize_port(port, "port", port_offset);
             sanitize_port(client_port, "client_port", port_offset);
@@ -63,6 +79,16 @@ struct service_address_ports_t {
     int http_port;
     int reql_port;
     int port_offset;
+    bool rebalance_client_conns;
+    tcp_accept_mode_t accept_mode;
+    bool cluster_compression;
+
+    /* Not really a service address, but servers need it and proxies don't */
+    bool auto_shard;
+
+    /* Not a service address either; configures the driver port's slow query
+    log */
+    slow_query_log_config_t slow_queries;
 };
 
 /* This has been factored out from `command_line.hpp` because it takes a very
@@ -71,6 +97,7 @@ long time to compile. */
 bool serve(extproc::spawner_info_t *spawner_info,
            io_backender_t *io_backender,
            const base_path_t &base_path,
+           const std::vector<base_path_t> &stripe_paths,
            metadata_persistence::cluster_persistent_file_t *cluster_persistent_file,
            metadata_persistence::auth_persistent_file_t *auth_persistent_file,
            const peer_address_set_t &joins,
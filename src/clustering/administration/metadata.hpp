@@ -21,6 +21,7 @@
 #include "containers/cow_ptr.hpp"
 #include "containers/auth_key.hpp"
 #include "http/json/json_adapter.hpp"
+#include "rpc/directory/diff.hpp"
 #include "rpc/semilattice/joins/cow_ptr.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 #include "rpc/serialize_macros.hpp"
@@ -45,6 +46,7 @@ public:
 };
 
 RDB_MAKE_SEMILATTICE_JOINABLE_6(cluster_semilattice_metadata_t, dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
+RDB_MAKE_SEMILATTICE_DELTA_6(cluster_semilattice_metadata_t, dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
 RDB_MAKE_EQUALITY_COMPARABLE_6(cluster_semilattice_metadata_t, dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
 
 //json adapter concept for cluster_semilattice_metadata_t
@@ -122,6 +124,50 @@ public:
     RDB_MAKE_ME_SERIALIZABLE_12(dummy_namespaces, memcached_namespaces, rdb_namespaces, machine_id, peer_id, ips, get_stats_mailbox_address, semilattice_change_mailbox, auth_change_mailbox, log_mailbox, local_issues, peer_type);
 };
 
+inline bool directory_value_unchanged(cluster_directory_peer_type_t old_value, cluster_directory_peer_type_t new_value) {
+    return old_value == new_value;
+}
+
+/* The fields of `cluster_directory_metadata_t`, in the order they are
+serialized in. Directory diffs go field by field, so a change to one table's
+reactor business card only sends that business card. */
+#define CLUSTER_DIRECTORY_METADATA_FIELDS(field) \
+    field(dummy_namespaces) \
+    field(memcached_namespaces) \
+    field(rdb_namespaces) \
+    field(machine_id) \
+    field(peer_id) \
+    field(ips) \
+    field(get_stats_mailbox_address) \
+    field(semilattice_change_mailbox) \
+    field(auth_change_mailbox) \
+    field(log_mailbox) \
+    field(local_issues) \
+    field(peer_type)
+
+#define CLUSTER_DIRECTORY_METADATA_COUNT_FIELD(name) + 1
+#define CLUSTER_DIRECTORY_METADATA_SERIALIZE_FIELD_DIFF(name) \
+    serialize_directory_diff(msg, old_value.name, new_value.name);
+#define CLUSTER_DIRECTORY_METADATA_DESERIALIZE_FIELD_DIFF(name) \
+    res = deserialize_directory_diff(s, &value->name); \
+    if (res) { return res; }
+
+inline void serialize_directory_diff(write_message_t *msg, const cluster_directory_metadata_t &old_value, const cluster_directory_metadata_t &new_value) {
+    // Every field that `RDB_MAKE_ME_SERIALIZABLE_12()` sends must be diffed.
+    CT_ASSERT(0 CLUSTER_DIRECTORY_METADATA_FIELDS(CLUSTER_DIRECTORY_METADATA_COUNT_FIELD) == 12);
+    CLUSTER_DIRECTORY_METADATA_FIELDS(CLUSTER_DIRECTORY_METADATA_SERIALIZE_FIELD_DIFF)
+}
+
+inline MUST_USE archive_result_t deserialize_directory_diff(read_stream_t *s, cluster_directory_metadata_t *value) {
+    archive_result_t res = ARCHIVE_SUCCESS;
+    CLUSTER_DIRECTORY_METADATA_FIELDS(CLUSTER_DIRECTORY_METADATA_DESERIALIZE_FIELD_DIFF)
+    return res;
+}
+
+#undef CLUSTER_DIRECTORY_METADATA_COUNT_FIELD
+#undef CLUSTER_DIRECTORY_METADATA_SERIALIZE_FIELD_DIFF
+#undef CLUSTER_DIRECTORY_METADATA_DESERIALIZE_FIELD_DIFF
+
 // ctx-less json adapter for directory_echo_wrapper_t
 template <typename T>
 json_adapter_if_t::json_adapter_map_t get_json_subfields(directory_echo_wrapper_t<T> *target) {
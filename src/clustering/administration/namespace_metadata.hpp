@@ -25,6 +25,7 @@
 #include "containers/name_string.hpp"
 #include "containers/uuid.hpp"
 #include "http/json/json_adapter.hpp"
+#include "rpc/directory/diff.hpp"
 #include "rpc/semilattice/joins/deletable.hpp"
 #include "rpc/semilattice/joins/macros.hpp"
 #include "rpc/semilattice/joins/map.hpp"
@@ -37,7 +38,9 @@ typedef uuid_u namespace_id_t;
 /* This is the metadata for a single namespace of a specific protocol. */
 
 /* If you change this data structure, you must also update
-`clustering/administration/issues/vector_clock_conflict.hpp`. */
+`clustering/administration/issues/vector_clock_conflict.hpp`. If you change its
+serialized layout, you must also teach `clustering/administration/persist.cc` to
+upgrade metadata files written with the old one. */
 
 class ack_expectation_t {
 public:
@@ -66,7 +69,7 @@ void debug_print(printf_buffer_t *buf, const ack_expectation_t &x);
 template<class protocol_t>
 class namespace_semilattice_metadata_t {
 public:
-    namespace_semilattice_metadata_t() : cache_size(GIGABYTE) { }
+    namespace_semilattice_metadata_t() : cache_size(GIGABYTE), cpu_sharding_factor(DEFAULT_CPU_SHARDING_FACTOR) { }
 
     vclock_t<persistable_blueprint_t<protocol_t> > blueprint;
     vclock_t<datacenter_id_t> primary_datacenter;
@@ -81,7 +84,12 @@ public:
     vclock_t<database_id_t> database;
     vclock_t<int64_t> cache_size;
 
-    RDB_MAKE_ME_SERIALIZABLE_12(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+    /* How many stores each server keeps for the table; see
+    `DEFAULT_CPU_SHARDING_FACTOR`. Only looked at when a server creates its
+    stores for the table, so it shouldn't change after the table is created. */
+    vclock_t<int32_t> cpu_sharding_factor;
+
+    RDB_MAKE_ME_SERIALIZABLE_13(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, cpu_sharding_factor);
 };
 
 template <class protocol_t>
@@ -108,6 +116,10 @@ void debug_print(printf_buffer_t *buf, const namespace_semilattice_metadata_t<pr
     debug_print(buf, m.primary_key);
     buf->appendf(", database=");
     debug_print(buf, m.database);
+    buf->appendf(", cache_size=");
+    debug_print(buf, m.cache_size);
+    buf->appendf(", cpu_sharding_factor=");
+    debug_print(buf, m.cpu_sharding_factor);
     buf->appendf("}");
 }
 
@@ -115,7 +127,8 @@ template<class protocol_t>
 namespace_semilattice_metadata_t<protocol_t> new_namespace(
     uuid_u machine, uuid_u database, uuid_u datacenter,
     const name_string_t &name, const std::string &key, int port,
-    int64_t cache_size) {
+    int64_t cache_size,
+    int32_t cpu_sharding_factor = DEFAULT_CPU_SHARDING_FACTOR) {
 
     namespace_semilattice_metadata_t<protocol_t> ns;
     ns.database           = make_vclock(database, machine);
@@ -142,14 +155,15 @@ namespace_semilattice_metadata_t<protocol_t> new_namespace(
     ns.secondary_pinnings = make_vclock(secondary_pinnings, machine);
 
     ns.cache_size = make_vclock(cache_size, machine);
+    ns.cpu_sharding_factor = make_vclock(cpu_sharding_factor, machine);
     return ns;
 }
 
 template<class protocol_t>
-RDB_MAKE_SEMILATTICE_JOINABLE_12(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+RDB_MAKE_SEMILATTICE_JOINABLE_13(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, cpu_sharding_factor);
 
 template<class protocol_t>
-RDB_MAKE_EQUALITY_COMPARABLE_12(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+RDB_MAKE_EQUALITY_COMPARABLE_13(namespace_semilattice_metadata_t<protocol_t>, blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size, cpu_sharding_factor);
 
 // ctx-less json adapter concept for ack_expectation_t
 json_adapter_if_t::json_adapter_map_t get_json_subfields(ack_expectation_t *target);
@@ -182,6 +196,9 @@ public:
 template<class protocol_t>
 RDB_MAKE_SEMILATTICE_JOINABLE_1(namespaces_semilattice_metadata_t<protocol_t>, namespaces);
 
+template<class protocol_t>
+RDB_MAKE_SEMILATTICE_DELTA_1(namespaces_semilattice_metadata_t<protocol_t>, namespaces);
+
 template<class protocol_t>
 RDB_MAKE_EQUALITY_COMPARABLE_1(namespaces_semilattice_metadata_t<protocol_t>, namespaces);
 
@@ -213,6 +230,16 @@ public:
     RDB_MAKE_ME_SERIALIZABLE_1(reactor_bcards);
 };
 
+template <class protocol_t>
+void serialize_directory_diff(write_message_t *msg, const namespaces_directory_metadata_t<protocol_t> &old_value, const namespaces_directory_metadata_t<protocol_t> &new_value) {
+    serialize_directory_diff(msg, old_value.reactor_bcards, new_value.reactor_bcards);
+}
+
+template <class protocol_t>
+MUST_USE archive_result_t deserialize_directory_diff(read_stream_t *s, namespaces_directory_metadata_t<protocol_t> *value) {
+    return deserialize_directory_diff(s, &value->reactor_bcards);
+}
+
 // ctx-less json adapter concept for namespaces_directory_metadata_t
 template <class protocol_t>
 json_adapter_if_t::json_adapter_map_t get_json_subfields(namespaces_directory_metadata_t<protocol_t> *target);
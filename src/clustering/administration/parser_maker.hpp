@@ -18,7 +18,8 @@ public:
                    int port_offset,
                    namespace_repo_t<protocol_t> *repo,
                    local_issue_tracker_t *_local_issue_tracker,
-                   perfmon_collection_repo_t *_perfmon_collection_repo);
+                   perfmon_collection_repo_t *_perfmon_collection_repo,
+                   tcp_accept_mode_t _accept_mode = ACCEPT_ON_HOME_THREAD);
 
 private:
     class ns_record_t {
@@ -45,6 +46,8 @@ private:
     perfmon_collection_repo_t *perfmon_collection_repo;
 
     local_issue_tracker_t *local_issue_tracker;
+
+    tcp_accept_mode_t accept_mode;
 };
 
 #include "clustering/administration/parser_maker.tcc"
@@ -14,7 +14,8 @@ parser_maker_t<protocol_t, parser_t>::parser_maker_t(mailbox_manager_t *_mailbox
                                int _port_offset,
                                namespace_repo_t<protocol_t> *_repo,
                                local_issue_tracker_t *_local_issue_tracker,
-                               perfmon_collection_repo_t *_perfmon_collection_repo)
+                               perfmon_collection_repo_t *_perfmon_collection_repo,
+                               tcp_accept_mode_t _accept_mode)
     : mailbox_manager(_mailbox_manager),
       namespaces_semilattice_metadata(_namespaces_semilattice_metadata),
       local_addresses(_local_addresses),
@@ -22,7 +23,8 @@ parser_maker_t<protocol_t, parser_t>::parser_maker_t(mailbox_manager_t *_mailbox
       repo(_repo),
       namespaces_subscription(boost::bind(&parser_maker_t::on_change, this), namespaces_semilattice_metadata),
       perfmon_collection_repo(_perfmon_collection_repo),
-      local_issue_tracker(_local_issue_tracker)
+      local_issue_tracker(_local_issue_tracker),
+      accept_mode(_accept_mode)
 {
     on_change();
 }
@@ -87,7 +89,7 @@ void parser_maker_t<protocol_t, parser_t>::serve_queries(std::string ns_name,
         logINF("Listening for queries for the namespace '%s' %s on port %d.\n", ns_name.c_str(), uuid_to_str(ns).c_str(), port);
 
         wait_any_t interruptor(&namespaces_being_handled.find(ns)->second->stopper, keepalive.get_drain_signal());
-        parser_t parser(local_addresses, port, repo, ns, &perfmon_collection_repo->get_perfmon_collections_for_namespace(ns)->namespace_collection);
+        parser_t parser(local_addresses, port, repo, ns, &perfmon_collection_repo->get_perfmon_collections_for_namespace(ns)->namespace_collection, accept_mode);
 
         signal_t *is_bound = parser.get_bound_signal();
 
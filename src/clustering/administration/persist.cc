@@ -38,6 +38,12 @@ struct cluster_metadata_superblock_t {
 /* Etymology: (R)ethink(D)B (m)eta(d)ata */
 const block_magic_t expected_magic = { { 'R', 'D', 'm', 'd' } };
 
+/* The cluster metadata superblock used to carry `expected_magic` too. Its
+metadata blob has since changed layout (tables gained a `cpu_sharding_factor`),
+so superblocks written in the new layout carry this magic instead, and ones that
+still carry `expected_magic` are read with `read_v1_cluster_metadata()`. */
+const block_magic_t cluster_metadata_v2_magic = { { 'R', 'D', 'm', '2' } };
+
 template <class T>
 static void write_blob(transaction_t *txn, char *ref, int maxreflen, const T &value) {
     write_message_t msg;
@@ -50,7 +56,7 @@ static void write_blob(transaction_t *txn, char *ref, int maxreflen, const T &va
     std::string str;
     str.reserve(slen);
     for (write_buffer_t *p = buffers->head(); p != NULL; p = buffers->next(p)) {
-        str.append(p->data, p->size);
+        str.append(p->bytes(), p->size);
     }
     guarantee(str.size() == slen);
     blob_t blob(ref, maxreflen);
@@ -71,6 +77,96 @@ static void read_blob(transaction_t *txn, const char *ref, int maxreflen, T *val
     guarantee(res == 0);
 }
 
+/* The layout of the per-table metadata before `cpu_sharding_factor` was added.
+These types exist only to read old cluster metadata blobs. */
+template <class protocol_t>
+class v1_namespace_semilattice_metadata_t {
+public:
+    vclock_t<persistable_blueprint_t<protocol_t> > blueprint;
+    vclock_t<datacenter_id_t> primary_datacenter;
+    vclock_t<std::map<datacenter_id_t, int32_t> > replica_affinities;
+    vclock_t<std::map<datacenter_id_t, ack_expectation_t> > ack_expectations;
+    vclock_t<nonoverlapping_regions_t<protocol_t> > shards;
+    vclock_t<name_string_t> name;
+    vclock_t<int> port;
+    vclock_t<region_map_t<protocol_t, machine_id_t> > primary_pinnings;
+    vclock_t<region_map_t<protocol_t, std::set<machine_id_t> > > secondary_pinnings;
+    vclock_t<std::string> primary_key;
+    vclock_t<database_id_t> database;
+    vclock_t<int64_t> cache_size;
+
+    RDB_MAKE_ME_SERIALIZABLE_12(blueprint, primary_datacenter, replica_affinities, ack_expectations, shards, name, port, primary_pinnings, secondary_pinnings, primary_key, database, cache_size);
+};
+
+template <class protocol_t>
+class v1_namespaces_semilattice_metadata_t {
+public:
+    std::map<namespace_id_t, deletable_t<v1_namespace_semilattice_metadata_t<protocol_t> > > namespaces;
+
+    RDB_MAKE_ME_SERIALIZABLE_1(namespaces);
+};
+
+class v1_cluster_semilattice_metadata_t {
+public:
+    v1_namespaces_semilattice_metadata_t<mock::dummy_protocol_t> dummy_namespaces;
+    v1_namespaces_semilattice_metadata_t<memcached_protocol_t> memcached_namespaces;
+    v1_namespaces_semilattice_metadata_t<rdb_protocol_t> rdb_namespaces;
+
+    machines_semilattice_metadata_t machines;
+    datacenters_semilattice_metadata_t datacenters;
+    databases_semilattice_metadata_t databases;
+
+    RDB_MAKE_ME_SERIALIZABLE_6(dummy_namespaces, memcached_namespaces, rdb_namespaces, machines, datacenters, databases);
+};
+
+/* Tables created before the factor was configurable were always split into
+`DEFAULT_CPU_SHARDING_FACTOR` stores, and their store files keep that number
+anyway, so that's what the upgraded metadata says. The factor gets an empty
+version vector so that any value a newer server has set wins the join. */
+template <class protocol_t>
+static void upgrade_v1_namespaces(const v1_namespaces_semilattice_metadata_t<protocol_t> &old_namespaces,
+                                  cow_ptr_t<namespaces_semilattice_metadata_t<protocol_t> > *namespaces_out) {
+    typename cow_ptr_t<namespaces_semilattice_metadata_t<protocol_t> >::change_t change(namespaces_out);
+    typedef typename std::map<namespace_id_t, deletable_t<v1_namespace_semilattice_metadata_t<protocol_t> > >::const_iterator ns_iterator_t;
+    for (ns_iterator_t it = old_namespaces.namespaces.begin(); it != old_namespaces.namespaces.end(); ++it) {
+        deletable_t<namespace_semilattice_metadata_t<protocol_t> > ns;
+        if (it->second.is_deleted()) {
+            ns.mark_deleted();
+        } else {
+            const v1_namespace_semilattice_metadata_t<protocol_t> &old_ns = it->second.get_ref();
+            namespace_semilattice_metadata_t<protocol_t> *new_ns = ns.get_mutable();
+            new_ns->blueprint = old_ns.blueprint;
+            new_ns->primary_datacenter = old_ns.primary_datacenter;
+            new_ns->replica_affinities = old_ns.replica_affinities;
+            new_ns->ack_expectations = old_ns.ack_expectations;
+            new_ns->shards = old_ns.shards;
+            new_ns->name = old_ns.name;
+            new_ns->port = old_ns.port;
+            new_ns->primary_pinnings = old_ns.primary_pinnings;
+            new_ns->secondary_pinnings = old_ns.secondary_pinnings;
+            new_ns->primary_key = old_ns.primary_key;
+            new_ns->database = old_ns.database;
+            new_ns->cache_size = old_ns.cache_size;
+            new_ns->cpu_sharding_factor = vclock_t<int32_t>(DEFAULT_CPU_SHARDING_FACTOR);
+        }
+        change.get()->namespaces.insert(std::make_pair(it->first, ns));
+    }
+}
+
+static cluster_semilattice_metadata_t read_v1_cluster_metadata(transaction_t *txn, const char *ref, int maxreflen) {
+    v1_cluster_semilattice_metadata_t old_metadata;
+    read_blob(txn, ref, maxreflen, &old_metadata);
+
+    cluster_semilattice_metadata_t metadata;
+    upgrade_v1_namespaces(old_metadata.dummy_namespaces, &metadata.dummy_namespaces);
+    upgrade_v1_namespaces(old_metadata.memcached_namespaces, &metadata.memcached_namespaces);
+    upgrade_v1_namespaces(old_metadata.rdb_namespaces, &metadata.rdb_namespaces);
+    metadata.machines = old_metadata.machines;
+    metadata.datacenters = old_metadata.datacenters;
+    metadata.databases = old_metadata.databases;
+    return metadata;
+}
+
 template <class metadata_t>
 persistent_file_t<metadata_t>::persistent_file_t(io_backender_t *io_backender,
                                                  const serializer_filepath_t &filename,
@@ -198,6 +294,16 @@ cluster_persistent_file_t::cluster_persistent_file_t(io_backender_t *io_backende
                                                      const serializer_filepath_t &filename,
                                                      perfmon_collection_t *perfmon_parent) :
     persistent_file_t<cluster_semilattice_metadata_t>(io_backender, filename, perfmon_parent, false) {
+    {
+        object_buffer_t<transaction_t> txn;
+        get_read_transaction(&txn, "check_magic");
+        buf_lock_t superblock(txn.get(), SUPERBLOCK_ID, rwi_read);
+
+        const cluster_metadata_superblock_t *sb = static_cast<const cluster_metadata_superblock_t *>(superblock.get_data_read());
+        if (sb->magic != cluster_metadata_v2_magic && sb->magic != expected_magic) {
+            throw file_format_exc_t();
+        }
+    }
     construct_branch_history_managers(false);
 }
 
@@ -215,7 +321,7 @@ cluster_persistent_file_t::cluster_persistent_file_t(io_backender_t *io_backende
     cluster_metadata_superblock_t *sb = static_cast<cluster_metadata_superblock_t *>(superblock.get_data_write());
 
     bzero(sb, get_cache_block_size().value());
-    sb->magic = expected_magic;
+    sb->magic = cluster_metadata_v2_magic;
     sb->machine_id = machine_id;
     write_blob(txn.get(),
                sb->metadata_blob,
@@ -247,6 +353,10 @@ cluster_semilattice_metadata_t cluster_persistent_file_t::read_metadata() {
     buf_lock_t superblock(txn.get(), SUPERBLOCK_ID, rwi_read);
 
     const cluster_metadata_superblock_t *sb = static_cast<const cluster_metadata_superblock_t *>(superblock.get_data_read());
+    if (sb->magic == expected_magic) {
+        return read_v1_cluster_metadata(txn.get(), sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN);
+    }
+    guarantee(sb->magic == cluster_metadata_v2_magic);
     cluster_semilattice_metadata_t metadata;
     read_blob(txn.get(), sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, &metadata);
     return metadata;
@@ -258,6 +368,8 @@ void cluster_persistent_file_t::update_metadata(const cluster_semilattice_metada
     buf_lock_t superblock(txn.get(), SUPERBLOCK_ID, rwi_write);
 
     cluster_metadata_superblock_t *sb = static_cast<cluster_metadata_superblock_t *>(superblock.get_data_write());
+    // This also upgrades a superblock that still has the old layout.
+    sb->magic = cluster_metadata_v2_magic;
     write_blob(txn.get(), sb->metadata_blob, cluster_metadata_superblock_t::METADATA_BLOB_MAXREFLEN, metadata);
 }
 
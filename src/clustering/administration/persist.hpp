@@ -21,6 +21,13 @@ public:
     }
 };
 
+class file_format_exc_t : public std::exception {
+public:
+    const char *what() const throw () {
+        return "metadata file has an unrecognized format";
+    }
+};
+
 template <class metadata_t>
 class persistent_file_t {
 public:
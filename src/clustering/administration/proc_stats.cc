@@ -9,6 +9,7 @@
 #include <sys/types.h>
 #include <unistd.h>
 
+#include "arch/runtime/runtime.hpp"
 #include "arch/timing.hpp"
 #include "utils.hpp"
 
@@ -44,5 +45,16 @@ scoped_ptr_t<perfmon_result_t> proc_stats_collector_t::instantaneous_stats_colle
     result->insert("version", new perfmon_result_t(std::string(RETHINKDB_VERSION)));
     result->insert("pid", new perfmon_result_t(strprintf("%d", getpid())));
 
+    // How busy each thread's event loop is
+    scoped_ptr_t<perfmon_result_t> threads = perfmon_result_t::alloc_map_result();
+    for (int i = 0; i < get_num_threads(); ++i) {
+        scoped_ptr_t<perfmon_result_t> thread = perfmon_result_t::alloc_map_result();
+        thread->insert("busy_time", new perfmon_result_t(strprintf("%f", get_thread_busy_secs(i))));
+        thread->insert("load", new perfmon_result_t(strprintf("%f", get_thread_load(i))));
+        thread->insert("spin_time", new perfmon_result_t(strprintf("%f", get_thread_spin_secs(i))));
+        threads->insert(strprintf("%d", i), thread.release());
+    }
+    result->insert("threads", threads.release());
+
     return result;
 }
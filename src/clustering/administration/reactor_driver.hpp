@@ -13,19 +13,37 @@
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "clustering/reactor/blueprint.hpp"
 #include "concurrency/watchable.hpp"
+#include "perfmon/core.hpp"
 #include "rpc/semilattice/view.hpp"
+#include "serializer/serializer.hpp"
 
 /* This files contains the class reactor driver whose job is to create and
  * destroy reactors based on blueprints given to the server. */
 
 class perfmon_collection_repo_t;
-class serializer_t;
 class serializer_multiplexer_t;
 
 template <class> class watchable_and_reactor_t;
 
 template <class> class multistore_ptr_t;
 
+/* One of the files a table's stores keep their data in, along with the
+collection for its stats. If the table has only one file, `perfmon_name` is
+empty and the stats are spliced straight into the table's serializers
+collection. */
+class serializer_file_t {
+public:
+    serializer_file_t(perfmon_collection_t *parent, const std::string &perfmon_name)
+        : perfmon_membership(parent, &perfmon_collection, perfmon_name) { }
+
+    perfmon_collection_t perfmon_collection;
+    perfmon_membership_t perfmon_membership;
+    scoped_ptr_t<serializer_t> serializer;
+
+private:
+    DISABLE_COPYING(serializer_file_t);
+};
+
 // This type holds some protocol_t::store_t objects, and doesn't let anybody _casually_ touch them.
 template <class protocol_t>
 class stores_lifetimer_t {
@@ -42,12 +60,12 @@ public:
         }
     }
 
-    scoped_ptr_t<serializer_t> *serializer() { return &serializer_; }
+    scoped_array_t<scoped_ptr_t<serializer_file_t> > *files() { return &files_; }
     scoped_ptr_t<serializer_multiplexer_t> *multiplexer() { return &multiplexer_; }
     scoped_array_t<scoped_ptr_t<typename protocol_t::store_t> > *stores() { return &stores_; }
 
 private:
-    scoped_ptr_t<serializer_t> serializer_;
+    scoped_array_t<scoped_ptr_t<serializer_file_t> > files_;
     scoped_ptr_t<serializer_multiplexer_t> multiplexer_;
     scoped_array_t<scoped_ptr_t<typename protocol_t::store_t> > stores_;
 
@@ -57,8 +75,11 @@ private:
 template <class protocol_t>
 class svs_by_namespace_t {
 public:
+    /* `cpu_sharding_factor` is how many stores to make if the table doesn't
+    have any on this server yet; existing stores are used as they are. */
     virtual void get_svs(perfmon_collection_t *perfmon_collection, namespace_id_t namespace_id,
                          int64_t cache_size,
+                         int cpu_sharding_factor,
                          stores_lifetimer_t<protocol_t> *stores_out,
                          scoped_ptr_t<multistore_ptr_t<protocol_t> > *svs_out,
                          typename protocol_t::context_t *) = 0;
@@ -0,0 +1,83 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_BACKFILL_BATCH_HPP_
+#define CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_BACKFILL_BATCH_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/string_stream.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "rpc/serialize_macros.hpp"
+
+/* `backfill_chunk_batch_t` is a run of backfill chunks that the backfiller
+sends to the backfillee as one message. The chunks are serialized as they are
+added, so that the backfiller knows how big the batch is without serializing
+anything twice; `get_chunks()` deserializes them again, in the order in which
+they were added.
+
+A batch also carries the regions that the backfiller finished with since the
+last batch was sent. Every chunk for such a region is in this batch or in an
+earlier one. */
+
+template <class protocol_t>
+class backfill_chunk_batch_t {
+public:
+    backfill_chunk_batch_t() : num_chunks(0) { }
+
+    void add_chunk(const typename protocol_t::backfill_chunk_t &chunk) {
+        write_message_t msg;
+        msg << chunk;
+        vector_stream_t stream;
+        int res = send_write_message(&stream, &msg);
+        guarantee(res == 0);
+        data.append(stream.vector().data(), stream.vector().size());
+        ++num_chunks;
+    }
+
+    void get_chunks(std::vector<typename protocol_t::backfill_chunk_t> *chunks_out) const {
+        chunks_out->resize(num_chunks);
+        read_string_stream_t stream(data);
+        for (int32_t i = 0; i < num_chunks; ++i) {
+            archive_result_t res = deserialize(&stream, &(*chunks_out)[i]);
+            guarantee(res == ARCHIVE_SUCCESS, "corrupt backfill chunk batch");
+        }
+    }
+
+    void add_finished_region(const typename protocol_t::region_t &region) {
+        finished_regions.push_back(region);
+    }
+
+    const std::vector<typename protocol_t::region_t> &get_finished_regions() const {
+        return finished_regions;
+    }
+
+    int get_num_chunks() const {
+        return num_chunks;
+    }
+
+    size_t get_size_in_bytes() const {
+        return data.size();
+    }
+
+    bool empty() const {
+        return num_chunks == 0 && finished_regions.empty();
+    }
+
+    void swap(backfill_chunk_batch_t *other) {
+        std::swap(num_chunks, other->num_chunks);
+        data.swap(other->data);
+        finished_regions.swap(other->finished_regions);
+    }
+
+    RDB_MAKE_ME_SERIALIZABLE_3(num_chunks, data, finished_regions);
+
+private:
+    int32_t num_chunks;
+    std::string data;
+    std::vector<typename protocol_t::region_t> finished_regions;
+};
+
+#endif /* CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_BACKFILL_BATCH_HPP_ */
@@ -1,15 +1,18 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/branch/backfillee.hpp"
 
+#include <map>
+#include <set>
+
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/coro_pool.hpp"
+#include "concurrency/pmap.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/fifo_enforcer_queue.hpp"
 #include "concurrency/promise.hpp"
 #include "concurrency/queue/unlimited_fifo.hpp"
 #include "containers/death_runner.hpp"
-
-#define ALLOCATION_CHUNK 50
+#include "containers/scoped.hpp"
 
 template <class protocol_t>
 struct backfill_queue_entry_t {
@@ -17,50 +20,120 @@ struct backfill_queue_entry_t {
     // constructor (and assignment operator, presumably) is completely asinine.
     backfill_queue_entry_t() { }
     backfill_queue_entry_t(bool _is_not_last_backfill_chunk,
-                           const typename protocol_t::backfill_chunk_t &_chunk,
+                           const backfill_chunk_batch_t<protocol_t> &_batch,
                            fifo_enforcer_write_token_t _write_token)
         : is_not_last_backfill_chunk(_is_not_last_backfill_chunk),
-          chunk(_chunk),
+          batch(_batch),
           write_token(_write_token) { }
 
     bool is_not_last_backfill_chunk;
-    typename protocol_t::backfill_chunk_t chunk;
+    backfill_chunk_batch_t<protocol_t> batch;
     fifo_enforcer_write_token_t write_token;
 };
 
 template <class protocol_t>
 void push_chunk_on_queue(fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *queue,
-                         typename protocol_t::backfill_chunk_t chunk, fifo_enforcer_write_token_t token) {
-    queue->push(token, backfill_queue_entry_t<protocol_t>(true, chunk, token));
+                         const backfill_chunk_batch_t<protocol_t> &batch, fifo_enforcer_write_token_t token) {
+    queue->push(token, backfill_queue_entry_t<protocol_t>(true, batch, token));
 }
 
 template <class protocol_t>
 void push_finish_on_queue(fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *queue, fifo_enforcer_write_token_t token) {
-    queue->push(token, backfill_queue_entry_t<protocol_t>(false, typename protocol_t::backfill_chunk_t(), token));
+    queue->push(token, backfill_queue_entry_t<protocol_t>(false, backfill_chunk_batch_t<protocol_t>(), token));
 }
 
 
 /* Now that the metadata indicates that the backfill is happening, it's
-   time to start actually performing backfill chunks */
+   time to start actually performing backfill chunks.
+
+   Whenever the backfiller finishes a region, the next batch says so. Once that
+   batch and all the ones before it have been applied, the region is up to date
+   as of `end_point`, so we record that in the metainfo. If the backfill is
+   interrupted, the next one starts from there for that region instead of from
+   the beginning. */
 template <class protocol_t>
 class chunk_callback_t : public coro_pool_callback_t<backfill_queue_entry_t<protocol_t> >,
                          public home_thread_mixin_debug_only_t {
 public:
     chunk_callback_t(store_view_t<protocol_t> *_svs,
                      fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *_chunk_queue, mailbox_manager_t *_mbox_manager,
-                     mailbox_addr_t<void(int)> _allocation_mailbox) :
+                     mailbox_addr_t<void(int)> _allocation_mailbox,
+                     const region_map_t<protocol_t, version_range_t> &_end_point,
+                     order_source_t *_order_source) :
         svs(_svs), chunk_queue(_chunk_queue), mbox_manager(_mbox_manager),
-        allocation_mailbox(_allocation_mailbox), unacked_chunks(0),
-        done_message_arrived(false), num_outstanding_chunks(0)
+        allocation_mailbox(_allocation_mailbox),
+        end_point(_end_point), order_source(_order_source),
+        done_message_arrived(false), num_outstanding_chunks(0),
+        next_batch_id(0), first_unapplied_batch_id(0)
     { }
 
-    void apply_backfill_chunk(fifo_enforcer_write_token_t chunk_token, const typename protocol_t::backfill_chunk_t& chunk, signal_t *interruptor) {
-        write_token_pair_t token_pair;
-        object_buffer_t<fifo_enforcer_sink_t::exit_write_t> write_token;
-        svs->new_write_token_pair(&token_pair);
-        chunk_queue->finish_write(chunk_token);
+    /* Takes a write token for every chunk in the batch before letting the next
+    batch go, so chunks acquire the superblock in the order they were sent in,
+    and then applies them all concurrently. */
+    void apply_backfill_batch(fifo_enforcer_write_token_t batch_token, const backfill_chunk_batch_t<protocol_t> &batch, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        std::vector<typename protocol_t::backfill_chunk_t> chunks;
+        batch.get_chunks(&chunks);
+
+        scoped_array_t<write_token_pair_t> token_pairs(chunks.size());
+        for (size_t i = 0; i < chunks.size(); ++i) {
+            svs->new_write_token_pair(&token_pairs[i]);
+        }
+        chunk_queue->finish_write(batch_token);
+
+        pmap(chunks.size(), boost::bind(&chunk_callback_t<protocol_t>::apply_backfill_chunk,
+                                        this, _1, &chunks, &token_pairs, interruptor));
+
+        /* `apply_backfill_chunk()` returns normally if it was interrupted, so
+        we have to check here. */
+        if (interruptor->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+    }
+
+    void apply_backfill_chunk(int i, const std::vector<typename protocol_t::backfill_chunk_t> *chunks,
+                              scoped_array_t<write_token_pair_t> *token_pairs, signal_t *interruptor) {
+        try {
+            svs->receive_backfill((*chunks)[i], &(*token_pairs)[i], interruptor);
+        } catch (const interrupted_exc_t &) {
+            /* `apply_backfill_batch()` will notice */
+        }
+    }
 
-        svs->receive_backfill(chunk, &token_pair, interruptor);
+    /* Called once the batch `batch_id` has been applied. Records the regions
+    that are now complete because every batch up to and including theirs has
+    been applied. */
+    void checkpoint_finished_regions(int64_t batch_id, const std::vector<typename protocol_t::region_t> &regions, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        applied_batch_ids.insert(batch_id);
+        if (!regions.empty()) {
+            pending_finished_regions[batch_id] = regions;
+        }
+
+        std::vector<std::pair<typename protocol_t::region_t, version_range_t> > checkpoint_parts;
+        while (!applied_batch_ids.empty() && *applied_batch_ids.begin() == first_unapplied_batch_id) {
+            applied_batch_ids.erase(applied_batch_ids.begin());
+            typename std::map<int64_t, std::vector<typename protocol_t::region_t> >::iterator it =
+                pending_finished_regions.find(first_unapplied_batch_id);
+            if (it != pending_finished_regions.end()) {
+                for (size_t i = 0; i < it->second.size(); ++i) {
+                    region_map_t<protocol_t, version_range_t> part = end_point.mask(it->second[i]);
+                    checkpoint_parts.insert(checkpoint_parts.end(), part.begin(), part.end());
+                }
+                pending_finished_regions.erase(it);
+            }
+            ++first_unapplied_batch_id;
+        }
+
+        if (!checkpoint_parts.empty()) {
+            object_buffer_t<fifo_enforcer_sink_t::exit_write_t> write_token;
+            svs->new_write_token(&write_token);
+            svs->set_metainfo(
+                region_map_transform<protocol_t, version_range_t, binary_blob_t>(
+                    region_map_t<protocol_t, version_range_t>(checkpoint_parts.begin(), checkpoint_parts.end()),
+                    &binary_blob_t::make<version_range_t>),
+                order_source->check_in("backfillee(checkpoint)"),
+                &write_token,
+                interruptor);
+        }
     }
 
     void coro_pool_callback(backfill_queue_entry_t<protocol_t> chunk, signal_t *interruptor) {
@@ -70,35 +143,27 @@ public:
                 /* This is an actual backfill chunk */
 
                 /* Before letting the next thing go, increment
-                   `num_outstanding_chunks` and acquire a write token. The
+                   `num_outstanding_chunks` and acquire write tokens. The
                    former is so that if the next thing is a done message,
                    it won't pulse `done_cond` while we're still going. The
                    latter is so that the backfill chunks acquire the
-                   superblock in the correct order. */
-                num_outstanding_chunks++;
-
-                // We acquire the write token in apply_backfill_chunk.
-                apply_backfill_chunk(chunk.write_token, chunk.chunk, interruptor);
-
-                /* Allow the backfiller to send us more data */
-                int chunks_to_send_out = 0;
-                {
-                    /* Notice it's important that we don't wait while we're
-                     * modifying unacked chunks, otherwise another callback may
-                     * decided to send out an allocation as well. */
-                    ASSERT_NO_CORO_WAITING;
-                    ++unacked_chunks;
-                    guarantee(unacked_chunks <= ALLOCATION_CHUNK);
-                    if (unacked_chunks == ALLOCATION_CHUNK) {
-                        unacked_chunks = 0;
-                        chunks_to_send_out = ALLOCATION_CHUNK;
-                    }
-                }
-                if (chunks_to_send_out != 0) {
-                    send(mbox_manager, allocation_mailbox, chunks_to_send_out);
-                }
+                   superblock in the correct order. The extra one covers
+                   the checkpoint below, which may have to be written even
+                   for a batch without chunks. */
+                num_outstanding_chunks += chunk.batch.get_num_chunks() + 1;
+                int64_t batch_id = next_batch_id++;
+
+                // We acquire the write tokens in apply_backfill_batch.
+                apply_backfill_batch(chunk.write_token, chunk.batch, interruptor);
+
+                /* Allow the backfiller to send us more data. The backfiller
+                   also goes by how fast these arrive to decide how much data
+                   to keep in flight. */
+                send(mbox_manager, allocation_mailbox, chunk.batch.get_num_chunks());
 
-                num_outstanding_chunks--;
+                checkpoint_finished_regions(batch_id, chunk.batch.get_finished_regions(), interruptor);
+
+                num_outstanding_chunks -= chunk.batch.get_num_chunks() + 1;
 
             } else {
                 /* This is a fake backfill "chunk" that just indicates
@@ -128,10 +193,16 @@ private:
     fifo_enforcer_queue_t<backfill_queue_entry_t<protocol_t> > *chunk_queue;
     mailbox_manager_t *mbox_manager;
     mailbox_addr_t<void(int)> allocation_mailbox;
-    int unacked_chunks;
+    region_map_t<protocol_t, version_range_t> end_point;
+    order_source_t *order_source;
     bool done_message_arrived;
     int num_outstanding_chunks;
 
+    /* Batches are numbered in the order they were sent in. */
+    int64_t next_batch_id, first_unapplied_batch_id;
+    std::set<int64_t> applied_batch_ids;
+    std::map<int64_t, std::vector<typename protocol_t::region_t> > pending_finished_regions;
+
     DISABLE_COPYING(chunk_callback_t);
 };
 
@@ -185,8 +256,6 @@ void backfillee(
         mailbox_callback_mode_inline);
 
     {
-        typedef typename protocol_t::backfill_chunk_t backfill_chunk_t;
-
         /* A queue of the requests the backfill chunk mailbox receives, a coro
          * pool services these requests and poops them off one at a time to
          * perform them. */
@@ -200,9 +269,9 @@ void backfillee(
             boost::bind(&push_finish_on_queue<protocol_t>, &chunk_queue, _1),
             mailbox_callback_mode_inline);
 
-        /* The backfiller will send individual chunks of the backfill to
+        /* The backfiller will send batches of backfill chunks to
         `chunk_mailbox`. */
-        mailbox_t<void(backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_mailbox(
+        mailbox_t<void(backfill_chunk_batch_t<protocol_t>, fifo_enforcer_write_token_t)> chunk_mailbox(
             mailbox_manager, boost::bind(&push_chunk_on_queue<protocol_t>, &chunk_queue, _1, _2), mailbox_callback_mode_inline);
 
         /* The backfiller will register for allocations on the allocation
@@ -319,7 +388,8 @@ void backfillee(
             &write_token,
             interruptor);
 
-        chunk_callback_t<protocol_t> chunk_callback(svs, &chunk_queue, mailbox_manager, allocation_mailbox);
+        chunk_callback_t<protocol_t> chunk_callback(svs, &chunk_queue, mailbox_manager, allocation_mailbox,
+                                                    end_point, &order_source);
 
         coro_pool_t<backfill_queue_entry_t<protocol_t> > backfill_workers(10, &chunk_queue, &chunk_callback);
 
@@ -1,6 +1,9 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/immediate_consistency/branch/backfiller.hpp"
 
+#include <algorithm>
+
+#include "arch/timing.hpp"
 #include "btree/parallel_traversal.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/fifo_enforcer.hpp"
@@ -8,8 +11,6 @@
 #include "rpc/semilattice/view.hpp"
 #include "stl_utils.hpp"
 
-#define MAX_CHUNKS_OUT 5000
-
 inline state_timestamp_t get_earliest_timestamp_of_version_range(const version_range_t &vr) {
     return vr.earliest.timestamp;
 }
@@ -85,33 +86,118 @@ bool backfiller_t<protocol_t>::confirm_and_send_metainfo(typename store_view_t<p
     return true;
 }
 
+/* `backfill_chunk_sender_t` collects the chunks of one backfill into batches
+and sends each batch once it is big enough. It keeps no more chunks in flight
+than the backfillee can apply in `BACKFILL_WINDOW_MS`, going by how fast the
+backfillee has been acknowledging them; the acknowledgements arrive at
+`on_chunks_applied()`. */
 template <class protocol_t>
-void do_send_chunk(mailbox_manager_t *mbox_manager,
-                   mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_addr,
-                   const typename protocol_t::backfill_chunk_t &chunk,
-                   fifo_enforcer_source_t *fifo_src,
-                   semaphore_t *chunk_semaphore,
-                   signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
-    chunk_semaphore->co_lock_interruptible(interruptor);
-    send(mbox_manager, chunk_addr, chunk, fifo_src->enter_write());
-}
+class backfill_chunk_sender_t {
+public:
+    backfill_chunk_sender_t(mailbox_manager_t *_mailbox_manager,
+                            mailbox_addr_t<void(backfill_chunk_batch_t<protocol_t>, fifo_enforcer_write_token_t)> _chunk_cont)
+        : mailbox_manager(_mailbox_manager), chunk_cont(_chunk_cont),
+          window(BACKFILL_INITIAL_CHUNKS_OUT),
+          start_time(get_ticks()), chunks_sent(0), bytes_sent(0),
+          rate_interval_start(start_time), chunks_applied_in_interval(0) { }
+
+    void send_chunk(const typename protocol_t::backfill_chunk_t &chunk, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        batch.add_chunk(chunk);
+        if (batch.get_size_in_bytes() >= static_cast<size_t>(BACKFILL_MAX_BATCH_BYTES) ||
+                batch.get_num_chunks() >= BACKFILL_MAX_BATCH_CHUNKS) {
+            flush(interruptor);
+        }
+    }
+
+    /* Marks `region` as done in the current batch and sends it off, so that
+    the backfillee can checkpoint its progress as soon as possible. */
+    void finish_region(const typename protocol_t::region_t &region, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        batch.add_finished_region(region);
+        flush(interruptor);
+    }
+
+    /* Sends whatever is left in the current batch. The traversal can call
+    `send_chunk()` from several coroutines at once. The backfillee applies
+    batches in FIFO order and only then gives their room in the window back, so
+    each batch must get its room in that same order; otherwise a small batch
+    could take the room that an earlier, larger batch is waiting for. Nothing
+    blocks between `enter_write()` and asking the window for room, and the
+    window grants requests in the order they were made. */
+    void flush(signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        if (batch.empty()) {
+            return;
+        }
+        backfill_chunk_batch_t<protocol_t> full_batch;
+        full_batch.swap(&batch);
+        fifo_enforcer_write_token_t token = fifo_src.enter_write();
+
+        window.co_lock_interruptible(interruptor, full_batch.get_num_chunks());
+        send(mailbox_manager, chunk_cont, full_batch, token);
+        chunks_sent += full_batch.get_num_chunks();
+        bytes_sent += full_batch.get_size_in_bytes();
+    }
+
+    fifo_enforcer_write_token_t enter_write() {
+        return fifo_src.enter_write();
+    }
+
+    void on_chunks_applied(int chunks) {
+        window.unlock(chunks);
+
+        chunks_applied_in_interval += chunks;
+        ticks_t now = get_ticks();
+        double secs = ticks_to_secs(now - rate_interval_start);
+        if (secs * THOUSAND >= BACKFILL_RATE_INTERVAL_MS) {
+            double apply_rate = chunks_applied_in_interval / secs;
+            int64_t new_window = static_cast<int64_t>(apply_rate * BACKFILL_WINDOW_MS / THOUSAND);
+            window.set_capacity(std::min<int64_t>(std::max<int64_t>(new_window, BACKFILL_MIN_CHUNKS_OUT),
+                                                  BACKFILL_MAX_CHUNKS_OUT));
+            rate_interval_start = now;
+            chunks_applied_in_interval = 0;
+        }
+    }
+
+    void fill_in_rates(backfill_progress_report_t *report) const {
+        double secs = ticks_to_secs(get_ticks() - start_time);
+        if (secs > 0) {
+            report->chunks_per_sec = chunks_sent / secs;
+            report->bytes_per_sec = bytes_sent / secs;
+            if (report->released_nodes > 0 && report->total_nodes >= report->released_nodes) {
+                report->eta_secs = secs * (report->total_nodes - report->released_nodes) / report->released_nodes;
+            }
+        }
+    }
+
+private:
+    mailbox_manager_t *mailbox_manager;
+    mailbox_addr_t<void(backfill_chunk_batch_t<protocol_t>, fifo_enforcer_write_token_t)> chunk_cont;
+
+    /* Orders the batches and the final done message */
+    fifo_enforcer_source_t fifo_src;
+    backfill_chunk_batch_t<protocol_t> batch;
+
+    /* Counts chunks that have been sent but not yet applied */
+    adjustable_semaphore_t window;
+
+    ticks_t start_time;
+    int64_t chunks_sent, bytes_sent;
+
+    ticks_t rate_interval_start;
+    int64_t chunks_applied_in_interval;
+
+    DISABLE_COPYING(backfill_chunk_sender_t);
+};
 
 template <class protocol_t>
 class backfiller_send_backfill_callback_t : public send_backfill_callback_t<protocol_t> {
 public:
     backfiller_send_backfill_callback_t(const region_map_t<protocol_t, version_range_t> *start_point,
                                         mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont,
-                                        mailbox_manager_t *mailbox_manager,
-                                        mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont,
-                                        fifo_enforcer_source_t *fifo_src,
-                                        semaphore_t *chunk_semaphore,
+                                        backfill_chunk_sender_t<protocol_t> *chunk_sender,
                                         backfiller_t<protocol_t> *backfiller)
         : start_point_(start_point),
           end_point_cont_(end_point_cont),
-          mailbox_manager_(mailbox_manager),
-          chunk_cont_(chunk_cont),
-          fifo_src_(fifo_src),
-          chunk_semaphore_(chunk_semaphore),
+          chunk_sender_(chunk_sender),
           backfiller_(backfiller) { }
 
     bool should_backfill_impl(const typename store_view_t<protocol_t>::metainfo_t &metainfo) {
@@ -119,15 +205,16 @@ public:
     }
 
     void send_chunk(const typename protocol_t::backfill_chunk_t &chunk, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
-        do_send_chunk<protocol_t>(mailbox_manager_, chunk_cont_, chunk, fifo_src_, chunk_semaphore_, interruptor);
+        chunk_sender_->send_chunk(chunk, interruptor);
+    }
+
+    void finish_region(const typename protocol_t::region_t &region, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        chunk_sender_->finish_region(region, interruptor);
     }
 private:
     const region_map_t<protocol_t, version_range_t> *start_point_;
     mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont_;
-    mailbox_manager_t *mailbox_manager_;
-    mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont_;
-    fifo_enforcer_source_t *fifo_src_;
-    semaphore_t *chunk_semaphore_;
+    backfill_chunk_sender_t<protocol_t> *chunk_sender_;
     backfiller_t<protocol_t> *backfiller_;
 
     DISABLE_COPYING(backfiller_send_backfill_callback_t);
@@ -138,7 +225,7 @@ void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
                                            const region_map_t<protocol_t, version_range_t> &start_point,
                                            const branch_history_t<protocol_t> &start_point_associated_branch_history,
                                            mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont,
-                                           mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont,
+                                           mailbox_addr_t<void(backfill_chunk_batch_t<protocol_t>, fifo_enforcer_write_token_t)> chunk_cont,
                                            mailbox_addr_t<void(fifo_enforcer_write_token_t)> done_cont,
                                            mailbox_addr_t<void(mailbox_addr_t<void(int)>)> allocation_registration_box,
                                            auto_drainer_t::lock_t keepalive) {
@@ -160,8 +247,10 @@ void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
        wait on that cond yet. */
     wait_any_t interrupted(&local_interruptor, keepalive.get_drain_signal());
 
-    semaphore_t chunk_semaphore(MAX_CHUNKS_OUT);
-    mailbox_t<void(int)> receive_allocations_mbox(mailbox_manager, boost::bind(&semaphore_t::unlock, &chunk_semaphore, _1), mailbox_callback_mode_inline);
+    backfill_chunk_sender_t<protocol_t> chunk_sender(mailbox_manager, chunk_cont);
+    map_insertion_sentry_t<backfill_session_id_t, backfill_chunk_sender_t<protocol_t> *> display_rates(&local_chunk_senders, session_id, &chunk_sender);
+
+    mailbox_t<void(int)> receive_allocations_mbox(mailbox_manager, boost::bind(&backfill_chunk_sender_t<protocol_t>::on_chunks_applied, &chunk_sender, _1), mailbox_callback_mode_inline);
     send(mailbox_manager, allocation_registration_box, receive_allocations_mbox.get_address());
 
     try {
@@ -170,14 +259,11 @@ void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
             branch_history_manager->import_branch_history(start_point_associated_branch_history, keepalive.get_drain_signal());
         }
 
-        // TODO: Describe this fifo source's purpose a bit.  It's for ordering backfill operations, right?
-        fifo_enforcer_source_t fifo_src;
-
         read_token_pair_t send_backfill_token_pair;
         svs->new_read_token_pair(&send_backfill_token_pair);
 
         backfiller_send_backfill_callback_t<protocol_t>
-            send_backfill_cb(&start_point, end_point_cont, mailbox_manager, chunk_cont, &fifo_src, &chunk_semaphore, this);
+            send_backfill_cb(&start_point, end_point_cont, &chunk_sender, this);
 
         /* Actually perform the backfill */
         svs->send_backfill(
@@ -190,8 +276,9 @@ void backfiller_t<protocol_t>::on_backfill(backfill_session_id_t session_id,
                      &send_backfill_token_pair,
                      &interrupted);
 
-        /* Send a confirmation */
-        send(mailbox_manager, done_cont, fifo_src.enter_write());
+        /* Send the last partial batch and then a confirmation */
+        chunk_sender.flush(&interrupted);
+        send(mailbox_manager, done_cont, chunk_sender.enter_write());
 
     } catch (const interrupted_exc_t &) {
         /* Ignore. If we were interrupted by the backfillee, then it already
@@ -223,15 +310,18 @@ void backfiller_t<protocol_t>::on_cancel_backfill(backfill_session_id_t session_
 
 template <class protocol_t>
 void backfiller_t<protocol_t>::request_backfill_progress(backfill_session_id_t session_id,
-                                                         mailbox_addr_t<void(std::pair<int, int>)> response_mbox,
+                                                         mailbox_addr_t<void(backfill_progress_report_t)> response_mbox,
                                                          auto_drainer_t::lock_t) {
+    backfill_progress_report_t report;
     if (std_contains(local_backfill_progress, session_id) && local_backfill_progress[session_id]) {
         progress_completion_fraction_t fraction = local_backfill_progress[session_id]->guess_completion();
-        std::pair<int, int> pair_fraction = std::make_pair(fraction.estimate_of_released_nodes, fraction.estimate_of_total_nodes);
-        send(mailbox_manager, response_mbox, pair_fraction);
-    } else {
-        send(mailbox_manager, response_mbox, std::make_pair(-1, -1));
+        report.released_nodes = fraction.estimate_of_released_nodes;
+        report.total_nodes = fraction.estimate_of_total_nodes;
+        if (std_contains(local_chunk_senders, session_id)) {
+            local_chunk_senders[session_id]->fill_in_rates(&report);
+        }
     }
+    send(mailbox_manager, response_mbox, report);
 
     //TODO indicate an error has occurred
 }
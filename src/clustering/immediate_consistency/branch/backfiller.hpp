@@ -8,13 +8,18 @@
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "clustering/immediate_consistency/branch/metadata.hpp"
 
+template <class> class backfill_chunk_sender_t;
 template <class> class backfiller_send_backfill_callback_t;
 template <class> class semilattice_read_view_t;
 class traversal_progress_combiner_t;
 
 /* If you construct a `backfiller_t` for a given store, then it will advertise
 its existence in the metadata and serve backfills over the network. Generally
-`backfiller_t` is constructed as a member of `replier_t`. */
+`backfiller_t` is constructed as a member of `replier_t`.
+
+Backfill chunks go out in size-bounded batches (see `backfill_chunk_batch_t`),
+and the number of chunks that may be in flight at once follows the rate at
+which the backfillee reports having applied them (see `BACKFILL_WINDOW_MS`). */
 
 template <class protocol_t>
 class backfiller_t : public home_thread_mixin_debug_only_t {
@@ -38,7 +43,7 @@ private:
             const region_map_t<protocol_t, version_range_t> &start_point,
             const branch_history_t<protocol_t> &start_point_associated_branch_history,
             mailbox_addr_t<void(region_map_t<protocol_t, version_range_t>, branch_history_t<protocol_t>)> end_point_cont,
-            mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)> chunk_cont,
+            mailbox_addr_t<void(backfill_chunk_batch_t<protocol_t>, fifo_enforcer_write_token_t)> chunk_cont,
             mailbox_addr_t<void(fifo_enforcer_write_token_t)> done_cont,
             mailbox_addr_t<void(mailbox_addr_t<void(int)>)> allocation_registration_box,
             auto_drainer_t::lock_t keepalive);
@@ -46,7 +51,7 @@ private:
     void on_cancel_backfill(backfill_session_id_t session_id, UNUSED auto_drainer_t::lock_t);
 
     void request_backfill_progress(backfill_session_id_t session_id,
-                                   mailbox_addr_t<void(std::pair<int, int>)> response_mbox,
+                                   mailbox_addr_t<void(backfill_progress_report_t)> response_mbox,
                                    auto_drainer_t::lock_t);
 
     mailbox_manager_t *const mailbox_manager;
@@ -56,6 +61,7 @@ private:
 
     std::map<backfill_session_id_t, cond_t *> local_interruptors;
     std::map<backfill_session_id_t, traversal_progress_combiner_t *> local_backfill_progress;
+    std::map<backfill_session_id_t, backfill_chunk_sender_t<protocol_t> *> local_chunk_senders;
     auto_drainer_t drainer;
 
     typename backfiller_business_card_t<protocol_t>::backfill_mailbox_t backfill_mailbox;
@@ -7,12 +7,14 @@
 #include "concurrency/coro_fifo.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/death_runner.hpp"
 #include "containers/uuid.hpp"
 #include "clustering/immediate_consistency/branch/listener.hpp"
 #include "clustering/immediate_consistency/branch/multistore.hpp"
 // TODO: Make us not include master.hpp -- we do it only for the ack_checker_t type.
 #include "clustering/immediate_consistency/query/master.hpp"
+#include "config/args.hpp"
 #include "rpc/mailbox/typed.hpp"
 #include "rpc/semilattice/view/field.hpp"
 #include "rpc/semilattice/view/member.hpp"
@@ -193,13 +195,35 @@ public:
         write = r.write;
         return *this;
     }
-    boost::shared_ptr<incomplete_write_t> get() {
+    boost::shared_ptr<incomplete_write_t> get() const {
         return write;
     }
 private:
     boost::shared_ptr<incomplete_write_t> write;
 };
 
+/* A write waiting in a dispatchee's queue to be sent to its mirror.
+   `is_writeread` is whether the mirror was readable when the write was
+   queued; if so, it goes to the write-read mailbox and we wait for the
+   response instead of just an ack. */
+template <class protocol_t>
+class broadcaster_t<protocol_t>::queued_write_t {
+public:
+    queued_write_t() { }
+    queued_write_t(const incomplete_write_ref_t &w, const auto_drainer_t::lock_t &ml,
+                   order_token_t ot, fifo_enforcer_write_token_t ft,
+                   bool iwr, write_durability_t d)
+        : write_ref(w), mirror_lock(ml), order_token(ot), fifo_token(ft),
+          is_writeread(iwr), durability(d) { }
+
+    incomplete_write_ref_t write_ref;
+    auto_drainer_t::lock_t mirror_lock;
+    order_token_t order_token;
+    fifo_enforcer_write_token_t fifo_token;
+    bool is_writeread;
+    write_durability_t durability;
+};
+
 /* The `registrar_t` constructs a `dispatchee_t` for every mirror that
    connects to us. */
 
@@ -211,8 +235,8 @@ public:
         queue_count(),
         queue_count_membership(&c->broadcaster_collection, &queue_count, uuid_to_str(d.write_mailbox.get_peer().get_uuid()) + "_broadcast_queue_count"),
         background_write_queue(&queue_count),
-        // TODO magic constant
-        background_write_workers(100, &background_write_queue, &background_write_caller),
+        background_write_caller(boost::bind(&broadcaster_t::background_write, c, this, _1)),
+        background_write_workers(BROADCASTER_MAX_WRITE_BATCHES_OUT, &background_write_queue, &background_write_caller),
         controller(c),
         upgrade_mailbox(controller->mailbox_manager,
             boost::bind(&dispatchee_t::upgrade, this, _1, _2, auto_drainer_t::lock_t(&drainer)), mailbox_callback_mode_inline),
@@ -240,8 +264,9 @@ public:
         for (typename std::list<boost::shared_ptr<incomplete_write_t> >::iterator it = controller->incomplete_writes.begin();
                 it != controller->incomplete_writes.end(); it++) {
 
-            coro_t::spawn_sometime(boost::bind(&broadcaster_t::background_write, controller,
-                                               this, auto_drainer_t::lock_t(&drainer), incomplete_write_ref_t(*it), order_source.check_in("dispatchee_t"), fifo_source.enter_write()));
+            background_write_queue.push(queued_write_t(incomplete_write_ref_t(*it), auto_drainer_t::lock_t(&drainer),
+                                                       order_source.check_in("dispatchee_t"), fifo_source.enter_write(),
+                                                       false, WRITE_DURABILITY_SOFT));
         }
     }
 
@@ -318,11 +343,11 @@ public:
 
     perfmon_counter_t queue_count;
     perfmon_membership_t queue_count_membership;
-    unlimited_fifo_queue_t<boost::function<void()> > background_write_queue;
-    calling_callback_t background_write_caller;
+    unlimited_fifo_queue_t<queued_write_t> background_write_queue;
+    boost_function_callback_t<queued_write_t> background_write_caller;
 
 private:
-    coro_pool_t<boost::function<void()> > background_write_workers;
+    coro_pool_t<queued_write_t> background_write_workers;
     broadcaster_t *controller;
     auto_drainer_t drainer;
 
@@ -332,30 +357,9 @@ private:
     DISABLE_COPYING(dispatchee_t);
 };
 
-/* Functions to send a read or write to a mirror and wait for a response.
-Important: These functions must send the message before responding to
-`interruptor` being pulsed. */
-
-template<class protocol_t>
-void listener_write(
-        mailbox_manager_t *mailbox_manager,
-        const typename listener_business_card_t<protocol_t>::write_mailbox_t::address_t &write_mailbox,
-        const typename protocol_t::write_t &w, transition_timestamp_t ts,
-        order_token_t order_token, fifo_enforcer_write_token_t token,
-        signal_t *interruptor)
-        THROWS_ONLY(interrupted_exc_t)
-{
-    cond_t ack_cond;
-    mailbox_t<void()> ack_mailbox(
-        mailbox_manager,
-        boost::bind(&cond_t::pulse, &ack_cond),
-        mailbox_callback_mode_inline);
-
-    send(mailbox_manager, write_mailbox,
-         w, ts, order_token, token, ack_mailbox.get_address());
-
-    wait_interruptible(&ack_cond, interruptor);
-}
+/* Function to send a read to a mirror and wait for a response. Important:
+This function must send the message before responding to `interruptor` being
+pulsed. */
 
 template <class response_t>
 void store_listener_response(response_t *result_out, const response_t &result_in, cond_t *done) {
@@ -490,11 +494,11 @@ void broadcaster_t<protocol_t>::spawn_write(const typename protocol_t::write_t &
                 unreachable();
             }
 
-            it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_writeread, this,
-                it->first, it->second, write_ref, order_token, fifo_enforcer_token, durability));
+            it->first->background_write_queue.push(queued_write_t(write_ref, it->second,
+                order_token, fifo_enforcer_token, true, durability));
         } else {
-            it->first->background_write_queue.push(boost::bind(&broadcaster_t::background_write, this,
-                it->first, it->second, write_ref, order_token, fifo_enforcer_token));
+            it->first->background_write_queue.push(queued_write_t(write_ref, it->second,
+                order_token, fifo_enforcer_token, false, WRITE_DURABILITY_SOFT));
         }
     }
 }
@@ -519,35 +523,78 @@ void broadcaster_t<protocol_t>::pick_a_readable_dispatchee(dispatchee_t **dispat
 }
 
 template<class protocol_t>
-void broadcaster_t<protocol_t>::background_write(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, order_token_t order_token, fifo_enforcer_write_token_t token) THROWS_NOTHING {
-    try {
-        listener_write<protocol_t>(mailbox_manager, mirror->write_mailbox,
-                                   write_ref.get()->write, write_ref.get()->timestamp, order_token, token,
-                                   mirror_lock.get_drain_signal());
-    } catch (const interrupted_exc_t &) {
-        return;
+void broadcaster_t<protocol_t>::background_write(dispatchee_t *mirror, const queued_write_t &first_write) THROWS_NOTHING {
+    /* Send along whatever else is waiting for this mirror. This is what makes
+    the batches: while all of the workers are waiting on the mirror, new writes
+    pile up in the queue, and the next worker to come free takes them all. */
+    std::vector<queued_write_t> writes(1, first_write);
+    while (writes.size() < BROADCASTER_MAX_WRITE_BATCH && mirror->background_write_queue.available->get()) {
+        writes.push_back(mirror->background_write_queue.pop());
     }
+
+    /* Writes and write-reads go to different mailboxes, so the batch gets
+    split wherever the mirror was upgraded or downgraded. That hardly ever
+    happens. */
+    std::vector<std::pair<size_t, size_t> > runs;
+    size_t run_start = 0;
+    for (size_t i = 1; i <= writes.size(); ++i) {
+        if (i == writes.size() || writes[i].is_writeread != writes[run_start].is_writeread) {
+            runs.push_back(std::make_pair(run_start, i));
+            run_start = i;
+        }
+    }
+
+    pmap(runs.size(), boost::bind(&broadcaster_t::send_write_batch, this,
+                                  mirror, &writes, &runs, _1));
 }
 
 template<class protocol_t>
-void broadcaster_t<protocol_t>::background_writeread(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, order_token_t order_token, fifo_enforcer_write_token_t token, const write_durability_t durability) THROWS_NOTHING {
-    try {
-        cond_t response_cond;
-        typename protocol_t::write_response_t response;
-        mailbox_t<void(typename protocol_t::write_response_t)> response_mailbox(
-            mailbox_manager,
-            boost::bind(&store_listener_response<typename protocol_t::write_response_t>, &response, _1, &response_cond),
-            mailbox_callback_mode_inline);
+void broadcaster_t<protocol_t>::send_write_batch(dispatchee_t *mirror, const std::vector<queued_write_t> *writes,
+                                                 const std::vector<std::pair<size_t, size_t> > *runs, int i) THROWS_NOTHING {
+    size_t begin = (*runs)[i].first, end = (*runs)[i].second;
+    std::vector<replicated_write_t<protocol_t> > batch;
+    batch.reserve(end - begin);
+    for (size_t j = begin; j < end; ++j) {
+        const queued_write_t &w = (*writes)[j];
+        batch.push_back(replicated_write_t<protocol_t>(w.write_ref.get()->write, w.write_ref.get()->timestamp,
+                                                       w.order_token, w.fifo_token, w.durability));
+    }
 
-        send(mailbox_manager, mirror->writeread_mailbox, write_ref.get()->write, write_ref.get()->timestamp, order_token, token, response_mailbox.get_address(), durability);
+    /* Every write in the queue holds the same lock on the mirror */
+    signal_t *interruptor = (*writes)[begin].mirror_lock.get_drain_signal();
 
-        wait_interruptible(&response_cond, mirror_lock.get_drain_signal());
+    try {
+        if ((*writes)[begin].is_writeread) {
+            cond_t response_cond;
+            std::vector<typename protocol_t::write_response_t> responses;
+            mailbox_t<void(std::vector<typename protocol_t::write_response_t>)> response_mailbox(
+                mailbox_manager,
+                boost::bind(&store_listener_response<std::vector<typename protocol_t::write_response_t> >, &responses, _1, &response_cond),
+                mailbox_callback_mode_inline);
+
+            send(mailbox_manager, mirror->writeread_mailbox, batch, response_mailbox.get_address());
+
+            wait_interruptible(&response_cond, interruptor);
+            guarantee(responses.size() == batch.size());
+
+            for (size_t j = begin; j < end; ++j) {
+                // TODO: Require that everybody provide a callback.
+                incomplete_write_t *write = (*writes)[j].write_ref.get().get();
+                if (write->callback) {
+                    write->callback->on_response(mirror->get_peer(), responses[j - begin]);
+                }
+            }
+        } else {
+            cond_t ack_cond;
+            mailbox_t<void()> ack_mailbox(
+                mailbox_manager,
+                boost::bind(&cond_t::pulse, &ack_cond),
+                mailbox_callback_mode_inline);
 
-        // TODO: Require that everybody provide a callback.
-        if (write_ref.get()->callback) {
-            write_ref.get()->callback->on_response(mirror->get_peer(), response);
-        }
+            send(mailbox_manager, mirror->write_mailbox, batch, ack_mailbox.get_address());
 
+            wait_interruptible(&ack_cond, interruptor);
+        }
     } catch (const interrupted_exc_t &) {
         return;
     }
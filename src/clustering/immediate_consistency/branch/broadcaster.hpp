@@ -4,6 +4,8 @@
 
 #include <list>
 #include <map>
+#include <utility>
+#include <vector>
 
 #include "utils.hpp"
 #include <boost/shared_ptr.hpp>
@@ -91,6 +93,8 @@ public:
 private:
     class incomplete_write_ref_t;
 
+    class queued_write_t;
+
     class dispatchee_t;
 
     /* Reads need to pick a single readable mirror to perform the operation.
@@ -101,8 +105,12 @@ private:
     machine.) */
     void pick_a_readable_dispatchee(dispatchee_t **dispatchee_out, mutex_assertion_t::acq_t *proof, auto_drainer_t::lock_t *lock_out) THROWS_ONLY(cannot_perform_query_exc_t);
 
-    void background_write(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, order_token_t order_token, fifo_enforcer_write_token_t token) THROWS_NOTHING;
-    void background_writeread(dispatchee_t *mirror, auto_drainer_t::lock_t mirror_lock, incomplete_write_ref_t write_ref, order_token_t order_token, fifo_enforcer_write_token_t token, write_durability_t durability) THROWS_NOTHING;
+    /* `background_write()` is run by the dispatchee's pool of workers. It
+    sends `first_write` to the mirror together with the writes that are queued
+    up behind it, and waits for the mirror to finish them. */
+    void background_write(dispatchee_t *mirror, const queued_write_t &first_write) THROWS_NOTHING;
+    void send_write_batch(dispatchee_t *mirror, const std::vector<queued_write_t> *writes,
+                          const std::vector<std::pair<size_t, size_t> > *runs, int i) THROWS_NOTHING;
     void end_write(boost::shared_ptr<incomplete_write_t> write) THROWS_NOTHING;
 
     /* This function sanity-checks `incomplete_writes`, `current_timestamp`,
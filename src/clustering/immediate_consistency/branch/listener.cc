@@ -8,6 +8,7 @@
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/coro_pool.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/pmap.hpp"
 
 
 /* `WRITE_QUEUE_CORO_POOL_SIZE` is the number of coroutines that will be used
@@ -77,10 +78,10 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
         WRITE_QUEUE_SEMAPHORE_TRICKLE_FRACTION),
     enforce_max_outstanding_writes_from_broadcaster_(MAX_OUTSTANDING_WRITES_FROM_BROADCASTER),
     write_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_write, this, _1, _2, _3, _4, _5),
+        boost::bind(&listener_t::on_write, this, _1, _2),
         mailbox_callback_mode_inline),
     writeread_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_writeread, this, _1, _2, _3, _4, _5, _6),
+        boost::bind(&listener_t::on_writeread, this, _1, _2),
         mailbox_callback_mode_inline),
     read_mailbox_(mailbox_manager_,
         boost::bind(&listener_t::on_read, this, _1, _2, _3, _4, _5),
@@ -251,10 +252,10 @@ listener_t<protocol_t>::listener_t(const base_path_t &base_path,
         WRITE_QUEUE_SEMAPHORE_TRICKLE_FRACTION),
     enforce_max_outstanding_writes_from_broadcaster_(MAX_OUTSTANDING_WRITES_FROM_BROADCASTER),
     write_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_write, this, _1, _2, _3, _4, _5),
+        boost::bind(&listener_t::on_write, this, _1, _2),
         mailbox_callback_mode_inline),
     writeread_mailbox_(mailbox_manager_,
-        boost::bind(&listener_t::on_writeread, this, _1, _2, _3, _4, _5, _6),
+        boost::bind(&listener_t::on_writeread, this, _1, _2),
         mailbox_callback_mode_inline),
     read_mailbox_(mailbox_manager_,
         boost::bind(&listener_t::on_read, this, _1, _2, _3, _4, _5),
@@ -396,42 +397,51 @@ void listener_t<protocol_t>::try_start_receiving_writes(
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::on_write(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
+void listener_t<protocol_t>::on_write(const std::vector<replicated_write_t<protocol_t> > &writes,
         mailbox_addr_t<void()> ack_addr) THROWS_NOTHING {
-    rassert(region_is_superset(our_branch_region_, write.get_region()));
-    rassert(!region_is_empty(write.get_region()));
-    order_token.assert_write_mode();
+    rassert(!writes.empty());
+    for (auto it = writes.begin(); it != writes.end(); ++it) {
+        rassert(region_is_superset(our_branch_region_, it->write.get_region()));
+        rassert(!region_is_empty(it->write.get_region()));
+        it->order_token.assert_write_mode();
+    }
 
     coro_t::spawn_sometime(boost::bind(
-        &listener_t<protocol_t>::enqueue_write, this,
-        write, transition_timestamp, order_token, fifo_token, ack_addr,
+        &listener_t<protocol_t>::enqueue_write_batch, this,
+        writes, ack_addr,
         auto_drainer_t::lock_t(&drainer_)));
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::enqueue_write(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
+void listener_t<protocol_t>::enqueue_write_batch(const std::vector<replicated_write_t<protocol_t> > &writes,
         mailbox_addr_t<void()> ack_addr,
         auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    /* The writes in a batch have consecutive FIFO tokens, so they go into the
+    write queue in order no matter which coroutine gets there first. */
+    pmap(writes.size(), boost::bind(&listener_t<protocol_t>::enqueue_write, this,
+                                    &writes, _1, keepalive));
+
+    /* If we were interrupted, some of the writes might not be in the queue */
+    if (!keepalive.get_drain_signal()->is_pulsed()) {
+        send(mailbox_manager_, ack_addr);
+    }
+}
+
+template <class protocol_t>
+void listener_t<protocol_t>::enqueue_write(const std::vector<replicated_write_t<protocol_t> > *writes,
+        int i,
+        auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    const replicated_write_t<protocol_t> &write = (*writes)[i];
     try {
         /* Make sure that the broadcaster isn't sending us too many concurrent
-        writes */
+        writes. The semaphore is released before the batch is acked, because
+        the broadcaster can send us a new write as soon as we send the ack. */
         semaphore_assertion_t::acq_t sem_acq(&enforce_max_outstanding_writes_from_broadcaster_);
 
-        fifo_enforcer_sink_t::exit_write_t fifo_exit(&write_queue_entrance_sink_, fifo_token);
+        fifo_enforcer_sink_t::exit_write_t fifo_exit(&write_queue_entrance_sink_, write.fifo_token);
         wait_interruptible(&fifo_exit, keepalive.get_drain_signal());
         write_queue_semaphore_.co_lock_interruptible(keepalive.get_drain_signal());
-        write_queue_.push(write_queue_entry_t(write, transition_timestamp, order_token, fifo_token));
-
-        /* Release the semaphore before sending the response, because the
-        broadcaster can send us a new write as soon as we send the ack */
-        sem_acq.reset();
-        send(mailbox_manager_, ack_addr);
+        write_queue_.push(write_queue_entry_t(write.write, write.timestamp, write.order_token, write.fifo_token));
 
     } catch (const interrupted_exc_t &) {
         /* pass */
@@ -482,33 +492,48 @@ void listener_t<protocol_t>::perform_enqueued_write(const write_queue_entry_t &q
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::on_writeread(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
-        mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-        write_durability_t durability) THROWS_NOTHING {
-    rassert(region_is_superset(our_branch_region_, write.get_region()));
-    rassert(!region_is_empty(write.get_region()));
-    rassert(region_is_superset(svs_->get_region(), write.get_region()));
-    order_token.assert_write_mode();
+void listener_t<protocol_t>::on_writeread(const std::vector<replicated_write_t<protocol_t> > &writes,
+        mailbox_addr_t<void(std::vector<typename protocol_t::write_response_t>)> ack_addr) THROWS_NOTHING {
+    rassert(!writes.empty());
+    for (auto it = writes.begin(); it != writes.end(); ++it) {
+        rassert(region_is_superset(our_branch_region_, it->write.get_region()));
+        rassert(!region_is_empty(it->write.get_region()));
+        rassert(region_is_superset(svs_->get_region(), it->write.get_region()));
+        it->order_token.assert_write_mode();
+    }
 
     coro_t::spawn_sometime(boost::bind(
-        &listener_t<protocol_t>::perform_writeread, this,
-        write, transition_timestamp, order_token, fifo_token, ack_addr, durability,
+        &listener_t<protocol_t>::perform_writeread_batch, this,
+        writes, ack_addr,
         auto_drainer_t::lock_t(&drainer_)));
 }
 
 template <class protocol_t>
-void listener_t<protocol_t>::perform_writeread(const typename protocol_t::write_t &write,
-        transition_timestamp_t transition_timestamp,
-        order_token_t order_token,
-        fifo_enforcer_write_token_t fifo_token,
-        mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-        const write_durability_t durability,
+void listener_t<protocol_t>::perform_writeread_batch(const std::vector<replicated_write_t<protocol_t> > &writes,
+        mailbox_addr_t<void(std::vector<typename protocol_t::write_response_t>)> ack_addr,
         auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    /* The writes go through `store_entrance_sink_` in order, so each one can
+    start on the B-tree as soon as the one before it has; they don't wait for
+    each other to finish. */
+    std::vector<typename protocol_t::write_response_t> responses(writes.size());
+    pmap(writes.size(), boost::bind(&listener_t<protocol_t>::perform_writeread, this,
+                                    &writes, _1, &responses, keepalive));
+
+    if (!keepalive.get_drain_signal()->is_pulsed()) {
+        send(mailbox_manager_, ack_addr, responses);
+    }
+}
+
+template <class protocol_t>
+void listener_t<protocol_t>::perform_writeread(const std::vector<replicated_write_t<protocol_t> > *writes,
+        int i,
+        std::vector<typename protocol_t::write_response_t> *responses_out,
+        auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    const replicated_write_t<protocol_t> &write = (*writes)[i];
     try {
-        /* Make sure the broadcaster isn't sending us too many writes */
+        /* Make sure the broadcaster isn't sending us too many writes. As in
+        `enqueue_write()`, the semaphore is released before the batch is
+        acked. */
         semaphore_assertion_t::acq_t sem_acq(&enforce_max_outstanding_writes_from_broadcaster_);
 
         write_token_pair_t write_token_pair;
@@ -516,46 +541,39 @@ void listener_t<protocol_t>::perform_writeread(const typename protocol_t::write_
             {
                 /* Briefly pass through `write_queue_entrance_sink_` in case we
                 are receiving a mix of writes and write-reads */
-                fifo_enforcer_sink_t::exit_write_t fifo_exit_1(&write_queue_entrance_sink_, fifo_token);
+                fifo_enforcer_sink_t::exit_write_t fifo_exit_1(&write_queue_entrance_sink_, write.fifo_token);
             }
 
-            fifo_enforcer_sink_t::exit_write_t fifo_exit_2(&store_entrance_sink_, fifo_token);
+            fifo_enforcer_sink_t::exit_write_t fifo_exit_2(&store_entrance_sink_, write.fifo_token);
             wait_interruptible(&fifo_exit_2, keepalive.get_drain_signal());
 
-            advance_current_timestamp_and_pulse_waiters(transition_timestamp);
+            advance_current_timestamp_and_pulse_waiters(write.timestamp);
 
             svs_->new_write_token_pair(&write_token_pair);
         }
 
         // Make sure we can serve the entire operation without masking it.
         // (We shouldn't have been signed up for writereads if we couldn't.)
-        rassert(region_is_superset(svs_->get_region(), write.get_region()));
+        rassert(region_is_superset(svs_->get_region(), write.write.get_region()));
 
 
 #ifndef NDEBUG
-        version_leq_metainfo_checker_callback_t<protocol_t> metainfo_checker_callback(transition_timestamp.timestamp_before());
+        version_leq_metainfo_checker_callback_t<protocol_t> metainfo_checker_callback(write.timestamp.timestamp_before());
         metainfo_checker_t<protocol_t> metainfo_checker(&metainfo_checker_callback, svs_->get_region());
 #endif
 
         // Perform the operation
-        typename protocol_t::write_response_t response;
-
         svs_->write(DEBUG_ONLY(metainfo_checker, )
                     region_map_t<protocol_t, binary_blob_t>(svs_->get_region(),
-                                                            binary_blob_t(version_range_t(version_t(branch_id_, transition_timestamp.timestamp_after())))),
-                    write,
-                    &response,
-                    durability,
-                    transition_timestamp,
-                    order_token,
+                                                            binary_blob_t(version_range_t(version_t(branch_id_, write.timestamp.timestamp_after())))),
+                    write.write,
+                    &responses_out->at(i),
+                    write.durability,
+                    write.timestamp,
+                    write.order_token,
                     &write_token_pair,
                     keepalive.get_drain_signal());
 
-        /* Release the semaphore before sending the response, because the
-        broadcaster can send us a new write as soon as we send the ack */
-        sem_acq.reset();
-        send(mailbox_manager_, ack_addr, response);
-
     } catch (const interrupted_exc_t &) {
         /* pass */
     }
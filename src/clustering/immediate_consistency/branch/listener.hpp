@@ -3,6 +3,7 @@
 #define CLUSTERING_IMMEDIATE_CONSISTENCY_BRANCH_LISTENER_HPP_
 
 #include <map>
+#include <vector>
 
 #include "clustering/immediate_consistency/branch/metadata.hpp"
 #include "concurrency/promise.hpp"
@@ -155,41 +156,38 @@ private:
             signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t, broadcaster_lost_exc_t);
 
-    void on_write(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
+    void on_write(const std::vector<replicated_write_t<protocol_t> > &writes,
             mailbox_addr_t<void()> ack_addr)
         THROWS_NOTHING;
 
-    void enqueue_write(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
+    void enqueue_write_batch(const std::vector<replicated_write_t<protocol_t> > &writes,
             mailbox_addr_t<void()> ack_addr,
             auto_drainer_t::lock_t keepalive)
         THROWS_NOTHING;
 
+    void enqueue_write(const std::vector<replicated_write_t<protocol_t> > *writes,
+            int i,
+            auto_drainer_t::lock_t keepalive)
+        THROWS_NOTHING;
+
     void perform_enqueued_write(const write_queue_entry_t &serialized_write, state_timestamp_t backfill_end_timestamp, signal_t *interruptor)
         THROWS_ONLY(interrupted_exc_t);
 
     /* See the note at the place where `writeread_mailbox` is declared for an
     explanation of why `on_writeread()` and `on_read()` are here. */
 
-    void on_writeread(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
-            mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-            write_durability_t durability)
+    void on_writeread(const std::vector<replicated_write_t<protocol_t> > &writes,
+            mailbox_addr_t<void(std::vector<typename protocol_t::write_response_t>)> ack_addr)
         THROWS_NOTHING;
 
-    void perform_writeread(const typename protocol_t::write_t &write,
-            transition_timestamp_t transition_timestamp,
-            order_token_t order_token,
-            fifo_enforcer_write_token_t fifo_token,
-            mailbox_addr_t<void(typename protocol_t::write_response_t)> ack_addr,
-            write_durability_t durability,
+    void perform_writeread_batch(const std::vector<replicated_write_t<protocol_t> > &writes,
+            mailbox_addr_t<void(std::vector<typename protocol_t::write_response_t>)> ack_addr,
+            auto_drainer_t::lock_t keepalive)
+        THROWS_NOTHING;
+
+    void perform_writeread(const std::vector<replicated_write_t<protocol_t> > *writes,
+            int i,
+            std::vector<typename protocol_t::write_response_t> *responses_out,
             auto_drainer_t::lock_t keepalive)
         THROWS_NOTHING;
 
@@ -4,8 +4,10 @@
 
 #include <map>
 #include <utility>
+#include <vector>
 
 #include "clustering/generic/registration_metadata.hpp"
+#include "clustering/immediate_consistency/branch/backfill_batch.hpp"
 #include "clustering/immediate_consistency/branch/history.hpp"
 #include "concurrency/fifo_checker.hpp"
 #include "concurrency/fifo_enforcer.hpp"
@@ -18,6 +20,32 @@
 
 template <class> class listener_intro_t;
 
+/* The broadcaster doesn't send writes to a listener one at a time; it
+coalesces the writes that are queued up for the listener into batches, in
+the order the broadcaster performed them. `replicated_write_t` is one write in
+such a batch. `durability` only matters for write-reads; plain writes are
+always applied with soft durability. */
+
+template <class protocol_t>
+class replicated_write_t {
+public:
+    replicated_write_t() { }
+    replicated_write_t(const typename protocol_t::write_t &w,
+                       transition_timestamp_t ts,
+                       order_token_t ot,
+                       fifo_enforcer_write_token_t ft,
+                       write_durability_t d)
+        : write(w), timestamp(ts), order_token(ot), fifo_token(ft), durability(d) { }
+
+    typename protocol_t::write_t write;
+    transition_timestamp_t timestamp;
+    order_token_t order_token;
+    fifo_enforcer_write_token_t fifo_token;
+    write_durability_t durability;
+
+    RDB_MAKE_ME_SERIALIZABLE_5(write, timestamp, order_token, fifo_token, durability);
+};
+
 /* Every `listener_t` constructs a `listener_business_card_t` and sends it to
 the `broadcaster_t`. */
 
@@ -26,20 +54,15 @@ class listener_business_card_t {
 
 public:
     /* These are the types of mailboxes that the master uses to communicate with
-    the mirrors. */
+    the mirrors. Writes come in batches; the mirror acks a batch once, when
+    it's done with every write in it, and replies to a batch of write-reads
+    with the responses in the same order as the writes. */
 
-    typedef mailbox_t<void(typename protocol_t::write_t,
-                           transition_timestamp_t,
-                           order_token_t,
-                           fifo_enforcer_write_token_t,
+    typedef mailbox_t<void(std::vector<replicated_write_t<protocol_t> >,
                            mailbox_addr_t<void()> ack_addr)> write_mailbox_t;
 
-    typedef mailbox_t<void(typename protocol_t::write_t,
-                           transition_timestamp_t,
-                           order_token_t,
-                           fifo_enforcer_write_token_t,
-                           mailbox_addr_t<void(typename protocol_t::write_response_t)>,
-                           write_durability_t)> writeread_mailbox_t;
+    typedef mailbox_t<void(std::vector<replicated_write_t<protocol_t> >,
+                           mailbox_addr_t<void(std::vector<typename protocol_t::write_response_t>)>)> writeread_mailbox_t;
 
     typedef mailbox_t<void(typename protocol_t::read_t,
                            state_timestamp_t,
@@ -97,6 +120,25 @@ backfills over the network. It appears in the directory. */
 
 typedef uuid_u backfill_session_id_t;
 
+/* What a backfiller replies when asked how a backfill is going.
+`released_nodes` and `total_nodes` are the traversal's guess at how far along
+it is (see `progress_completion_fraction_t`), or -1 if it can't tell.
+`chunks_per_sec` and `bytes_per_sec` are how fast backfill chunks have been
+sent so far, and `eta_secs` is how much longer the backfill will take if it
+keeps going at that rate, or -1 if that isn't known yet. */
+struct backfill_progress_report_t {
+    backfill_progress_report_t()
+        : released_nodes(-1), total_nodes(-1),
+          chunks_per_sec(0), bytes_per_sec(0), eta_secs(-1) { }
+
+    int released_nodes, total_nodes;
+    double chunks_per_sec, bytes_per_sec;
+    double eta_secs;
+
+    RDB_MAKE_ME_SERIALIZABLE_5(released_nodes, total_nodes,
+                               chunks_per_sec, bytes_per_sec, eta_secs);
+};
+
 template<class protocol_t>
 struct backfiller_business_card_t {
 
@@ -108,7 +150,7 @@ struct backfiller_business_card_t {
             region_map_t<protocol_t, version_range_t>,
             branch_history_t<protocol_t>
             ) >,
-        mailbox_addr_t<void(typename protocol_t::backfill_chunk_t, fifo_enforcer_write_token_t)>,
+        mailbox_addr_t<void(backfill_chunk_batch_t<protocol_t>, fifo_enforcer_write_token_t)>,
         mailbox_t<void(fifo_enforcer_write_token_t)>::address_t,
         mailbox_t<void(mailbox_addr_t<void(int)>)>::address_t
         )> backfill_mailbox_t;
@@ -117,7 +159,7 @@ struct backfiller_business_card_t {
 
 
     /* Mailboxes used for requesting the progress of a backfill */
-    typedef mailbox_t<void(backfill_session_id_t, mailbox_addr_t<void(std::pair<int, int>)>)> request_progress_mailbox_t;
+    typedef mailbox_t<void(backfill_session_id_t, mailbox_addr_t<void(backfill_progress_report_t)>)> request_progress_mailbox_t;
 
     backfiller_business_card_t() { }
     backfiller_business_card_t(
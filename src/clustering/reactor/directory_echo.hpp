@@ -6,11 +6,18 @@
 
 #include "concurrency/watchable.hpp"
 #include "containers/scoped.hpp"
+#include "rpc/directory/diff.hpp"
 #include "rpc/mailbox/typed.hpp"
 #include "utils.hpp"
 
 typedef int32_t directory_echo_version_t;
 
+template<class internal_t>
+class directory_echo_wrapper_t;
+
+template<class internal_t>
+bool directory_value_unchanged(const directory_echo_wrapper_t<internal_t> &old_value, const directory_echo_wrapper_t<internal_t> &new_value);
+
 template<class internal_t>
 class directory_echo_wrapper_t {
 public:
@@ -21,6 +28,7 @@ private:
     friend class directory_echo_writer_t;
     template<class internal2_t>
     friend class directory_echo_mirror_t;
+    friend bool directory_value_unchanged<>(const directory_echo_wrapper_t &old_value, const directory_echo_wrapper_t &new_value);
     directory_echo_wrapper_t(const internal_t &i, directory_echo_version_t v, const mailbox_addr_t<void(peer_id_t, directory_echo_version_t)> &am) :
         internal(i), version(v), ack_mailbox(am) { }
     directory_echo_version_t version;
@@ -28,6 +36,15 @@ private:
     RDB_MAKE_ME_SERIALIZABLE_3(internal, version, ack_mailbox);
 };
 
+/* Every change that goes through a `directory_echo_writer_t` bumps the version,
+so a version mismatch is a cheap way to spot a changed value. */
+template<class internal_t>
+bool directory_value_unchanged(const directory_echo_wrapper_t<internal_t> &old_value, const directory_echo_wrapper_t<internal_t> &new_value) {
+    return old_value.version == new_value.version &&
+        directory_value_unchanged(old_value.ack_mailbox, new_value.ack_mailbox) &&
+        directory_value_unchanged(old_value.internal, new_value.internal);
+}
+
 template<class internal_t>
 class directory_echo_writer_t {
 public:
@@ -2,6 +2,7 @@
 #include "clustering/reactor/namespace_interface.hpp"
 #include "clustering/immediate_consistency/query/master_access.hpp"
 #include "concurrency/fifo_enforcer.hpp"
+#include "containers/object_buffer.hpp"
 #include "concurrency/watchable.hpp"
 
 template <class protocol_t>
@@ -198,16 +199,36 @@ cluster_namespace_interface_t<protocol_t>::dispatch_outdated_read(const typename
                     }
                 }
             }
+            relationship_t *hedge_relationship = NULL;
             if (!chosen_relationship && !potential_relationships.empty()) {
-                chosen_relationship = potential_relationships[distributor_rng.randint(potential_relationships.size())];
+                /* Pick two replicas at random and use the one we expect to
+                answer sooner; the other one gets the read too if the first
+                is slow. Always going for the best replica overall would send
+                it every read until its statistics caught up. */
+                int first = distributor_rng.randint(potential_relationships.size());
+                chosen_relationship = potential_relationships[first];
+                if (potential_relationships.size() > 1) {
+                    int second = distributor_rng.randint(potential_relationships.size() - 1);
+                    if (second >= first) {
+                        ++second;
+                    }
+                    hedge_relationship = potential_relationships[second];
+                    if (hedge_relationship->latency.better_than(chosen_relationship->latency, get_ticks())) {
+                        std::swap(chosen_relationship, hedge_relationship);
+                    }
+                }
             }
             if (!chosen_relationship) {
                 /* Don't bother looking for masters; if there are no direct
                    readers, there won't be any masters either. */
                 throw cannot_perform_query_exc_t("No direct reader available");
             }
-            new_op_info->direct_reader_access = chosen_relationship->direct_reader_access;
+            new_op_info->relationship = chosen_relationship;
             new_op_info->keepalive = auto_drainer_t::lock_t(&chosen_relationship->drainer);
+            new_op_info->hedge_relationship = hedge_relationship;
+            if (hedge_relationship) {
+                new_op_info->hedge_keepalive = auto_drainer_t::lock_t(&hedge_relationship->drainer);
+            }
             direct_readers_to_contact.push_back(new_op_info.release());
             new_op_info.init(new outdated_read_info_t());
         }
@@ -230,9 +251,13 @@ cluster_namespace_interface_t<protocol_t>::dispatch_outdated_read(const typename
 }
 
 template <class protocol_t>
-void outdated_read_store_result(typename protocol_t::read_response_t *result_out, const typename protocol_t::read_response_t &result_in, cond_t *done) {
-    *result_out = result_in;
-    done->pulse();
+void outdated_read_store_result(typename protocol_t::read_response_t *result_out, int *answered_by_out, int index, const typename protocol_t::read_response_t &result_in, cond_t *done) {
+    /* If we hedged the read, the slower replica's answer is ignored */
+    if (!done->is_pulsed()) {
+        *result_out = result_in;
+        *answered_by_out = index;
+        done->pulse();
+    }
 }
 
 template <class protocol_t>
@@ -245,17 +270,66 @@ void cluster_namespace_interface_t<protocol_t>::perform_outdated_read(
     THROWS_NOTHING
 {
     outdated_read_info_t *direct_reader_to_contact = &(*direct_readers_to_contact)[i];
+    relationship_t *primary = direct_reader_to_contact->relationship;
+    relationship_t *hedge = direct_reader_to_contact->hedge_relationship;
 
     try {
         cond_t done;
+        int answered_by = -1;
         mailbox_t<void(typename protocol_t::read_response_t)> cont(mailbox_manager,
-                                                                   boost::bind(&outdated_read_store_result<protocol_t>, &results->at(i), _1, &done),
+                                                                   boost::bind(&outdated_read_store_result<protocol_t>, &results->at(i), &answered_by, 0, _1, &done),
                                                                    mailbox_callback_mode_inline);
+        mailbox_t<void(typename protocol_t::read_response_t)> hedge_cont(mailbox_manager,
+                                                                         boost::bind(&outdated_read_store_result<protocol_t>, &results->at(i), &answered_by, 1, _1, &done),
+                                                                         mailbox_callback_mode_inline);
+
+        ticks_t start_time = get_ticks();
+        replica_latency_stats_t::read_sentry_t primary_sentry(&primary->latency);
+        send(mailbox_manager, primary->direct_reader_access->access().read_mailbox, direct_reader_to_contact->sharded_op, cont.get_address());
+
+        /* If the first replica doesn't answer in time, or loses contact, send
+        the read to the other one as well. */
+        bool hedged = false;
+        ticks_t hedge_start_time = 0;
+        object_buffer_t<replica_latency_stats_t::read_sentry_t> hedge_sentry;
+        int64_t hedge_delay_ms;
+        if (hedge != NULL && primary->latency.hedge_delay_ms(&hedge_delay_ms)) {
+            signal_timer_t hedge_timer(hedge_delay_ms);
+            wait_any_t waiter(primary->direct_reader_access->get_failed_signal(), &done, &hedge_timer);
+            wait_interruptible(&waiter, interruptor);
+            if (!done.is_pulsed() && !hedge->direct_reader_access->get_failed_signal()->is_pulsed()) {
+                hedge_start_time = get_ticks();
+                hedge_sentry.create(&hedge->latency);
+                send(mailbox_manager, hedge->direct_reader_access->access().read_mailbox, direct_reader_to_contact->sharded_op, hedge_cont.get_address());
+                hedged = true;
+            }
+        }
 
-        send(mailbox_manager, direct_reader_to_contact->direct_reader_access->access().read_mailbox, direct_reader_to_contact->sharded_op, cont.get_address());
-        wait_any_t waiter(direct_reader_to_contact->direct_reader_access->get_failed_signal(), &done);
-        wait_interruptible(&waiter, interruptor);
-        direct_reader_to_contact->direct_reader_access->access();   /* throws if `get_failed_signal()->is_pulsed()` */
+        /* Wait for an answer, unless everybody we asked has gone away */
+        while (!done.is_pulsed()) {
+            wait_any_t waiter(&done);
+            bool anybody_left = false;
+            if (!primary->direct_reader_access->get_failed_signal()->is_pulsed()) {
+                waiter.add(primary->direct_reader_access->get_failed_signal());
+                anybody_left = true;
+            }
+            if (hedged && !hedge->direct_reader_access->get_failed_signal()->is_pulsed()) {
+                waiter.add(hedge->direct_reader_access->get_failed_signal());
+                anybody_left = true;
+            }
+            if (!anybody_left) {
+                throw resource_lost_exc_t();
+            }
+            wait_interruptible(&waiter, interruptor);
+        }
+
+        ticks_t end_time = get_ticks();
+        /* If the hedged read won, the first replica took at least this long,
+        which is worth remembering even though it hasn't answered yet. */
+        primary->latency.record(start_time, end_time);
+        if (answered_by == 1) {
+            hedge->latency.record(hedge_start_time, end_time);
+        }
     } catch (const resource_lost_exc_t &) {
         failures->at(i).assign("lost contact with direct reader");
     } catch (const interrupted_exc_t &) {
@@ -16,6 +16,7 @@
 #include "arch/timing.hpp"
 #include "clustering/generic/resource.hpp"
 #include "clustering/reactor/metadata.hpp"
+#include "clustering/reactor/replica_latency.hpp"
 #include "containers/clone_ptr.hpp"
 #include "containers/cow_ptr.hpp"
 #include "concurrency/fifo_enforcer.hpp"
@@ -88,6 +89,7 @@ private:
         typename protocol_t::region_t region;
         master_access_t<protocol_t> *master_access;
         resource_access_t<direct_reader_business_card_t<protocol_t> > *direct_reader_access;
+        replica_latency_stats_t latency;
         auto_drainer_t drainer;
     };
 
@@ -104,11 +106,15 @@ private:
         auto_drainer_t::lock_t keepalive;
     };
 
+    /* Outdated reads go to `relationship`. If it's slow to answer and
+    `hedge_relationship` isn't `NULL`, they go there too. */
     class outdated_read_info_t {
     public:
         typename protocol_t::read_t sharded_op;
-        resource_access_t<direct_reader_business_card_t<protocol_t> > *direct_reader_access;
+        relationship_t *relationship;
         auto_drainer_t::lock_t keepalive;
+        relationship_t *hedge_relationship;
+        auto_drainer_t::lock_t hedge_keepalive;
     };
 
     template <class op_type, class fifo_enforcer_token_type, class op_response_type>
@@ -235,7 +235,6 @@ void reactor_t<protocol_t>::run_role(
              * up in the directory thus make sure that the bcard is in the
              * directory before the be_role functions get called. */
             directory_echo_mirror.get_internal()->run_until_satisfied(boost::bind(&we_see_our_bcard<protocol_t>, _1, get_me()), &wait_any);
-            // guarantee(CLUSTER_CPU_SHARDING_FACTOR == svs_subview.num_stores());
 
             pmap(svs_subview.num_stores(), boost::bind(&reactor_t<protocol_t>::run_cpu_sharded_role, this, _1, role, region, &svs_subview, &wait_any, &role->abort_roles));
         } catch (const interrupted_exc_t &) {
@@ -0,0 +1,54 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "clustering/reactor/replica_latency.hpp"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "config/args.hpp"
+
+replica_latency_stats_t::replica_latency_stats_t() :
+    in_flight(0), has_samples(false), last_sample_time(0),
+    average_secs(0), deviation_secs(0) { }
+
+void replica_latency_stats_t::record(ticks_t start_time, ticks_t end_time) {
+    double sample = end_time > start_time ? ticks_to_secs(end_time - start_time) : 0;
+    if (!has_samples) {
+        average_secs = sample;
+        deviation_secs = sample / 2;
+        has_samples = true;
+    } else {
+        const double weight = OUTDATED_READ_LATENCY_EWMA_WEIGHT;
+        deviation_secs = (1 - weight) * deviation_secs + weight * fabs(sample - average_secs);
+        average_secs = (1 - weight) * average_secs + weight * sample;
+    }
+    last_sample_time = std::max(last_sample_time, end_time);
+}
+
+double replica_latency_stats_t::expected_latency_secs(ticks_t now) const {
+    if (!has_samples) {
+        return 0;
+    }
+    if (now > last_sample_time &&
+            ticks_to_secs(now - last_sample_time) * 1000 > OUTDATED_READ_LATENCY_STALE_MS) {
+        return 0;
+    }
+    return average_secs * (in_flight + 1);
+}
+
+bool replica_latency_stats_t::hedge_delay_ms(int64_t *delay_out) const {
+    if (!has_samples) {
+        return false;
+    }
+    int64_t delay = static_cast<int64_t>(ceil((average_secs + 4 * deviation_secs) * 1000));
+    *delay_out = std::max<int64_t>(delay, OUTDATED_READ_HEDGE_MIN_MS);
+    return true;
+}
+
+bool replica_latency_stats_t::better_than(const replica_latency_stats_t &other, ticks_t now) const {
+    double ours = expected_latency_secs(now), theirs = other.expected_latency_secs(now);
+    if (ours != theirs) {
+        return ours < theirs;
+    }
+    return in_flight < other.in_flight;
+}
@@ -0,0 +1,62 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CLUSTERING_REACTOR_REPLICA_LATENCY_HPP_
+#define CLUSTERING_REACTOR_REPLICA_LATENCY_HPP_
+
+#include "errors.hpp"
+#include "utils.hpp"
+
+/* `replica_latency_stats_t` keeps track of how quickly one replica has been
+answering outdated reads, so that `cluster_namespace_interface_t` can send reads
+to whichever replica is likely to answer first. It is only ever touched from the
+namespace interface's thread. */
+class replica_latency_stats_t {
+public:
+    replica_latency_stats_t();
+
+    /* Records that a read that started at `start_time` was answered (or given
+    up on) at `end_time`. */
+    void record(ticks_t start_time, ticks_t end_time);
+
+    /* How long we expect a new read sent to this replica to take, taking into
+    account the reads that are already waiting on it. Returns zero if we don't
+    know, either because the replica hasn't answered anything yet or because it
+    hasn't answered anything for a while; this makes us try it again. */
+    double expected_latency_secs(ticks_t now) const;
+
+    /* How long to wait for an answer before also sending the read to another
+    replica. This is an estimate of a high percentile of the replica's response
+    time, computed the way TCP computes its retransmission timeout. Returns
+    false if the replica hasn't answered anything yet, in which case we don't
+    know enough to pick a delay. */
+    MUST_USE bool hedge_delay_ms(int64_t *delay_out) const;
+
+    /* Returns true if a new read should go to `this` rather than `other`. */
+    bool better_than(const replica_latency_stats_t &other, ticks_t now) const;
+
+    int reads_in_flight() const { return in_flight; }
+
+    /* Construct one of these for as long as a read is waiting on the replica */
+    class read_sentry_t {
+    public:
+        explicit read_sentry_t(replica_latency_stats_t *_parent) : parent(_parent) {
+            ++parent->in_flight;
+        }
+        ~read_sentry_t() {
+            --parent->in_flight;
+        }
+    private:
+        replica_latency_stats_t *parent;
+        DISABLE_COPYING(read_sentry_t);
+    };
+
+private:
+    int in_flight;
+    bool has_samples;
+    ticks_t last_sample_time;
+    double average_secs;
+    double deviation_secs;
+
+    DISABLE_COPYING(replica_latency_stats_t);
+};
+
+#endif  // CLUSTERING_REACTOR_REPLICA_LATENCY_HPP_
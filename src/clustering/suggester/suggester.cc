@@ -1,6 +1,8 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "clustering/suggester/suggester.hpp"
 
+#include <algorithm>
+
 #include "stl_utils.hpp"
 #include "containers/priority_queue.hpp"
 #include "clustering/generic/nonoverlapping_regions.hpp"
@@ -346,6 +348,103 @@ persistable_blueprint_t<protocol_t> suggest_blueprint(
     return blueprint;
 }
 
+namespace {
+
+/* Merges the key distribution and the load into a single weight per key,
+normalized so the weights add up to one. Returns false if there's nothing to
+go on. */
+bool combine_shard_weights(const std::map<store_key_t, int64_t> &key_counts,
+                           const std::map<store_key_t, double> &traffic,
+                           double load_weight,
+                           std::map<store_key_t, double> *weights_out) {
+    guarantee(load_weight >= 0 && load_weight <= 1);
+
+    double total_keys = 0;
+    for (std::map<store_key_t, int64_t>::const_iterator it = key_counts.begin(); it != key_counts.end(); ++it) {
+        total_keys += std::max<int64_t>(it->second, 0);
+    }
+    double total_load = 0;
+    for (std::map<store_key_t, double>::const_iterator it = traffic.begin(); it != traffic.end(); ++it) {
+        total_load += std::max(it->second, 0.0);
+    }
+
+    if (total_keys == 0 && total_load == 0) {
+        return false;
+    } else if (total_keys == 0) {
+        load_weight = 1;
+    } else if (total_load == 0) {
+        load_weight = 0;
+    }
+
+    weights_out->clear();
+    if (load_weight < 1) {
+        for (std::map<store_key_t, int64_t>::const_iterator it = key_counts.begin(); it != key_counts.end(); ++it) {
+            (*weights_out)[it->first] += (1 - load_weight) * std::max<int64_t>(it->second, 0) / total_keys;
+        }
+    }
+    if (load_weight > 0) {
+        for (std::map<store_key_t, double>::const_iterator it = traffic.begin(); it != traffic.end(); ++it) {
+            (*weights_out)[it->first] += load_weight * std::max(it->second, 0.0) / total_load;
+        }
+    }
+    return true;
+}
+
+}  // namespace
+
+std::vector<store_key_t> suggest_split_points(
+        const std::map<store_key_t, int64_t> &key_counts,
+        const std::map<store_key_t, double> &traffic,
+        size_t num_shards,
+        double load_weight) {
+    guarantee(num_shards > 0);
+    std::vector<store_key_t> split_points;
+    std::map<store_key_t, double> weights;
+    if (!combine_shard_weights(key_counts, traffic, load_weight, &weights)) {
+        return split_points;
+    }
+
+    /* Walk the keys in order and start a new shard at whichever key brings the
+    running total closest to the next multiple of `1 / num_shards`. The first
+    key can't start a shard, since the shard before it would be empty. */
+    double weight_so_far = 0;
+    size_t next_shard = 1;
+    for (std::map<store_key_t, double>::const_iterator it = weights.begin();
+         it != weights.end() && next_shard < num_shards;
+         ++it) {
+        double target = static_cast<double>(next_shard) / num_shards;
+        if (it != weights.begin() && weight_so_far + it->second / 2 >= target) {
+            split_points.push_back(it->first);
+            /* One key may be heavy enough to be worth several shards; skip the
+            targets it covers, since we can't split it any further. */
+            while (next_shard < num_shards &&
+                   weight_so_far + it->second / 2 >= static_cast<double>(next_shard) / num_shards) {
+                ++next_shard;
+            }
+        }
+        weight_so_far += it->second;
+    }
+    return split_points;
+}
+
+double estimate_shard_imbalance(
+        const std::map<store_key_t, int64_t> &key_counts,
+        const std::map<store_key_t, double> &traffic,
+        const std::vector<store_key_t> &split_points,
+        double load_weight) {
+    std::map<store_key_t, double> weights;
+    if (!combine_shard_weights(key_counts, traffic, load_weight, &weights)) {
+        return 1.0;
+    }
+
+    std::vector<double> shard_weights(split_points.size() + 1, 0.0);
+    for (std::map<store_key_t, double>::const_iterator it = weights.begin(); it != weights.end(); ++it) {
+        size_t shard = std::upper_bound(split_points.begin(), split_points.end(), it->first) - split_points.begin();
+        shard_weights[shard] += it->second;
+    }
+    return *std::max_element(shard_weights.begin(), shard_weights.end()) * shard_weights.size();
+}
+
 #include "mock/dummy_protocol.hpp"
 
 
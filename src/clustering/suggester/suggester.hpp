@@ -5,7 +5,9 @@
 #include <map>
 #include <set>
 #include <string>
+#include <vector>
 
+#include "btree/keys.hpp"
 #include "clustering/administration/datacenter_metadata.hpp"
 #include "clustering/administration/persistable_blueprint.hpp"
 #include "clustering/reactor/metadata.hpp"
@@ -40,4 +42,27 @@ persistable_blueprint_t<protocol_t> suggest_blueprint(
         std::map<machine_id_t, int> *usage,
         bool prioritize_distribution);
 
+/* Picks up to `num_shards - 1` split points that divide the key space into
+`num_shards` shards carrying roughly equal weight. `key_counts` is a key
+distribution like the one a distribution read returns, and `traffic` is the
+per-key load from the same read. Each shard's weight is a mix of its share of
+the keys and its share of the load; `load_weight` (between 0 and 1) says how
+much the load counts. If either the distribution or the load is empty, only
+the other one is used. Fewer split points are returned if there isn't enough
+information to place them all. */
+std::vector<store_key_t> suggest_split_points(
+        const std::map<store_key_t, int64_t> &key_counts,
+        const std::map<store_key_t, double> &traffic,
+        size_t num_shards,
+        double load_weight);
+
+/* How unevenly the weight (in the sense of `suggest_split_points()`) is spread
+over the shards that `split_points` (which must be sorted) would make: the
+heaviest shard's weight divided by the average. 1.0 is perfectly even. */
+double estimate_shard_imbalance(
+        const std::map<store_key_t, int64_t> &key_counts,
+        const std::map<store_key_t, double> &traffic,
+        const std::vector<store_key_t> &split_points,
+        double load_weight);
+
 #endif /* CLUSTERING_SUGGESTER_SUGGESTER_HPP_ */
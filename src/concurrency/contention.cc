@@ -0,0 +1,175 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#define __STDC_FORMAT_MACROS
+
+#include "concurrency/contention.hpp"
+
+#include <inttypes.h>
+
+#include <algorithm>
+#include <map>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/pmap.hpp"
+#include "perfmon/perfmon.hpp"
+
+bool global_profile_contention = false;
+
+std::vector<contention_site_t *> *get_contention_sites() {
+    // Never freed, so that it's still around when static sites are destroyed
+    // at exit.
+    static std::vector<contention_site_t *> *sites = new std::vector<contention_site_t *>;
+    return sites;
+}
+
+void contention_stats_t::add(const contention_stats_t &other) {
+    waits += other.waits;
+    wait_ticks += other.wait_ticks;
+    max_wait_ticks = std::max(max_wait_ticks, other.max_wait_ticks);
+    waiters += other.waiters;
+    max_waiters = std::max(max_waiters, other.max_waiters);
+}
+
+contention_site_t::contention_site_t(const char *_name) : name(_name) {
+    for (int i = 0; i < MAX_THREADS; ++i) {
+        thread_stats[i].value = contention_stats_t();
+    }
+    get_contention_sites()->push_back(this);
+}
+
+contention_site_t::~contention_site_t() {
+    std::vector<contention_site_t *> *sites = get_contention_sites();
+    sites->erase(std::find(sites->begin(), sites->end(), this));
+}
+
+contention_stats_t contention_site_t::get_thread_stats() const {
+    return thread_stats[get_thread_id()].value;
+}
+
+contention_wait_t::contention_wait_t(contention_site_t *_site)
+    : site(NULL), start(0), thread(-1) {
+    begin(_site);
+}
+
+contention_wait_t::~contention_wait_t() {
+    end();
+}
+
+void contention_wait_t::begin(contention_site_t *_site) {
+    rassert(site == NULL);
+    if (_site != NULL && global_profile_contention) {
+        site = _site;
+        start = get_ticks();
+        thread = get_thread_id();
+        contention_stats_t *stats = &site->thread_stats[thread].value;
+        ++stats->waiters;
+        stats->max_waiters = std::max(stats->max_waiters, stats->waiters);
+    }
+}
+
+void contention_wait_t::end() {
+    if (site != NULL) {
+        rassert(get_thread_id() == thread, "a contention_wait_t must end on the thread it began on");
+        const ticks_t wait_ticks = get_ticks() - start;
+        contention_stats_t *stats = &site->thread_stats[thread].value;
+        --stats->waiters;
+        ++stats->waits;
+        stats->wait_ticks += wait_ticks;
+        stats->max_wait_ticks = std::max(stats->max_wait_ticks, wait_ticks);
+        site = NULL;
+    }
+}
+
+/* `stats[thread][i]` is the `i`th site's stats on that thread. Sites with the
+same name are combined. */
+typedef std::vector<std::vector<contention_stats_t> > contention_stats_by_thread_t;
+
+void get_contention_thread_stats(contention_stats_by_thread_t *stats) {
+    const std::vector<contention_site_t *> *sites = get_contention_sites();
+    std::vector<contention_stats_t> *thread_stats = &(*stats)[get_thread_id()];
+    thread_stats->resize(sites->size());
+    for (size_t i = 0; i < sites->size(); ++i) {
+        (*thread_stats)[i] = (*sites)[i]->get_thread_stats();
+    }
+}
+
+std::map<std::string, contention_stats_t> combine_contention_stats(
+        const contention_stats_by_thread_t &stats) {
+    const std::vector<contention_site_t *> *sites = get_contention_sites();
+    std::map<std::string, contention_stats_t> combined;
+    for (auto it = stats.begin(); it != stats.end(); ++it) {
+        for (size_t i = 0; i < it->size() && i < sites->size(); ++i) {
+            combined[(*sites)[i]->get_name()].add((*it)[i]);
+        }
+    }
+    return combined;
+}
+
+void get_contention_thread_stats_on(int thread, contention_stats_by_thread_t *stats) {
+    on_thread_t th(thread);
+    get_contention_thread_stats(stats);
+}
+
+bool more_contended(const std::pair<std::string, contention_stats_t> &a,
+                    const std::pair<std::string, contention_stats_t> &b) {
+    return a.second.wait_ticks > b.second.wait_ticks;
+}
+
+std::vector<std::pair<std::string, contention_stats_t> > get_contention_stats() {
+    contention_stats_by_thread_t stats(get_num_threads());
+    pmap(get_num_threads(), boost::bind(&get_contention_thread_stats_on, _1, &stats));
+
+    std::map<std::string, contention_stats_t> combined = combine_contention_stats(stats);
+    std::vector<std::pair<std::string, contention_stats_t> > sorted;
+    for (auto it = combined.begin(); it != combined.end(); ++it) {
+        if (it->second.waits > 0 || it->second.waiters > 0) {
+            sorted.push_back(*it);
+        }
+    }
+    std::stable_sort(sorted.begin(), sorted.end(), &more_contended);
+    return sorted;
+}
+
+/* Reports each site's waits, total, mean and longest wait time in seconds,
+and waiters, keyed by the site's name. */
+class contention_perfmon_t : public perfmon_t {
+public:
+    contention_perfmon_t() { }
+
+    void *begin_stats() {
+        return new contention_stats_by_thread_t(get_num_threads());
+    }
+
+    void visit_stats(void *data) {
+        get_contention_thread_stats(static_cast<contention_stats_by_thread_t *>(data));
+    }
+
+    scoped_ptr_t<perfmon_result_t> end_stats(void *data) {
+        scoped_ptr_t<contention_stats_by_thread_t> stats(static_cast<contention_stats_by_thread_t *>(data));
+        std::map<std::string, contention_stats_t> combined = combine_contention_stats(*stats);
+
+        scoped_ptr_t<perfmon_result_t> result = perfmon_result_t::alloc_map_result();
+        for (auto it = combined.begin(); it != combined.end(); ++it) {
+            const contention_stats_t &s = it->second;
+            scoped_ptr_t<perfmon_result_t> site = perfmon_result_t::alloc_map_result();
+            site->insert("waits", new perfmon_result_t(strprintf("%" PRIi64, s.waits)));
+            site->insert("wait_time", new perfmon_result_t(strprintf("%f", ticks_to_secs(s.wait_ticks))));
+            site->insert("mean_wait", new perfmon_result_t(strprintf("%f",
+                s.waits == 0 ? 0.0 : ticks_to_secs(s.wait_ticks) / s.waits)));
+            site->insert("max_wait", new perfmon_result_t(strprintf("%f", ticks_to_secs(s.max_wait_ticks))));
+            site->insert("waiters", new perfmon_result_t(strprintf("%" PRIi64, s.waiters)));
+            site->insert("max_waiters", new perfmon_result_t(strprintf("%" PRIi64, s.max_waiters)));
+            result->insert(it->first, site.release());
+        }
+        return result;
+    }
+
+private:
+    DISABLE_COPYING(contention_perfmon_t);
+};
+
+static contention_perfmon_t pm_contention;
+static perfmon_membership_t pm_contention_membership(&get_global_perfmon_collection(),
+    &pm_contention, "contention");
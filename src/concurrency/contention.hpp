@@ -0,0 +1,87 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CONCURRENCY_CONTENTION_HPP_
+#define CONCURRENCY_CONTENTION_HPP_
+
+#include <string>
+#include <utility>
+#include <vector>
+
+#include "utils.hpp"
+
+/* The contention profiler keeps stats on how long coroutines wait to get
+through the locks and queues at the places in the code that ask for it.
+`rwi_lock_t`, `mutex_t`, `coro_fifo_t` and `fifo_enforcer_sink_t` take an
+optional `contention_site_t *` when they're constructed, and every wait on such
+a lock is recorded for its site. Only waits are recorded; getting a lock that's
+free costs nothing.
+
+The profiler is off unless the server is started with `--profile-contention`,
+which sets `global_profile_contention`. Each thread keeps its own stats for
+each site, so recording never takes a lock. They are reported in the
+`contention` perfmon and, most contended site first, at /ajax/contention. */
+
+extern bool global_profile_contention;
+
+struct contention_stats_t {
+    contention_stats_t()
+        : waits(0), wait_ticks(0), max_wait_ticks(0), waiters(0), max_waiters(0) { }
+
+    /* Sums the counts and takes the larger maximums, so the maximums of stats
+    combined across threads are the largest of any one thread. */
+    void add(const contention_stats_t &other);
+
+    int64_t waits;
+    ticks_t wait_ticks, max_wait_ticks;
+    // The waits that haven't ended yet, and the most there have been at once
+    int64_t waiters, max_waiters;
+};
+
+/* A place in the code whose locks are profiled, such as "buffer cache block";
+all the locks constructed with the same site add to its stats. Sites are meant
+to be static objects. They're registered when they're constructed, which isn't
+thread-safe. */
+class contention_site_t {
+public:
+    explicit contention_site_t(const char *_name);
+    ~contention_site_t();
+
+    const char *get_name() const { return name; }
+
+    /* Must be called on the thread whose stats are wanted */
+    contention_stats_t get_thread_stats() const;
+
+private:
+    friend class contention_wait_t;
+
+    const char *const name;
+    cache_line_padded_t<contention_stats_t> thread_stats[MAX_THREADS];
+
+    DISABLE_COPYING(contention_site_t);
+};
+
+/* Times one wait at a site: call `begin()` when a coroutine or callback gets in
+line for a lock, and `end()`, or destroy the `contention_wait_t`, on the same
+thread when it gets through. It does nothing if the site is `NULL` or the
+profiler is off. */
+class contention_wait_t {
+public:
+    contention_wait_t() : site(NULL), start(0), thread(-1) { }
+    explicit contention_wait_t(contention_site_t *_site);
+    ~contention_wait_t();
+
+    void begin(contention_site_t *_site);
+    void end();
+
+private:
+    contention_site_t *site;
+    ticks_t start;
+    int thread;
+
+    DISABLE_COPYING(contention_wait_t);
+};
+
+/* Every site's stats, combined across threads, most total wait time first.
+Sites nobody has waited at are left out. Must be called in a coroutine. */
+std::vector<std::pair<std::string, contention_stats_t> > get_contention_stats();
+
+#endif  // CONCURRENCY_CONTENTION_HPP_
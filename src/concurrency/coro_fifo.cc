@@ -1,6 +1,8 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "concurrency/coro_fifo.hpp"
 
+#include "concurrency/contention.hpp"
+
 // This is an inefficient implementation but we'd need extreme hacks
 // or coro_t magic to make this efficient.  This works efficiently
 // with no blocking in the case where no reordering is needed.
@@ -52,7 +54,12 @@ void coro_fifo_acq_t::leave() {
     rassert(initialized_);
     if (initialized_) {
         fifo_->inform_ready_to_leave(this);
+        contention_wait_t wait;
+        if (!ready_to_leave_.is_pulsed()) {
+            wait.begin(fifo_->site_);
+        }
         ready_to_leave_.wait();
+        wait.end();
         fifo_->inform_left_and_notified();
         rassert(!in_a_list(), "should have been removed from the acquisitor_queue_");
         initialized_ = false;
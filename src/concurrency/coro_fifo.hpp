@@ -20,11 +20,14 @@ assuming that nothing will block between exiting the `coro_fifo_t` and accessing
 whatever the next important thing is. Also, `fifo_enforcer_t` can be split
 across two different threads or machines. */
 
+class contention_site_t;
 class coro_fifo_acq_t;
 
 class coro_fifo_t : public home_thread_mixin_t {
 public:
-    coro_fifo_t() : queue_counter_(0) { }
+    // Waits to leave the FIFO are recorded for `site` if it isn't `NULL`; see
+    // `contention.hpp`.
+    explicit coro_fifo_t(contention_site_t *site = NULL) : queue_counter_(0), site_(site) { }
 
     friend class coro_fifo_acq_t;
 
@@ -48,6 +51,8 @@ private:
     // Counts how many coroutines have been pulse but have not yet woken.
     int64_t queue_counter_;
 
+    contention_site_t *site_;
+
     DISABLE_COPYING(coro_fifo_t);
 };
 
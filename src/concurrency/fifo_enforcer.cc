@@ -51,6 +51,9 @@ void fifo_enforcer_sink_t::exit_read_t::begin(fifo_enforcer_sink_t *p, fifo_enfo
     mutex_assertion_t::acq_t acq(&parent->internal_lock);
     parent->internal_read_queue.push(this);
     parent->internal_pump();
+    if (!is_pulsed()) {
+        wait.begin(parent->site);
+    }
 }
 
 void fifo_enforcer_sink_t::exit_read_t::end() THROWS_NOTHING {
@@ -83,6 +86,7 @@ void fifo_enforcer_sink_t::exit_read_t::end() THROWS_NOTHING {
         parent->internal_read_queue.swap_in_place(this,
             new dummy_exit_read_t(token, parent));
     }
+    wait.end();
     ended = true;
 }
 
@@ -111,6 +115,9 @@ void fifo_enforcer_sink_t::exit_write_t::begin(fifo_enforcer_sink_t *p, fifo_enf
     mutex_assertion_t::acq_t acq(&parent->internal_lock);
     parent->internal_write_queue.push(this);
     parent->internal_pump();
+    if (!is_pulsed()) {
+        wait.begin(parent->site);
+    }
 }
 
 void fifo_enforcer_sink_t::exit_write_t::end() THROWS_NOTHING {
@@ -141,6 +148,7 @@ void fifo_enforcer_sink_t::exit_write_t::end() THROWS_NOTHING {
         parent->internal_write_queue.swap_in_place(this,
             new dummy_exit_write_t(token, parent));
     }
+    wait.end();
     ended = true;
 }
 
@@ -5,6 +5,7 @@
 #include <map>
 #include <utility>
 
+#include "concurrency/contention.hpp"
 #include "concurrency/mutex_assertion.hpp"
 #include "concurrency/queue/passive_producer.hpp"
 #include "concurrency/signal.hpp"
@@ -182,6 +183,7 @@ public:
         }
         void on_reached_head_of_queue() {
             parent->internal_read_queue.remove(this);
+            wait.end();
             pulse();
         }
         void on_early_shutdown() {
@@ -195,6 +197,9 @@ public:
         bool ended;
 
         fifo_enforcer_read_token_t token;
+
+        /* Times the wait to get to the head of the queue */
+        contention_wait_t wait;
     };
 
     class exit_write_t : public signal_t, public internal_exit_write_t {
@@ -216,6 +221,7 @@ public:
         }
         void on_reached_head_of_queue() {
             parent->internal_write_queue.remove(this);
+            wait.end();
             pulse();
         }
         void on_early_shutdown() {
@@ -229,18 +235,26 @@ public:
         bool ended;
 
         fifo_enforcer_write_token_t token;
+
+        /* Times the wait to get to the head of the queue */
+        contention_wait_t wait;
     };
 
-    fifo_enforcer_sink_t() THROWS_NOTHING :
+    /* The time tokens wait to get to the head of the queue is recorded for
+    `site` if it isn't `NULL`; see `contention.hpp`. */
+    explicit fifo_enforcer_sink_t(contention_site_t *_site = NULL) THROWS_NOTHING :
         popped_state(state_timestamp_t::zero(), 0),
         finished_state(state_timestamp_t::zero(), 0),
-        in_pump(false)
+        in_pump(false),
+        site(_site)
         { }
 
-    explicit fifo_enforcer_sink_t(fifo_enforcer_state_t init) THROWS_NOTHING :
+    explicit fifo_enforcer_sink_t(fifo_enforcer_state_t init,
+                                  contention_site_t *_site = NULL) THROWS_NOTHING :
         popped_state(init),
         finished_state(init),
-        in_pump(false)
+        in_pump(false),
+        site(_site)
         { }
 
     ~fifo_enforcer_sink_t() THROWS_NOTHING;
@@ -268,6 +282,8 @@ private:
     way, we use a loop rather than arbitrarily deep recursion. */
     bool in_pump, pump_should_keep_going;
 
+    contention_site_t *site;
+
     DISABLE_COPYING(fifo_enforcer_sink_t);
 };
 
@@ -2,6 +2,7 @@
 #include "concurrency/mutex.hpp"
 
 #include "arch/runtime/coroutines.hpp"
+#include "concurrency/contention.hpp"
 
 mutex_t::acq_t::acq_t(mutex_t *l, bool eager) : lock_(NULL), eager_(false) {
     reset(l, eager);
@@ -27,6 +28,7 @@ void mutex_t::acq_t::reset(mutex_t *l, bool eager) {
 
 void co_lock_mutex(mutex_t *mutex) {
     if (mutex->locked) {
+        contention_wait_t wait(mutex->site);
         mutex->waiters.push_back(coro_t::self());
         coro_t::wait();
     } else {
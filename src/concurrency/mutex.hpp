@@ -7,6 +7,7 @@
 
 #include "utils.hpp"
 
+class contention_site_t;
 class coro_t;
 class mutex_t;
 
@@ -33,7 +34,9 @@ public:
         DISABLE_COPYING(acq_t);
     };
 
-    mutex_t() : locked(false) { }
+    // Waits for the mutex are recorded for `site` if it isn't `NULL`; see
+    // `contention.hpp`.
+    explicit mutex_t(contention_site_t *_site = NULL) : locked(false), site(_site) { }
     ~mutex_t() { rassert(!locked); }
 
     bool is_locked() {
@@ -46,6 +49,7 @@ public:
 private:
     bool locked;
     std::deque<coro_t *> waiters;
+    contention_site_t *site;
 
     DISABLE_COPYING(mutex_t);
 };
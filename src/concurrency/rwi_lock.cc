@@ -4,16 +4,19 @@
 #include "config/args.hpp"
 #include "arch/runtime/runtime.hpp"
 #include "concurrency/cond_var.hpp"
+#include "concurrency/contention.hpp"
 
 
 struct lock_request_t : public thread_message_t,
                         public intrusive_list_node_t<lock_request_t>
 {
-    lock_request_t(access_t _op, lock_available_callback_t *_callback)
-        : op(_op), callback(_callback)
+    lock_request_t(access_t _op, lock_available_callback_t *_callback,
+                   contention_site_t *site)
+        : op(_op), callback(_callback), wait(site)
     {}
     access_t op;
     lock_available_callback_t *callback;
+    contention_wait_t wait;
 
     // Actually, this is called later on the same thread...
     void on_thread_switch() {
@@ -201,7 +204,7 @@ bool rwi_lock_t::try_lock_upgrade(UNUSED bool from_queue) {
 }
 
 void rwi_lock_t::enqueue_request(access_t access, lock_available_callback_t *callback) {
-    queue.push_back(new lock_request_t(access, callback));
+    queue.push_back(new lock_request_t(access, callback, site));
 }
 
 void rwi_lock_t::process_queue() {
@@ -211,6 +214,7 @@ void rwi_lock_t::process_queue() {
             break;
         } else {
             queue.remove(req);
+            req->wait.end();
             call_later_on_this_thread(req);
         }
         req = queue.head();
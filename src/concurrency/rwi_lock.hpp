@@ -5,6 +5,8 @@
 #include "containers/intrusive_list.hpp"
 #include "concurrency/access.hpp"
 
+class contention_site_t;
+
 // Forward declarations
 struct rwi_lock_t;
 struct lock_request_t;
@@ -40,8 +42,10 @@ public:
     // Note, the receiver of lock_request_t completion notifications
     // is responsible for freeing associated memory by calling delete.
 
-    rwi_lock_t()
-        : state(rwis_unlocked), nreaders(0)
+    // Waits for the lock are recorded for `site` if it isn't `NULL`; see
+    // `contention.hpp`.
+    explicit rwi_lock_t(contention_site_t *_site = NULL)
+        : state(rwis_unlocked), nreaders(0), site(_site)
         {}
 
     // Call to lock for read, write, intent, or upgrade intent to write
@@ -130,6 +134,7 @@ private:
 
     rwi_state state;
     int nreaders; // not counting reader with intent
+    contention_site_t *site;
 
     intrusive_list_t<lock_request_t> queue;
 
@@ -82,7 +82,8 @@ void semaphore_t::lock_now(int count) {
 void adjustable_semaphore_t::lock(semaphore_available_callback_t *cb, int count) {
     rassert(!in_callback);
     rassert(count <= capacity || capacity == SEMAPHORE_NO_LIMIT);
-    if (try_lock(count)) {
+    // Don't overtake earlier requests that are still waiting for room.
+    if (waiters.empty() && try_lock(count)) {
         rassert(!in_callback);
         DEBUG_ONLY_CODE(in_callback = true);
         cb->on_semaphore_available();
@@ -107,12 +108,12 @@ void adjustable_semaphore_t::co_lock(int count) {
     coro_t::yield();
 }
 
-void adjustable_semaphore_t::co_lock_interruptible(signal_t *interruptor) {
+void adjustable_semaphore_t::co_lock_interruptible(signal_t *interruptor, int count) {
     rassert(!in_callback);
     struct : public semaphore_available_callback_t, public cond_t {
         void on_semaphore_available() { pulse(); }
     } cb;
-    lock(&cb, 1);
+    lock(&cb, count);
 
     try {
         wait_interruptible(&cb, interruptor);
@@ -125,6 +126,8 @@ void adjustable_semaphore_t::co_lock_interruptible(signal_t *interruptor) {
                 break;
             }
         }
+        // The requests behind ours may fit now that we stopped waiting.
+        pump();
         throw;
     }
 }
@@ -54,7 +54,10 @@ public:
 capacity at runtime. If you call `set_capacity()` and the new capacity is less
 than the current number of objects that hold the semaphore, then new objects
 will be allowed to enter at `trickle_fraction` of the rate that the objects are
-leaving until the number of objects drops to the desired capacity. */
+leaving until the number of objects drops to the desired capacity.
+
+Requests are granted in the order they were made: a request never goes ahead of
+an earlier one that is still waiting, even if there would be room for it. */
 
 class adjustable_semaphore_t {
     struct lock_request_t : public intrusive_list_node_t<lock_request_t> {
@@ -88,7 +91,7 @@ public:
     void lock(semaphore_available_callback_t *cb, int count = 1);
 
     void co_lock(int count = 1);
-    void co_lock_interruptible(signal_t *interruptor);
+    void co_lock_interruptible(signal_t *interruptor, int count = 1);
 
     void unlock(int count = 1);
 
@@ -91,9 +91,150 @@
 // TODO: make this dynamic where possible
 #define MAX_THREADS                               128
 
+// How many hash sub-shards ("CPU shards") a table is split into on each server
+// by default, and at most. Each one gets its own store, on its own thread if
+// there are enough. The factor is fixed when the table is created, since the
+// servers in a cluster can't work with differing factors for the same table.
+#define DEFAULT_CPU_SHARDING_FACTOR               4
+#define MAX_CPU_SHARDING_FACTOR                   64
+
 // Ticks (in milliseconds) the internal timed tasks are performed at
 #define TIMER_TICKS_IN_MS                         5
 
+// How long a window each thread measures its event loop load over. The load is
+// used to place new client connections on the least busy thread.
+#define THREAD_LOAD_WINDOW_MS                     100
+
+// New client connections go to the least loaded thread; threads whose loads are
+// within this much of each other are considered equally loaded, and the one with
+// fewer client connections wins.
+#define CLIENT_CONN_PLACEMENT_LOAD_SLACK          0.05
+
+// A client connection is only moved to another thread between queries if that
+// thread's load is lower than its current thread's by at least this much, and
+// no more often than every CLIENT_CONN_MIGRATION_INTERVAL_MS.
+#define CLIENT_CONN_MIGRATION_LOAD_GAP            0.25
+#define CLIENT_CONN_MIGRATION_INTERVAL_MS         1000
+
+// ReQL requests that take at least this long go in the slow query log, unless
+// --slow-query-threshold-ms says otherwise. Each thread keeps its last
+// SLOW_QUERY_LOG_SIZE entries, and the printed query of an entry is cut off
+// after SLOW_QUERY_MAX_PRINTED_LENGTH characters.
+#define DEFAULT_SLOW_QUERY_THRESHOLD_MS           1000
+#define SLOW_QUERY_LOG_SIZE                       100
+#define SLOW_QUERY_MAX_PRINTED_LENGTH             2000
+
+// /metrics reuses the stats it collected for scrapes that come within this
+// long of each other, so that frequent scrapes don't each walk every perfmon
+#define METRICS_SNAPSHOT_MAX_AGE_MS               1000
+
+// When busy polling is enabled (--busy-poll-usecs), an idle event loop spins
+// for up to that long before going to sleep in epoll_wait. While spinning it
+// checks its incoming message queue on every iteration and the kernel (with a
+// non-blocking epoll_wait) every EVENT_LOOP_SPIN_EPOLL_INTERVAL iterations.
+// Spins that time out halve the next spin, down to 1/EVENT_LOOP_SPIN_MIN_FRACTION
+// of the budget; spins that find work double it again.
+#define MAX_EVENT_LOOP_SPIN_USECS                 100000
+#define EVENT_LOOP_SPIN_EPOLL_INTERVAL            32
+#define EVENT_LOOP_SPIN_MIN_FRACTION              16
+
+// The resolution of the per-thread timer wheel. Timers ring up to one tick
+// late, and a timer started right after another one rang is started just past
+// a tick boundary, so this has to be well below the millisecond granularity at
+// which timers are requested.
+#define TIMER_WHEEL_TICK_NANOS                    (100 * THOUSAND)
+
+// A directory change is sent to other peers right away if no change was sent in
+// the last DIRECTORY_UPDATE_COALESCE_MS milliseconds. Otherwise it is held back
+// until then, and all changes made in the meantime go out as one update.
+#define DIRECTORY_UPDATE_COALESCE_MS              5
+
+// On cluster connections that use compression (--cluster-compression), only
+// messages of at least CLUSTER_COMPRESSION_MIN_BYTES are compressed. When a
+// message of some type (the tag the message multiplexer puts in front of it)
+// doesn't shrink below CLUSTER_COMPRESSION_MAX_PERCENT percent of its size, the
+// next CLUSTER_COMPRESSION_BACKOFF_MESSAGES messages of that type are sent
+// without trying.
+#define CLUSTER_COMPRESSION_MIN_BYTES             512
+#define CLUSTER_COMPRESSION_MAX_PERCENT           90
+#define CLUSTER_COMPRESSION_BACKOFF_MESSAGES      64
+
+// The backfiller packs backfill chunks into batches and sends a batch once it
+// holds BACKFILL_MAX_BATCH_BYTES of serialized chunks or BACKFILL_MAX_BATCH_CHUNKS
+// chunks. The backfillee applies the chunks of a batch concurrently, so the
+// latter also bounds how many coroutines each batch takes.
+#define BACKFILL_MAX_BATCH_BYTES                  (64 * KILOBYTE)
+#define BACKFILL_MAX_BATCH_CHUNKS                 64
+
+// How many backfill chunks may be sent but not yet applied by the backfillee.
+// The backfiller measures how fast the backfillee applies chunks every
+// BACKFILL_RATE_INTERVAL_MS and allows BACKFILL_WINDOW_MS worth of chunks at
+// that rate to be outstanding, but never fewer than BACKFILL_MIN_CHUNKS_OUT
+// or more than BACKFILL_MAX_CHUNKS_OUT. The window starts out at
+// BACKFILL_INITIAL_CHUNKS_OUT.
+#define BACKFILL_INITIAL_CHUNKS_OUT               5000
+#define BACKFILL_MIN_CHUNKS_OUT                   500
+#define BACKFILL_MAX_CHUNKS_OUT                   100000
+#define BACKFILL_WINDOW_MS                        1000
+#define BACKFILL_RATE_INTERVAL_MS                 200
+
+// The backfiller splits the key range it sends into at most BACKFILL_MAX_PIECES
+// pieces per hash region, along the keys in the root node. The backfillee
+// records in its metainfo each piece it has completely received, so an
+// interrupted backfill doesn't need to send those pieces again.
+#define BACKFILL_MAX_PIECES                       16
+
+// Outdated reads go to the replica expected to answer first: the one with the
+// lowest moving average response time (each response counts for
+// OUTDATED_READ_LATENCY_EWMA_WEIGHT of it) times the number of reads already
+// waiting on it, plus one. A replica that hasn't answered anything for
+// OUTDATED_READ_LATENCY_STALE_MS is tried again as if we knew nothing about it.
+// If a read isn't answered within the replica's average plus four times its
+// average deviation, and at least OUTDATED_READ_HEDGE_MIN_MS, it is also sent to
+// another replica and the first answer is used.
+#define OUTDATED_READ_LATENCY_EWMA_WEIGHT         0.125
+#define OUTDATED_READ_LATENCY_STALE_MS            5000
+#define OUTDATED_READ_HEDGE_MIN_MS                5
+
+// The broadcaster sends writes to each listener in batches of at most
+// BROADCASTER_MAX_WRITE_BATCH writes, with at most
+// BROADCASTER_MAX_WRITE_BATCHES_OUT batches outstanding per listener. A write
+// is sent right away if fewer batches than that are outstanding; otherwise it
+// waits and goes out with the writes queued up behind it.
+#define BROADCASTER_MAX_WRITE_BATCH               64
+#define BROADCASTER_MAX_WRITE_BATCHES_OUT         16
+
+// Each store samples one in KEY_TRAFFIC_SAMPLE_INTERVAL of the operations on it,
+// keeping the keys of the last KEY_TRAFFIC_SAMPLE_SIZE sampled operations from
+// at most the last KEY_TRAFFIC_WINDOW_SECS, to estimate where its traffic goes.
+#define KEY_TRAFFIC_SAMPLE_INTERVAL               16
+#define KEY_TRAFFIC_SAMPLE_SIZE                   256
+#define KEY_TRAFFIC_WINDOW_SECS                   60
+
+// How much the recent load on a table counts, next to the number of keys, when
+// picking shard boundaries (0 means only keys count, 1 means only load counts)
+#define SHARD_SPLIT_LOAD_WEIGHT                   0.5
+
+// With `--auto-shard`, how often tables are checked for uneven shards. Moving
+// shard boundaries costs a backfill, so the auto-sharder settings below are
+// conservative.
+#define AUTO_SHARD_CHECK_INTERVAL_MS              (60 * THOUSAND)
+
+// How uneven a table's shards (heaviest shard over average) must be before
+// the auto-sharder considers moving their boundaries
+#define AUTO_SHARD_IMBALANCE_THRESHOLD            1.5
+
+// How many times less uneven the new boundaries must make the shards for the
+// auto-sharder to move them; smaller gains aren't worth the backfill
+#define AUTO_SHARD_MIN_IMPROVEMENT                1.5
+
+// How long the auto-sharder leaves a table alone after moving its boundaries
+#define AUTO_SHARD_MIN_CHANGE_INTERVAL_SECS       3600
+
+// The distribution read the auto-sharder does to look at a table
+#define AUTO_SHARD_DISTRIBUTION_DEPTH             2
+#define AUTO_SHARD_DISTRIBUTION_LIMIT             1024
+
 // How many milliseconds to allow changes to sit in memory before flushing to disk
 #define DEFAULT_FLUSH_TIMER_MS                    1000
 
@@ -131,13 +272,19 @@
 // memcached specifies the maximum value size to be 1MB, but customers asked this to be much higher
 #define MAX_VALUE_SIZE                            (10 * MEGABYTE)
 
-// Values larger than this will be streamed in a get operation
-#define MAX_BUFFERED_GET_SIZE                     MAX_VALUE_SIZE // streaming is too slow for now, so we disable it completely
+// Values at least this large are written to the client straight from their
+// buffer by a get operation, instead of being copied into the connection's
+// write buffer first
+#define MAX_BUFFERED_GET_SIZE                     (64 * KILOBYTE)
 
 // If a single connection sends this many 'noreply' commands, the next command will
 // have to wait until the first one finishes
 #define MAX_CONCURRENT_QUERIES_PER_CONNECTION     500
 
+// How many binary protocol quiet gets (GETQ and GETKQ) are batched into one read
+// before they're sent off without waiting for the request that ends the batch
+#define MAX_BATCHED_BINARY_MEMCACHED_GETS         1000
+
 // The number of concurrent queries when loading memcached operations from a file.
 #define MAX_CONCURRENT_QUEURIES_ON_IMPORT         1000
 
@@ -208,6 +355,15 @@
 
 #define COROUTINE_STACK_SIZE                      131072
 
+// How many idle coroutines per thread keep their stacks fully committed. Idle
+// coroutines beyond this number have their unused stack pages returned to the
+// OS, and are only reused once the fully committed ones run out.
+#define COROUTINE_HOT_FREE_LIST_SIZE              64
+
+// In debug builds, one in this many coroutines spawned on a thread has its
+// stack usage measured for the coroutine summary.
+#define COROUTINE_STACK_USAGE_SAMPLE_INTERVAL     64
+
 #define MAX_COROS_PER_THREAD                      10000
 
 
@@ -1,6 +1,7 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "containers/archive/archive.hpp"
 
+#include <limits.h>
 #include <string.h>
 
 #include <algorithm>
@@ -40,7 +41,9 @@ write_message_t::~write_message_t() {
 
 void write_message_t::append(const void *p, int64_t n) {
     while (n > 0) {
-        if (buffers_.empty() || buffers_.tail()->size == write_buffer_t::DATA_SIZE) {
+        if (buffers_.empty()
+            || buffers_.tail()->external.has()
+            || buffers_.tail()->size == write_buffer_t::DATA_SIZE) {
             buffers_.push_back(new write_buffer_t);
         }
 
@@ -54,10 +57,31 @@ void write_message_t::append(const void *p, int64_t n) {
     }
 }
 
+void write_message_t::append_buffer(const counted_t<data_buffer_t> &buf) {
+    if (buf->size() < MIN_REFERENCED_BUFFER_SIZE) {
+        append(buf->buf(), buf->size());
+        return;
+    }
+
+    guarantee(buf->size() <= INT_MAX);
+    write_buffer_t *b = new write_buffer_t;
+    b->external = buf;
+    b->size = buf->size();
+    buffers_.push_back(b);
+}
+
+int64_t write_message_t::size() const {
+    int64_t ret = 0;
+    for (write_buffer_t *p = buffers_.head(); p; p = buffers_.next(p)) {
+        ret += p->size;
+    }
+    return ret;
+}
+
 int send_write_message(write_stream_t *s, const write_message_t *msg) {
     intrusive_list_t<write_buffer_t> *list = const_cast<write_message_t *>(msg)->unsafe_expose_buffers();
     for (write_buffer_t *p = list->head(); p; p = list->next(p)) {
-        int64_t res = s->write(p->data, p->size);
+        int64_t res = s->write(p->bytes(), p->size);
         if (res == -1) {
             return -1;
         }
@@ -4,6 +4,7 @@
 
 #include <stdint.h>
 
+#include "containers/data_buffer.hpp"
 #include "containers/intrusive_list.hpp"
 #include "utils.hpp"
 
@@ -80,6 +81,12 @@ public:
     int size;
     char data[DATA_SIZE];
 
+    // If this is set, the buffer holds a reference instead of a copy: its
+    // bytes are the `size` bytes of `external`, and `data` goes unused.
+    counted_t<data_buffer_t> external;
+
+    const char *bytes() const { return external.has() ? external->buf() : data; }
+
 private:
     DISABLE_COPYING(write_buffer_t);
 };
@@ -87,9 +94,9 @@ private:
 // A set of buffers in which an atomic message to be sent on a stream
 // gets built up.  (This way we don't flush after the first four bytes
 // sent to a stream, or buffer things and then forget to manually
-// flush.  This type can be extended to support holding references to
-// large buffers, to save copying.)  Generally speaking, you serialize
-// to a write_message_t, and then flush that to a write_stream_t.
+// flush.  Large data buffers get held by reference instead of being
+// copied; see append_buffer.)  Generally speaking, you serialize to a
+// write_message_t, and then flush that to a write_stream_t.
 class write_message_t {
 public:
     write_message_t() { }
@@ -97,6 +104,17 @@ public:
 
     void append(const void *p, int64_t n);
 
+    // Appends the contents of buf.  Buffers of at least
+    // MIN_REFERENCED_BUFFER_SIZE bytes are held by reference, so big
+    // values (such as memcached values) aren't copied into the message;
+    // nobody may modify buf while the message is alive.
+    void append_buffer(const counted_t<data_buffer_t> &buf);
+
+    static const int64_t MIN_REFERENCED_BUFFER_SIZE = 16 * write_buffer_t::DATA_SIZE;
+
+    // The number of bytes appended so far.
+    int64_t size() const;
+
     intrusive_list_t<write_buffer_t> *unsafe_expose_buffers() { return &buffers_; }
 
     template <class T>
@@ -0,0 +1,265 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_INTRUSIVE_TIMER_WHEEL_HPP_
+#define CONTAINERS_INTRUSIVE_TIMER_WHEEL_HPP_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <algorithm>
+
+#include "containers/intrusive_list.hpp"
+#include "errors.hpp"
+
+/* `intrusive_timer_wheel_t` is a hierarchical timing wheel, in the style of the
+Linux kernel's timer wheel. Nodes are filed under the integral "tick" at which
+they expire. Adding and removing a node is O(1); finding expired nodes costs
+O(1) per node plus an occasional cascade of a coarse slot into finer ones.
+
+There are `num_levels` levels of `slots_per_level` slots each. Level 0 has one
+slot per tick; each slot of level N covers `slots_per_level` slots of level
+N - 1. Nodes that expire further out than the wheel covers are kept on an
+overflow list and reconsidered every time the top level wraps around. */
+
+template <class node_t>
+class intrusive_timer_wheel_t;
+
+template <class node_t>
+class intrusive_timer_wheel_node_t : public intrusive_list_node_t<node_t> {
+public:
+    intrusive_timer_wheel_node_t() : expiration_tick(-1), slot(NULL) { }
+
+    int64_t get_expiration_tick() const { return expiration_tick; }
+
+protected:
+    ~intrusive_timer_wheel_node_t() {
+        rassert(slot == NULL);
+    }
+
+private:
+    friend class intrusive_timer_wheel_t<node_t>;
+
+    int64_t expiration_tick;
+
+    // The slot list this node is on, or `NULL` if it isn't in a wheel.
+    intrusive_list_t<node_t> *slot;
+
+    DISABLE_COPYING(intrusive_timer_wheel_node_t);
+};
+
+template <class node_t>
+class intrusive_timer_wheel_t {
+public:
+    static const int slot_bits = 6;
+    static const int slots_per_level = 1 << slot_bits;
+    static const int num_levels = 4;
+
+    /* `start_tick` is the first tick the wheel will consider. */
+    explicit intrusive_timer_wheel_t(int64_t start_tick)
+        : current_tick(start_tick), num_nodes(0) {
+        for (int level = 0; level < num_levels; ++level) {
+            occupied[level] = 0;
+        }
+    }
+
+    ~intrusive_timer_wheel_t() {
+        rassert(empty());
+    }
+
+    bool empty() const {
+        return num_nodes == 0;
+    }
+
+    size_t size() const {
+        return num_nodes;
+    }
+
+    /* Adds `x` to the wheel, to be returned by `pop_expired()` once the wheel
+    reaches `expiration_tick`. Expiration ticks in the past are treated as the
+    current tick. */
+    void add(node_t *x, int64_t expiration_tick) {
+        rassert(x != NULL);
+        rassert(node_slot(x) == NULL);
+        node_expiration(x) = std::max(expiration_tick, current_tick);
+        file_node(x);
+        ++num_nodes;
+    }
+
+    void remove(node_t *x) {
+        rassert(x != NULL);
+        intrusive_list_t<node_t> *slot = node_slot(x);
+        rassert(slot != NULL);
+        unfile_node(x, slot);
+        --num_nodes;
+    }
+
+    /* Advances the wheel up to and including `now_tick` and returns a node
+    that has expired by then, removing it from the wheel. Returns `NULL` once
+    no such node remains. Nodes may be added and removed between calls. */
+    node_t *pop_expired(int64_t now_tick) {
+        while (current_tick <= now_tick) {
+            intrusive_list_t<node_t> *slot = &slots[0][current_tick & slot_mask];
+            if (!slot->empty()) {
+                node_t *x = slot->head();
+                rassert(node_expiration(x) == current_tick);
+                unfile_node(x, slot);
+                --num_nodes;
+                return x;
+            }
+            advance(now_tick);
+        }
+        return NULL;
+    }
+
+    /* Returns a tick no later than the earliest tick at which `pop_expired()`
+    could return something, or at which a cascade is due. Callers waiting for
+    timers can sleep until then. The wheel must not be empty. */
+    int64_t next_tick_lower_bound() const {
+        rassert(!empty());
+        int64_t best = INT64_MAX;
+
+        if (occupied[0] != 0) {
+            const int offset = first_occupied_from(0, current_tick & slot_mask);
+            best = current_tick + offset;
+        }
+
+        // Counting from `current_tick` itself keeps this a lower bound.
+        best = std::min(best, next_cascade_after(current_tick - 1));
+
+        return best;
+    }
+
+private:
+    static const int64_t slot_mask = slots_per_level - 1;
+
+    static int64_t &node_expiration(node_t *x) {
+        intrusive_timer_wheel_node_t<node_t> *node = x;
+        return node->expiration_tick;
+    }
+
+    static intrusive_list_t<node_t> *&node_slot(node_t *x) {
+        intrusive_timer_wheel_node_t<node_t> *node = x;
+        return node->slot;
+    }
+
+    /* Returns how many slots after `index` the first occupied slot of `level`
+    is, wrapping around. `level` must have at least one occupied slot. */
+    int first_occupied_from(int level, int64_t index) const {
+        rassert(occupied[level] != 0);
+        uint64_t rotated = occupied[level];
+        if (index != 0) {
+            rotated = (rotated >> index) | (rotated << (slots_per_level - index));
+        }
+        return __builtin_ctzll(rotated);
+    }
+
+    /* Returns the first tick after `tick` at which a nonempty slot of level 1
+    or above, or the overflow list, would be cascaded, or `INT64_MAX` if there
+    is nothing to cascade. A slot of level N is cascaded when the wheel reaches
+    the start of the block of ticks it covers. */
+    int64_t next_cascade_after(int64_t tick) const {
+        int64_t best = INT64_MAX;
+        for (int level = 1; level < num_levels; ++level) {
+            if (occupied[level] != 0) {
+                const int shift = slot_bits * level;
+                const int64_t block = (tick >> shift) + 1;
+                const int offset = first_occupied_from(level, block & slot_mask);
+                best = std::min(best, (block + offset) << shift);
+            }
+        }
+        if (overflow.size() != 0) {
+            const int shift = slot_bits * num_levels;
+            best = std::min(best, ((tick >> shift) + 1) << shift);
+        }
+        return best;
+    }
+
+    void file_node(node_t *x) {
+        const int64_t expiration = node_expiration(x);
+        const int64_t delta = expiration - current_tick;
+        rassert(delta >= 0);
+
+        for (int level = 0; level < num_levels; ++level) {
+            const int shift = slot_bits * level;
+            if (delta < (int64_t(1) << (shift + slot_bits))) {
+                const int64_t index = (expiration >> shift) & slot_mask;
+                node_slot(x) = &slots[level][index];
+                slots[level][index].push_back(x);
+                occupied[level] |= uint64_t(1) << index;
+                return;
+            }
+        }
+
+        node_slot(x) = &overflow;
+        overflow.push_back(x);
+    }
+
+    void unfile_node(node_t *x, intrusive_list_t<node_t> *slot) {
+        slot->remove(x);
+        node_slot(x) = NULL;
+        if (slot->empty()) {
+            mark_slot_empty(slot);
+        }
+    }
+
+    void mark_slot_empty(intrusive_list_t<node_t> *slot) {
+        if (slot != &overflow) {
+            const ptrdiff_t flat_index = slot - &slots[0][0];
+            occupied[flat_index / slots_per_level] &= ~(uint64_t(1) << (flat_index % slots_per_level));
+        }
+    }
+
+    /* Re-files every node on `slot` relative to the current tick. */
+    void cascade_slot(intrusive_list_t<node_t> *slot) {
+        intrusive_list_t<node_t> pending;
+        pending.append_and_clear(slot);
+        mark_slot_empty(slot);
+        while (node_t *x = pending.head()) {
+            pending.remove(x);
+            file_node(x);
+        }
+    }
+
+    /* Moves `current_tick` forward by at least one tick, but not past the next
+    occupied level 0 slot, the next cascade or `now_tick + 1`. When level 0 is
+    empty, this skips straight to the next cascade that has anything to do, so
+    catching up after a long idle doesn't visit every block of 64 ticks. */
+    void advance(int64_t now_tick) {
+        const int64_t index = current_tick & slot_mask;
+        uint64_t ahead = index == slot_mask ? 0 : occupied[0] & ~((uint64_t(2) << index) - 1);
+        int64_t target;
+        if (ahead != 0) {
+            target = (current_tick & ~slot_mask) + __builtin_ctzll(ahead);
+        } else if (occupied[0] != 0) {
+            // What's left on level 0 is in the next block.
+            target = (current_tick | slot_mask) + 1;
+        } else {
+            target = next_cascade_after(current_tick);
+        }
+        current_tick = std::min(target, now_tick + 1);
+
+        if ((current_tick & slot_mask) == 0) {
+            for (int level = 1; level < num_levels; ++level) {
+                const int shift = slot_bits * level;
+                const int64_t level_index = (current_tick >> shift) & slot_mask;
+                cascade_slot(&slots[level][level_index]);
+                if (level_index != 0) {
+                    return;
+                }
+            }
+            cascade_slot(&overflow);
+        }
+    }
+
+    // The next tick that `pop_expired()` hasn't finished with yet.
+    int64_t current_tick;
+    size_t num_nodes;
+
+    intrusive_list_t<node_t> slots[num_levels][slots_per_level];
+    // Bit `i` of `occupied[level]` is set when `slots[level][i]` is nonempty.
+    uint64_t occupied[num_levels];
+    intrusive_list_t<node_t> overflow;
+
+    DISABLE_COPYING(intrusive_timer_wheel_t);
+};
+
+#endif  // CONTAINERS_INTRUSIVE_TIMER_WHEEL_HPP_
@@ -0,0 +1,164 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "containers/lz_compress.hpp"
+
+#include <stdint.h>
+#include <string.h>
+
+#include <algorithm>
+
+namespace {
+
+const size_t MIN_MATCH = 4;
+const size_t MAX_OFFSET = 65535;
+
+/* The last bytes of the input are always sent as literals, so that we can read
+four bytes at a time while looking for matches without checking for the end. */
+const size_t LAST_LITERALS = 5;
+
+const int HASH_BITS = 12;
+
+/* After this many positions without a match, we start skipping ahead faster, so
+that data that doesn't compress doesn't cost too much. */
+const int SKIP_SHIFT = 6;
+
+inline uint32_t read_uint32(const char *p) {
+    uint32_t v;
+    memcpy(&v, p, sizeof(v));
+    return v;
+}
+
+inline size_t hash_sequence(uint32_t sequence) {
+    return (sequence * 2654435761U) >> (32 - HASH_BITS);
+}
+
+void write_extra_length(size_t length, std::vector<char> *out) {
+    while (length >= 255) {
+        out->push_back(static_cast<char>(255));
+        length -= 255;
+    }
+    out->push_back(static_cast<char>(length));
+}
+
+bool read_extra_length(const char *data, size_t size, size_t *pos, size_t *length) {
+    uint8_t byte;
+    do {
+        if (*pos == size) {
+            return false;
+        }
+        byte = data[*pos];
+        ++*pos;
+        *length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/* Writes a sequence of `literals_length` literal bytes followed by a match. If
+`match_length` is zero, this is the last sequence and there is no match. */
+void write_sequence(const char *literals, size_t literals_length,
+                    size_t match_length, size_t offset,
+                    std::vector<char> *out) {
+    size_t match_code = match_length == 0 ? 0 : match_length - MIN_MATCH;
+    out->push_back(static_cast<char>((std::min<size_t>(literals_length, 15) << 4) |
+                                     std::min<size_t>(match_code, 15)));
+    if (literals_length >= 15) {
+        write_extra_length(literals_length - 15, out);
+    }
+    out->insert(out->end(), literals, literals + literals_length);
+    if (match_length != 0) {
+        out->push_back(static_cast<char>(offset & 0xff));
+        out->push_back(static_cast<char>(offset >> 8));
+        if (match_code >= 15) {
+            write_extra_length(match_code - 15, out);
+        }
+    }
+}
+
+}  // namespace
+
+void lz_compress(const char *data, size_t size, std::vector<char> *out) {
+    out->clear();
+    out->reserve(size + size / 255 + 16);
+
+    size_t anchor = 0;
+    if (size >= MIN_MATCH + LAST_LITERALS) {
+        const size_t match_limit = size - LAST_LITERALS;
+        std::vector<uint32_t> table(1 << HASH_BITS, 0);
+        size_t pos = 0;
+        while (pos + MIN_MATCH <= match_limit) {
+            uint32_t sequence = read_uint32(data + pos);
+            size_t hash = hash_sequence(sequence);
+            size_t candidate = table[hash];
+            table[hash] = pos;
+
+            if (candidate < pos && pos - candidate <= MAX_OFFSET &&
+                    read_uint32(data + candidate) == sequence) {
+                size_t length = MIN_MATCH;
+                while (pos + length < match_limit && data[candidate + length] == data[pos + length]) {
+                    ++length;
+                }
+                write_sequence(data + anchor, pos - anchor, length, pos - candidate, out);
+                pos += length;
+                anchor = pos;
+            } else {
+                pos += 1 + ((pos - anchor) >> SKIP_SHIFT);
+            }
+        }
+    }
+    write_sequence(data + anchor, size - anchor, 0, 0, out);
+}
+
+bool lz_decompress(const char *data, size_t size, size_t decompressed_size, std::vector<char> *out) {
+    /* No byte of compressed data stands for more than 255 bytes of output.
+    Checking this first means a bogus `decompressed_size` can't make us
+    allocate an absurd amount of memory. */
+    if (decompressed_size / 255 > size) {
+        return false;
+    }
+    out->resize(decompressed_size);
+    char *dest = out->data();
+    size_t in_pos = 0, out_pos = 0;
+
+    while (in_pos < size) {
+        uint8_t token = data[in_pos];
+        ++in_pos;
+
+        size_t literals_length = token >> 4;
+        if (literals_length == 15 && !read_extra_length(data, size, &in_pos, &literals_length)) {
+            return false;
+        }
+        if (literals_length > size - in_pos || literals_length > decompressed_size - out_pos) {
+            return false;
+        }
+        memcpy(dest + out_pos, data + in_pos, literals_length);
+        in_pos += literals_length;
+        out_pos += literals_length;
+
+        if (in_pos == size) {
+            /* That was the last sequence */
+            break;
+        }
+
+        if (size - in_pos < 2) {
+            return false;
+        }
+        size_t offset = static_cast<uint8_t>(data[in_pos]) |
+            (static_cast<size_t>(static_cast<uint8_t>(data[in_pos + 1])) << 8);
+        in_pos += 2;
+        size_t match_length = token & 15;
+        if (match_length == 15 && !read_extra_length(data, size, &in_pos, &match_length)) {
+            return false;
+        }
+        match_length += MIN_MATCH;
+        if (offset == 0 || offset > out_pos || match_length > decompressed_size - out_pos) {
+            return false;
+        }
+
+        /* The match may overlap the bytes it produces, so copy byte by byte. */
+        for (size_t i = 0; i < match_length; ++i) {
+            dest[out_pos + i] = dest[out_pos + i - offset];
+        }
+        out_pos += match_length;
+    }
+
+    return out_pos == decompressed_size;
+}
@@ -0,0 +1,35 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef CONTAINERS_LZ_COMPRESS_HPP_
+#define CONTAINERS_LZ_COMPRESS_HPP_
+
+#include <stddef.h>
+
+#include <vector>
+
+#include "errors.hpp"
+
+/* A small LZ77 codec in the style of LZ4, for when speed matters much more
+than the compression ratio (e.g. for messages between cluster nodes).
+
+The compressed data is a series of sequences. Each one is a token byte whose
+high four bits are the number of literal bytes and whose low four bits are the
+length of the match minus four, followed by the literal bytes, a two-byte
+little-endian offset back into the output, and then the match is copied from
+there. A length of 15 in the token means that more length bytes follow; each
+one is added to the length, and all but the last are 255. The last sequence
+has literals only and ends the data.
+
+The compressed data doesn't record how long the original was, so whoever
+decompresses it must already know. */
+
+/* Replaces the contents of `out` with the compressed form of the `size` bytes
+at `data`. If `data` doesn't compress, `out` may end up slightly bigger than
+`size`. */
+void lz_compress(const char *data, size_t size, std::vector<char> *out);
+
+/* Replaces the contents of `out` with the decompressed form of the `size` bytes
+at `data`, which must decompress to exactly `decompressed_size` bytes. Returns
+false if the data is corrupt. */
+MUST_USE bool lz_decompress(const char *data, size_t size, size_t decompressed_size, std::vector<char> *out);
+
+#endif  // CONTAINERS_LZ_COMPRESS_HPP_
@@ -8,6 +8,7 @@
 #include <boost/algorithm/string.hpp>
 
 #include "arch/io/network.hpp"
+#include "arch/runtime/runtime.hpp"
 #include "logger.hpp"
 
 static const char *resource_parts_sep_char = "/";
@@ -181,10 +182,18 @@ http_res_t http_error_res(const std::string &content, http_status_code_t rescode
 
 http_server_t::http_server_t(const std::set<ip_address_t> &local_addresses,
                              int port,
-                             http_app_t *_application) :
+                             http_app_t *_application,
+                             tcp_accept_mode_t accept_mode) :
     application(_application) {
+    boost::function<void(scoped_ptr_t<tcp_conn_descriptor_t> &)> conn_handler;  // NOLINT(readability/casting)
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        per_thread_drainers.init(new one_per_thread_t<auto_drainer_t>);
+        conn_handler = boost::bind(&http_server_t::handle_local_conn, this, _1);
+    } else {
+        conn_handler = boost::bind(&http_server_t::handle_conn, this, _1, auto_drainer_t::lock_t(&auto_drainer));
+    }
     try {
-        tcp_listener.init(new tcp_listener_t(local_addresses, port, boost::bind(&http_server_t::handle_conn, this, _1, auto_drainer_t::lock_t(&auto_drainer))));
+        tcp_listener.init(new tcp_listener_t(local_addresses, port, conn_handler, accept_mode));
     } catch (const address_in_use_exc_t &ex) {
         nice_crash("%s. Could not bind to http port. Exiting.\n", ex.what());
     }
@@ -293,6 +302,10 @@ void write_http_msg(tcp_conn_t *conn, const http_res_t &res, signal_t *closer) T
     conn->write(res.body.c_str(), res.body.size(), closer);
 }
 
+void http_server_t::handle_local_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+    handle_conn(nconn, auto_drainer_t::lock_t(per_thread_drainers->get()));
+}
+
 void http_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, auto_drainer_t::lock_t keepalive) {
     scoped_ptr_t<tcp_conn_t> conn;
     nconn->make_overcomplicated(&conn);
@@ -303,8 +316,13 @@ void http_server_t::handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn
     /* parse the request */
     try {
         if (http_msg_parser.parse(conn.get(), &req, keepalive.get_drain_signal())) {
-            /* TODO pass interruptor */
-            http_res_t res = application->handle(req);
+            http_res_t res;
+            {
+                /* The application lives on our home thread.
+                TODO pass interruptor */
+                on_thread_t th(home_thread());
+                res = application->handle(req);
+            }
             res.version = req.version;
             write_http_msg(conn.get(), res, keepalive.get_drain_signal());
         } else {
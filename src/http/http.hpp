@@ -15,6 +15,7 @@
 #include "arch/types.hpp"
 #include "arch/address.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/one_per_thread.hpp"
 #include "containers/scoped.hpp"
 #include "parsing/util.hpp"
 
@@ -161,15 +162,22 @@ public:
  * connections, the data from incoming connections will be parsed into
  * http_req_ts and passed to the handle function which must then return an http
  * msg that's a meaningful response */
-class http_server_t {
+class http_server_t : public home_thread_mixin_t {
 public:
-    http_server_t(const std::set<ip_address_t> &local_addresses, int port, http_app_t *application);
+    /* With `ACCEPT_ON_EVERY_THREAD`, connections are accepted and requests are
+     * parsed and answered on every thread, but `application` is still only
+     * called on the thread the server was created on. */
+    http_server_t(const std::set<ip_address_t> &local_addresses, int port, http_app_t *application,
+                  tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD);
     ~http_server_t();
     int get_port() const;
 private:
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &conn, auto_drainer_t::lock_t);
+    void handle_local_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &conn);
     http_app_t *application;
     auto_drainer_t auto_drainer;
+    // Only used with `ACCEPT_ON_EVERY_THREAD`
+    scoped_ptr_t<one_per_thread_t<auto_drainer_t> > per_thread_drainers;
     scoped_ptr_t<tcp_listener_t> tcp_listener;
 };
 
@@ -0,0 +1,649 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "memcached/binary_parser.hpp"
+
+#include <endian.h>
+#include <string.h>
+#include <time.h>
+
+#include <algorithm>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/fifo_checker.hpp"
+#include "containers/scoped.hpp"
+#include "memcached/handler.hpp"
+#include "memcached/protocol.hpp"
+
+/* The binary protocol is described at
+https://code.google.com/p/memcached/wiki/BinaryProtocolRevamped. Every request
+and response is a 24-byte header followed by the extras, the key and the value,
+and all the integers in them are big-endian. */
+
+namespace {
+
+const size_t header_size = 24;
+const uint8_t response_magic = 0x81;
+
+enum binary_opcode_t {
+    op_get = 0x00,
+    op_set = 0x01,
+    op_add = 0x02,
+    op_replace = 0x03,
+    op_delete = 0x04,
+    op_increment = 0x05,
+    op_decrement = 0x06,
+    op_quit = 0x07,
+    op_getq = 0x09,
+    op_noop = 0x0a,
+    op_version = 0x0b,
+    op_getk = 0x0c,
+    op_getkq = 0x0d,
+    op_append = 0x0e,
+    op_prepend = 0x0f,
+    op_setq = 0x11,
+    op_addq = 0x12,
+    op_replaceq = 0x13,
+    op_deleteq = 0x14,
+    op_incrementq = 0x15,
+    op_decrementq = 0x16,
+    op_quitq = 0x17,
+    op_appendq = 0x19,
+    op_prependq = 0x1a
+};
+
+enum binary_status_t {
+    status_ok = 0x0000,
+    status_key_not_found = 0x0001,
+    status_key_exists = 0x0002,
+    status_too_large = 0x0003,
+    status_invalid_arguments = 0x0004,
+    status_not_stored = 0x0005,
+    status_non_numeric = 0x0006,
+    status_unknown_command = 0x0081,
+    status_internal_error = 0x0084
+};
+
+uint16_t decode_uint16(const char *p) {
+    uint16_t x;
+    memcpy(&x, p, sizeof(x));
+    return be16toh(x);
+}
+
+uint32_t decode_uint32(const char *p) {
+    uint32_t x;
+    memcpy(&x, p, sizeof(x));
+    return be32toh(x);
+}
+
+uint64_t decode_uint64(const char *p) {
+    uint64_t x;
+    memcpy(&x, p, sizeof(x));
+    return be64toh(x);
+}
+
+void encode_uint16(uint16_t x, char *p) {
+    x = htobe16(x);
+    memcpy(p, &x, sizeof(x));
+}
+
+void encode_uint32(uint32_t x, char *p) {
+    x = htobe32(x);
+    memcpy(p, &x, sizeof(x));
+}
+
+void encode_uint64(uint64_t x, char *p) {
+    x = htobe64(x);
+    memcpy(p, &x, sizeof(x));
+}
+
+struct binary_request_t {
+    binary_request_t()
+        : opcode(0), opaque(0), cas(0), flags(0), exptime(0), delta(0), status(status_ok) { }
+
+    uint8_t opcode;
+    // Sent back as is in the response
+    uint32_t opaque;
+    cas_t cas;
+
+    // From the extras of the commands that have them
+    mcflags_t flags;
+    exptime_t exptime;
+    uint64_t delta;
+
+    store_key_t key;
+    counted_t<data_buffer_t> value;
+
+    // If this isn't `status_ok`, the request was malformed or isn't supported,
+    // and it's answered with this status instead of being run.
+    binary_status_t status;
+};
+
+bool is_quiet_get(uint8_t opcode) {
+    return opcode == op_getq || opcode == op_getkq;
+}
+
+bool is_get(uint8_t opcode) {
+    return opcode == op_get || opcode == op_getk || is_quiet_get(opcode);
+}
+
+/* Quiet commands only get a response if something goes wrong, except that quiet
+gets also get one if they find their key. */
+bool is_quiet(uint8_t opcode) {
+    switch (opcode) {
+    case op_getq:
+    case op_getkq:
+    case op_setq:
+    case op_addq:
+    case op_replaceq:
+    case op_deleteq:
+    case op_incrementq:
+    case op_decrementq:
+    case op_quitq:
+    case op_appendq:
+    case op_prependq:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Whether the request is run against the store, or answered in line */
+bool is_store_request(uint8_t opcode) {
+    switch (opcode) {
+    case op_noop:
+    case op_version:
+    case op_quit:
+    case op_quitq:
+        return false;
+    default:
+        return true;
+    }
+}
+
+/* How big a well-formed request's extras are, whether it has a key, and whether
+it may have a value. Returns false if we don't support the opcode. */
+bool get_request_format(uint8_t opcode, size_t *extras_size, bool *has_key, bool *has_value) {
+    switch (opcode) {
+    case op_get:
+    case op_getq:
+    case op_getk:
+    case op_getkq:
+    case op_delete:
+    case op_deleteq:
+        *extras_size = 0;
+        *has_key = true;
+        *has_value = false;
+        return true;
+    case op_set:
+    case op_setq:
+    case op_add:
+    case op_addq:
+    case op_replace:
+    case op_replaceq:
+        // Flags and expiration time
+        *extras_size = 8;
+        *has_key = true;
+        *has_value = true;
+        return true;
+    case op_append:
+    case op_appendq:
+    case op_prepend:
+    case op_prependq:
+        *extras_size = 0;
+        *has_key = true;
+        *has_value = true;
+        return true;
+    case op_increment:
+    case op_incrementq:
+    case op_decrement:
+    case op_decrementq:
+        // Amount, initial value and expiration time
+        *extras_size = 20;
+        *has_key = true;
+        *has_value = false;
+        return true;
+    case op_quit:
+    case op_quitq:
+    case op_noop:
+    case op_version:
+        *extras_size = 0;
+        *has_key = false;
+        *has_value = false;
+        return true;
+    default:
+        return false;
+    }
+}
+
+/* Throws away the body of a request we aren't going to run */
+void skip_body(txt_memcached_handler_t *rh, size_t size) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
+    while (size > 0) {
+        const size_t chunk = std::min<size_t>(size, 16 * KILOBYTE);
+        rh->peek(chunk);
+        rh->pop(chunk);
+        size -= chunk;
+    }
+}
+
+/* Reads one request. The header, extras and key are parsed where they are in
+the connection's read buffer, without being tokenized or copied first, and the
+value is read straight into its data buffer. Returns false if the client sent
+something that isn't a binary protocol request, in which case the connection
+should be closed. */
+bool read_request(txt_memcached_handler_t *rh, binary_request_t *req) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
+    const char *header = rh->peek(header_size);
+    if (static_cast<uint8_t>(header[0]) != memcached_binary_request_magic) {
+        return false;
+    }
+    req->opcode = header[1];
+    const size_t key_size = decode_uint16(header + 2);
+    const size_t extras_size = static_cast<uint8_t>(header[4]);
+    // The data type and vbucket, at 5 and 6, aren't used.
+    const size_t body_size = decode_uint32(header + 8);
+    req->opaque = decode_uint32(header + 12);
+    req->cas = decode_uint64(header + 16);
+    rh->pop(header_size);
+
+    if (extras_size + key_size > body_size) {
+        return false;
+    }
+    const size_t value_size = body_size - extras_size - key_size;
+
+    size_t expected_extras_size;
+    bool has_key, has_value;
+    if (!get_request_format(req->opcode, &expected_extras_size, &has_key, &has_value)) {
+        req->status = status_unknown_command;
+    } else if (extras_size != expected_extras_size
+               || (key_size > 0) != has_key
+               || key_size > MAX_KEY_SIZE
+               || (value_size > 0 && !has_value)) {
+        req->status = status_invalid_arguments;
+    } else if (value_size > MAX_VALUE_SIZE) {
+        req->status = status_too_large;
+    }
+    if (req->status != status_ok) {
+        skip_body(rh, body_size);
+        return true;
+    }
+
+    if (extras_size + key_size > 0) {
+        const char *body = rh->peek(extras_size + key_size);
+        if (extras_size == 8) {
+            req->flags = decode_uint32(body);
+            req->exptime = absolute_exptime(decode_uint32(body + 4));
+        } else if (extras_size == 20) {
+            // We don't create missing keys, so the initial value and
+            // expiration time aren't used.
+            req->delta = decode_uint64(body);
+        }
+        req->key.assign(key_size, reinterpret_cast<const uint8_t *>(body + extras_size));
+        rh->pop(extras_size + key_size);
+    }
+
+    if (has_value) {
+        req->value = data_buffer_t::create(value_size);
+        rh->read(req->value->buf(), value_size);
+    }
+
+    return true;
+}
+
+void write_response_header(txt_memcached_handler_t *rh, const binary_request_t &req,
+                           binary_status_t status, cas_t cas,
+                           size_t extras_size, size_t key_size, size_t value_size) {
+    char header[header_size];
+    header[0] = response_magic;
+    header[1] = req.opcode;
+    encode_uint16(key_size, header + 2);
+    header[4] = extras_size;
+    header[5] = 0;
+    encode_uint16(status, header + 6);
+    encode_uint32(extras_size + key_size + value_size, header + 8);
+    encode_uint32(req.opaque, header + 12);
+    encode_uint64(cas, header + 16);
+    rh->write(header, header_size);
+}
+
+/* A response with no extras or key, and with `message` as its value */
+void write_simple_response(txt_memcached_handler_t *rh, const binary_request_t &req,
+                           binary_status_t status, const std::string &message = "") {
+    write_response_header(rh, req, status, 0, 0, 0, message.size());
+    rh->write(message);
+}
+
+void write_get_response(txt_memcached_handler_t *rh, const binary_request_t &req,
+                        const get_result_t &res) {
+    const bool with_key = (req.opcode == op_getk || req.opcode == op_getkq);
+    const size_t key_size = with_key ? req.key.size() : 0;
+    if (res.value.has()) {
+        write_response_header(rh, req, status_ok, res.cas, 4, key_size, res.value->size());
+        char extras[4];
+        encode_uint32(res.flags, extras);
+        rh->write(extras, sizeof(extras));
+        rh->write(reinterpret_cast<const char *>(req.key.contents()), key_size);
+        rh->write_from_data_provider(res.value.get());
+    } else if (!is_quiet(req.opcode)) {
+        write_response_header(rh, req, status_key_not_found, 0, 0, key_size, 0);
+        rh->write(reinterpret_cast<const char *>(req.key.contents()), key_size);
+    }
+}
+
+void run_gets(txt_memcached_handler_t *rh,
+              pipeliner_acq_t *pipeliner_acq_raw,
+              std::vector<binary_request_t> *gets_raw,
+              order_token_t token) {
+    scoped_ptr_t<pipeliner_acq_t> pipeliner_acq(pipeliner_acq_raw);
+    scoped_ptr_t<std::vector<binary_request_t> > gets(gets_raw);
+
+    block_pm_duration get_timer(&rh->stats->pm_cmd_get);
+
+    get_multi_query_t get_multi_query;
+    get_multi_query.keys.reserve(gets->size());
+    for (size_t i = 0; i < gets->size(); ++i) {
+        get_multi_query.keys.push_back((*gets)[i].key);
+    }
+
+    get_multi_result_t result;
+    std::string error_message;
+    bool ok;
+
+    try {
+        memcached_protocol_t::read_t read(get_multi_query, time(NULL));
+        memcached_protocol_t::read_response_t response;
+        rh->nsi->read(read, &response, token, rh->interruptor);
+        result = boost::get<get_multi_result_t>(response.result);
+        guarantee(result.results.size() == gets->size());
+        ok = true;
+    } catch (const cannot_perform_query_exc_t &e) {
+        error_message = e.what();
+        ok = false;
+    } catch (const interrupted_exc_t &) {
+        pipeliner_acq->begin_write();
+        pipeliner_acq->end_write();
+        return;
+    }
+
+    pipeliner_acq->begin_write();
+    for (size_t i = 0; i < gets->size(); ++i) {
+        if (ok) {
+            write_get_response(rh, (*gets)[i], result.results[i]);
+        } else {
+            write_simple_response(rh, (*gets)[i], status_internal_error, error_message);
+        }
+    }
+    pipeliner_acq->end_write();
+}
+
+memcached_protocol_t::write_t make_write(const binary_request_t &req, cas_t proposed_cas) {
+    const exptime_t effective_time = time(NULL);
+    switch (req.opcode) {
+    case op_set:
+    case op_setq:
+    case op_add:
+    case op_addq:
+    case op_replace:
+    case op_replaceq: {
+        add_policy_t add_policy;
+        replace_policy_t replace_policy;
+        if (req.opcode == op_add || req.opcode == op_addq) {
+            add_policy = add_policy_yes;
+            replace_policy = replace_policy_no;
+        } else if (req.cas != 0) {
+            add_policy = add_policy_no;
+            replace_policy = replace_policy_if_cas_matches;
+        } else if (req.opcode == op_replace || req.opcode == op_replaceq) {
+            add_policy = add_policy_no;
+            replace_policy = replace_policy_yes;
+        } else {
+            add_policy = add_policy_yes;
+            replace_policy = replace_policy_yes;
+        }
+        sarc_mutation_t sarc_mutation(req.key, req.value, req.flags, req.exptime,
+                                      add_policy, replace_policy, req.cas);
+        return memcached_protocol_t::write_t(sarc_mutation, proposed_cas, effective_time);
+    }
+    case op_append:
+    case op_appendq:
+    case op_prepend:
+    case op_prependq: {
+        const bool append = (req.opcode == op_append || req.opcode == op_appendq);
+        append_prepend_mutation_t append_prepend_mutation(
+            append ? append_prepend_APPEND : append_prepend_PREPEND, req.key, req.value);
+        return memcached_protocol_t::write_t(append_prepend_mutation, proposed_cas, effective_time);
+    }
+    case op_delete:
+    case op_deleteq: {
+        delete_mutation_t delete_mutation(req.key, false);
+        return memcached_protocol_t::write_t(delete_mutation, INVALID_CAS, effective_time);
+    }
+    case op_increment:
+    case op_incrementq:
+    case op_decrement:
+    case op_decrementq: {
+        const bool incr = (req.opcode == op_increment || req.opcode == op_incrementq);
+        incr_decr_mutation_t incr_decr_mutation(
+            incr ? incr_decr_INCR : incr_decr_DECR, req.key, req.delta);
+        return memcached_protocol_t::write_t(incr_decr_mutation, proposed_cas, effective_time);
+    }
+    default:
+        unreachable();
+    }
+}
+
+binary_status_t get_write_status(const binary_request_t &req,
+                                 const memcached_protocol_t::write_response_t &response,
+                                 uint64_t *new_value_out) {
+    switch (req.opcode) {
+    case op_set:
+    case op_setq:
+    case op_add:
+    case op_addq:
+    case op_replace:
+    case op_replaceq:
+        switch (boost::get<set_result_t>(response.result)) {
+        case sr_stored: return status_ok;
+        case sr_didnt_add: return status_key_not_found;
+        case sr_didnt_replace: return status_key_exists;
+        case sr_too_large: return status_too_large;
+        default: unreachable();
+        }
+    case op_append:
+    case op_appendq:
+    case op_prepend:
+    case op_prependq:
+        switch (boost::get<append_prepend_result_t>(response.result)) {
+        case apr_success: return status_ok;
+        case apr_not_found: return status_not_stored;
+        case apr_too_large: return status_too_large;
+        default: unreachable();
+        }
+    case op_delete:
+    case op_deleteq:
+        switch (boost::get<delete_result_t>(response.result)) {
+        case dr_deleted: return status_ok;
+        case dr_not_found: return status_key_not_found;
+        default: unreachable();
+        }
+    case op_increment:
+    case op_incrementq:
+    case op_decrement:
+    case op_decrementq: {
+        const incr_decr_result_t &res = boost::get<incr_decr_result_t>(response.result);
+        switch (res.res) {
+        case incr_decr_result_t::idr_success:
+            *new_value_out = res.new_value;
+            return status_ok;
+        case incr_decr_result_t::idr_not_found: return status_key_not_found;
+        case incr_decr_result_t::idr_not_numeric: return status_non_numeric;
+        default: unreachable();
+        }
+    }
+    default:
+        unreachable();
+    }
+}
+
+void run_write(txt_memcached_handler_t *rh,
+               pipeliner_acq_t *pipeliner_acq_raw,
+               binary_request_t *req_raw,
+               order_token_t token) {
+    scoped_ptr_t<pipeliner_acq_t> pipeliner_acq(pipeliner_acq_raw);
+    scoped_ptr_t<binary_request_t> req(req_raw);
+
+    block_pm_duration set_timer(&rh->stats->pm_cmd_set);
+
+    binary_status_t status;
+    uint64_t new_value = 0;
+    std::string error_message;
+
+    try {
+        memcached_protocol_t::write_t write = make_write(*req, rh->generate_cas());
+        memcached_protocol_t::write_response_t response;
+        rh->nsi->write(write, &response, token, rh->interruptor);
+        status = get_write_status(*req, response, &new_value);
+    } catch (const cannot_perform_query_exc_t &e) {
+        error_message = e.what();
+        status = status_internal_error;
+    } catch (const interrupted_exc_t &) {
+        pipeliner_acq->begin_write();
+        pipeliner_acq->end_write();
+        return;
+    }
+
+    pipeliner_acq->begin_write();
+    if (status != status_ok) {
+        write_simple_response(rh, *req, status, error_message);
+    } else if (req->opcode == op_increment || req->opcode == op_decrement) {
+        char value[8];
+        encode_uint64(new_value, value);
+        write_response_header(rh, *req, status_ok, 0, 0, 0, sizeof(value));
+        rh->write(value, sizeof(value));
+    } else if (!is_quiet(req->opcode)) {
+        // The CAS is 0 because we don't know the new value's CAS; see
+        // `handle_binary_memcache()`.
+        write_simple_response(rh, *req, status_ok);
+    }
+    pipeliner_acq->end_write();
+}
+
+/* Sends off a batch of gets as one read. Takes ownership of `gets`. */
+void dispatch_gets(txt_memcached_handler_t *rh, pipeliner_t *pipeliner,
+                   order_source_t *order_source, std::vector<binary_request_t> *gets) {
+    pipeliner_acq_t *pipeliner_acq = new pipeliner_acq_t(pipeliner);
+    pipeliner_acq->done_argparsing();
+    order_token_t token = order_source->check_in("handle_binary_memcache+get").with_read_mode();
+    coro_t::spawn_now_dangerously(boost::bind(&run_gets, rh, pipeliner_acq, gets, token));
+}
+
+void dispatch_write(txt_memcached_handler_t *rh, pipeliner_t *pipeliner,
+                    order_source_t *order_source, const binary_request_t &req) {
+    if (req.value.has()) {
+        rh->stats->pm_storage_key_size.record(req.key.size());
+        rh->stats->pm_storage_value_size.record(req.value->size());
+    } else if (req.opcode == op_delete || req.opcode == op_deleteq) {
+        rh->stats->pm_delete_key_size.record(req.key.size());
+    }
+
+    pipeliner_acq_t *pipeliner_acq = new pipeliner_acq_t(pipeliner);
+    pipeliner_acq->done_argparsing();
+    order_token_t token = order_source->check_in("handle_binary_memcache+write");
+    coro_t::spawn_now_dangerously(boost::bind(&run_write, rh, pipeliner_acq, new binary_request_t(req), token));
+}
+
+/* Answers a request that doesn't go to the store, or one that's malformed.
+Returns false if the client asked to close the connection. */
+bool handle_in_line(txt_memcached_handler_t *rh, pipeliner_t *pipeliner, const binary_request_t &req) {
+    pipeliner_acq_t pipeliner_acq(pipeliner);
+    pipeliner_acq.done_argparsing();
+    pipeliner_acq.begin_write();
+
+    bool keep_open = true;
+    if (req.status != status_ok) {
+        write_simple_response(rh, req, req.status);
+    } else {
+        switch (req.opcode) {
+        case op_noop:
+            write_simple_response(rh, req, status_ok);
+            break;
+        case op_version:
+            write_simple_response(rh, req, status_ok, strprintf("rethinkdb-%s", RETHINKDB_VERSION));
+            break;
+        case op_quit:
+            write_simple_response(rh, req, status_ok);
+            keep_open = false;
+            break;
+        case op_quitq:
+            keep_open = false;
+            break;
+        default:
+            unreachable();
+        }
+    }
+
+    pipeliner_acq.end_write();
+    return keep_open;
+}
+
+}   /* anonymous namespace */
+
+void handle_binary_memcache(txt_memcached_handler_t *rh,
+                            pipeliner_t *pipeliner,
+                            order_source_t *order_source) {
+    /* The quiet gets that are waiting for the request that ends their batch */
+    scoped_ptr_t<std::vector<binary_request_t> > batch(new std::vector<binary_request_t>);
+
+    while (pipeliner->lock_argparsing(), !rh->interruptor->is_pulsed()) {
+        block_pm_duration read_timer(&rh->stats->pm_conns_reading);
+        binary_request_t req;
+        try {
+            if (!read_request(rh, &req)) {
+                break;
+            }
+        } catch (const memcached_interface_t::no_more_data_exc_t &) {
+            break;
+        }
+        read_timer.end();
+
+        block_pm_duration action_timer(&rh->stats->pm_conns_acting);
+
+        if (req.status == status_ok && is_get(req.opcode)) {
+            rh->stats->pm_get_key_size.record(req.key.size());
+            batch->push_back(req);
+            if (is_quiet_get(req.opcode) && batch->size() < MAX_BATCHED_BINARY_MEMCACHED_GETS) {
+                pipeliner->unlock_argparsing();
+            } else {
+                dispatch_gets(rh, pipeliner, order_source, batch.release());
+                batch.init(new std::vector<binary_request_t>);
+            }
+            continue;
+        }
+
+        /* The held back gets go first, so that the responses are in the same
+        order as the requests */
+        if (!batch->empty()) {
+            dispatch_gets(rh, pipeliner, order_source, batch.release());
+            batch.init(new std::vector<binary_request_t>);
+            pipeliner->lock_argparsing();
+        }
+
+        if (req.status == status_ok && is_store_request(req.opcode)) {
+            dispatch_write(rh, pipeliner, order_source, req);
+        } else if (!handle_in_line(rh, pipeliner, req)) {
+            pipeliner->lock_argparsing();
+            break;
+        }
+
+        action_timer.end();
+    }
+
+    /* The client won't send the request that would have ended the batch, but
+    it may still read the responses. */
+    if (!batch->empty()) {
+        dispatch_gets(rh, pipeliner, order_source, batch.release());
+        pipeliner->lock_argparsing();
+    }
+}
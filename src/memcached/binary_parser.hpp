@@ -0,0 +1,37 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef MEMCACHED_BINARY_PARSER_HPP_
+#define MEMCACHED_BINARY_PARSER_HPP_
+
+#include <stdint.h>
+
+class order_source_t;
+class pipeliner_t;
+struct txt_memcached_handler_t;
+
+/* Every binary protocol request starts with this byte. No text protocol command
+does, so `handle_memcache()` looks at a connection's first byte to tell which
+protocol it speaks. */
+const uint8_t memcached_binary_request_magic = 0x80;
+
+/* `handle_binary_memcache()` handles binary protocol requests the way
+`handle_memcache()` handles text protocol ones, until the connection is closed,
+the client sends something that isn't a binary protocol request, or
+`rh->interruptor` is pulsed. Like the text protocol's loop, it stops with the
+pipeliner's argparsing lock held.
+
+It supports the get, set, add, replace, append, prepend, delete, increment,
+decrement, quit, no-op and version commands and their quiet versions. Quiet gets
+are batched: they're held back until a request that isn't a quiet get comes in,
+and then sent to the cluster as one read, along with that request if it's a get.
+Sets and replaces with a CAS in their header only store the value if its
+CAS matches.
+
+Responses to successful stores always carry a CAS of 0, because the store
+doesn't report the CAS it gave the new value (or whether it gave it one at all).
+Clients that want to chain CAS operations have to get the key again to learn
+its CAS, as text protocol clients do with `gets`. */
+void handle_binary_memcache(txt_memcached_handler_t *rh,
+                            pipeliner_t *pipeliner,
+                            order_source_t *order_source);
+
+#endif  // MEMCACHED_BINARY_PARSER_HPP_
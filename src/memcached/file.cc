@@ -1,5 +1,8 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "memcached/file.hpp"
+
+#include <vector>
+
 #include "memcached/parser.hpp"
 #include "concurrency/fifo_checker.hpp"
 
@@ -48,6 +51,27 @@ public:
         //we didn't every find a crlf unleash the exception
         if (*head) throw no_more_data_exc_t();
     }
+
+    const char *peek(size_t nbytes, signal_t *interruptor) {
+        if (interruptor->is_pulsed()) throw no_more_data_exc_t();
+        peek_buffer.resize(nbytes);
+        if (nbytes == 0) return peek_buffer.data();
+        if (fread(peek_buffer.data(), nbytes, 1, file) == 0)
+            throw no_more_data_exc_t();
+        // Seek back so that the next read gets the same bytes
+        if (fseek(file, -static_cast<long>(nbytes), SEEK_CUR) != 0)  // NOLINT(runtime/int)
+            throw no_more_data_exc_t();
+        return peek_buffer.data();
+    }
+
+    void pop(size_t nbytes, signal_t *interruptor) {
+        if (interruptor->is_pulsed()) throw no_more_data_exc_t();
+        if (fseek(file, nbytes, SEEK_CUR) != 0)
+            throw no_more_data_exc_t();
+    }
+
+private:
+    std::vector<char> peek_buffer;
 };
 
 void import_memcache(const char *filename, namespace_interface_t<memcached_protocol_t> *nsi, signal_t *interrupter) {
@@ -0,0 +1,302 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef MEMCACHED_HANDLER_HPP_
+#define MEMCACHED_HANDLER_HPP_
+
+#ifndef __STDC_FORMAT_MACROS
+#define __STDC_FORMAT_MACROS
+#endif
+
+#include <inttypes.h>
+#include <stdarg.h>
+#include <time.h>
+
+#include <string>
+#include <vector>
+
+#include "concurrency/coro_fifo.hpp"
+#include "concurrency/mutex.hpp"
+#include "concurrency/semaphore.hpp"
+#include "containers/printf_buffer.hpp"
+#include "memcached/parser.hpp"
+#include "memcached/stats.hpp"
+
+/* txt_memcached_handler_t only exists as a convenient thing to pass around to do_get(),
+do_storage(), and the like. The binary protocol's handlers use it too, along with
+`pipeliner_t`, so both protocols get the same request ordering. */
+
+struct txt_memcached_handler_t : public home_thread_mixin_debug_only_t {
+    txt_memcached_handler_t(memcached_interface_t *_interface,
+                            namespace_interface_t<memcached_protocol_t> *_nsi,
+                            int _max_concurrent_queries_per_connection,
+                            memcached_stats_t *_stats,
+                            signal_t *_interruptor)
+        : interface(_interface), nsi(_nsi),
+          max_concurrent_queries_per_connection(_max_concurrent_queries_per_connection),
+          stats(_stats), interruptor(_interruptor)
+    { }
+
+    memcached_interface_t *interface;
+
+    namespace_interface_t<memcached_protocol_t> *nsi;
+
+    const int max_concurrent_queries_per_connection;
+
+    memcached_stats_t *stats;
+
+    signal_t *interruptor;
+
+    cas_t generate_cas() {
+        // TODO we have to do better than this. CASes need to be generated in a
+        // way that is very fast but also gives a reasonably good guarantee of
+        // uniqueness across time and space.
+        return random();
+    }
+
+    void write(const std::string& buffer) THROWS_NOTHING {
+        write(buffer.data(), buffer.length());
+    }
+
+    void write(const char *buffer, size_t bytes) THROWS_NOTHING {
+        try {
+            interface->write(buffer, bytes, interruptor);
+        } catch (const interrupted_exc_t &) {
+            /* ignore */
+        }
+    }
+
+    void vwritef(const char *format, va_list args) THROWS_NOTHING __attribute__((format (printf, 2, 0))) {
+        printf_buffer_t buffer(args, format);
+        write(buffer.data(), buffer.size());
+    }
+
+    void writef(const char *format, ...) THROWS_NOTHING
+        __attribute__ ((format (printf, 2, 3))) {
+        va_list args;
+        va_start(args, format);
+        vwritef(format, args);
+        va_end(args);
+    }
+
+    void write_unbuffered(const char *buffer, size_t bytes) THROWS_NOTHING {
+        try {
+            interface->write_unbuffered(buffer, bytes, interruptor);
+        } catch (const interrupted_exc_t &) {
+            /* ignore */
+        }
+    }
+
+    void write_from_data_provider(data_buffer_t *dp) THROWS_NOTHING {
+        if (dp->size() < MAX_BUFFERED_GET_SIZE) {
+            write(dp->buf(), dp->size());
+        } else {
+            write_unbuffered(dp->buf(), dp->size());
+        }
+    }
+
+    void write_value_header(const char *key, size_t key_size, mcflags_t mcflags, size_t value_size) THROWS_NOTHING {
+        writef("VALUE %*.*s %u %zu\r\n",
+               static_cast<int>(key_size), static_cast<int>(key_size), key, mcflags, value_size);
+    }
+
+    void write_value_header(const char *key, size_t key_size, mcflags_t mcflags, size_t value_size, cas_t cas) THROWS_NOTHING {
+        writef("VALUE %*.*s %u %zu %" PRIu64 "\r\n",
+               static_cast<int>(key_size), static_cast<int>(key_size), key, mcflags, value_size, cas);
+    }
+
+    void error() THROWS_NOTHING {
+        writef("ERROR\r\n");
+    }
+
+    void write_crlf() THROWS_NOTHING {
+        write("\r\n", 2);
+    }
+
+    void write_end() THROWS_NOTHING {
+        writef("END\r\n");
+    }
+
+    void client_error(const char *format, ...) THROWS_NOTHING
+        __attribute__ ((format (printf, 2, 3))) {
+        writef("CLIENT_ERROR ");
+        va_list args;
+        va_start(args, format);
+        vwritef(format, args);
+        va_end(args);
+    }
+
+    void server_error(const char *format, ...) THROWS_NOTHING
+        __attribute__ ((format (printf, 2, 3))) {
+        writef("SERVER_ERROR ");
+        va_list args;
+        va_start(args, format);
+        printf_buffer_t buffer(args, format);
+        write(buffer.data(), buffer.size());
+        va_end(args);
+        writef("\r\n");
+    }
+
+    void client_error_bad_command_line_format() THROWS_NOTHING {
+        client_error("bad command line format\r\n");
+    }
+
+    void client_error_bad_data() THROWS_NOTHING {
+        client_error("bad data chunk\r\n");
+    }
+
+    void server_error_object_too_large_for_cache() THROWS_NOTHING {
+        server_error("object too large for cache");
+    }
+
+    void flush_buffer() THROWS_NOTHING {
+        try {
+            interface->flush_buffer(interruptor);
+        } catch (const interrupted_exc_t &) {
+            /* ignore */
+        }
+    }
+
+    bool is_write_open() {
+        return interface->is_write_open();
+    }
+
+    void read(void *buf, size_t nbytes) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
+        try {
+            interface->read(buf, nbytes, interruptor);
+        } catch (const interrupted_exc_t &) {
+            throw memcached_interface_t::no_more_data_exc_t();
+        }
+    }
+
+    void read_line(std::vector<char> *dest) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
+        try {
+            interface->read_line(dest, interruptor);
+        } catch (const interrupted_exc_t &) {
+            throw memcached_interface_t::no_more_data_exc_t();
+        }
+    }
+
+    const char *peek(size_t nbytes) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
+        try {
+            return interface->peek(nbytes, interruptor);
+        } catch (const interrupted_exc_t &) {
+            throw memcached_interface_t::no_more_data_exc_t();
+        }
+    }
+
+    void pop(size_t nbytes) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
+        try {
+            interface->pop(nbytes, interruptor);
+        } catch (const interrupted_exc_t &) {
+            throw memcached_interface_t::no_more_data_exc_t();
+        }
+    }
+};
+
+// This is protocol.txt, verbatim:
+// Some commands involve a client sending some kind of expiration time
+// (relative to an item or to an operation requested by the client) to
+// the server. In all such cases, the actual value sent may either be
+// Unix time (number of seconds since January 1, 1970, as a 32-bit
+// value), or a number of seconds starting from current time. In the
+// latter case, this number of seconds may not exceed 60*60*24*30 (number
+// of seconds in 30 days); if the number sent by a client is larger than
+// that, the server will consider it to be real Unix time value rather
+// than an offset from current time.
+inline exptime_t absolute_exptime(exptime_t exptime) {
+    if (exptime <= 60*60*24*30 && exptime > 0) {
+        // If 60*60*24*30 < exptime <= time(NULL), that's fine, the
+        // btree code needs to handle that case gracefully anyway
+        // (since the clock can tick in the middle of an insert
+        // anyway...).  We have tests in expiration.py.
+        exptime += time(NULL);
+    }
+    return exptime;
+}
+
+class pipeliner_t {
+public:
+    explicit pipeliner_t(txt_memcached_handler_t *rh) : requests_out_sem(rh->max_concurrent_queries_per_connection), rh_(rh) { }
+    ~pipeliner_t() { }
+
+    void lock_argparsing() {
+        co_lock_mutex(&argparsing_mutex);
+    }
+
+    /* For a request that's put off rather than acquiring the pipeliner, such
+    as a binary protocol quiet get waiting to be batched */
+    void unlock_argparsing() {
+        unlock_mutex(&argparsing_mutex);
+    }
+private:
+    friend class pipeliner_acq_t;
+    coro_fifo_t fifo;
+
+    // This should have no effect (because we don't block coroutines
+    // until after done argparsing), but
+    mutex_t argparsing_mutex;
+
+    // Used to limit number of concurrent requests
+    semaphore_t requests_out_sem;
+
+    mutex_t mutex;
+    txt_memcached_handler_t *rh_;
+
+    DISABLE_COPYING(pipeliner_t);
+};
+
+class pipeliner_acq_t {
+public:
+    explicit pipeliner_acq_t(pipeliner_t *pipeliner) : pipeliner_(pipeliner), state_(untouched) {
+        begin_operation();
+    }
+    ~pipeliner_acq_t() {
+        guarantee(state_ == has_ended_write);
+    }
+
+private:
+    void begin_operation() {
+        guarantee(state_ == untouched);
+        DEBUG_ONLY_CODE(state_ = has_begun_operation);
+        fifo_acq_.enter(&pipeliner_->fifo);
+    }
+
+public:
+    void done_argparsing() {
+        guarantee(state_ == has_begun_operation);
+        DEBUG_ONLY_CODE(state_ = has_done_argparsing);
+
+        unlock_mutex(&pipeliner_->argparsing_mutex);
+        pipeliner_->requests_out_sem.co_lock();
+    }
+
+    void begin_write() {
+        guarantee(state_ == has_done_argparsing);
+        DEBUG_ONLY_CODE(state_ = has_begun_write);
+        fifo_acq_.leave();
+        mutex_acq_.reset(&pipeliner_->mutex);
+    }
+
+    void end_write() {
+        guarantee(state_ == has_begun_write);
+        DEBUG_ONLY_CODE(state_ = has_ended_write);
+
+        {
+            block_pm_duration flush_timer(&pipeliner_->rh_->stats->pm_conns_writing); // FIXME: race condition here
+            pipeliner_->rh_->flush_buffer();
+        }
+
+        mutex_acq_.reset();
+        pipeliner_->requests_out_sem.unlock();
+    }
+
+private:
+    pipeliner_t *pipeliner_;
+    mutex_t::acq_t mutex_acq_;
+    coro_fifo_acq_t fifo_acq_;
+
+    enum { untouched, has_begun_operation, has_done_argparsing, has_begun_write, has_ended_write } state_;
+
+    DISABLE_COPYING(pipeliner_acq_t);
+};
+
+#endif  // MEMCACHED_HANDLER_HPP_
@@ -25,6 +25,7 @@ get_result_t memcached_get(const store_key_t &store_key, btree_slice_t *slice, e
 
     counted_t<data_buffer_t> dp = value_to_data_buffer(value, txn);
 
-    return get_result_t(dp, value->mcflags(), 0);
+    // Values only have a CAS once a `gets` has given them one
+    return get_result_t(dp, value->mcflags(), value->has_cas() ? value->cas() : 0);
 }
 
@@ -30,244 +30,12 @@
 #include "logger.hpp"
 #include "arch/os_signal.hpp"
 #include "perfmon/collect.hpp"
+#include "memcached/binary_parser.hpp"
+#include "memcached/handler.hpp"
 #include "memcached/stats.hpp"
 
 static const char *crlf = "\r\n";
 
-/* txt_memcached_handler_t only exists as a convenient thing to pass around to do_get(),
-do_storage(), and the like. */
-
-struct txt_memcached_handler_t : public home_thread_mixin_debug_only_t {
-    txt_memcached_handler_t(memcached_interface_t *_interface,
-                            namespace_interface_t<memcached_protocol_t> *_nsi,
-                            int _max_concurrent_queries_per_connection,
-                            memcached_stats_t *_stats,
-                            signal_t *_interruptor)
-        : interface(_interface), nsi(_nsi),
-          max_concurrent_queries_per_connection(_max_concurrent_queries_per_connection),
-          stats(_stats), interruptor(_interruptor)
-    { }
-
-    memcached_interface_t *interface;
-
-    namespace_interface_t<memcached_protocol_t> *nsi;
-
-    const int max_concurrent_queries_per_connection;
-
-    memcached_stats_t *stats;
-
-    signal_t *interruptor;
-
-    cas_t generate_cas() {
-        // TODO we have to do better than this. CASes need to be generated in a
-        // way that is very fast but also gives a reasonably good guarantee of
-        // uniqueness across time and space.
-        return random();
-    }
-
-    void write(const std::string& buffer) THROWS_NOTHING {
-        write(buffer.data(), buffer.length());
-    }
-
-    void write(const char *buffer, size_t bytes) THROWS_NOTHING {
-        try {
-            interface->write(buffer, bytes, interruptor);
-        } catch (const interrupted_exc_t &) {
-            /* ignore */
-        }
-    }
-
-    void vwritef(const char *format, va_list args) THROWS_NOTHING __attribute__((format (printf, 2, 0))) {
-        printf_buffer_t buffer(args, format);
-        write(buffer.data(), buffer.size());
-    }
-
-    void writef(const char *format, ...) THROWS_NOTHING
-        __attribute__ ((format (printf, 2, 3))) {
-        va_list args;
-        va_start(args, format);
-        vwritef(format, args);
-        va_end(args);
-    }
-
-    void write_unbuffered(const char *buffer, size_t bytes) THROWS_NOTHING {
-        try {
-            interface->write_unbuffered(buffer, bytes, interruptor);
-        } catch (const interrupted_exc_t &) {
-            /* ignore */
-        }
-    }
-
-    void write_from_data_provider(data_buffer_t *dp) THROWS_NOTHING {
-        if (dp->size() < MAX_BUFFERED_GET_SIZE) {
-            write(dp->buf(), dp->size());
-        } else {
-            write_unbuffered(dp->buf(), dp->size());
-        }
-    }
-
-    void write_value_header(const char *key, size_t key_size, mcflags_t mcflags, size_t value_size) THROWS_NOTHING {
-        writef("VALUE %*.*s %u %zu\r\n",
-               static_cast<int>(key_size), static_cast<int>(key_size), key, mcflags, value_size);
-    }
-
-    void write_value_header(const char *key, size_t key_size, mcflags_t mcflags, size_t value_size, cas_t cas) THROWS_NOTHING {
-        writef("VALUE %*.*s %u %zu %" PRIu64 "\r\n",
-               static_cast<int>(key_size), static_cast<int>(key_size), key, mcflags, value_size, cas);
-    }
-
-    void error() THROWS_NOTHING {
-        writef("ERROR\r\n");
-    }
-
-    void write_crlf() THROWS_NOTHING {
-        write(crlf, 2);
-    }
-
-    void write_end() THROWS_NOTHING {
-        writef("END\r\n");
-    }
-
-    void client_error(const char *format, ...) THROWS_NOTHING
-        __attribute__ ((format (printf, 2, 3))) {
-        writef("CLIENT_ERROR ");
-        va_list args;
-        va_start(args, format);
-        vwritef(format, args);
-        va_end(args);
-    }
-
-    void server_error(const char *format, ...) THROWS_NOTHING
-        __attribute__ ((format (printf, 2, 3))) {
-        writef("SERVER_ERROR ");
-        va_list args;
-        va_start(args, format);
-        printf_buffer_t buffer(args, format);
-        write(buffer.data(), buffer.size());
-        va_end(args);
-        writef("\r\n");
-    }
-
-    void client_error_bad_command_line_format() THROWS_NOTHING {
-        client_error("bad command line format\r\n");
-    }
-
-    void client_error_bad_data() THROWS_NOTHING {
-        client_error("bad data chunk\r\n");
-    }
-
-    void server_error_object_too_large_for_cache() THROWS_NOTHING {
-        server_error("object too large for cache");
-    }
-
-    void flush_buffer() THROWS_NOTHING {
-        try {
-            interface->flush_buffer(interruptor);
-        } catch (const interrupted_exc_t &) {
-            /* ignore */
-        }
-    }
-
-    bool is_write_open() {
-        return interface->is_write_open();
-    }
-
-    void read(void *buf, size_t nbytes) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
-        try {
-            interface->read(buf, nbytes, interruptor);
-        } catch (const interrupted_exc_t &) {
-            throw memcached_interface_t::no_more_data_exc_t();
-        }
-    }
-
-    void read_line(std::vector<char> *dest) THROWS_ONLY(memcached_interface_t::no_more_data_exc_t) {
-        try {
-            interface->read_line(dest, interruptor);
-        } catch (const interrupted_exc_t &) {
-            throw memcached_interface_t::no_more_data_exc_t();
-        }
-    }
-};
-
-class pipeliner_t {
-public:
-    explicit pipeliner_t(txt_memcached_handler_t *rh) : requests_out_sem(rh->max_concurrent_queries_per_connection), rh_(rh) { }
-    ~pipeliner_t() { }
-
-    void lock_argparsing() {
-        co_lock_mutex(&argparsing_mutex);
-    }
-private:
-    friend class pipeliner_acq_t;
-    coro_fifo_t fifo;
-
-    // This should have no effect (because we don't block coroutines
-    // until after done argparsing), but
-    mutex_t argparsing_mutex;
-
-    // Used to limit number of concurrent requests
-    semaphore_t requests_out_sem;
-
-    mutex_t mutex;
-    txt_memcached_handler_t *rh_;
-
-    DISABLE_COPYING(pipeliner_t);
-};
-
-class pipeliner_acq_t {
-public:
-    explicit pipeliner_acq_t(pipeliner_t *pipeliner) : pipeliner_(pipeliner), state_(untouched) {
-        begin_operation();
-    }
-    ~pipeliner_acq_t() {
-        guarantee(state_ == has_ended_write);
-    }
-
-private:
-    void begin_operation() {
-        guarantee(state_ == untouched);
-        DEBUG_ONLY_CODE(state_ = has_begun_operation);
-        fifo_acq_.enter(&pipeliner_->fifo);
-    }
-
-public:
-    void done_argparsing() {
-        guarantee(state_ == has_begun_operation);
-        DEBUG_ONLY_CODE(state_ = has_done_argparsing);
-
-        unlock_mutex(&pipeliner_->argparsing_mutex);
-        pipeliner_->requests_out_sem.co_lock();
-    }
-
-    void begin_write() {
-        guarantee(state_ == has_done_argparsing);
-        DEBUG_ONLY_CODE(state_ = has_begun_write);
-        fifo_acq_.leave();
-        mutex_acq_.reset(&pipeliner_->mutex);
-    }
-
-    void end_write() {
-        guarantee(state_ == has_begun_write);
-        DEBUG_ONLY_CODE(state_ = has_ended_write);
-
-        {
-            block_pm_duration flush_timer(&pipeliner_->rh_->stats->pm_conns_writing); // FIXME: race condition here
-            pipeliner_->rh_->flush_buffer();
-        }
-
-        mutex_acq_.reset();
-        pipeliner_->requests_out_sem.unlock();
-    }
-
-private:
-    pipeliner_t *pipeliner_;
-    mutex_t::acq_t mutex_acq_;
-    coro_fifo_acq_t fifo_acq_;
-
-    enum { untouched, has_begun_operation, has_done_argparsing, has_begun_write, has_ended_write } state_;
-
-    DISABLE_COPYING(pipeliner_acq_t);
-};
 /* do_get() is used for "get" and "gets" commands. */
 
 struct get_t {
@@ -277,21 +45,15 @@ struct get_t {
     bool ok;
 };
 
-void do_one_get(txt_memcached_handler_t *rh, bool with_cas, get_t *gets, int i, order_token_t token) {
+/* `gets` has to assign each key a new CAS, which is a write, so it does one
+write per key. */
+void do_one_get_cas(txt_memcached_handler_t *rh, get_t *gets, int i, order_token_t token) {
     try {
-        if (with_cas) {
-            get_cas_mutation_t get_cas_mutation(gets[i].key);
-            memcached_protocol_t::write_t write(get_cas_mutation, rh->generate_cas(), time(NULL));
-            memcached_protocol_t::write_response_t response;
-            rh->nsi->write(write, &response, token, rh->interruptor);
-            gets[i].res = boost::get<get_result_t>(response.result);
-        } else {
-            get_query_t get_query(gets[i].key);
-            memcached_protocol_t::read_t read(get_query, time(NULL));
-            memcached_protocol_t::read_response_t response;
-            rh->nsi->read(read, &response, token, rh->interruptor);
-            gets[i].res = boost::get<get_result_t>(response.result);
-        }
+        get_cas_mutation_t get_cas_mutation(gets[i].key);
+        memcached_protocol_t::write_t write(get_cas_mutation, rh->generate_cas(), time(NULL));
+        memcached_protocol_t::write_response_t response;
+        rh->nsi->write(write, &response, token, rh->interruptor);
+        gets[i].res = boost::get<get_result_t>(response.result);
         gets[i].ok = true;
     } catch (const cannot_perform_query_exc_t &e) {
         gets[i].error_message = e.what();
@@ -301,6 +63,35 @@ void do_one_get(txt_memcached_handler_t *rh, bool with_cas, get_t *gets, int i,
     }
 }
 
+/* `get` reads all the keys at once, so each shard gets one read no matter how
+many of the keys it has. */
+void do_multi_get(txt_memcached_handler_t *rh, std::vector<get_t> *gets, order_token_t token) {
+    get_multi_query_t get_multi_query;
+    get_multi_query.keys.reserve(gets->size());
+    for (size_t i = 0; i < gets->size(); ++i) {
+        get_multi_query.keys.push_back((*gets)[i].key);
+    }
+
+    try {
+        memcached_protocol_t::read_t read(get_multi_query, time(NULL));
+        memcached_protocol_t::read_response_t response;
+        rh->nsi->read(read, &response, token, rh->interruptor);
+        const get_multi_result_t &result = boost::get<get_multi_result_t>(response.result);
+        guarantee(result.results.size() == gets->size());
+        for (size_t i = 0; i < gets->size(); ++i) {
+            (*gets)[i].res = result.results[i];
+            (*gets)[i].ok = true;
+        }
+    } catch (const cannot_perform_query_exc_t &e) {
+        for (size_t i = 0; i < gets->size(); ++i) {
+            (*gets)[i].error_message = e.what();
+            (*gets)[i].ok = false;
+        }
+    } catch (const interrupted_exc_t &) {
+        /* do nothing */
+    }
+}
+
 void do_get(txt_memcached_handler_t *rh, pipeliner_t *pipeliner, bool with_cas, int argc, char **argv, order_token_t token) {
     // We should already be spawned within a coroutine.
     pipeliner_acq_t pipeliner_acq(pipeliner);
@@ -337,7 +128,11 @@ void do_get(txt_memcached_handler_t *rh, pipeliner_t *pipeliner, bool with_cas,
     block_pm_duration get_timer(&rh->stats->pm_cmd_get);
 
     /* Now that we're sure they're all valid, send off the requests */
-    pmap(gets.size(), boost::bind(&do_one_get, rh, with_cas, gets.data(), _1, token));
+    if (with_cas) {
+        pmap(gets.size(), boost::bind(&do_one_get_cas, rh, gets.data(), _1, token));
+    } else {
+        do_multi_get(rh, &gets, token);
+    }
 
     if (rh->interruptor->is_pulsed()) {
         pipeliner_acq.begin_write();
@@ -372,7 +167,6 @@ void do_get(txt_memcached_handler_t *rh, pipeliner_t *pipeliner, bool with_cas,
                 if (with_cas) {
                     rh->write_value_header(reinterpret_cast<const char *>(key.contents()), key.size(), res.flags, res.value->size(), res.cas);
                 } else {
-                    guarantee(res.cas == 0);
                     rh->write_value_header(reinterpret_cast<const char *>(key.contents()), key.size(), res.flags, res.value->size());
                 }
 
@@ -771,23 +565,7 @@ void do_storage(txt_memcached_handler_t *rh, pipeliner_t *pipeliner, storage_com
         return;
     }
 
-    // This is protocol.txt, verbatim:
-    // Some commands involve a client sending some kind of expiration time
-    // (relative to an item or to an operation requested by the client) to
-    // the server. In all such cases, the actual value sent may either be
-    // Unix time (number of seconds since January 1, 1970, as a 32-bit
-    // value), or a number of seconds starting from current time. In the
-    // latter case, this number of seconds may not exceed 60*60*24*30 (number
-    // of seconds in 30 days); if the number sent by a client is larger than
-    // that, the server will consider it to be real Unix time value rather
-    // than an offset from current time.
-    if (exptime <= 60*60*24*30 && exptime > 0) {
-        // If 60*60*24*30 < exptime <= time(NULL), that's fine, the
-        // btree code needs to handle that case gracefully anyway
-        // (since the clock can tick in the middle of an insert
-        // anyway...).  We have tests in expiration.py.
-        exptime += time(NULL);
-    }
+    exptime = absolute_exptime(exptime);
 
     /* Now parse the value length */
     size_t value_size = strtou64_strict(argv[4], &invalid_char, 10);
@@ -1123,108 +901,120 @@ void handle_memcache(memcached_interface_t *interface,
 
     pipeliner_t pipeliner(&rh);
 
-    while (pipeliner.lock_argparsing(), !interruptor->is_pulsed()) {
-        /* Read a line off the socket */
-        block_pm_duration read_timer(&rh.stats->pm_conns_reading);
-        try {
-            rh.read_line(&line);
-        } catch (const memcached_interface_t::no_more_data_exc_t &) {
-            break;
-        }
-        read_timer.end();
+    /* Binary protocol clients are told apart by their first byte */
+    bool is_binary;
+    try {
+        is_binary = static_cast<uint8_t>(rh.peek(1)[0]) == memcached_binary_request_magic;
+    } catch (const memcached_interface_t::no_more_data_exc_t &) {
+        is_binary = false;
+    }
 
-        block_pm_duration action_timer(&rh.stats->pm_conns_acting);
+    if (is_binary) {
+        handle_binary_memcache(&rh, &pipeliner, &order_source);
+    } else {
+        while (pipeliner.lock_argparsing(), !interruptor->is_pulsed()) {
+            /* Read a line off the socket */
+            block_pm_duration read_timer(&rh.stats->pm_conns_reading);
+            try {
+                rh.read_line(&line);
+            } catch (const memcached_interface_t::no_more_data_exc_t &) {
+                break;
+            }
+            read_timer.end();
 
-        /* Tokenize the line */
-        line.push_back('\0');   // Null terminator
-        args.clear();
-        char *l = line.data(), *state = NULL;
-        while (char *cmd_str = strtok_r(l, " \r\n\t", &state)) {
-            args.push_back(cmd_str);
-            l = NULL;
-        }
+            block_pm_duration action_timer(&rh.stats->pm_conns_acting);
 
-        if (args.empty()) {
-            pipeliner_acq_t pipeliner_acq(&pipeliner);
-            pipeliner_acq.done_argparsing();
-            pipeliner_acq.begin_write();
-            rh.error();
-            pipeliner_acq.end_write();
-            continue;
-        }
+            /* Tokenize the line */
+            line.push_back('\0');   // Null terminator
+            args.clear();
+            char *l = line.data(), *state = NULL;
+            while (char *cmd_str = strtok_r(l, " \r\n\t", &state)) {
+                args.push_back(cmd_str);
+                l = NULL;
+            }
 
-        /* Dispatch to the appropriate subclass */
-        order_token_t token = order_source.check_in(std::string("handle_memcache+") + args[0]);
-        if (!strcmp(args[0], "get")) {    // check for retrieval commands
-            coro_t::spawn_now_dangerously(boost::bind(do_get, &rh, &pipeliner, false, args.size(), args.data(), token.with_read_mode()));
-        } else if (!strcmp(args[0], "gets")) {
-            coro_t::spawn_now_dangerously(boost::bind(do_get, &rh, &pipeliner, true, args.size(), args.data(), token));
-        } else if (!strcmp(args[0], "rget")) {
-            coro_t::spawn_now_dangerously(boost::bind(do_rget, &rh, &pipeliner, &order_source, args.size(), args.data()));
-        } else if (!strcmp(args[0], "set")) {     // check for storage commands
-            do_storage(&rh, &pipeliner, set_command, args.size(), args.data(), token);
-        } else if (!strcmp(args[0], "add")) {
-            do_storage(&rh, &pipeliner, add_command, args.size(), args.data(), token);
-        } else if (!strcmp(args[0], "replace")) {
-            do_storage(&rh, &pipeliner, replace_command, args.size(), args.data(), token);
-        } else if (!strcmp(args[0], "append")) {
-            do_storage(&rh, &pipeliner, append_command, args.size(), args.data(), token);
-        } else if (!strcmp(args[0], "prepend")) {
-            do_storage(&rh, &pipeliner, prepend_command, args.size(), args.data(), token);
-        } else if (!strcmp(args[0], "cas")) {
-            do_storage(&rh, &pipeliner, cas_command, args.size(), args.data(), token);
-        } else if (!strcmp(args[0], "delete")) {
-            coro_t::spawn_now_dangerously(boost::bind(do_delete, &rh, &pipeliner, args.size(), args.data(), token));
-        } else if (!strcmp(args[0], "incr")) {
-            coro_t::spawn_now_dangerously(boost::bind(do_incr_decr, &rh, &pipeliner, true, args.size(), args.data(), token));
-        } else if (!strcmp(args[0], "decr")) {
-            coro_t::spawn_now_dangerously(boost::bind(do_incr_decr, &rh, &pipeliner, false, args.size(), args.data(), token));
-        } else if (!strcmp(args[0], "quit")) {
-            // Make sure there's no more tokens (the kind in args, not
-            // order tokens)
-            if (args.size() > 1) {
+            if (args.empty()) {
                 pipeliner_acq_t pipeliner_acq(&pipeliner);
-                // We block everybody, but who cares?
                 pipeliner_acq.done_argparsing();
                 pipeliner_acq.begin_write();
                 rh.error();
                 pipeliner_acq.end_write();
-            } else {
-                break;
+                continue;
             }
-        } else if (!strcmp(args[0], "stats") || !strcmp(args[0], "stat")) {
-            pipeliner_acq_t pipeliner_acq(&pipeliner);
 
-            std::vector<std::string> stat_response_lines;
-            memcached_stats(args.size(), args.data(), &stat_response_lines);
+            /* Dispatch to the appropriate subclass */
+            order_token_t token = order_source.check_in(std::string("handle_memcache+") + args[0]);
+            if (!strcmp(args[0], "get")) {    // check for retrieval commands
+                coro_t::spawn_now_dangerously(boost::bind(do_get, &rh, &pipeliner, false, args.size(), args.data(), token.with_read_mode()));
+            } else if (!strcmp(args[0], "gets")) {
+                coro_t::spawn_now_dangerously(boost::bind(do_get, &rh, &pipeliner, true, args.size(), args.data(), token));
+            } else if (!strcmp(args[0], "rget")) {
+                coro_t::spawn_now_dangerously(boost::bind(do_rget, &rh, &pipeliner, &order_source, args.size(), args.data()));
+            } else if (!strcmp(args[0], "set")) {     // check for storage commands
+                do_storage(&rh, &pipeliner, set_command, args.size(), args.data(), token);
+            } else if (!strcmp(args[0], "add")) {
+                do_storage(&rh, &pipeliner, add_command, args.size(), args.data(), token);
+            } else if (!strcmp(args[0], "replace")) {
+                do_storage(&rh, &pipeliner, replace_command, args.size(), args.data(), token);
+            } else if (!strcmp(args[0], "append")) {
+                do_storage(&rh, &pipeliner, append_command, args.size(), args.data(), token);
+            } else if (!strcmp(args[0], "prepend")) {
+                do_storage(&rh, &pipeliner, prepend_command, args.size(), args.data(), token);
+            } else if (!strcmp(args[0], "cas")) {
+                do_storage(&rh, &pipeliner, cas_command, args.size(), args.data(), token);
+            } else if (!strcmp(args[0], "delete")) {
+                coro_t::spawn_now_dangerously(boost::bind(do_delete, &rh, &pipeliner, args.size(), args.data(), token));
+            } else if (!strcmp(args[0], "incr")) {
+                coro_t::spawn_now_dangerously(boost::bind(do_incr_decr, &rh, &pipeliner, true, args.size(), args.data(), token));
+            } else if (!strcmp(args[0], "decr")) {
+                coro_t::spawn_now_dangerously(boost::bind(do_incr_decr, &rh, &pipeliner, false, args.size(), args.data(), token));
+            } else if (!strcmp(args[0], "quit")) {
+                // Make sure there's no more tokens (the kind in args, not
+                // order tokens)
+                if (args.size() > 1) {
+                    pipeliner_acq_t pipeliner_acq(&pipeliner);
+                    // We block everybody, but who cares?
+                    pipeliner_acq.done_argparsing();
+                    pipeliner_acq.begin_write();
+                    rh.error();
+                    pipeliner_acq.end_write();
+                } else {
+                    break;
+                }
+            } else if (!strcmp(args[0], "stats") || !strcmp(args[0], "stat")) {
+                pipeliner_acq_t pipeliner_acq(&pipeliner);
 
-            // We block everybody before writing.  I don't think we care.
-            pipeliner_acq.done_argparsing();
-            pipeliner_acq.begin_write();
-            for (std::vector<std::string>::const_iterator i = stat_response_lines.begin(); i != stat_response_lines.end(); ++i) {
-                rh.write(*i);
-            }
-            pipeliner_acq.end_write();
-        } else if (!strcmp(args[0], "version")) {
-            pipeliner_acq_t pipeliner_acq(&pipeliner);
+                std::vector<std::string> stat_response_lines;
+                memcached_stats(args.size(), args.data(), &stat_response_lines);
 
-            pipeliner_acq.done_argparsing();
-            pipeliner_acq.begin_write();
-            if (args.size() == 1) {
-                rh.writef("VERSION rethinkdb-%s\r\n", RETHINKDB_VERSION);
+                // We block everybody before writing.  I don't think we care.
+                pipeliner_acq.done_argparsing();
+                pipeliner_acq.begin_write();
+                for (std::vector<std::string>::const_iterator i = stat_response_lines.begin(); i != stat_response_lines.end(); ++i) {
+                    rh.write(*i);
+                }
+                pipeliner_acq.end_write();
+            } else if (!strcmp(args[0], "version")) {
+                pipeliner_acq_t pipeliner_acq(&pipeliner);
+
+                pipeliner_acq.done_argparsing();
+                pipeliner_acq.begin_write();
+                if (args.size() == 1) {
+                    rh.writef("VERSION rethinkdb-%s\r\n", RETHINKDB_VERSION);
+                } else {
+                    rh.error();
+                }
+                pipeliner_acq.end_write();
             } else {
+                pipeliner_acq_t pipeliner_acq(&pipeliner);
+                pipeliner_acq.done_argparsing();
+                pipeliner_acq.begin_write();
                 rh.error();
+                pipeliner_acq.end_write();
             }
-            pipeliner_acq.end_write();
-        } else {
-            pipeliner_acq_t pipeliner_acq(&pipeliner);
-            pipeliner_acq.done_argparsing();
-            pipeliner_acq.begin_write();
-            rh.error();
-            pipeliner_acq.end_write();
-        }
 
-        action_timer.end();
+            action_timer.end();
+        }
     }
 
     // Make sure anything that would be running has finished.
@@ -1,6 +1,9 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "memcached/protocol.hpp"
 
+#include <algorithm>
+#include <map>
+
 #include "errors.hpp"
 #include <boost/variant.hpp>
 #include <boost/bind.hpp>
@@ -49,7 +52,7 @@ write_message_t &operator<<(write_message_t &msg, const counted_t<data_buffer_t>
         msg << exists;
         int64_t size = buf->size();
         msg << size;
-        msg.append(buf->buf(), buf->size());
+        msg.append_buffer(buf);
     } else {
         bool exists = false;
         msg << exists;
@@ -77,9 +80,11 @@ archive_result_t deserialize(read_stream_t *s, counted_t<data_buffer_t> *buf) {
 }
 
 RDB_IMPL_SERIALIZABLE_1(get_query_t, key);
+RDB_IMPL_SERIALIZABLE_1(get_multi_query_t, keys);
 RDB_IMPL_SERIALIZABLE_2(rget_query_t, region, maximum);
 RDB_IMPL_SERIALIZABLE_3(distribution_get_query_t, max_depth, result_limit, region);
 RDB_IMPL_SERIALIZABLE_3(get_result_t, value, flags, cas);
+RDB_IMPL_SERIALIZABLE_2(get_multi_result_t, keys, results);
 RDB_IMPL_SERIALIZABLE_3(key_with_data_buffer_t, key, mcflags, value_provider);
 RDB_IMPL_SERIALIZABLE_2(rget_result_t, pairs, truncated);
 RDB_IMPL_SERIALIZABLE_2(distribution_result_t, region, key_counts);
@@ -117,6 +122,27 @@ struct read_get_region_visitor_t : public boost::static_visitor<region_t> {
     region_t operator()(get_query_t get) {
         return monokey_region(get.key);
     }
+    region_t operator()(const get_multi_query_t &get_multi) {
+        // The smallest region with all the keys in it. It's usually much more
+        // than just the keys, but `shard()` only sends a shard the keys that
+        // are actually in it.
+        if (get_multi.keys.empty()) {
+            return region_t::empty();
+        }
+        region_t region = monokey_region(get_multi.keys[0]);
+        for (size_t i = 1; i < get_multi.keys.size(); ++i) {
+            const region_t key_region = monokey_region(get_multi.keys[i]);
+            region.beg = std::min(region.beg, key_region.beg);
+            region.end = std::max(region.end, key_region.end);
+            if (key_region.inner.left < region.inner.left) {
+                region.inner.left = key_region.inner.left;
+            }
+            if (region.inner.right < key_region.inner.right) {
+                region.inner.right = key_region.inner.right;
+            }
+        }
+        return region;
+    }
     region_t operator()(rget_query_t rget) {
         return rget.region;
     }
@@ -149,6 +175,21 @@ struct read_shard_visitor_t : public boost::static_visitor<bool> {
         return ret;
     }
 
+    bool operator()(const get_multi_query_t &get_multi) const {
+        get_multi_query_t tmp;
+        for (size_t i = 0; i < get_multi.keys.size(); ++i) {
+            if (region_contains_key(*region, get_multi.keys[i])) {
+                tmp.keys.push_back(get_multi.keys[i]);
+            }
+        }
+        if (!tmp.keys.empty()) {
+            *read_out = read_t(tmp, effective_time);
+            return true;
+        } else {
+            return false;
+        }
+    }
+
     template <class T>
     bool rangey_query(const T &arg) const {
         const hash_region_t<key_range_t> intersection
@@ -237,6 +278,28 @@ struct read_unshard_visitor_t : public boost::static_visitor<read_response_t> {
         guarantee(count == 1);
         return read_response_t(boost::get<get_result_t>(bits[0].result));
     }
+    read_response_t operator()(const get_multi_query_t &get_multi) {
+        std::map<store_key_t, const get_result_t *> found;
+        for (size_t i = 0; i < count; ++i) {
+            const get_multi_result_t *bit = boost::get<get_multi_result_t>(&bits[i].result);
+            guarantee(bit != NULL, "Bad boost::get\n");
+            guarantee(bit->keys.size() == bit->results.size());
+            for (size_t j = 0; j < bit->keys.size(); ++j) {
+                found[bit->keys[j]] = &bit->results[j];
+            }
+        }
+
+        get_multi_result_t result;
+        result.keys = get_multi.keys;
+        result.results.reserve(get_multi.keys.size());
+        for (size_t i = 0; i < get_multi.keys.size(); ++i) {
+            std::map<store_key_t, const get_result_t *>::const_iterator it = found.find(get_multi.keys[i]);
+            guarantee(it != found.end(), "No shard answered for one of the keys");
+            result.results.push_back(*it->second);
+        }
+        return read_response_t(result);
+    }
+
     read_response_t operator()(rget_query_t rget) {
         // TODO: do this without dynamic memory?
         std::vector<key_with_data_buffer_t> pairs;
@@ -431,6 +494,24 @@ struct read_visitor_t : public boost::static_visitor<read_response_t> {
             memcached_get(get.key, btree, effective_time, txn, superblock));
     }
 
+    read_response_t operator()(const get_multi_query_t& get_multi) {
+        // Looking the keys up in order makes consecutive lookups go through
+        // the same internal nodes, which are then already in the cache.
+        get_multi_result_t result;
+        result.keys = get_multi.keys;
+        std::sort(result.keys.begin(), result.keys.end());
+        result.keys.erase(std::unique(result.keys.begin(), result.keys.end()), result.keys.end());
+        result.results.reserve(result.keys.size());
+        // Each lookup releases the superblock once it has the root, so the
+        // real superblock may only be released after the last one.
+        refcount_superblock_t refcount_wrapper(superblock, result.keys.size());
+        for (size_t i = 0; i < result.keys.size(); ++i) {
+            result.results.push_back(
+                memcached_get(result.keys[i], btree, effective_time, txn, &refcount_wrapper));
+        }
+        return read_response_t(result);
+    }
+
     read_response_t operator()(const rget_query_t& rget) {
         return read_response_t(
             memcached_rget_slice(btree, rget.region.inner, rget.maximum, effective_time, txn, superblock));
@@ -572,6 +653,10 @@ public:
     void on_keyvalue(const backfill_atom_t& atom, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
         chunk_fun_cb_->send_chunk(chunk_t::set_key(atom), interruptor);
     }
+
+    void finish_region(const region_t &region, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        chunk_fun_cb_->finish_region(region, interruptor);
+    }
     ~memcached_backfill_callback_t() { }
 
 protected:
@@ -594,6 +679,7 @@ static void call_memcached_backfill(int i, btree_slice_t *btree, const std::vect
     repli_timestamp_t timestamp = regions[i].second.to_repli_timestamp();
     try {
         memcached_backfill(btree, regions[i].first.inner, timestamp, callback, txn, superblock, sindex_block, p, interruptor);
+        callback->finish_region(regions[i].first, interruptor);
     } catch (const interrupted_exc_t &) {
         /* do nothing; `protocol_send_backfill()` will notice and deal with it.
         */
@@ -52,6 +52,23 @@ struct get_result_t {
     cas_t cas;
 };
 
+/* `get` with more than one key. The query is sharded like any other read, so
+each shard gets only its own keys; it looks them up in key order and sends
+them back with their results. Unsharding puts the results back in the order
+of `keys`. */
+
+struct get_multi_query_t {
+    std::vector<store_key_t> keys;
+    get_multi_query_t() { }
+    explicit get_multi_query_t(const std::vector<store_key_t> &_keys) : keys(_keys) { }
+};
+
+struct get_multi_result_t {
+    // `results[i]` is the result for `keys[i]`.
+    std::vector<store_key_t> keys;
+    std::vector<get_result_t> results;
+};
+
 /* `rget` */
 
 struct rget_query_t {
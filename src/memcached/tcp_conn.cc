@@ -88,6 +88,22 @@ struct tcp_conn_memcached_interface_t : public memcached_interface_t, public hom
             throw no_more_data_exc_t();
         }
     }
+
+    const char *peek(size_t nbytes, signal_t *interruptor) {
+        try {
+            return conn->peek(nbytes, interruptor).beg;
+        } catch (const tcp_conn_read_closed_exc_t &) {
+            throw no_more_data_exc_t();
+        }
+    }
+
+    void pop(size_t nbytes, signal_t *interruptor) {
+        try {
+            conn->pop(nbytes, interruptor);
+        } catch (const tcp_conn_read_closed_exc_t &) {
+            throw no_more_data_exc_t();
+        }
+    }
 };
 
 void serve_memcache(tcp_conn_t *conn, namespace_interface_t<memcached_protocol_t> *nsi, memcached_stats_t *stats, signal_t *interruptor) {
@@ -100,16 +116,23 @@ memcache_listener_t::memcache_listener_t(const std::set<ip_address_t> &local_add
                                          int _port,
                                          namespace_repo_t<memcached_protocol_t> *_ns_repo,
                                          uuid_u _namespace_id,
-                                         perfmon_collection_t *_parent)
+                                         perfmon_collection_t *_parent,
+                                         tcp_accept_mode_t accept_mode)
     : port(_port),
       namespace_id(_namespace_id),
       ns_repo(_ns_repo),
       next_thread(0),
       parent(_parent),
-      stats(parent),
-      tcp_listener(new repeated_nonthrowing_tcp_listener_t(local_addresses, port,
-          boost::bind(&memcache_listener_t::handle, this, auto_drainer_t::lock_t(&drainer), _1)))
+      stats(parent)
 {
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        per_thread_drainers.init(new one_per_thread_t<auto_drainer_t>);
+        tcp_listener.init(new repeated_nonthrowing_tcp_listener_t(local_addresses, port,
+            boost::bind(&memcache_listener_t::handle_local, this, _1), accept_mode));
+    } else {
+        tcp_listener.init(new repeated_nonthrowing_tcp_listener_t(local_addresses, port,
+            boost::bind(&memcache_listener_t::handle, this, auto_drainer_t::lock_t(&drainer), _1)));
+    }
     tcp_listener->begin_repeated_listening_attempts();
 }
 
@@ -133,14 +156,26 @@ void memcache_listener_t::handle(auto_drainer_t::lock_t keepalive, const scoped_
     cross_thread_signal_t signal_transfer(keepalive.get_drain_signal(), chosen_thread);
 
     on_thread_t thread_switcher(chosen_thread);
+    serve(nconn, &signal_transfer);
+}
+
+void memcache_listener_t::handle_local(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+    /* The connection was accepted on the thread that will serve it, so there is
+    no need to switch threads. */
+    auto_drainer_t::lock_t keepalive(per_thread_drainers->get());
+    block_pm_duration conn_timer(&stats.pm_conns);
+    serve(nconn, keepalive.get_drain_signal());
+}
+
+void memcache_listener_t::serve(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, signal_t *interruptor) {
     scoped_ptr_t<tcp_conn_t> conn;
     nconn->make_overcomplicated(&conn);
 
     /* `serve_memcache()` will continuously serve memcache queries on the given conn
     until the connection is closed. */
     try {
-        namespace_repo_t<memcached_protocol_t>::access_t ns_access(ns_repo, namespace_id, &signal_transfer);
-        serve_memcache(conn.get(), ns_access.get_namespace_if(), &stats, &signal_transfer);
+        namespace_repo_t<memcached_protocol_t>::access_t ns_access(ns_repo, namespace_id, interruptor);
+        serve_memcache(conn.get(), ns_access.get_namespace_if(), &stats, interruptor);
     } catch (const interrupted_exc_t &ex) {
         // Interrupted, nothing to do but return
     }
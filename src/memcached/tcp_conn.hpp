@@ -6,6 +6,7 @@
 
 #include "arch/types.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/one_per_thread.hpp"
 #include "containers/scoped.hpp"
 #include "memcached/protocol.hpp"
 #include "memcached/stats.hpp"
@@ -24,7 +25,8 @@ struct memcache_listener_t : public home_thread_mixin_debug_only_t {
                         int _port,
                         namespace_repo_t<memcached_protocol_t> *_ns_repo,
                         uuid_u _namespace_id,
-                        perfmon_collection_t *_parent);
+                        perfmon_collection_t *_parent,
+                        tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD);
     ~memcache_listener_t();
 
     signal_t *get_bound_signal();
@@ -45,9 +47,15 @@ private:
     `memcached_listener_t` is destroyed. */
     auto_drainer_t drainer;
 
+    /* With `ACCEPT_ON_EVERY_THREAD`, connections are accepted and served on
+    every thread, and each thread has its own drainer. */
+    scoped_ptr_t<one_per_thread_t<auto_drainer_t> > per_thread_drainers;
+
     scoped_ptr_t<repeated_nonthrowing_tcp_listener_t> tcp_listener;
 
     void handle(auto_drainer_t::lock_t keepalive, const scoped_ptr_t<tcp_conn_descriptor_t>& conn);
+    void handle_local(const scoped_ptr_t<tcp_conn_descriptor_t>& conn);
+    void serve(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, signal_t *interruptor);
 };
 
 #endif /* MEMCACHED_TCP_CONN_HPP_ */
@@ -454,6 +454,7 @@ bool dummy_protocol_t::store_t::send_backfill(const region_map_t<dummy_protocol_
                 }
                 if (rng.randint(2) == 0) nap(rng.randint(10), interruptor);
             }
+            send_backfill_cb->finish_region(r_it->first, interruptor);
         }
         return true;
     } else {
@@ -29,10 +29,11 @@ public:
                             int port,
                             namespace_repo_t<dummy_protocol_t> *ns_repo,
                             const namespace_id_t &ns_id,
-                            perfmon_collection_t *) :
+                            perfmon_collection_t *,
+                            tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD) :
         ns_access(ns_repo, ns_id, &interruptor),
         query_app(ns_access.get_namespace_if()),
-        server(local_addresses, port, &query_app)
+        server(local_addresses, port, &query_app, accept_mode)
     {
         always_bound.pulse();
     }
@@ -18,6 +18,10 @@ static const char * stat_per_sec = "per_sec";
 static const char * stat_count = "count";
 static const char * stat_mean = "mean";
 static const char * stat_std_dev = "std_dev";
+static const char * stat_p50 = "p50";
+static const char * stat_p90 = "p90";
+static const char * stat_p99 = "p99";
+static const char * stat_p999 = "p999";
 static const char * no_value = "-";
 
 
@@ -134,6 +138,184 @@ scoped_ptr_t<perfmon_result_t> perfmon_sampler_t::output_stat(const stats_t &agg
     return stat;
 }
 
+/* perfmon_histogram_t */
+
+namespace perfmon_histogram {
+
+const uint64_t SUB_BUCKETS = 1 << SUB_BUCKET_BITS;
+const uint64_t MAX_VALUE = (static_cast<uint64_t>(1) << MAX_VALUE_BITS) - 1;
+
+int bucket_for(uint64_t value) {
+    value = std::min(value, MAX_VALUE);
+    if (value < SUB_BUCKETS) {
+        return value;
+    }
+    /* The position of the highest set bit picks the power of two, and the
+    next `SUB_BUCKET_BITS` bits pick the bucket within it. */
+    int top_bit = 63 - __builtin_clzll(value);
+    int shift = top_bit - SUB_BUCKET_BITS;
+    return ((shift + 1) << SUB_BUCKET_BITS) + ((value >> shift) - SUB_BUCKETS);
+}
+
+uint64_t bucket_low(int bucket) {
+    rassert(bucket >= 0 && bucket < NUM_BUCKETS);
+    if (bucket < static_cast<int>(SUB_BUCKETS)) {
+        return bucket;
+    }
+    int shift = (bucket >> SUB_BUCKET_BITS) - 1;
+    return (SUB_BUCKETS + (bucket & (SUB_BUCKETS - 1))) << shift;
+}
+
+uint64_t bucket_width(int bucket) {
+    rassert(bucket >= 0 && bucket < NUM_BUCKETS);
+    if (bucket < static_cast<int>(SUB_BUCKETS)) {
+        return 1;
+    }
+    return static_cast<uint64_t>(1) << ((bucket >> SUB_BUCKET_BITS) - 1);
+}
+
+void stats_t::record(uint64_t v) {
+    if (buckets.empty()) {
+        buckets.resize(NUM_BUCKETS, 0);
+    }
+    ++buckets[bucket_for(v)];
+    ++count;
+    sum += v;
+    min = std::min(min, v);
+    max = std::max(max, v);
+}
+
+void stats_t::aggregate(const stats_t &s) {
+    if (s.count == 0) {
+        return;
+    }
+    if (buckets.empty()) {
+        buckets.resize(NUM_BUCKETS, 0);
+    }
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        buckets[i] += s.buckets[i];
+    }
+    count += s.count;
+    sum += s.sum;
+    min = std::min(min, s.min);
+    max = std::max(max, s.max);
+}
+
+void stats_t::clear() {
+    /* Keep the buckets' memory, since the thread that owns them is likely to
+    record more soon. */
+    std::fill(buckets.begin(), buckets.end(), 0);
+    count = 0;
+    sum = 0;
+    min = std::numeric_limits<uint64_t>::max();
+    max = 0;
+}
+
+uint64_t stats_t::percentile(double p) const {
+    rassert(count > 0);
+    int64_t rank = std::max<int64_t>(1, static_cast<int64_t>(ceil(p * count)));
+    int64_t seen = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        seen += buckets[i];
+        if (seen >= rank) {
+            /* Report the middle of the bucket, but never more than the
+            largest value or less than the smallest. */
+            uint64_t value = bucket_low(i) + bucket_width(i) / 2;
+            return std::max(min, std::min(max, value));
+        }
+    }
+    return max;
+}
+
+}   /* namespace perfmon_histogram */
+
+perfmon_histogram_t::perfmon_histogram_t(ticks_t _length, bool _include_rate, double _resolution)
+    : perfmon_perthread_t<stats_t>(), thread_data(new thread_info_t[MAX_THREADS]),
+      length(_length), include_rate(_include_rate), resolution(_resolution)
+{
+    rassert(resolution > 0);
+    for (int i = 0; i < MAX_THREADS; i++) {
+        thread_data[i].current_interval = get_ticks() / length;
+    }
+}
+
+perfmon_histogram_t::~perfmon_histogram_t() {
+    delete[] thread_data;
+}
+
+void perfmon_histogram_t::update(ticks_t now) {
+    int interval = now / length;
+    rassert(get_thread_id() >= 0);
+    thread_info_t *thread = &thread_data[get_thread_id()];
+
+    if (thread->current_interval == interval) {
+        /* We're up to date; nothing to do */
+    } else if (thread->current_interval + 1 == interval) {
+        /* We're one step behind. Swapping rather than copying reuses the
+        old interval's buckets for the new one. */
+        std::swap(thread->last_stats, thread->current_stats);
+        thread->current_stats.clear();
+        thread->current_interval++;
+    } else {
+        /* We're more than one step behind */
+        thread->last_stats.clear();
+        thread->current_stats.clear();
+        thread->current_interval = interval;
+    }
+}
+
+void perfmon_histogram_t::record(double v) {
+    ticks_t now = get_ticks();
+    update(now);
+    rassert(get_thread_id() >= 0);
+    thread_info_t *thread = &thread_data[get_thread_id()];
+    thread->current_stats.record(v > 0 ? static_cast<uint64_t>(v / resolution + 0.5) : 0);
+}
+
+void perfmon_histogram_t::get_thread_stat(stats_t *stat) {
+    update(get_ticks());
+    /* As with `perfmon_sampler_t`, report the last complete interval. */
+    rassert(get_thread_id() >= 0);
+    *stat = thread_data[get_thread_id()].last_stats;
+}
+
+perfmon_histogram_t::stats_t perfmon_histogram_t::combine_stats(const stats_t *stats) {
+    stats_t aggregated;
+    for (int i = 0; i < get_num_threads(); i++) {
+        aggregated.aggregate(stats[i]);
+    }
+    return aggregated;
+}
+
+scoped_ptr_t<perfmon_result_t> perfmon_histogram_t::output_stat(const stats_t &aggregated) {
+    scoped_ptr_t<perfmon_result_t> stat = perfmon_result_t::alloc_map_result();
+
+    const char *percentile_names[] = { stat_p50, stat_p90, stat_p99, stat_p999 };
+    const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+
+    if (aggregated.count > 0) {
+        stat->insert(stat_avg, new perfmon_result_t(strprintf("%.8f", aggregated.sum * resolution / aggregated.count)));
+        stat->insert(stat_min, new perfmon_result_t(strprintf("%.8f", aggregated.min * resolution)));
+        stat->insert(stat_max, new perfmon_result_t(strprintf("%.8f", aggregated.max * resolution)));
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+            stat->insert(percentile_names[i], new perfmon_result_t(
+                strprintf("%.8f", aggregated.percentile(percentiles[i]) * resolution)));
+        }
+    } else {
+        stat->insert(stat_avg, new perfmon_result_t(no_value));
+        stat->insert(stat_min, new perfmon_result_t(no_value));
+        stat->insert(stat_max, new perfmon_result_t(no_value));
+        for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+            stat->insert(percentile_names[i], new perfmon_result_t(no_value));
+        }
+    }
+    if (include_rate) {
+        stat->insert(stat_per_sec, new perfmon_result_t(strprintf("%.8f", aggregated.count / ticks_to_secs(length))));
+    }
+
+    return stat;
+}
+
 /* perfmon_stddev_t */
 
 stddev_t::stddev_t()
@@ -286,7 +468,7 @@ scoped_ptr_t<perfmon_result_t> perfmon_rate_monitor_t::output_stat(const double
 }
 
 perfmon_duration_sampler_t::perfmon_duration_sampler_t(ticks_t length, bool _ignore_global_full_perfmon)
-    : stat(), active(), total(), recent(length, true),
+    : stat(), active(), total(), recent(length, true, ticks_to_secs(1)),
       active_membership(&stat, &active, "active_count"),
       total_membership(&stat, &total, "total"),
       recent_membership(&stat, &recent, "recent_duration"),
@@ -13,6 +13,7 @@
 #include <string>
 #include <map>
 #include <memory>
+#include <vector>
 
 #include "perfmon/types.hpp"
 #include "perfmon/core.hpp"
@@ -139,6 +140,75 @@ public:
     void record(double value);
 };
 
+/* perfmon_histogram_t is like perfmon_sampler_t, but it also keeps a histogram
+ * of the records, so that it can report percentiles (p50, p90, p99 and p999)
+ * as well as the average, min and max. The buckets are log-linear, the way
+ * HdrHistogram's are: each power of two is split into
+ * `2^perfmon_histogram::SUB_BUCKET_BITS` equal buckets, so the reported
+ * percentiles are within a few percent of the real ones however large the
+ * values get. Values are rounded to multiples of `resolution` first.
+ *
+ * Each thread records into its own buckets, which are allocated the first time
+ * the thread records something, and the buckets are merged only when the stats
+ * are read; so recording never takes a lock.
+ */
+
+namespace perfmon_histogram {
+
+/* Each power of two is split into this many bits' worth of buckets */
+const int SUB_BUCKET_BITS = 4;
+
+/* Values of `2^MAX_VALUE_BITS` units or more all go in the last bucket */
+const int MAX_VALUE_BITS = 40;
+
+const int NUM_BUCKETS = (MAX_VALUE_BITS - SUB_BUCKET_BITS + 1) << SUB_BUCKET_BITS;
+
+/* Which bucket `value` goes in, and the range of values in a bucket */
+int bucket_for(uint64_t value);
+uint64_t bucket_low(int bucket);
+uint64_t bucket_width(int bucket);
+
+struct stats_t {
+    int64_t count;
+    uint64_t sum, min, max;
+    /* Empty until something has been recorded */
+    std::vector<uint32_t> buckets;
+
+    stats_t() : count(0), sum(0), min(std::numeric_limits<uint64_t>::max()), max(0) { }
+    void record(uint64_t v);
+    void aggregate(const stats_t &s);
+    void clear();
+
+    /* The value that a fraction `p` of the records are at or below */
+    uint64_t percentile(double p) const;
+};
+
+}   /* namespace perfmon_histogram */
+
+class perfmon_histogram_t : public perfmon_perthread_t<perfmon_histogram::stats_t> {
+    typedef perfmon_histogram::stats_t stats_t;
+    struct thread_info_t {
+        stats_t current_stats, last_stats;
+        int current_interval;
+    };
+
+    thread_info_t *thread_data;
+
+    void get_thread_stat(stats_t *);
+    stats_t combine_stats(const stats_t *);
+    scoped_ptr_t<perfmon_result_t> output_stat(const stats_t&);
+
+    void update(ticks_t now);
+
+    ticks_t length;
+    bool include_rate;
+    double resolution;
+public:
+    perfmon_histogram_t(ticks_t _length, bool _include_rate, double _resolution);
+    virtual ~perfmon_histogram_t();
+    void record(double value);
+};
+
 // One-pass variance calculation algorithm/datastructure taken from
 // http://www.cs.berkeley.edu/~mhoemmen/cs194/Tutorials/variance.pdf
 struct stddev_t {
@@ -209,9 +279,9 @@ public:
 /* perfmon_duration_sampler_t is a perfmon_t that monitors events that have a
  * starting and ending time. When something starts, call begin(); when
  * something ends, call end() with the same value as begin. It will produce
- * stats for the number of active events, the average length of an event, and
- * so on. If `global_full_perfmon` is false, it won't report any timing-related
- * stats because `get_ticks()` is rather slow.
+ * stats for the number of active events, the average length of an event, the
+ * percentiles of the lengths, and so on. If `global_full_perfmon` is false, it
+ * won't report any timing-related stats because `get_ticks()` is rather slow.
  *
  * Frequently we're in the case where we'd like to have a single slow perfmon
  * up, but don't want the other ones, perfmon_duration_sampler_t has an
@@ -224,7 +294,7 @@ private:
     perfmon_collection_t stat;
     perfmon_counter_t active;
     perfmon_counter_t total;
-    perfmon_sampler_t recent;
+    perfmon_histogram_t recent;
     perfmon_membership_t active_membership;
     perfmon_membership_t total_membership;
     perfmon_membership_t recent_membership;
@@ -0,0 +1,107 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "perfmon/text.hpp"
+
+#include <math.h>
+#include <stdlib.h>
+
+#include <map>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "containers/uuid.hpp"
+
+typedef std::vector<std::pair<std::string, std::string> > metric_labels_t;
+
+std::string metric_name_component(const std::string &name) {
+    std::string ret(name);
+    for (size_t i = 0; i < ret.size(); ++i) {
+        const char c = ret[i];
+        if (!(('a' <= c && c <= 'z') || ('A' <= c && c <= 'Z')
+              || ('0' <= c && c <= '9') || c == '_')) {
+            ret[i] = '_';
+        }
+    }
+    return ret;
+}
+
+bool is_uuid_component(const std::string &name) {
+    uuid_u id;
+    return str_to_uuid(name, &id);
+}
+
+bool has_label(const metric_labels_t &labels, const std::string &label) {
+    for (auto it = labels.begin(); it != labels.end(); ++it) {
+        if (it->first == label) {
+            return true;
+        }
+    }
+    return false;
+}
+
+std::string metric_series(const std::string &name, const metric_labels_t &labels) {
+    if (labels.empty()) {
+        return name;
+    }
+    std::string ret = name + "{";
+    for (auto it = labels.begin(); it != labels.end(); ++it) {
+        if (it != labels.begin()) {
+            ret += ",";
+        }
+        ret += it->first + "=\"" + it->second + "\"";
+    }
+    ret += "}";
+    return ret;
+}
+
+/* Fills `series_out` with the value of each series. A series that more than one
+stat maps to goes in `collisions_out`. */
+void collect_metrics(const perfmon_result_t &result, const std::string &name,
+                     const std::string &last_component, const metric_labels_t &labels,
+                     std::map<std::string, std::string> *series_out,
+                     std::set<std::string> *collisions_out) {
+    if (result.is_map()) {
+        for (auto it = result.begin(); it != result.end(); ++it) {
+            const std::string label = last_component.empty() ? "table" : last_component;
+            if (is_uuid_component(it->first) && !has_label(labels, label)) {
+                metric_labels_t child_labels(labels);
+                child_labels.push_back(std::make_pair(label, it->first));
+                collect_metrics(*it->second, name, label, child_labels,
+                                series_out, collisions_out);
+            } else {
+                const std::string component = metric_name_component(it->first);
+                collect_metrics(*it->second, name + "_" + component, component, labels,
+                                series_out, collisions_out);
+            }
+        }
+    } else {
+        const std::string *value = result.get_string();
+        char *end;
+        const double d = strtod(value->c_str(), &end);
+        if (value->empty() || *end != '\0' || !isfinite(d)) {
+            return;
+        }
+        const std::string series = metric_series(name, labels);
+        if (!series_out->insert(std::make_pair(series, *value)).second) {
+            collisions_out->insert(series);
+        }
+    }
+}
+
+std::string perfmon_result_to_text(const perfmon_result_t &result, const std::string &prefix) {
+    std::map<std::string, std::string> series;
+    std::set<std::string> collisions;
+    collect_metrics(result, metric_name_component(prefix), "", metric_labels_t(),
+                    &series, &collisions);
+
+    std::string out;
+    for (auto it = series.begin(); it != series.end(); ++it) {
+        if (collisions.count(it->first) == 0) {
+            out += it->first;
+            out += " ";
+            out += it->second;
+            out += "\n";
+        }
+    }
+    return out;
+}
@@ -0,0 +1,24 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef PERFMON_TEXT_HPP_
+#define PERFMON_TEXT_HPP_
+
+#include <string>
+
+#include "perfmon/core.hpp"
+
+/* Renders stats in the text format that Prometheus scrapes: one
+`name value` line per stat. A stat's name is `prefix` followed by its path in
+`result`, joined with underscores, with every character that can't be in a
+metric name replaced by an underscore; a stat at `serializers/foo/reads` is
+`<prefix>_serializers_foo_reads`.
+
+A path component that is a UUID, such as a table's or a peer's, becomes a label
+named after the component before it (`table` at the top level) instead, so
+`connectivity/<id>/sent` is `<prefix>_connectivity_sent{connectivity="<id>"}`.
+
+Stats whose values aren't finite numbers are left out, and so are stats whose
+names come out the same, like `read-latency` and `read_latency`, since there's
+no telling them apart. */
+std::string perfmon_result_to_text(const perfmon_result_t &result, const std::string &prefix);
+
+#endif  // PERFMON_TEXT_HPP_
@@ -5,6 +5,7 @@
 #include <set>
 #include <map>
 #include <string>
+#include <vector>
 
 #include "errors.hpp"
 #include <boost/function.hpp>
@@ -12,11 +13,15 @@
 #include <boost/ptr_container/ptr_vector.hpp>
 
 #include "arch/runtime/runtime.hpp"
+#include "arch/runtime/thread_load.hpp"
 #include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "concurrency/cross_thread_watchable.hpp"
+#include "concurrency/one_per_thread.hpp"
 #include "containers/archive/archive.hpp"
 #include "http/http.hpp"
+#include "rpc/semilattice/joins/vclock.hpp"
 
 enum protob_server_callback_mode_t {
     INLINE, //protobs that arrive will be called inline
@@ -100,6 +105,10 @@ private:
 // request_t::protob_type *underlying_protob_value(request_t *request);
 //
 // "request_t::protob_type" does not actually have to be defined.
+//
+// context_t must also provide "bool can_change_thread() const", which says
+// whether the connection's state allows it to be served from a fresh context_t
+// on another thread.  It is only consulted between queries.
 
 
 template <class request_t, class response_t, class context_t>
@@ -111,13 +120,24 @@ public:
                     boost::function<bool(request_t, response_t *, context_t *)> _f,  // NOLINT(readability/casting)
                     response_t (*_on_unparsable_query)(request_t, std::string),
                     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > _auth_metadata,
-                    protob_server_callback_mode_t _cb_mode = CORO_ORDERED);
+                    protob_server_callback_mode_t _cb_mode = CORO_ORDERED,
+                    bool _migrate_idle_conns = false,
+                    tcp_accept_mode_t _accept_mode = ACCEPT_ON_HOME_THREAD);
     ~protob_server_t();
 
     int get_port() const;
 private:
 
     void handle_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn, auto_drainer_t::lock_t);
+    // Used instead of `handle_conn()` when connections are accepted on every thread.
+    void handle_local_conn(const scoped_ptr_t<tcp_conn_descriptor_t> &nconn);
+    // Returns false if the connection should be dropped.
+    bool handshake(tcp_conn_t *conn, const vclock_t<auth_key_t> &auth_vclock, signal_t *closer);
+    // Returns `INVALID_THREAD` once the connection is closed, or the thread the
+    // connection should move to if it should be moved.
+    int serve_requests(tcp_conn_t *conn, context_t *ctx, signal_t *closer);
+    int choose_thread_for_new_conn();
+    int choose_thread_for_idle_conn();
     void send(const response_t &, tcp_conn_t *conn, signal_t *closer) THROWS_ONLY(tcp_conn_write_closed_exc_t);
     static auth_key_t read_auth_key(tcp_conn_t *conn, signal_t *interruptor);
 
@@ -131,11 +151,22 @@ private:
 
     protob_server_callback_mode_t cb_mode;
 
+    // If set, idle connections are moved off threads that are much busier than others.
+    bool migrate_idle_conns;
+
+    tcp_accept_mode_t accept_mode;
+
+    // Which threads client connections are served on.
+    conn_placement_t conn_placement;
+
     /* WARNING: The order here is fragile. */
     cond_t main_shutting_down_cond;
     signal_t *shutdown_signal() { return &shutting_down_conds[get_thread_id()]; }
     boost::ptr_vector<cross_thread_signal_t> shutting_down_conds;
     auto_drainer_t auto_drainer;
+    // These are only used with `ACCEPT_ON_EVERY_THREAD`.
+    scoped_array_t<scoped_ptr_t<cross_thread_watchable_variable_t<auth_semilattice_metadata_t> > > cross_thread_auth_watchables;
+    scoped_ptr_t<one_per_thread_t<auto_drainer_t> > per_thread_drainers;
     struct pulse_on_destruct_t {
         explicit pulse_on_destruct_t(cond_t *_cond) : cond(_cond) { }
         ~pulse_on_destruct_t() { cond->pulse(); }
@@ -144,8 +175,6 @@ private:
     http_conn_cache_t<context_t> http_conn_cache;
 
     scoped_ptr_t<tcp_listener_t> tcp_listener;
-
-    unsigned next_thread;
 };
 
 //TODO figure out how to do 0 copy serialization with this.
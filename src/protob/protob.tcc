@@ -13,6 +13,8 @@
 #include "arch/arch.hpp"
 #include "arch/io/network.hpp"
 #include "concurrency/cross_thread_signal.hpp"
+#include "rpc/semilattice/view.hpp"
+#include "rpc/semilattice/watchable.hpp"
 #include "utils.hpp"
 
 template <class request_t, class response_t, class context_t>
@@ -22,14 +24,18 @@ protob_server_t<request_t, response_t, context_t>::protob_server_t(
     boost::function<bool(request_t, response_t *, context_t *)> _f,  // NOLINT(readability/casting)
     response_t (*_on_unparsable_query)(request_t, std::string),
     boost::shared_ptr<semilattice_readwrite_view_t<auth_semilattice_metadata_t> > _auth_metadata,
-    protob_server_callback_mode_t _cb_mode)
+    protob_server_callback_mode_t _cb_mode,
+    bool _migrate_idle_conns,
+    tcp_accept_mode_t _accept_mode)
     : f(_f),
       on_unparsable_query(_on_unparsable_query),
       auth_metadata(_auth_metadata),
       cb_mode(_cb_mode),
+      migrate_idle_conns(_migrate_idle_conns),
+      accept_mode(_accept_mode),
+      conn_placement(get_num_threads()),
       shutting_down_conds(get_num_threads()),
-      pulse_sdc_on_shutdown(&main_shutting_down_cond),
-      next_thread(0) {
+      pulse_sdc_on_shutdown(&main_shutting_down_cond) {
 
     for (int i = 0; i < get_num_threads(); ++i) {
         cross_thread_signal_t *s =
@@ -38,12 +44,28 @@ protob_server_t<request_t, response_t, context_t>::protob_server_t(
         rassert(s == &shutting_down_conds[i]);
     }
 
+    boost::function<void(scoped_ptr_t<tcp_conn_descriptor_t> &)> conn_handler;  // NOLINT(readability/casting)
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        // Connections arrive on every thread, so they can neither use our home
+        // thread's drainer nor read the auth key from our home thread.
+        cross_thread_auth_watchables.init(get_num_db_threads());
+        for (int thread = 0; thread < get_num_db_threads(); ++thread) {
+            cross_thread_auth_watchables[thread].init(
+                new cross_thread_watchable_variable_t<auth_semilattice_metadata_t>(
+                    clone_ptr_t<semilattice_watchable_t<auth_semilattice_metadata_t> >(
+                        new semilattice_watchable_t<auth_semilattice_metadata_t>(auth_metadata)),
+                    thread));
+        }
+        per_thread_drainers.init(new one_per_thread_t<auto_drainer_t>);
+        conn_handler = boost::bind(&protob_server_t<request_t, response_t, context_t>::handle_local_conn,
+                                   this, _1);
+    } else {
+        conn_handler = boost::bind(&protob_server_t<request_t, response_t, context_t>::handle_conn,
+                                   this, _1, auto_drainer_t::lock_t(&auto_drainer));
+    }
+
     try {
-        tcp_listener.init(new tcp_listener_t(
-            local_addresses,
-            port,
-            boost::bind(&protob_server_t<request_t, response_t, context_t>::handle_conn,
-                        this, _1, auto_drainer_t::lock_t(&auto_drainer))));
+        tcp_listener.init(new tcp_listener_t(local_addresses, port, conn_handler, accept_mode));
     } catch (const address_in_use_exc_t &e) {
         nice_crash("%s. Cannot bind to RDB protocol port. Exiting.\n", e.what());
     }
@@ -87,20 +109,65 @@ auth_key_t protob_server_t<request_t, response_t, context_t>::read_auth_key(tcp_
     return ret;
 }
 
+template <class request_t, class response_t, class context_t>
+void protob_server_t<request_t, response_t, context_t>::handle_local_conn(
+    const scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+    handle_conn(nconn, auto_drainer_t::lock_t(per_thread_drainers->get()));
+}
+
 template <class request_t, class response_t, class context_t>
 void protob_server_t<request_t, response_t, context_t>::handle_conn(
     const scoped_ptr_t<tcp_conn_descriptor_t> &nconn,
     auto_drainer_t::lock_t keepalive) {
 
     // This must be read here because of home threads and stuff
-    const vclock_t<auth_key_t> auth_vclock = auth_metadata->get().auth_key;
+    const vclock_t<auth_key_t> auth_vclock = accept_mode == ACCEPT_ON_EVERY_THREAD
+        ? cross_thread_auth_watchables[get_thread_id()]->get_watchable()->get().auth_key
+        : auth_metadata->get().auth_key;
+
+    int chosen_thread = choose_thread_for_new_conn();
+
+    // Set when the connection is being handed over to another thread between queries.
+    tcp_conn_t *migrating_conn = NULL;
 
-    int chosen_thread = (next_thread++) % get_num_db_threads();
-    cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
-    on_thread_t rethreader(chosen_thread);
-    context_t ctx;
-    scoped_ptr_t<tcp_conn_t> conn;
-    nconn->make_overcomplicated(&conn);
+    for (;;) {
+        cross_thread_signal_t ct_keepalive(keepalive.get_drain_signal(), chosen_thread);
+        on_thread_t rethreader(chosen_thread);
+        conn_placement_t::conn_t conn_count(&conn_placement, chosen_thread);
+        context_t ctx;
+        scoped_ptr_t<tcp_conn_t> conn;
+
+        if (migrating_conn == NULL) {
+            nconn->make_overcomplicated(&conn);
+            if (!handshake(conn.get(), auth_vclock, &ct_keepalive)) {
+                return;
+            }
+        } else {
+            conn.init(migrating_conn);
+            migrating_conn = NULL;
+            conn->rethread(chosen_thread);
+        }
+
+        ip_address_t peer_address;
+        if (conn->getpeername(&peer_address) == 0) {
+            ctx.client_address = peer_address.as_dotted_decimal();
+        }
+
+        chosen_thread = serve_requests(conn.get(), &ctx, &ct_keepalive);
+        if (chosen_thread == INVALID_THREAD) {
+            return;
+        }
+
+        conn->rethread(INVALID_THREAD);
+        migrating_conn = conn.release();
+    }
+}
+
+template <class request_t, class response_t, class context_t>
+bool protob_server_t<request_t, response_t, context_t>::handshake(
+    tcp_conn_t *conn,
+    const vclock_t<auth_key_t> &auth_vclock,
+    signal_t *closer) {
 
     std::string init_error;
 
@@ -110,19 +177,19 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
         }
 
         int32_t client_magic_number;
-        conn->read(&client_magic_number, sizeof(int32_t), &ct_keepalive);
+        conn->read(&client_magic_number, sizeof(int32_t), closer);
 
         if (client_magic_number == context_t::no_auth_magic_number) {
             if (!auth_vclock.get().str().empty()) {
                 throw protob_server_exc_t("authorization required, client does not support it");
             }
         } else if (client_magic_number == context_t::auth_magic_number) {
-            auth_key_t provided_auth = read_auth_key(conn.get(), &ct_keepalive);
+            auth_key_t provided_auth = read_auth_key(conn, closer);
             if (!timing_sensitive_equals(provided_auth, auth_vclock.get())) {
                 throw protob_server_exc_t("incorrect authorization key");
             }
             const char *success_msg = "SUCCESS";
-            conn->write(success_msg, strlen(success_msg) + 1, &ct_keepalive);
+            conn->write(success_msg, strlen(success_msg) + 1, closer);
         } else {
             throw protob_server_exc_t("this is the rdb protocol port (bad magic number)");
         }
@@ -131,19 +198,42 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
         // Can't write response here due to coro switching inside exception handler
         init_error = strprintf("ERROR: %s\n", ex.what());
     } catch (const tcp_conn_read_closed_exc_t &) {
-        return;
+        return false;
     } catch (const tcp_conn_write_closed_exc_t &) {
-        return;
+        return false;
     }
 
     if (!init_error.empty()) {
-        conn->write(init_error.c_str(), init_error.length() + 1, &ct_keepalive);
+        conn->write(init_error.c_str(), init_error.length() + 1, closer);
         conn->shutdown_write();
-        return;
+        return false;
     }
 
+    return true;
+}
+
+template <class request_t, class response_t, class context_t>
+int protob_server_t<request_t, response_t, context_t>::serve_requests(
+    tcp_conn_t *conn,
+    context_t *ctx,
+    signal_t *closer) {
+
+    ticks_t last_placement_check = get_ticks();
+
     //TODO figure out how to do this with less copying
     for (;;) {
+        // Between queries, see if the connection would be better off on a less busy thread.
+        if (migrate_idle_conns && ctx->can_change_thread()) {
+            const ticks_t now = get_ticks();
+            if (now - last_placement_check >= CLIENT_CONN_MIGRATION_INTERVAL_MS * MILLION) {
+                last_placement_check = now;
+                const int better_thread = choose_thread_for_idle_conn();
+                if (better_thread != get_thread_id()) {
+                    return better_thread;
+                }
+            }
+        }
+
         request_t request;
         make_empty_protob_bearer(&request);
         bool force_response = false;
@@ -151,14 +241,14 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
         std::string err;
         try {
             int32_t size;
-            conn->read(&size, sizeof(int32_t), &ct_keepalive);
+            conn->read(&size, sizeof(int32_t), closer);
             if (size < 0) {
                 err = strprintf("Negative protobuf size (%d).", size);
                 forced_response = on_unparsable_query(request_t(), err);
                 force_response = true;
             } else {
                 scoped_array_t<char> data(size);
-                conn->read(data.data(), size, &ct_keepalive);
+                conn->read(data.data(), size, closer);
 
                 const bool res
                     = underlying_protob_value(&request)->ParseFromArray(data.data(), size);
@@ -171,28 +261,28 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
         } catch (const tcp_conn_read_closed_exc_t &) {
             //TODO need to figure out what blocks us up here in non inline cb
             //mode
-            return;
+            return INVALID_THREAD;
         }
 
         try {
             switch (cb_mode) {
             case INLINE:
                 if (force_response) {
-                    send(forced_response, conn.get(), &ct_keepalive);
+                    send(forced_response, conn, closer);
                 } else {
 #ifdef __linux
                     linux_event_watcher_t *ew = conn->get_event_watcher();
                     linux_event_watcher_t::watch_t conn_interrupted(
                         ew, poll_event_rdhup);
                     wait_any_t interruptor(&conn_interrupted, shutdown_signal());
-                    ctx.interruptor = &interruptor;
+                    ctx->interruptor = &interruptor;
 #else
-                    ctx.interruptor = shutdown_signal();
+                    ctx->interruptor = shutdown_signal();
 #endif  // __linux
                     response_t response;
-                    bool response_needed = f(request, &response, &ctx);
+                    bool response_needed = f(request, &response, ctx);
                     if (response_needed) {
-                        send(response, conn.get(), &ct_keepalive);
+                        send(response, conn, closer);
                     }
                 }
                 break;
@@ -209,11 +299,33 @@ void protob_server_t<request_t, response_t, context_t>::handle_conn(
         } catch (const tcp_conn_write_closed_exc_t &) {
             //TODO need to figure out what blocks us up here in non inline cb
             //mode
-            return;
+            return INVALID_THREAD;
         }
     }
 }
 
+inline std::vector<double> get_db_thread_loads() {
+    std::vector<double> loads(get_num_db_threads());
+    for (size_t i = 0; i < loads.size(); ++i) {
+        loads[i] = get_thread_load(i);
+    }
+    return loads;
+}
+
+template <class request_t, class response_t, class context_t>
+int protob_server_t<request_t, response_t, context_t>::choose_thread_for_new_conn() {
+    // The kernel already spread the connections over the threads for us.
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        return get_thread_id();
+    }
+    return conn_placement.choose_thread_for_new_conn(get_db_thread_loads());
+}
+
+template <class request_t, class response_t, class context_t>
+int protob_server_t<request_t, response_t, context_t>::choose_thread_for_idle_conn() {
+    return conn_placement.choose_thread_for_idle_conn(get_thread_id(), get_db_thread_loads());
+}
+
 template <class request_t, class response_t, class context_t>
 void protob_server_t<request_t, response_t, context_t>::send(
     const response_t &res,
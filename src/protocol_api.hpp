@@ -289,6 +289,12 @@ class chunk_fun_callback_t {
 public:
     virtual void send_chunk(const typename protocol_t::backfill_chunk_t &, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) = 0;
 
+    /* Called once every chunk for `region`, which is part of the region being
+    backfilled, has gone to `send_chunk()`. The backfillee uses this to
+    remember how far it got, so that an interrupted backfill doesn't start
+    over from scratch. */
+    virtual void finish_region(UNUSED const typename protocol_t::region_t &region, UNUSED signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) { }
+
 protected:
     chunk_fun_callback_t() { }
     virtual ~chunk_fun_callback_t() { }
@@ -116,7 +116,7 @@ lazy_datum_stream_t::lazy_datum_stream_t(
     : datum_stream_t(env, bt_src),
       json_stream(new query_language::batched_rget_stream_t(
                       *ns_access, env->interruptor, counted_t<datum_t>(), counted_t<datum_t>(),
-                      env->get_all_optargs(), use_outdated))
+                      env->get_all_optargs(), use_outdated, env))
 { }
 
 lazy_datum_stream_t::lazy_datum_stream_t(
@@ -126,7 +126,7 @@ lazy_datum_stream_t::lazy_datum_stream_t(
     : datum_stream_t(env, bt_src),
       json_stream(new query_language::batched_rget_stream_t(
                       *ns_access, env->interruptor, left_bound, right_bound,
-                      env->get_all_optargs(), use_outdated))
+                      env->get_all_optargs(), use_outdated, env))
 { }
 
 lazy_datum_stream_t::lazy_datum_stream_t(
@@ -137,7 +137,7 @@ lazy_datum_stream_t::lazy_datum_stream_t(
     : datum_stream_t(env, bt_src),
       json_stream(new query_language::batched_rget_stream_t(
                       *ns_access, env->interruptor, sindex_id,
-                      env->get_all_optargs(), use_outdated, left_bound, right_bound))
+                      env->get_all_optargs(), use_outdated, left_bound, right_bound, env))
 { }
 
 lazy_datum_stream_t::lazy_datum_stream_t(const lazy_datum_stream_t *src)
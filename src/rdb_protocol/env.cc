@@ -159,6 +159,41 @@ void env_t::do_eval_callback() {
     }
 }
 
+void env_t::start_profile() {
+    if (!profile.has()) {
+        profile.init(new profile_t());
+    }
+}
+
+void env_t::count_js_call() {
+    ++js_calls;
+    ++stats.reads.js_calls;
+    if (profile.has()) {
+        profile->add_js_calls(1);
+    }
+}
+
+void env_t::count_read(const rdb_protocol_t::read_stats_t &read_stats, int64_t rows_read) {
+    stats.reads.add(read_stats);
+    if (profile.has()) {
+        profile->add_read_stats(read_stats);
+        profile->add_rows(rows_read);
+    }
+}
+
+void env_t::count_rows_returned(int64_t rows) {
+    stats.rows_returned += rows;
+    if (profile.has()) {
+        profile->add_rows(rows);
+    }
+}
+
+query_stats_t env_t::take_stats() {
+    query_stats_t ret = stats;
+    stats = query_stats_t();
+    return ret;
+}
+
 void env_t::join_and_wait_to_propagate(
     const cluster_semilattice_metadata_t &metadata_to_join)
     THROWS_ONLY(interrupted_exc_t) {
@@ -223,6 +258,7 @@ env_t::env_t(
     directory_read_manager(_directory_read_manager),
     js_runner(_js_runner),
     DEBUG_ONLY(eval_callback(NULL), )
+    js_calls(0),
     interruptor(_interruptor),
     this_machine(_this_machine) {
 
@@ -237,6 +273,7 @@ env_t::env_t(signal_t *_interruptor)
     ns_repo(NULL),
     directory_read_manager(NULL),
     DEBUG_ONLY(eval_callback(NULL), )
+    js_calls(0),
     interruptor(_interruptor) { }
 
 env_t::~env_t() { }
@@ -15,6 +15,7 @@
 #include "extproc/pool.hpp"
 #include "rdb_protocol/error.hpp"
 #include "rdb_protocol/js.hpp"
+#include "rdb_protocol/profile.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/stream.hpp"
 #include "rdb_protocol/val.hpp"
@@ -169,6 +170,30 @@ public:
 private:
     eval_callback_t *eval_callback;
 
+public:
+    // Starts profiling the query, for the `profile` global optarg.
+    void start_profile();
+    // Returns NULL unless the query is being profiled.
+    profile_t *get_profile() { return profile.get(); }
+
+    // Called for each call into the JS runner, so that profiles and read
+    // stats can say how many there were.
+    void count_js_call();
+    int64_t get_js_calls() const { return js_calls; }
+
+    // Count what the query's reads cost and the rows sent back to the client,
+    // in the query's stats and in its profile if it has one.
+    void count_read(const rdb_protocol_t::read_stats_t &read_stats, int64_t rows_read);
+    void count_rows_returned(int64_t rows);
+
+    // Returns the stats counted since the last call, and resets them.
+    query_stats_t take_stats();
+
+private:
+    scoped_ptr_t<profile_t> profile;
+    int64_t js_calls;
+    query_stats_t stats;
+
 public:
     signal_t *interruptor;
     uuid_u this_machine;
@@ -94,6 +94,7 @@ counted_t<val_t> func_t::call(const std::vector<counted_t<const datum_t> > &args
             }
 
             boost::shared_ptr<js::runner_t> js = js_env->get_js_runner();
+            js_env->count_js_call();
             js::js_result_t result = js->call(js_id, json_args);
 
             return boost::apply_visitor(js_result_visitor_t(js_env, js_parent), result);
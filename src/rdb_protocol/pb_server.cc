@@ -19,13 +19,19 @@ Response on_unparsable_query2(ql::protob_t<Query> q, std::string msg) {
 
 query2_server_t::query2_server_t(const std::set<ip_address_t> &local_addresses,
                                  int port,
-                                 rdb_protocol_t::context_t *_ctx) :
+                                 rdb_protocol_t::context_t *_ctx,
+                                 bool rebalance_conns,
+                                 tcp_accept_mode_t accept_mode,
+                                 const slow_query_log_config_t &slow_query_config) :
+    slow_query_log(slow_query_config),
     server(local_addresses,
            port,
            boost::bind(&query2_server_t::handle, this, _1, _2, _3),
            &on_unparsable_query2,
            _ctx->auth_metadata,
-           INLINE),
+           INLINE,
+           rebalance_conns,
+           accept_mode),
     ctx(_ctx), parser_id(generate_uuid()), thread_counters(0)
 { }
 
@@ -33,6 +39,10 @@ http_app_t *query2_server_t::get_http_app() {
     return &server;
 }
 
+http_app_t *query2_server_t::get_slow_query_app() {
+    return &slow_query_log;
+}
+
 int query2_server_t::get_port() const {
     return server.get_port();
 }
@@ -46,6 +56,8 @@ bool query2_server_t::handle(ql::protob_t<Query> q,
     response_out->set_token(q->token());
 
     bool response_needed = true;
+    ticks_t start_time = get_ticks();
+    ql::query_stats_t stats;
     try {
         boost::shared_ptr<js::runner_t> js_runner = boost::make_shared<js::runner_t>();
         int thread = get_thread_id();
@@ -59,7 +71,11 @@ bool query2_server_t::handle(ql::protob_t<Query> q,
                 js_runner, interruptor, ctx->machine_id,
                 std::map<std::string, ql::wire_func_t>()));
         // `ql::run` will set the status code
-        ql::run(q, &env, response_out, stream_cache2, &response_needed);
+        ql::run(q, &env, response_out, stream_cache2, &response_needed, &stats);
+        // If the query didn't become a stream, its stats are still in its env
+        if (env.has()) {
+            stats.add(env->take_stats());
+        }
     } catch (const interrupted_exc_t &e) {
         ql::fill_error(response_out, Response::RUNTIME_ERROR,
                        "Query interrupted.  Did you shut down the server?");
@@ -68,6 +84,11 @@ bool query2_server_t::handle(ql::protob_t<Query> q,
                        strprintf("Unexpected exception: %s\n", e.what()));
     }
 
+    if (q->type() != Query::STOP) {
+        slow_query_log.maybe_record(*q, query2_context->client_address,
+                                    get_ticks() - start_time, stats);
+    }
+
     return response_needed;
 }
 
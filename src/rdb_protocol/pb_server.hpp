@@ -13,6 +13,7 @@
 #include "protocol_api.hpp"
 #include "rdb_protocol/protocol.hpp"
 #include "rdb_protocol/ql2.hpp"
+#include "rdb_protocol/slow_query_log.hpp"
 
 namespace ql { template <class> class protob_t; }
 
@@ -23,23 +24,34 @@ Query *underlying_protob_value(ql::protob_t<Query> *request);
 class query2_server_t {
 public:
     query2_server_t(const std::set<ip_address_t> &local_addresses, int port,
-                    rdb_protocol_t::context_t *_ctx);
+                    rdb_protocol_t::context_t *_ctx,
+                    bool rebalance_conns = false,
+                    tcp_accept_mode_t accept_mode = ACCEPT_ON_HOME_THREAD,
+                    const slow_query_log_config_t &slow_query_config = slow_query_log_config_t());
 
     http_app_t *get_http_app();
 
+    // Serves the slow query log
+    http_app_t *get_slow_query_app();
+
     int get_port() const;
 
     struct context_t {
         context_t() : interruptor(0) { }
         static const int32_t no_auth_magic_number = VersionDummy::V0_1;
         static const int32_t auth_magic_number = VersionDummy::V0_2;
+        // Open streams belong to this thread, so only idle connections may move.
+        bool can_change_thread() const { return stream_cache2.empty(); }
         ql::stream_cache2_t stream_cache2;
         signal_t *interruptor;
+        // Set by `protob_server_t`, for the slow query log
+        std::string client_address;
     };
 private:
     MUST_USE bool handle(ql::protob_t<Query> q,
                          Response *response_out,
                          context_t *query2_context);
+    slow_query_log_t slow_query_log;
     protob_server_t<ql::protob_t<Query>, Response, context_t> server;
     rdb_protocol_t::context_t *ctx;
     uuid_u parser_id;
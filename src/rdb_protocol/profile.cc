@@ -0,0 +1,102 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rdb_protocol/profile.hpp"
+
+#include <map>
+#include <vector>
+
+#include "rdb_protocol/datum.hpp"
+
+namespace ql {
+
+void query_stats_t::add(const query_stats_t &other) {
+    rows_returned += other.rows_returned;
+    reads.add(other.reads);
+}
+
+profile_t::profile_t() : root("query"), current(&root) { }
+
+profile_t::~profile_t() { }
+
+void profile_t::add_rows(int64_t rows) {
+    current->rows += rows;
+}
+
+void profile_t::add_read_stats(const rdb_protocol_t::read_stats_t &stats) {
+    current->stats.add(stats);
+}
+
+void profile_t::add_js_calls(int64_t js_calls) {
+    current->stats.js_calls += js_calls;
+}
+
+counted_t<const datum_t> profile_t::take_spans() {
+    guarantee(current == &root, "taking a query profile while a span is still open");
+    std::vector<counted_t<const datum_t> > spans;
+    for (auto it = root.children.begin(); it != root.children.end(); ++it) {
+        spans.push_back(it->as_datum());
+    }
+    root.children.clear();
+    return make_counted<const datum_t>(spans);
+}
+
+profile_t::span_t::span_t(const std::string &_name)
+    : name(_name), count(0), duration(0), rows(0) { }
+
+counted_t<const datum_t> profile_t::span_t::as_datum() const {
+    std::map<std::string, counted_t<const datum_t> > obj;
+    obj["name"] = make_counted<const datum_t>(name);
+    obj["count"] = make_counted<const datum_t>(static_cast<double>(count));
+    obj["duration_ms"] = make_counted<const datum_t>(duration / 1000000.0);
+    if (rows != 0) {
+        obj["rows"] = make_counted<const datum_t>(static_cast<double>(rows));
+    }
+    if (stats.shards != 0) {
+        obj["shards"] = make_counted<const datum_t>(static_cast<double>(stats.shards));
+        obj["blocks_from_cache"] = make_counted<const datum_t>(
+            static_cast<double>(stats.blocks_acquired - stats.blocks_loaded));
+        obj["blocks_from_disk"] = make_counted<const datum_t>(
+            static_cast<double>(stats.blocks_loaded));
+    }
+    if (stats.js_calls != 0) {
+        obj["js_calls"] = make_counted<const datum_t>(static_cast<double>(stats.js_calls));
+    }
+    if (!children.empty()) {
+        std::vector<counted_t<const datum_t> > child_spans;
+        for (auto it = children.begin(); it != children.end(); ++it) {
+            child_spans.push_back(it->as_datum());
+        }
+        obj["children"] = make_counted<const datum_t>(child_spans);
+    }
+    return make_counted<const datum_t>(obj);
+}
+
+profile_span_t::profile_span_t(profile_t *_profile, const char *name)
+    : profile(_profile), span(NULL), parent(NULL), start(0) {
+    if (profile == NULL) {
+        return;
+    }
+    parent = profile->current;
+    for (auto it = parent->children.begin(); it != parent->children.end(); ++it) {
+        if (it->name == name) {
+            span = &*it;
+            break;
+        }
+    }
+    if (span == NULL) {
+        span = new profile_t::span_t(name);
+        parent->children.push_back(span);
+    }
+    ++span->count;
+    profile->current = span;
+    start = get_ticks();
+}
+
+profile_span_t::~profile_span_t() {
+    if (profile == NULL) {
+        return;
+    }
+    span->duration += get_ticks() - start;
+    profile->current = parent;
+}
+
+}  // namespace ql
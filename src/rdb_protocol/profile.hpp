@@ -0,0 +1,90 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_PROFILE_HPP_
+#define RDB_PROTOCOL_PROFILE_HPP_
+
+#include <string>
+
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_vector.hpp>
+
+#include "containers/counted.hpp"
+#include "rdb_protocol/protocol.hpp"
+#include "utils.hpp"
+
+namespace ql {
+
+class datum_t;
+
+/* Totals of the work done for a query. Unlike `profile_t`, these are kept for
+every query; the slow query log reports them. */
+struct query_stats_t {
+    query_stats_t() : rows_returned(0) { }
+    void add(const query_stats_t &other);
+
+    int64_t rows_returned;
+    // `reads.js_calls` also counts the JS calls made outside of the reads
+    rdb_protocol_t::read_stats_t reads;
+};
+
+/* A profile of where a query spent its time, built when the query has the
+`profile` global optarg. It is a tree of spans: one for each term evaluated,
+each read sent to a table, and each batch of a stream sent to the client. A span
+starts out as a child of the innermost span that was open when it began.
+
+Spans with the same name and parent are merged into one with a `count`, so
+that a term evaluated once per row doesn't make one span per row, and the tree
+stays about as big as the query. */
+class profile_t {
+public:
+    profile_t();
+    ~profile_t();
+
+    /* These add to the innermost open span */
+    void add_rows(int64_t rows);
+    void add_read_stats(const rdb_protocol_t::read_stats_t &stats);
+    void add_js_calls(int64_t js_calls);
+
+    /* Returns the spans that have ended since the last call as an array of
+    objects, and forgets about them. There mustn't be any open spans. */
+    counted_t<const datum_t> take_spans();
+
+private:
+    friend class profile_span_t;
+
+    struct span_t {
+        explicit span_t(const std::string &_name);
+        counted_t<const datum_t> as_datum() const;
+
+        std::string name;
+        int64_t count;
+        ticks_t duration;
+        int64_t rows;
+        rdb_protocol_t::read_stats_t stats;
+        boost::ptr_vector<span_t> children;
+    };
+
+    span_t root;
+    span_t *current;
+
+    DISABLE_COPYING(profile_t);
+};
+
+/* Times a span for as long as it's in scope. It does nothing if the profile is
+`NULL`, which it is for queries that aren't being profiled. */
+class profile_span_t {
+public:
+    profile_span_t(profile_t *_profile, const char *name);
+    ~profile_span_t();
+
+private:
+    profile_t *profile;
+    profile_t::span_t *span;
+    profile_t::span_t *parent;
+    ticks_t start;
+
+    DISABLE_COPYING(profile_span_t);
+};
+
+}  // namespace ql
+
+#endif  // RDB_PROTOCOL_PROFILE_HPP_
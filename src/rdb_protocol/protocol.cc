@@ -40,6 +40,7 @@ typedef rdb_protocol_t::region_t region_t;
 
 typedef rdb_protocol_t::read_t read_t;
 typedef rdb_protocol_t::read_response_t read_response_t;
+typedef rdb_protocol_t::read_stats_t read_stats_t;
 
 typedef rdb_protocol_t::point_read_t point_read_t;
 typedef rdb_protocol_t::point_read_response_t point_read_response_t;
@@ -695,6 +696,15 @@ public:
         std::sort(results.begin(), results.end(), distribution_read_response_less_t());
 
         distribution_read_response_t res;
+
+        // Each key lives in exactly one of the stores we heard from, so the
+        // load on it is whatever that store reported
+        for (size_t j = 0; j < results.size(); ++j) {
+            for (std::map<store_key_t, double>::const_iterator it = results[j].traffic.begin(); it != results[j].traffic.end(); ++it) {
+                res.traffic[it->first] += it->second;
+            }
+        }
+
         size_t i = 0;
         while (i < results.size()) {
             // Find the largest hash shard for this key range
@@ -760,6 +770,19 @@ void read_t::unshard(read_response_t *responses, size_t count, read_response_t
     THROWS_ONLY(interrupted_exc_t) {
     rdb_r_unshard_visitor_t v(responses, count, response, ctx, interruptor);
     boost::apply_visitor(v, read);
+
+    read_stats_t stats;
+    for (size_t i = 0; i < count; ++i) {
+        stats.add(responses[i].stats);
+    }
+    response->stats = stats;
+}
+
+void read_stats_t::add(const read_stats_t &other) {
+    shards += other.shards;
+    blocks_acquired += other.blocks_acquired;
+    blocks_loaded += other.blocks_loaded;
+    js_calls += other.js_calls;
 }
 
 bool rget_data_cmp(const std::pair<store_key_t, boost::shared_ptr<scoped_cJSON_t> >& a,
@@ -1037,6 +1060,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
         response->response = point_read_response_t();
         point_read_response_t *res =
             boost::get<point_read_response_t>(&response->response);
+        store->key_traffic.record(get.key);
         rdb_get(get.key, btree, txn, superblock, res);
     }
 
@@ -1050,6 +1074,7 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
 
         if (!rget.sindex) {
             //Normal rget
+            store->key_traffic.record(rget.region.inner.left);
             rdb_rget_slice(btree, rget.region.inner, txn, superblock, &ql_env, rget.transform, rget.terminal, res);
         } else {
             scoped_ptr_t<real_superblock_t> sindex_sb;
@@ -1147,6 +1172,15 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
             scale_down_distribution(dg.result_limit, &res->key_counts);
         }
 
+        // Report the load on the part of the key space we were asked about
+        std::map<store_key_t, double> traffic;
+        store->key_traffic.get_rates(get_ticks(), &traffic);
+        for (std::map<store_key_t, double>::const_iterator it = traffic.begin(); it != traffic.end(); ++it) {
+            if (dg.region.inner.contains_key(it->first)) {
+                res->traffic.insert(*it);
+            }
+        }
+
         res->region = dg.region;
     }
 
@@ -1192,6 +1226,8 @@ struct rdb_read_visitor_t : public boost::static_visitor<void> {
                std::map<std::string, ql::wire_func_t>())
     { }
 
+    int64_t get_js_calls() const { return ql_env.get_js_calls(); }
+
 private:
     read_response_t *response;
     btree_slice_t *btree;
@@ -1212,6 +1248,11 @@ void store_t::protocol_read(const read_t &read,
                             signal_t *interruptor) {
     rdb_read_visitor_t v(btree, this, txn, superblock, token_pair, ctx, response, interruptor);
     boost::apply_visitor(v, read.read);
+
+    response->stats.shards = 1;
+    response->stats.blocks_acquired = txn->get_num_blocks_acquired();
+    response->stats.blocks_loaded = txn->get_num_blocks_loaded();
+    response->stats.js_calls = v.get_js_calls();
 }
 
 // TODO: get rid of this extra response_t copy on the stack
@@ -1229,6 +1270,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         point_replace_response_t *res = boost::get<point_replace_response_t>(&response->response);
         // TODO: modify surrounding code so we can dump this const_cast.
         ql::map_wire_func_t *f = const_cast<ql::map_wire_func_t *>(&r.f);
+        store->key_traffic.record(r.key);
         rdb_modification_report_t mod_report(r.key);
         rdb_replace(btree, timestamp, txn, superblock->get(),
                     r.primary_key, r.key, f, &ql_env, res,
@@ -1240,6 +1282,9 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
     void operator()(const batched_replaces_t &br) {
         response->response = batched_replaces_response_t();
         batched_replaces_response_t *res = boost::get<batched_replaces_response_t>(&response->response);
+        for (size_t i = 0; i < br.point_replaces.size(); ++i) {
+            store->key_traffic.record(br.point_replaces[i].second.key);
+        }
 
         rdb_modification_report_cb_t sindex_cb(store, token_pair, txn,
                                                (*superblock)->get_sindex_block_id(),
@@ -1252,6 +1297,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         response->response = point_write_response_t();
         point_write_response_t *res = boost::get<point_write_response_t>(&response->response);
 
+        store->key_traffic.record(w.key);
         rdb_modification_report_t mod_report(w.key);
         rdb_set(w.key, w.data, w.overwrite, btree, timestamp, txn, superblock->get(), res, &mod_report.info);
 
@@ -1262,6 +1308,7 @@ struct rdb_write_visitor_t : public boost::static_visitor<void> {
         response->response = point_delete_response_t();
         point_delete_response_t *res = boost::get<point_delete_response_t>(&response->response);
 
+        store->key_traffic.record(d.key);
         rdb_modification_report_t mod_report(d.key);
         rdb_delete(d.key, btree, timestamp, txn, superblock->get(), res, &mod_report.info);
 
@@ -1438,6 +1485,10 @@ public:
         chunk_fun_cb->send_chunk(chunk_t::sindexes(sindexes), interruptor);
     }
 
+    void finish_region(const region_t &region, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        chunk_fun_cb->finish_region(region, interruptor);
+    }
+
 protected:
     store_key_t to_store_key(const btree_key_t *key) {
         return store_key_t(key->size, key->contents);
@@ -1450,7 +1501,7 @@ private:
 };
 
 static void call_rdb_backfill(int i, btree_slice_t *btree, const std::vector<std::pair<region_t, state_timestamp_t> > &regions,
-        rdb_backfill_callback_t *callback, transaction_t *txn, superblock_t *superblock, buf_lock_t *sindex_block, backfill_progress_t *progress,
+        rdb_backfill_callback_impl_t *callback, transaction_t *txn, superblock_t *superblock, buf_lock_t *sindex_block, backfill_progress_t *progress,
         signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
     parallel_traversal_progress_t *p = new parallel_traversal_progress_t;
     scoped_ptr_t<traversal_progress_t> p_owned(p);
@@ -1458,6 +1509,7 @@ static void call_rdb_backfill(int i, btree_slice_t *btree, const std::vector<std
     repli_timestamp_t timestamp = regions[i].second.to_repli_timestamp();
     try {
         rdb_backfill(btree, regions[i].first.inner, timestamp, callback, txn, superblock, sindex_block, p, interruptor);
+        callback->finish_region(regions[i].first, interruptor);
     } catch (const interrupted_exc_t &) {
         /* do nothing; `protocol_send_backfill()` will notice that interruptor
         has been pulsed */
@@ -1617,9 +1669,11 @@ RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::rget_read_response_t::inserted_t, ins
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_read_response_t, data);
 RDB_IMPL_ME_SERIALIZABLE_5(rdb_protocol_t::rget_read_response_t,
                            result, errors, key_range, truncated, last_considered_key);
-RDB_IMPL_ME_SERIALIZABLE_2(rdb_protocol_t::distribution_read_response_t, region, key_counts);
+RDB_IMPL_ME_SERIALIZABLE_3(rdb_protocol_t::distribution_read_response_t, region, key_counts, traffic);
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::sindex_list_response_t, sindexes);
-RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::read_response_t, response);
+RDB_IMPL_ME_SERIALIZABLE_4(rdb_protocol_t::read_stats_t,
+                           shards, blocks_acquired, blocks_loaded, js_calls);
+RDB_IMPL_ME_SERIALIZABLE_2(rdb_protocol_t::read_response_t, response, stats);
 
 RDB_IMPL_ME_SERIALIZABLE_1(rdb_protocol_t::point_read_t, key);
 RDB_IMPL_ME_SERIALIZABLE_8(rdb_protocol_t::rget_read_t, region, sindex,
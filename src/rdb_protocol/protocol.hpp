@@ -237,6 +237,10 @@ struct rdb_protocol_t {
         region_t region;
         std::map<store_key_t, int64_t> key_counts;
 
+        // Estimated operations per second on sampled keys in the region, from
+        // the stores' `key_traffic_sampler_t`s; see `suggest_split_points()`
+        std::map<store_key_t, double> traffic;
+
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
@@ -246,11 +250,27 @@ struct rdb_protocol_t {
         RDB_DECLARE_ME_SERIALIZABLE;
     };
 
+    /* What a read cost on the stores that served it; query profiles report
+    this. `unshard()` adds up the stats of the pieces of a read. */
+    struct read_stats_t {
+        read_stats_t() : shards(0), blocks_acquired(0), blocks_loaded(0), js_calls(0) { }
+        void add(const read_stats_t &other);
+
+        int64_t shards;
+        // Blocks acquired in total, and those that weren't in the cache
+        int64_t blocks_acquired;
+        int64_t blocks_loaded;
+        int64_t js_calls;
+
+        RDB_DECLARE_ME_SERIALIZABLE;
+    };
+
     struct read_response_t {
         boost::variant<point_read_response_t,
                        rget_read_response_t,
                        distribution_read_response_t,
                        sindex_list_response_t> response;
+        read_stats_t stats;
 
         read_response_t() { }
         explicit read_response_t(const boost::variant<point_read_response_t, rget_read_response_t, distribution_read_response_t> &r)
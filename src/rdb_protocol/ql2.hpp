@@ -12,10 +12,12 @@
 
 namespace ql {
 // Runs a query!  This is all outside code should ever need to call.  See
-// term.cc for definition.
+// term.cc for definition.  The stats of work done for a stream are added to
+// `*stats_out`; if `*env_ptr` still holds the env afterwards, the rest are in
+// there.
 void run(protob_t<Query> q, scoped_ptr_t<env_t> *env_ptr,
          Response *res, stream_cache2_t *stream_cache2,
-         bool *response_needed_out);
+         bool *response_needed_out, query_stats_t *stats_out);
 } // namespace ql
 
 #endif // RDB_PROTOCOL_QL2_HPP_
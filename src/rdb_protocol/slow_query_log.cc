@@ -0,0 +1,182 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rdb_protocol/slow_query_log.hpp"
+
+#include <algorithm>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "concurrency/pmap.hpp"
+#include "http/json.hpp"
+#include "logger.hpp"
+
+void print_datum_for_log(const Datum &d, size_t max_length, std::string *out) {
+    if (out->size() > max_length) {
+        return;
+    }
+    switch (d.type()) {
+    case Datum::R_NULL: *out += "null"; break;
+    case Datum::R_BOOL: *out += d.r_bool() ? "true" : "false"; break;
+    case Datum::R_NUM: *out += strprintf("%.15g", d.r_num()); break;
+    case Datum::R_STR: *out += "\"" + d.r_str() + "\""; break;
+    case Datum::R_ARRAY: {
+        *out += "[";
+        for (int i = 0; i < d.r_array_size(); ++i) {
+            if (i != 0) *out += ", ";
+            print_datum_for_log(d.r_array(i), max_length, out);
+        }
+        *out += "]";
+    } break;
+    case Datum::R_OBJECT: {
+        *out += "{";
+        for (int i = 0; i < d.r_object_size(); ++i) {
+            if (i != 0) *out += ", ";
+            *out += "\"" + d.r_object(i).key() + "\": ";
+            print_datum_for_log(d.r_object(i).val(), max_length, out);
+        }
+        *out += "}";
+    } break;
+    default: *out += "?"; break;
+    }
+}
+
+void print_term_for_log(const Term &t, size_t max_length, std::string *out) {
+    if (out->size() > max_length) {
+        return;
+    }
+    if (t.type() == Term::DATUM) {
+        print_datum_for_log(t.datum(), max_length, out);
+        return;
+    }
+    *out += Term::TermType_Name(t.type()) + "(";
+    for (int i = 0; i < t.args_size(); ++i) {
+        if (i != 0) *out += ", ";
+        print_term_for_log(t.args(i), max_length, out);
+    }
+    for (int i = 0; i < t.optargs_size(); ++i) {
+        if (i != 0 || t.args_size() != 0) *out += ", ";
+        *out += t.optargs(i).key() + "=";
+        print_term_for_log(t.optargs(i).val(), max_length, out);
+    }
+    *out += ")";
+}
+
+std::string print_term_for_log(const Term &t, size_t max_length) {
+    std::string ret;
+    print_term_for_log(t, max_length, &ret);
+    if (ret.size() > max_length) {
+        ret.resize(max_length);
+        ret += "...";
+    }
+    return ret;
+}
+
+slow_query_log_t::slow_query_log_t(const slow_query_log_config_t &_config)
+    : config(_config) { }
+
+void slow_query_log_t::maybe_record(const Query &q, const std::string &client,
+                                    ticks_t duration, const ql::query_stats_t &stats) {
+    slow_query_t entry;
+    if (duration >= static_cast<ticks_t>(config.threshold_ms) * MILLION) {
+        entry.sampled = false;
+    } else if (config.sample_every > 0 && randint(config.sample_every) == 0) {
+        entry.sampled = true;
+    } else {
+        return;
+    }
+
+    entry.finished = current_microtime();
+    entry.duration = duration;
+    entry.client = client;
+    if (q.type() == Query::START) {
+        entry.query = print_term_for_log(q.query(), SLOW_QUERY_MAX_PRINTED_LENGTH);
+    } else {
+        entry.query = strprintf("%s of token %" PRIi64,
+                                Query::QueryType_Name(q.type()).c_str(), q.token());
+    }
+    entry.stats = stats;
+
+    if (config.log_to_file && !entry.sampled) {
+        logINF("Slow query from %s took %.1f ms, returned %" PRIi64 " rows, "
+               "read %" PRIi64 " shards, %" PRIi64 " blocks from the cache and "
+               "%" PRIi64 " from disk: %s",
+               entry.client.c_str(), entry.duration / static_cast<double>(MILLION),
+               stats.rows_returned, stats.reads.shards,
+               stats.reads.blocks_acquired - stats.reads.blocks_loaded,
+               stats.reads.blocks_loaded, entry.query.c_str());
+    }
+
+    std::deque<slow_query_t> *entries = thread_entries.get();
+    entries->push_back(entry);
+    if (entries->size() > SLOW_QUERY_LOG_SIZE) {
+        entries->pop_front();
+    }
+}
+
+void slow_query_log_t::get_thread_entries(int thread,
+                                          std::vector<std::vector<slow_query_t> > *entries_out) {
+    on_thread_t th(thread);
+    const std::deque<slow_query_t> *entries = thread_entries.get();
+    (*entries_out)[thread].assign(entries->begin(), entries->end());
+}
+
+bool slow_query_finished_before(const slow_query_t &a, const slow_query_t &b) {
+    return a.finished < b.finished;
+}
+
+std::vector<slow_query_t> slow_query_log_t::get_entries() {
+    std::vector<std::vector<slow_query_t> > entries_by_thread(get_num_threads());
+    pmap(get_num_threads(), boost::bind(&slow_query_log_t::get_thread_entries,
+                                        this, _1, &entries_by_thread));
+
+    std::vector<slow_query_t> entries;
+    for (auto it = entries_by_thread.begin(); it != entries_by_thread.end(); ++it) {
+        entries.insert(entries.end(), it->begin(), it->end());
+    }
+    std::stable_sort(entries.begin(), entries.end(), &slow_query_finished_before);
+    if (entries.size() > SLOW_QUERY_LOG_SIZE) {
+        entries.erase(entries.begin(), entries.end() - SLOW_QUERY_LOG_SIZE);
+    }
+    return entries;
+}
+
+cJSON *render_as_json(const slow_query_t &entry) {
+    scoped_cJSON_t json(cJSON_CreateObject());
+    json.AddItemToObject("time", cJSON_CreateNumber(entry.finished / static_cast<double>(MILLION)));
+    json.AddItemToObject("duration_ms", cJSON_CreateNumber(entry.duration / static_cast<double>(MILLION)));
+    json.AddItemToObject("sampled", cJSON_CreateBool(entry.sampled));
+    json.AddItemToObject("client", cJSON_CreateString(entry.client.c_str()));
+    json.AddItemToObject("query", cJSON_CreateString(entry.query.c_str()));
+    json.AddItemToObject("rows_returned", cJSON_CreateNumber(entry.stats.rows_returned));
+    json.AddItemToObject("shards", cJSON_CreateNumber(entry.stats.reads.shards));
+    json.AddItemToObject("blocks_from_cache", cJSON_CreateNumber(
+        entry.stats.reads.blocks_acquired - entry.stats.reads.blocks_loaded));
+    json.AddItemToObject("blocks_from_disk", cJSON_CreateNumber(entry.stats.reads.blocks_loaded));
+    json.AddItemToObject("js_calls", cJSON_CreateNumber(entry.stats.reads.js_calls));
+    return json.release();
+}
+
+void slow_query_log_t::get_root(scoped_cJSON_t *json_out) {
+    std::vector<slow_query_t> entries = get_entries();
+    json_out->reset(cJSON_CreateArray());
+    for (auto it = entries.begin(); it != entries.end(); ++it) {
+        json_out->AddItemToArray(render_as_json(*it));
+    }
+}
+
+http_res_t slow_query_log_t::handle(const http_req_t &req) {
+    if (req.method != GET) {
+        return http_res_t(HTTP_METHOD_NOT_ALLOWED);
+    }
+
+    std::string resource = req.resource.as_string();
+    if (resource != "/" && resource != "") {
+        return http_res_t(HTTP_NOT_FOUND);
+    }
+
+    scoped_cJSON_t json(NULL);
+    get_root(&json);
+
+    return http_json_res(json.get());
+}
@@ -0,0 +1,76 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RDB_PROTOCOL_SLOW_QUERY_LOG_HPP_
+#define RDB_PROTOCOL_SLOW_QUERY_LOG_HPP_
+
+#include <deque>
+#include <string>
+#include <vector>
+
+#include "concurrency/one_per_thread.hpp"
+#include "config/args.hpp"
+#include "http/http.hpp"
+#include "rdb_protocol/profile.hpp"
+#include "rdb_protocol/ql2.pb.h"
+
+struct slow_query_log_config_t {
+    slow_query_log_config_t()
+        : threshold_ms(DEFAULT_SLOW_QUERY_THRESHOLD_MS), sample_every(0), log_to_file(false) { }
+    slow_query_log_config_t(int _threshold_ms, int _sample_every, bool _log_to_file)
+        : threshold_ms(_threshold_ms), sample_every(_sample_every), log_to_file(_log_to_file) { }
+
+    int threshold_ms;
+    // One in this many of the other requests is recorded too, so that there is
+    // something to compare the slow ones with. 0 means none of them are.
+    int sample_every;
+    // Whether entries also go to the log file
+    bool log_to_file;
+};
+
+/* What the slow query log knows about a request */
+struct slow_query_t {
+    slow_query_t() : finished(0), duration(0), sampled(false) { }
+
+    microtime_t finished;
+    ticks_t duration;
+    // True if it was recorded as part of the sample rather than for being slow
+    bool sampled;
+    std::string client;
+    std::string query;
+    ql::query_stats_t stats;
+};
+
+/* The slow query log records the ReQL requests that took longer than a
+threshold, and a random sample of the rest, with the printed query, the client's
+address, how long the request took, the rows it sent back and what its reads
+cost. `query2_server_t` passes it every request it handles. Each thread keeps
+its own last `SLOW_QUERY_LOG_SIZE` entries, so recording never waits for other
+threads. The admin HTTP server serves the latest entries of all threads as JSON,
+oldest first. */
+class slow_query_log_t : public http_json_app_t {
+public:
+    explicit slow_query_log_t(const slow_query_log_config_t &_config);
+
+    /* Records the request if it was slow or is sampled. The query is only
+    printed if it's recorded. */
+    void maybe_record(const Query &q, const std::string &client, ticks_t duration,
+                      const ql::query_stats_t &stats);
+
+    /* The latest entries of all threads, oldest first */
+    std::vector<slow_query_t> get_entries();
+
+    http_res_t handle(const http_req_t &);
+    void get_root(scoped_cJSON_t *json_out);
+
+private:
+    void get_thread_entries(int thread, std::vector<std::vector<slow_query_t> > *entries_out);
+
+    const slow_query_log_config_t config;
+    one_per_thread_t<std::deque<slow_query_t> > thread_entries;
+
+    DISABLE_COPYING(slow_query_log_t);
+};
+
+/* Prints a query's term tree, cut off after about `max_length` characters */
+std::string print_term_for_log(const Term &t, size_t max_length);
+
+#endif  // RDB_PROTOCOL_SLOW_QUERY_LOG_HPP_
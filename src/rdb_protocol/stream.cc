@@ -1,6 +1,7 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
 #include "rdb_protocol/stream.hpp"
 
+#include "rdb_protocol/env.hpp"
 #include "rdb_protocol/ql2.hpp"
 #include "rdb_protocol/transform_visitors.hpp"
 
@@ -102,7 +103,8 @@ batched_rget_stream_t::batched_rget_stream_t(
     counted_t<const ql::datum_t> left_bound,
     counted_t<const ql::datum_t> right_bound,
     const std::map<std::string, ql::wire_func_t> &_optargs,
-    bool _use_outdated)
+    bool _use_outdated,
+    ql::env_t *_env)
     : ns_access(_ns_access), interruptor(_interruptor),
       finished(false), started(false), optargs(_optargs), use_outdated(_use_outdated),
       range(key_range_t::closed,
@@ -113,7 +115,8 @@ batched_rget_stream_t::batched_rget_stream_t(
             right_bound.has()
               ? store_key_t(right_bound->print_primary())
               : store_key_t::max()),
-      table_scan_backtrace()
+      table_scan_backtrace(),
+      env(_env)
 { }
 
 batched_rget_stream_t::batched_rget_stream_t(
@@ -122,7 +125,8 @@ batched_rget_stream_t::batched_rget_stream_t(
     const std::map<std::string, ql::wire_func_t> &_optargs,
     bool _use_outdated,
     counted_t<const ql::datum_t> _sindex_start_value,
-    counted_t<const ql::datum_t> _sindex_end_value)
+    counted_t<const ql::datum_t> _sindex_end_value,
+    ql::env_t *_env)
     : ns_access(_ns_access),
       interruptor(_interruptor),
       sindex_id(_sindex_id),
@@ -139,7 +143,8 @@ batched_rget_stream_t::batched_rget_stream_t(
                 _sindex_end_value != NULL
                   ? _sindex_end_value->truncated_secondary()
                   : store_key_t::max())),
-      table_scan_backtrace()
+      table_scan_backtrace(),
+      env(_env)
 { }
 
 boost::shared_ptr<scoped_cJSON_t> batched_rget_stream_t::next() {
@@ -174,12 +179,14 @@ result_t batched_rget_stream_t::apply_terminal(
     rget_read.terminal = rdb_protocol_details::terminal_t(t, per_op_backtrace);
     rdb_protocol_t::read_t read(rget_read);
     try {
+        ql::profile_span_t span(env->get_profile(), "read_terminal");
         rdb_protocol_t::read_response_t res;
         if (use_outdated) {
             ns_access.get_namespace_if()->read_outdated(read, &res, interruptor);
         } else {
             ns_access.get_namespace_if()->read(read, &res, order_token_t::ignore, interruptor);
         }
+        env->count_read(res.stats, 0);
         rdb_protocol_t::rget_read_response_t *p_res = boost::get<rdb_protocol_t::rget_read_response_t>(&res.response);
         guarantee(p_res);
 
@@ -223,6 +230,7 @@ void batched_rget_stream_t::read_more() {
     rdb_protocol_t::read_t read(get_rget());
     try {
         guarantee(ns_access.get_namespace_if());
+        ql::profile_span_t span(env->get_profile(), "read");
         rdb_protocol_t::read_response_t res;
         if (use_outdated) {
             ns_access.get_namespace_if()->read_outdated(read, &res, interruptor);
@@ -250,6 +258,7 @@ void batched_rget_stream_t::read_more() {
             guarantee(i->second);
             data.push_back(i->second);
         }
+        env->count_read(res.stats, stream->size());
 
         range.left = p_res->last_considered_key;
 
@@ -93,7 +93,8 @@ public:
                           counted_t<const ql::datum_t> left_bound,
                           counted_t<const ql::datum_t> right_bound,
                           const std::map<std::string, ql::wire_func_t> &_optargs,
-                          bool _use_outdated);
+                          bool _use_outdated,
+                          ql::env_t *_env);
 
     /* Sindex rget. */
     batched_rget_stream_t(const namespace_repo_t<rdb_protocol_t>::access_t &_ns_access,
@@ -101,7 +102,8 @@ public:
                           const std::map<std::string, ql::wire_func_t> &_optargs,
                           bool _use_outdated,
                           counted_t<const ql::datum_t> _sindex_start_value,
-                          counted_t<const ql::datum_t> _sindex_end_value);
+                          counted_t<const ql::datum_t> _sindex_end_value,
+                          ql::env_t *_env);
 
     boost::shared_ptr<scoped_cJSON_t> next();
 
@@ -134,6 +136,10 @@ private:
     key_range_t range;
 
     boost::optional<backtrace_t> table_scan_backtrace;
+
+    /* The query's env, which counts the reads for the query's stats and
+    profile */
+    ql::env_t *env;
 };
 
 
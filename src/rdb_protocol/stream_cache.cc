@@ -8,6 +8,10 @@ bool stream_cache2_t::contains(int64_t key) {
     return streams.find(key) != streams.end();
 }
 
+bool stream_cache2_t::empty() const {
+    return streams.empty();
+}
+
 void stream_cache2_t::insert(int64_t key,
                              scoped_ptr_t<env_t> *val_env,
                              counted_t<datum_stream_t> val_stream) {
@@ -22,7 +26,8 @@ void stream_cache2_t::erase(int64_t key) {
     guarantee(num_erased == 1);
 }
 
-bool stream_cache2_t::serve(int64_t key, Response *res, signal_t *interruptor) {
+bool stream_cache2_t::serve(int64_t key, Response *res, signal_t *interruptor,
+                            query_stats_t *stats_out) {
     boost::ptr_map<int64_t, entry_t>::iterator it = streams.find(key);
     if (it == streams.end()) return false;
     entry_t *entry = it->second;
@@ -32,6 +37,7 @@ bool stream_cache2_t::serve(int64_t key, Response *res, signal_t *interruptor) {
         // the time we reach here, so we just reset it to a good one.
         entry->env->interruptor = interruptor;
 
+        profile_span_t span(entry->env->get_profile(), "batch");
         int chunk_size = 0;
         if (entry->next_datum.has()) {
             *res->add_response() = *entry->next_datum.get();
@@ -50,10 +56,18 @@ bool stream_cache2_t::serve(int64_t key, Response *res, signal_t *interruptor) {
                 break;
             }
         }
+        entry->env->count_rows_returned(chunk_size);
     } catch (const std::exception &e) {
+        stats_out->add(entry->env->take_stats());
         erase(key);
         throw;
     }
+    // Each response carries the stats and profile of the work done since the
+    // last one.
+    stats_out->add(entry->env->take_stats());
+    if (profile_t *profile = entry->env->get_profile()) {
+        profile->take_spans()->write_to_protobuf(res->mutable_profile());
+    }
     if (!entry->next_datum.has()) {
         erase(key);
         res->set_type(Response::SUCCESS_SEQUENCE);
@@ -17,6 +17,7 @@
 
 namespace ql {
 class env_t;
+struct query_stats_t;
 }
 
 namespace ql {
@@ -25,10 +26,13 @@ class stream_cache2_t {
 public:
     stream_cache2_t() { }
     MUST_USE bool contains(int64_t key);
+    MUST_USE bool empty() const;
     void insert(int64_t key,
                 scoped_ptr_t<env_t> *val_env, counted_t<datum_stream_t> val_stream);
     void erase(int64_t key);
-    MUST_USE bool serve(int64_t key, Response *res, signal_t *interruptor);
+    // Adds the stats of the work done for the response to `*stats_out`.
+    MUST_USE bool serve(int64_t key, Response *res, signal_t *interruptor,
+                        query_stats_t *stats_out);
 private:
     void maybe_evict();
 
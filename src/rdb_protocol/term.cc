@@ -113,7 +113,7 @@ counted_t<term_t> compile_term(env_t *env, protob_t<const Term> t) {
 
 void run(protob_t<Query> q, scoped_ptr_t<env_t> *env_ptr,
          Response *res, stream_cache2_t *stream_cache2,
-         bool *response_needed_out) {
+         bool *response_needed_out, query_stats_t *stats_out) {
     try {
         validate_pb(*q);
     } catch (const base_exc_t &e) {
@@ -161,6 +161,13 @@ void run(protob_t<Query> q, scoped_ptr_t<env_t> *env_ptr,
                 }
             }
 
+            // The `profile` optarg asks for a profile of the query's execution
+            // to be sent back with the result.
+            counted_t<val_t> profile = env->get_optarg("profile");
+            if (profile.has() && profile->as_bool()) {
+                env->start_profile();
+            }
+
             protob_t<Term> ewt = make_counted_term();
             Term *const arg = ewt.get();
 
@@ -208,9 +215,13 @@ void run(protob_t<Query> q, scoped_ptr_t<env_t> *env_ptr,
                 res->set_type(Response_ResponseType_SUCCESS_ATOM);
                 counted_t<const datum_t> d = val->as_datum();
                 d->write_to_protobuf(res->add_response());
+                env->count_rows_returned(1);
+                if (profile_t *profile = env->get_profile()) {
+                    profile->take_spans()->write_to_protobuf(res->mutable_profile());
+                }
             } else if (val->get_type().is_convertible(val_t::type_t::SEQUENCE)) {
                 stream_cache2->insert(token, env_ptr, val->as_seq());
-                bool b = stream_cache2->serve(token, res, env->interruptor);
+                bool b = stream_cache2->serve(token, res, env->interruptor, stats_out);
                 r_sanity_check(b);
             } else {
                 rfail_toplevel(base_exc_t::GENERIC,
@@ -228,7 +239,7 @@ void run(protob_t<Query> q, scoped_ptr_t<env_t> *env_ptr,
     } break;
     case Query_QueryType_CONTINUE: {
         try {
-            bool b = stream_cache2->serve(token, res, env->interruptor);
+            bool b = stream_cache2->serve(token, res, env->interruptor, stats_out);
             rcheck_toplevel(b, base_exc_t::GENERIC,
                             strprintf("Token %" PRIi64 " not in stream cache.", token));
         } catch (const exc_t &e) {
@@ -294,6 +305,7 @@ counted_t<val_t> term_t::eval() {
     DEBUG_ONLY_CODE(env->do_eval_callback());
     DBG("EVALUATING %s (%d):\n", name(), is_deterministic());
     env->throw_if_interruptor_pulsed();
+    profile_span_t span(env->get_profile(), name());
     INC_DEPTH;
 
     try {
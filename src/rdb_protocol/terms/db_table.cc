@@ -166,7 +166,8 @@ public:
     table_create_term_t(env_t *env, protob_t<const Term> term) :
         meta_write_op_t(env, term, argspec_t(1, 2),
                         optargspec_t({"datacenter", "primary_key",
-                                    "cache_size", "durability"})) { }
+                                    "cache_size", "durability",
+                                    "cpu_sharding_factor"})) { }
 private:
     virtual std::string write_eval_impl() {
         uuid_u dc_id = nil_uuid();
@@ -194,6 +195,15 @@ private:
             cache_size = v->as_int<int>();
         }
 
+        int cpu_sharding_factor = DEFAULT_CPU_SHARDING_FACTOR;
+        if (counted_t<val_t> v = optarg("cpu_sharding_factor")) {
+            cpu_sharding_factor = v->as_int<int>();
+            rcheck(cpu_sharding_factor >= 1 && cpu_sharding_factor <= MAX_CPU_SHARDING_FACTOR,
+                   base_exc_t::GENERIC,
+                   strprintf("`cpu_sharding_factor` must be between 1 and %d.",
+                             MAX_CPU_SHARDING_FACTOR));
+        }
+
         uuid_u db_id;
         name_string_t tbl_name;
         if (num_args() == 1) {
@@ -221,7 +231,7 @@ private:
         namespace_semilattice_metadata_t<rdb_protocol_t> ns =
             new_namespace<rdb_protocol_t>(env->this_machine, db_id, dc_id, tbl_name,
                                           primary_key, port_defaults::reql_port,
-                                          cache_size);
+                                          cache_size, cpu_sharding_factor);
 
         // Set Durability
         std::map<datacenter_id_t, ack_expectation_t> *ack_map =
@@ -32,6 +32,7 @@ private:
         config.timeout_ms = timeout_s * 1000;
 
         try {
+            env->count_js_call();
             js::js_result_t result = js->eval(source, &config);
             return boost::apply_visitor(js_result_visitor_t(env,
                                                             this->counted_from_this()),
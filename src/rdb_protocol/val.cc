@@ -376,6 +376,7 @@ counted_t<const datum_t> table_t::get_row(counted_t<const datum_t> pval) {
     std::string pks = pval->print_primary();
     rdb_protocol_t::read_t read((rdb_protocol_t::point_read_t(store_key_t(pks))));
     rdb_protocol_t::read_response_t res;
+    profile_span_t span(env->get_profile(), "read_point");
     if (use_outdated) {
         access->get_namespace_if()->read_outdated(read, &res, env->interruptor);
     } else {
@@ -385,7 +386,10 @@ counted_t<const datum_t> table_t::get_row(counted_t<const datum_t> pval) {
     rdb_protocol_t::point_read_response_t *p_res =
         boost::get<rdb_protocol_t::point_read_response_t>(&res.response);
     r_sanity_check(p_res);
-    return make_counted<datum_t>(p_res->data, env);
+    counted_t<const datum_t> row = make_counted<datum_t>(p_res->data, env);
+    // A get that misses comes back as null, which isn't a row read.
+    env->count_read(res.stats, row->get_type() == datum_t::R_NULL ? 0 : 1);
+    return row;
 }
 
 counted_t<datum_stream_t> table_t::get_rows(counted_t<const datum_t> left_bound,
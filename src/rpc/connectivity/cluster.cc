@@ -7,10 +7,12 @@
 #include "arch/io/network.hpp"
 #include "arch/timing.hpp"
 
+#include "concurrency/contention.hpp"
 #include "concurrency/cross_thread_signal.hpp"
 #include "concurrency/pmap.hpp"
 #include "concurrency/semaphore.hpp"
 #include "containers/archive/vector_stream.hpp"
+#include "containers/lz_compress.hpp"
 #include "containers/object_buffer.hpp"
 #include "containers/uuid.hpp"
 #include "logger.hpp"
@@ -50,10 +52,12 @@ connectivity_cluster_t::run_t::run_t(connectivity_cluster_t *p,
                                      int port,
                                      message_handler_t *mh,
                                      int client_port,
-                                     heartbeat_manager_t *_heartbeat_manager) THROWS_ONLY(address_in_use_exc_t) :
+                                     heartbeat_manager_t *_heartbeat_manager,
+                                     bool _offer_compression) THROWS_ONLY(address_in_use_exc_t) :
     parent(p),
     message_handler(mh),
     heartbeat_manager(_heartbeat_manager),
+    offer_compression(_offer_compression),
 
     /* Create the socket to use when listening for connections from peers */
     cluster_listener_socket(new tcp_bound_socket_t(local_addresses, port)),
@@ -83,7 +87,7 @@ connectivity_cluster_t::run_t::run_t(connectivity_cluster_t *p,
     `connection_map` on each thread and notifying any listeners that we're now
     connected to ourself. The destructor will remove us from the
     `connection_map` and again notify any listeners. */
-    connection_to_ourself(this, parent->me, NULL, routing_table[parent->me]),
+    connection_to_ourself(this, parent->me, NULL, routing_table[parent->me], false),
 
     listener(new tcp_listener_t(cluster_listener_socket.get(),
                                 boost::bind(&connectivity_cluster_t::run_t::on_new_connection,
@@ -109,8 +113,11 @@ void connectivity_cluster_t::run_t::join(peer_address_t address) THROWS_NOTHING
         auto_drainer_t::lock_t(&drainer)));
 }
 
-connectivity_cluster_t::run_t::connection_entry_t::connection_entry_t(run_t *p, peer_id_t id, tcp_conn_stream_t *c, peer_address_t a) THROWS_NOTHING :
-    conn(c), address(a), session_id(generate_uuid()),
+// Contention profiler site for the connections' `send_mutex`es
+static contention_site_t send_mutex_contention_site("cluster connection send");
+
+connectivity_cluster_t::run_t::connection_entry_t::connection_entry_t(run_t *p, peer_id_t id, tcp_conn_stream_t *c, peer_address_t a, bool _compress) THROWS_NOTHING :
+    conn(c), address(a), send_mutex(&send_mutex_contention_site), compress(_compress), session_id(generate_uuid()),
     pm_collection(),
     pm_bytes_sent(secs_to_ticks(1), true),
     pm_collection_membership(&p->parent->connectivity_collection, &pm_collection, uuid_to_str(id.get_uuid())),
@@ -404,13 +411,17 @@ void connectivity_cluster_t::run_t::handle(
     conn_closer_1.reset(drainer_lock.get_drain_signal());
 
     // Each side sends a header followed by its own ID and address, then receives and checks the
-    // other side's.
+    // other side's. The compression flag is always sent, even without --cluster-compression, so
+    // this handshake differs from older versions'; that's fine only because the version check
+    // below requires an exact RETHINKDB_CODE_VERSION match, so nodes of different versions never
+    // get as far as reading it.
     {
         write_message_t msg;
         msg.append(cluster_proto_header.c_str(), cluster_proto_header.length());
         msg << cluster_version;
         msg << cluster_arch_bitsize;
         msg << cluster_build_mode;
+        msg << offer_compression;
         msg << parent->me;
         msg << routing_table[parent->me];
         if (send_write_message(conn, &msg))
@@ -467,10 +478,12 @@ void connectivity_cluster_t::run_t::handle(
         }
     }
 
-    // Receive id, address.
+    // Receive whether the other side wants compression, id, address.
+    bool remote_offers_compression;
     peer_id_t other_id;
     peer_address_t other_address;
-    if (deserialize_and_check(conn, &other_id, peername) ||
+    if (deserialize_and_check(conn, &remote_offers_compression, peername) ||
+        deserialize_and_check(conn, &other_id, peername) ||
         deserialize_and_check(conn, &other_address, peername))
         return;
 
@@ -670,7 +683,8 @@ void connectivity_cluster_t::run_t::handle(
         /* `connection_entry_t` is the public interface of this coroutine. Its
         constructor registers it in the `connectivity_cluster_t`'s connection
         map and notifies any connect listeners. */
-        connection_entry_t conn_structure(this, other_id, conn, other_address);
+        connection_entry_t conn_structure(this, other_id, conn, other_address,
+                                          offer_compression && remote_offers_compression);
         object_buffer_t<heartbeat_keepalive_t> keepalive;
 
         if (heartbeat_manager != NULL) {
@@ -682,6 +696,16 @@ void connectivity_cluster_t::run_t::handle(
         shutting down, or us shutting down. */
         try {
             while (true) {
+                cluster_message_format_t format = CLUSTER_MESSAGE_UNCOMPRESSED;
+                uint64_t uncompressed_size = 0;
+                if (conn_structure.compress) {
+                    if (deserialize_and_check(conn, &format, peername))
+                        break;
+                    if (format == CLUSTER_MESSAGE_COMPRESSED &&
+                        deserialize_and_check(conn, &uncompressed_size, peername))
+                        break;
+                }
+
                 /* For now, we use `std::string` for messages on the wire: it's
                 just a length and a byte vector. This is obviously slow and we
                 should change it when we care about performance. */
@@ -689,7 +713,17 @@ void connectivity_cluster_t::run_t::handle(
                 if (deserialize_and_check(conn, &message, peername))
                     break;
 
-                std::vector<char> vec(message.begin(), message.end());
+                std::vector<char> vec;
+                if (format == CLUSTER_MESSAGE_COMPRESSED) {
+                    block_pm_duration decompression_timer(&parent->pm_decompression_time);
+                    if (!lz_decompress(message.data(), message.size(), uncompressed_size, &vec)) {
+                        logERR("received a corrupt compressed message from %s, closing connection", peername);
+                        conn->shutdown_read();
+                        break;
+                    }
+                } else {
+                    vec.assign(message.begin(), message.end());
+                }
                 vector_read_stream_t stream(&vec);
                 message_handler->on_message(other_id, &stream); // might raise fake_archive_exc_t
             }
@@ -713,7 +747,18 @@ connectivity_cluster_t::connectivity_cluster_t() THROWS_NOTHING :
     me(peer_id_t(generate_uuid())),
     current_run(NULL),
     connectivity_collection(),
-    stats_membership(&get_global_perfmon_collection(), &connectivity_collection, "connectivity")
+    stats_membership(&get_global_perfmon_collection(), &connectivity_collection, "connectivity"),
+    pm_compression_ratio(secs_to_ticks(1), false),
+    pm_compression_time(secs_to_ticks(1), true),
+    pm_decompression_time(secs_to_ticks(1), true),
+    compression_collection_membership(&connectivity_collection, &compression_collection, "compression"),
+    compression_stats_membership(&compression_collection,
+        &pm_compression_bytes_in, "bytes_in",
+        &pm_compression_bytes_out, "bytes_out",
+        &pm_compression_ratio, "ratio",
+        &pm_compression_time, "compression_time",
+        &pm_decompression_time, "decompression_time",
+        NULL)
     { }
 
 connectivity_cluster_t::~connectivity_cluster_t() THROWS_NOTHING {
@@ -826,10 +871,32 @@ void connectivity_cluster_t::send_message(peer_id_t dest, send_message_write_cal
 
         {
             write_message_t msg;
-            std::string buffer_str(buffer.vector().begin(), buffer.vector().end());
-            msg << buffer_str;
+            std::vector<char> compressed;
+            bool use_compressed = false;
+            if (conn_structure->compress) {
+                block_pm_duration compression_timer(&pm_compression_time);
+                use_compressed = conn_structure->compressor.compress(buffer.vector(), &compressed);
+                msg << (use_compressed ? CLUSTER_MESSAGE_COMPRESSED : CLUSTER_MESSAGE_UNCOMPRESSED);
+            }
+
+            size_t size_on_wire;
+            if (use_compressed) {
+                uint64_t uncompressed_size = buffer.vector().size();
+                msg << uncompressed_size;
+                std::string compressed_str(compressed.begin(), compressed.end());
+                msg << compressed_str;
+                size_on_wire = compressed.size();
+
+                pm_compression_bytes_in += uncompressed_size;
+                pm_compression_bytes_out += compressed.size();
+                pm_compression_ratio.record(static_cast<double>(compressed.size()) / uncompressed_size);
+            } else {
+                std::string buffer_str(buffer.vector().begin(), buffer.vector().end());
+                msg << buffer_str;
+                size_on_wire = buffer.vector().size();
+            }
             int res = send_write_message(conn_structure->conn, &msg);
-            conn_structure->pm_bytes_sent.record(buffer.vector().size());
+            conn_structure->pm_bytes_sent.record(size_on_wire);
             if (res) {
                 /* Close the other half of the connection to make sure that
                    `connectivity_cluster_t::run_t::handle()` notices that something is
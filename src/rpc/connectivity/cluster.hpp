@@ -15,6 +15,7 @@
 #include "containers/archive/tcp_conn_stream.hpp"
 #include "containers/map_sentries.hpp"
 #include "perfmon/perfmon.hpp"
+#include "rpc/connectivity/compression.hpp"
 #include "rpc/connectivity/connectivity.hpp"
 #include "rpc/connectivity/messages.hpp"
 #include "rpc/connectivity/heartbeat.hpp"
@@ -107,7 +108,8 @@ public:
               int port,
               message_handler_t *message_handler,
               int client_port,
-              heartbeat_manager_t *_heartbeat_manager) THROWS_ONLY(address_in_use_exc_t);
+              heartbeat_manager_t *_heartbeat_manager,
+              bool _offer_compression = false) THROWS_ONLY(address_in_use_exc_t);
 
         ~run_t();
 
@@ -124,7 +126,7 @@ public:
         public:
             /* The constructor registers us in every thread's `connection_map`;
             the destructor deregisters us. Both also notify all subscribers. */
-            connection_entry_t(run_t *, peer_id_t, tcp_conn_stream_t *, peer_address_t) THROWS_NOTHING;
+            connection_entry_t(run_t *, peer_id_t, tcp_conn_stream_t *, peer_address_t, bool compress) THROWS_NOTHING;
             ~connection_entry_t() THROWS_NOTHING;
 
             /* NULL for our "connection" to ourself */
@@ -138,6 +140,13 @@ public:
             /* Unused for our connection to ourself */
             mutex_t send_mutex;
 
+            /* True if both sides offered to use compression during the
+            handshake; then every message on the connection is preceded by a
+            `cluster_message_format_t`. `compressor` is only used on the
+            connection's thread, while holding `send_mutex`. */
+            bool compress;
+            cluster_message_compressor_t compressor;
+
             uuid_u session_id;
 
             perfmon_collection_t pm_collection;
@@ -222,6 +231,10 @@ public:
 
         heartbeat_manager_t *heartbeat_manager;
 
+        /* Whether we offer to compress messages to the peers we connect to.
+        Connections only use compression if both sides offer it. */
+        const bool offer_compression;
+
         /* `attempt_table` is a table of all the host:port pairs we're currently
         trying to connect to or have connected to. If we are told to connect to
         an address already in this table, we'll just ignore it. That's important
@@ -317,6 +330,18 @@ private:
     perfmon_collection_t connectivity_collection;
     perfmon_membership_t stats_membership;
 
+    /* Stats for compressed messages, over all connections. `bytes_in` and
+    `bytes_out` count the messages that we compressed before and after
+    compression, and the ratio is sampled per message. `compression_time` covers
+    every message we send on a connection that uses compression, including the
+    ones we decide not to compress. */
+    perfmon_collection_t compression_collection;
+    perfmon_counter_t pm_compression_bytes_in, pm_compression_bytes_out;
+    perfmon_sampler_t pm_compression_ratio;
+    perfmon_duration_sampler_t pm_compression_time, pm_decompression_time;
+    perfmon_membership_t compression_collection_membership;
+    perfmon_multi_membership_t compression_stats_membership;
+
     DISABLE_COPYING(connectivity_cluster_t);
 };
 
@@ -0,0 +1,30 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "rpc/connectivity/compression.hpp"
+
+#include "config/args.hpp"
+#include "containers/lz_compress.hpp"
+
+cluster_message_compressor_t::cluster_message_compressor_t() {
+    for (int i = 0; i < 256; ++i) {
+        skip_remaining[i] = 0;
+    }
+}
+
+bool cluster_message_compressor_t::compress(const std::vector<char> &message, std::vector<char> *compressed_out) {
+    if (message.size() < CLUSTER_COMPRESSION_MIN_BYTES) {
+        return false;
+    }
+
+    uint8_t type = message[0];
+    if (skip_remaining[type] > 0) {
+        --skip_remaining[type];
+        return false;
+    }
+
+    lz_compress(message.data(), message.size(), compressed_out);
+    if (compressed_out->size() * 100 >= message.size() * CLUSTER_COMPRESSION_MAX_PERCENT) {
+        skip_remaining[type] = CLUSTER_COMPRESSION_BACKOFF_MESSAGES;
+        return false;
+    }
+    return true;
+}
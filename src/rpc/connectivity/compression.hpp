@@ -0,0 +1,45 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_CONNECTIVITY_COMPRESSION_HPP_
+#define RPC_CONNECTIVITY_COMPRESSION_HPP_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+
+/* On a cluster connection where both sides agreed to use compression during
+the handshake, every message is preceded by one of these. */
+enum cluster_message_format_t {
+    CLUSTER_MESSAGE_UNCOMPRESSED = 0,
+
+    /* The message is followed by its uncompressed size, and was compressed
+    with `lz_compress()` */
+    CLUSTER_MESSAGE_COMPRESSED = 1
+};
+
+ARCHIVE_PRIM_MAKE_RANGED_SERIALIZABLE(cluster_message_format_t, int8_t, CLUSTER_MESSAGE_UNCOMPRESSED, CLUSTER_MESSAGE_COMPRESSED);
+
+/* `cluster_message_compressor_t` decides which messages on one connection are
+worth compressing. Small messages never are. For the others it keeps track, by
+message type, of whether compression has been paying off lately, and stops
+trying for a while for types that don't compress (see
+`CLUSTER_COMPRESSION_MAX_PERCENT`). The type of a message is its first byte,
+which is the tag of the `message_multiplexer_t` client that sent it. */
+class cluster_message_compressor_t {
+public:
+    cluster_message_compressor_t();
+
+    /* Returns true and puts the compressed message in `compressed_out` if the
+    message should be sent compressed. */
+    bool compress(const std::vector<char> &message, std::vector<char> *compressed_out);
+
+private:
+    /* How many more messages of each type to send without trying to compress
+    them */
+    int skip_remaining[256];
+
+    DISABLE_COPYING(cluster_message_compressor_t);
+};
+
+#endif  // RPC_CONNECTIVITY_COMPRESSION_HPP_
@@ -0,0 +1,161 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_DIRECTORY_DIFF_HPP_
+#define RPC_DIRECTORY_DIFF_HPP_
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "containers/archive/archive.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "containers/cow_ptr.hpp"
+#include "containers/uuid.hpp"
+#include "rpc/connectivity/connectivity.hpp"
+
+/* Directory values are replaced rather than joined, so a peer that has an old
+value needs to be told what changed and what it changed to.
+`serialize_directory_diff(msg, old_value, new_value)` writes such a diff, and
+`deserialize_directory_diff(s, &value)` reads one and applies it to `value`,
+which must be equal to the `old_value` the diff was computed from.
+
+By default a diff is a flag saying whether the value changed at all, followed by
+the new value if it did. Diffs of `std::map`s only hold the entries that were
+added, changed, or removed, and structs can diff field by field by defining
+their own overloads in terms of their fields' diffs.
+
+`directory_value_unchanged()` decides whether something changed. By default it
+compares the serialized values. Types whose `operator==` compares everything
+they serialize get overloads that use it instead; `std::vector`s compare element
+by element; and `cow_ptr_t`s that share their value are known to be unchanged
+without looking at the value. */
+
+template <class T>
+bool directory_value_unchanged(const T &old_value, const T &new_value) {
+    write_message_t old_msg, new_msg;
+    old_msg << old_value;
+    new_msg << new_value;
+    if (old_msg.size() != new_msg.size()) {
+        return false;
+    }
+    vector_stream_t old_stream, new_stream;
+    int res = send_write_message(&old_stream, &old_msg);
+    guarantee(res == 0);
+    res = send_write_message(&new_stream, &new_msg);
+    guarantee(res == 0);
+    return old_stream.vector() == new_stream.vector();
+}
+
+inline bool directory_value_unchanged(const std::string &old_value, const std::string &new_value) {
+    return old_value == new_value;
+}
+
+inline bool directory_value_unchanged(const uuid_u &old_value, const uuid_u &new_value) {
+    return old_value == new_value;
+}
+
+inline bool directory_value_unchanged(const peer_id_t &old_value, const peer_id_t &new_value) {
+    return old_value == new_value;
+}
+
+template <class T>
+bool directory_value_unchanged(const std::vector<T> &old_value, const std::vector<T> &new_value) {
+    if (old_value.size() != new_value.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < old_value.size(); ++i) {
+        if (!directory_value_unchanged(old_value[i], new_value[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+template <class T>
+bool directory_value_unchanged(const cow_ptr_t<T> &old_value, const cow_ptr_t<T> &new_value) {
+    return old_value.get() == new_value.get() ||
+        directory_value_unchanged(*old_value.get(), *new_value.get());
+}
+
+template <class T>
+void serialize_directory_diff(write_message_t *msg, const T &old_value, const T &new_value) {
+    bool changed = !directory_value_unchanged(old_value, new_value);
+    *msg << changed;
+    if (changed) {
+        *msg << new_value;
+    }
+}
+
+template <class T>
+MUST_USE archive_result_t deserialize_directory_diff(read_stream_t *s, T *value) {
+    bool changed;
+    archive_result_t res = deserialize(s, &changed);
+    if (res) { return res; }
+    if (changed) {
+        T new_value;
+        res = deserialize(s, &new_value);
+        if (res) { return res; }
+        *value = new_value;
+    }
+    return ARCHIVE_SUCCESS;
+}
+
+namespace std {
+
+/* The `std::map` versions go in `namespace std` so that argument-dependent
+lookup finds them from inside other templates. */
+
+template <class K, class V>
+void serialize_directory_diff(write_message_t *msg, const std::map<K, V> &old_value, const std::map<K, V> &new_value) {
+    std::vector<typename std::map<K, V>::const_iterator> changed;
+    std::vector<K> removed;
+    typename std::map<K, V>::const_iterator old_it = old_value.begin(), new_it = new_value.begin();
+    while (old_it != old_value.end() || new_it != new_value.end()) {
+        if (new_it == new_value.end() ||
+                (old_it != old_value.end() && old_value.key_comp()(old_it->first, new_it->first))) {
+            removed.push_back(old_it->first);
+            ++old_it;
+        } else if (old_it == old_value.end() || old_value.key_comp()(new_it->first, old_it->first)) {
+            changed.push_back(new_it);
+            ++new_it;
+        } else {
+            if (!directory_value_unchanged(old_it->second, new_it->second)) {
+                changed.push_back(new_it);
+            }
+            ++old_it;
+            ++new_it;
+        }
+    }
+
+    uint64_t num_changed = changed.size();
+    *msg << num_changed;
+    for (size_t i = 0; i < changed.size(); ++i) {
+        *msg << *changed[i];
+    }
+    *msg << removed;
+}
+
+template <class K, class V>
+MUST_USE archive_result_t deserialize_directory_diff(read_stream_t *s, std::map<K, V> *value) {
+    uint64_t num_changed;
+    archive_result_t res = deserialize(s, &num_changed);
+    if (res) { return res; }
+    for (uint64_t i = 0; i < num_changed; ++i) {
+        std::pair<K, V> entry;
+        res = deserialize(s, &entry);
+        if (res) { return res; }
+        (*value)[entry.first] = entry.second;
+    }
+
+    std::vector<K> removed;
+    res = deserialize(s, &removed);
+    if (res) { return res; }
+    for (size_t i = 0; i < removed.size(); ++i) {
+        value->erase(removed[i]);
+    }
+    return ARCHIVE_SUCCESS;
+}
+
+}   /* namespace std */
+
+#endif /* RPC_DIRECTORY_DIFF_HPP_ */
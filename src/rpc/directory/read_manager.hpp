@@ -3,6 +3,7 @@
 #define RPC_DIRECTORY_READ_MANAGER_HPP_
 
 #include <map>
+#include <vector>
 
 #include "errors.hpp"
 #include <boost/ptr_container/ptr_map.hpp>
@@ -55,7 +56,7 @@ private:
 
     /* These are meant to be spawned in new coroutines */
     void propagate_initialization(peer_id_t peer, uuid_u session_id, metadata_t new_value, fifo_enforcer_state_t metadata_fifo_state, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING;
-    void propagate_update(peer_id_t peer, uuid_u session_id, metadata_t new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING;
+    void propagate_update(peer_id_t peer, uuid_u session_id, const std::vector<char> &diff, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING;
     void interrupt_updates_and_free_session(session_t *session, auto_drainer_t::lock_t global_keepalive) THROWS_NOTHING;
 
     /* The connectivity service telling us which peers are connected */
@@ -6,9 +6,12 @@
 
 #include <map>
 #include <utility>
+#include <vector>
 
 #include "concurrency/wait_any.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/archive/vector_stream.hpp"
+#include "rpc/directory/diff.hpp"
 
 template<class metadata_t>
 directory_read_manager_t<metadata_t>::directory_read_manager_t(connectivity_service_t *conn_serv) THROWS_NOTHING :
@@ -64,11 +67,12 @@ void directory_read_manager_t<metadata_t>::on_message(peer_id_t source_peer, rea
         }
 
         case 'U': {
-            /* Update from another peer */
-            metadata_t new_value = metadata_t();
+            /* Update from another peer. It's a diff against the peer's previous
+            value, so we can't apply it until we're in FIFO order. */
+            std::vector<char> diff;
             fifo_enforcer_write_token_t metadata_fifo_token;
             {
-                int res = deserialize(s, &new_value);
+                int res = deserialize(s, &diff);
                 guarantee(!res);  // In the spirit of unreachable...
                 res = deserialize(s, &metadata_fifo_token);
                 guarantee(!res);  // In the spirit of unreachable...
@@ -81,7 +85,7 @@ void directory_read_manager_t<metadata_t>::on_message(peer_id_t source_peer, rea
             coro_t::spawn_sometime(boost::bind(
                 &directory_read_manager_t::propagate_update, this,
                 source_peer, connectivity_service->get_connection_session_id(source_peer),
-                new_value, metadata_fifo_token,
+                diff, metadata_fifo_token,
                 auto_drainer_t::lock_t(per_thread_drainers.get())));
 
             break;
@@ -164,7 +168,7 @@ void directory_read_manager_t<metadata_t>::propagate_initialization(peer_id_t pe
 }
 
 template<class metadata_t>
-void directory_read_manager_t<metadata_t>::propagate_update(peer_id_t peer, uuid_u session_id, metadata_t new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING {
+void directory_read_manager_t<metadata_t>::propagate_update(peer_id_t peer, uuid_u session_id, const std::vector<char> &diff, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t per_thread_keepalive) THROWS_NOTHING {
     per_thread_keepalive.assert_is_holding(per_thread_drainers.get());
     on_thread_t thread_switcher(home_thread());
 
@@ -209,7 +213,9 @@ void directory_read_manager_t<metadata_t>::propagate_update(peer_id_t peer, uuid
                 //The session was deleted we can ignore this update.
                 return;
             }
-            var_it->second = new_value;
+            vector_read_stream_t diff_stream(&diff);
+            int res = deserialize_directory_diff(&diff_stream, &var_it->second);
+            guarantee(!res);
             variable.set_value(map);
         }
     } catch (const interrupted_exc_t &) {
@@ -2,13 +2,25 @@
 #ifndef RPC_DIRECTORY_WRITE_MANAGER_HPP_
 #define RPC_DIRECTORY_WRITE_MANAGER_HPP_
 
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/shared_ptr.hpp>
+
 #include "concurrency/auto_drainer.hpp"
 #include "concurrency/fifo_enforcer.hpp"
 #include "concurrency/watchable.hpp"
+#include "perfmon/perfmon.hpp"
 #include "rpc/connectivity/connectivity.hpp"
 
 class message_service_t;
 
+/* `directory_write_manager_t` sends our directory value to every connected
+peer. A newly connected peer gets the whole value; after that, peers only get
+diffs (see "rpc/directory/diff.hpp") against the last value we sent. Changes
+that happen in quick succession are coalesced into a single update (see
+`DIRECTORY_UPDATE_COALESCE_MS`). */
+
 template<class metadata_t>
 class directory_write_manager_t : private peers_list_callback_t {
 public:
@@ -17,19 +29,38 @@ public:
         const clone_ptr_t<watchable_t<metadata_t> > &value) THROWS_NOTHING;
     ~directory_write_manager_t();
 
+    /* Counts and sizes of the messages sent to other peers, for adding to a
+    stats collection. */
+    perfmon_collection_t *get_stats();
+
 private:
     void on_connect(peer_id_t peer) THROWS_NOTHING;
     void on_disconnect(UNUSED peer_id_t p) { }
     void on_change() THROWS_NOTHING;
 
+    void send_update_later(auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
+    void send_update_to_peers() THROWS_NOTHING;
+
     void send_initialization(peer_id_t peer, const metadata_t &initial_value, fifo_enforcer_state_t metadata_fifo_state, auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
-    void send_update(peer_id_t peer, const metadata_t &new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
+    void send_update(peer_id_t peer, const boost::shared_ptr<std::vector<char> > &diff, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t keepalive) THROWS_NOTHING;
 
     class initialization_writer_t;
     class update_writer_t;
 
     message_service_t *const message_service;
     clone_ptr_t<watchable_t<metadata_t> > value_watchable;
+
+    /* The value as of the last update we sent. Newly connected peers get this
+    rather than the current value, so that the next diff applies to it. */
+    metadata_t last_sent_value;
+    ticks_t last_update_time;
+    bool update_pending;
+
+    perfmon_collection_t stats;
+    perfmon_counter_t changes, updates_sent, update_bytes_sent;
+    perfmon_counter_t initializations_sent, initialization_bytes_sent;
+    perfmon_multi_membership_t stats_membership;
+
     fifo_enforcer_source_t metadata_fifo_source;
     auto_drainer_t drainer;
     typename watchable_t<metadata_t>::subscription_t value_subscription;
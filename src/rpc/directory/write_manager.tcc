@@ -5,8 +5,12 @@
 #include "rpc/directory/write_manager.hpp"
 
 #include <set>
+#include <vector>
 
+#include "arch/timing.hpp"
+#include "containers/archive/vector_stream.hpp"
 #include "rpc/connectivity/messages.hpp"
+#include "rpc/directory/diff.hpp"
 
 template<class metadata_t>
 directory_write_manager_t<metadata_t>::directory_write_manager_t(
@@ -14,11 +18,21 @@ directory_write_manager_t<metadata_t>::directory_write_manager_t(
         const clone_ptr_t<watchable_t<metadata_t> > &value) THROWS_NOTHING :
     message_service(sub),
     value_watchable(value),
+    last_update_time(0),
+    update_pending(false),
+    stats_membership(&stats,
+        &changes, "changes",
+        &updates_sent, "updates_sent",
+        &update_bytes_sent, "update_bytes_sent",
+        &initializations_sent, "initializations_sent",
+        &initialization_bytes_sent, "initialization_bytes_sent",
+        NULL),
     value_subscription(boost::bind(&directory_write_manager_t::on_change, this)),
     connectivity_subscription(this) {
     typename watchable_t<metadata_t>::freeze_t value_freeze(value_watchable);
     connectivity_service_t::peers_list_freeze_t connectivity_freeze(message_service->get_connectivity_service());
     guarantee(message_service->get_connectivity_service()->get_peers_list().empty());
+    last_sent_value = value_watchable->get();
     value_subscription.reset(value_watchable, &value_freeze);
     connectivity_subscription.reset(message_service->get_connectivity_service(), &connectivity_freeze);
 }
@@ -26,30 +40,81 @@ directory_write_manager_t<metadata_t>::directory_write_manager_t(
 template<class metadata_t>
 directory_write_manager_t<metadata_t>::~directory_write_manager_t() { }
 
+template<class metadata_t>
+perfmon_collection_t *directory_write_manager_t<metadata_t>::get_stats() {
+    return &stats;
+}
+
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::on_connect(peer_id_t peer) THROWS_NOTHING {
-    typename watchable_t<metadata_t>::freeze_t freeze(value_watchable);
+    /* `send_update_to_peers()` holds a `peers_list_freeze_t` while it changes
+    `last_sent_value` and enters the FIFO, so the peer gets exactly the updates
+    that come after this value. */
     coro_t::spawn_sometime(boost::bind(
         &directory_write_manager_t::send_initialization, this,
         peer,
-        value_watchable->get(), metadata_fifo_source.get_state(),
+        last_sent_value, metadata_fifo_source.get_state(),
         auto_drainer_t::lock_t(&drainer)));
 }
 
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::on_change() THROWS_NOTHING {
-    /* Acquire this lock to avoid the case where a new peer copies the metadata
-    value after we change it but also gets an update sent. (That would lead to a
-    crash on the receiving end because the receiving FIFO would get a duplicate
-    update.) */
+    ++changes;
+    if (!update_pending) {
+        update_pending = true;
+        coro_t::spawn_sometime(boost::bind(
+            &directory_write_manager_t::send_update_later, this,
+            auto_drainer_t::lock_t(&drainer)));
+    }
+}
+
+template<class metadata_t>
+void directory_write_manager_t<metadata_t>::send_update_later(auto_drainer_t::lock_t keepalive) THROWS_NOTHING {
+    /* Even without waiting, changes made before this coroutine got to run all
+    go out together. */
+    const ticks_t coalesce_ticks = DIRECTORY_UPDATE_COALESCE_MS * MILLION;
+    const ticks_t now = get_ticks();
+    try {
+        if (now < last_update_time + coalesce_ticks) {
+            nap((last_update_time + coalesce_ticks - now + MILLION - 1) / MILLION,
+                keepalive.get_drain_signal());
+        } else if (keepalive.get_drain_signal()->is_pulsed()) {
+            throw interrupted_exc_t();
+        }
+    } catch (const interrupted_exc_t &) {
+        /* We're shutting down, so nobody will see the update anyway. */
+        return;
+    }
+    update_pending = false;
+    last_update_time = get_ticks();
+    send_update_to_peers();
+}
+
+template<class metadata_t>
+void directory_write_manager_t<metadata_t>::send_update_to_peers() THROWS_NOTHING {
+    /* Acquire this lock to avoid the case where a new peer copies
+    `last_sent_value` before we change it but also gets this update. (That would
+    lead to a crash on the receiving end because the receiving FIFO would get a
+    duplicate update.) */
     connectivity_service_t::peers_list_freeze_t freeze(message_service->get_connectivity_service());
+    metadata_t new_value = value_watchable->get();
+
+    /* The diff is the same for every peer, so we serialize it only once. */
+    write_message_t diff_msg;
+    serialize_directory_diff(&diff_msg, last_sent_value, new_value);
+    vector_stream_t diff_stream;
+    int res = send_write_message(&diff_stream, &diff_msg);
+    guarantee(res == 0);
+    boost::shared_ptr<std::vector<char> > diff(new std::vector<char>(diff_stream.vector()));
+    last_sent_value = new_value;
+
     fifo_enforcer_write_token_t metadata_fifo_token = metadata_fifo_source.enter_write();
     std::set<peer_id_t> peers = message_service->get_connectivity_service()->get_peers_list();
     for (std::set<peer_id_t>::iterator it = peers.begin(); it != peers.end(); it++) {
         coro_t::spawn_sometime(boost::bind(
             &directory_write_manager_t::send_update, this,
             *it,
-            value_watchable->get(), metadata_fifo_token,
+            diff, metadata_fifo_token,
             auto_drainer_t::lock_t(&drainer)));
     }
 }
@@ -57,8 +122,8 @@ void directory_write_manager_t<metadata_t>::on_change() THROWS_NOTHING {
 template <class metadata_t>
 class directory_write_manager_t<metadata_t>::initialization_writer_t : public send_message_write_callback_t {
 public:
-    initialization_writer_t(const metadata_t &_initial_value, fifo_enforcer_state_t _metadata_fifo_state) :
-        initial_value(_initial_value), metadata_fifo_state(_metadata_fifo_state) { }
+    initialization_writer_t(const metadata_t &_initial_value, fifo_enforcer_state_t _metadata_fifo_state, directory_write_manager_t *_parent) :
+        initial_value(_initial_value), metadata_fifo_state(_metadata_fifo_state), parent(_parent) { }
     ~initialization_writer_t() { }
 
     void write(write_stream_t *stream) {
@@ -67,6 +132,8 @@ public:
         msg << code;
         msg << initial_value;
         msg << metadata_fifo_state;
+        ++parent->initializations_sent;
+        parent->initialization_bytes_sent += msg.size();
         int res = send_write_message(stream, &msg);
         if (res) {
             throw fake_archive_exc_t();
@@ -75,40 +142,44 @@ public:
 private:
     const metadata_t &initial_value;
     fifo_enforcer_state_t metadata_fifo_state;
+    directory_write_manager_t *parent;
 };
 
 template <class metadata_t>
 class directory_write_manager_t<metadata_t>::update_writer_t : public send_message_write_callback_t {
 public:
-    update_writer_t(const metadata_t &_new_value, fifo_enforcer_write_token_t _metadata_fifo_token) :
-        new_value(_new_value), metadata_fifo_token(_metadata_fifo_token) { }
+    update_writer_t(const std::vector<char> &_diff, fifo_enforcer_write_token_t _metadata_fifo_token, directory_write_manager_t *_parent) :
+        diff(_diff), metadata_fifo_token(_metadata_fifo_token), parent(_parent) { }
     ~update_writer_t() { }
 
     void write(write_stream_t *stream) {
         write_message_t msg;
         uint8_t code = 'U';
         msg << code;
-        msg << new_value;
+        msg << diff;
         msg << metadata_fifo_token;
+        ++parent->updates_sent;
+        parent->update_bytes_sent += msg.size();
         int res = send_write_message(stream, &msg);
         if (res) {
             throw fake_archive_exc_t();
         }
     }
 private:
-    const metadata_t &new_value;
+    const std::vector<char> &diff;
     fifo_enforcer_write_token_t metadata_fifo_token;
+    directory_write_manager_t *parent;
 };
 
 template<class metadata_t>
 void directory_write_manager_t<metadata_t>::send_initialization(peer_id_t peer, const metadata_t &initial_value, fifo_enforcer_state_t metadata_fifo_state, auto_drainer_t::lock_t) THROWS_NOTHING {
-    initialization_writer_t writer(initial_value, metadata_fifo_state);
+    initialization_writer_t writer(initial_value, metadata_fifo_state, this);
     message_service->send_message(peer, &writer);
 }
 
 template<class metadata_t>
-void directory_write_manager_t<metadata_t>::send_update(peer_id_t peer, const metadata_t &new_value, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t) THROWS_NOTHING {
-    update_writer_t writer(new_value, metadata_fifo_token);
+void directory_write_manager_t<metadata_t>::send_update(peer_id_t peer, const boost::shared_ptr<std::vector<char> > &diff, fifo_enforcer_write_token_t metadata_fifo_token, auto_drainer_t::lock_t) THROWS_NOTHING {
+    update_writer_t writer(*diff, metadata_fifo_token, this);
     message_service->send_message(peer, &writer);
 }
 
@@ -3,6 +3,7 @@
 #define RPC_SEMILATTICE_JOINS_COW_PTR_HPP_
 
 #include "containers/cow_ptr.hpp"
+#include "rpc/semilattice/joins/delta.hpp"
 
 template <class T>
 void semilattice_join(cow_ptr_t<T> *a, const cow_ptr_t<T> &b) {
@@ -10,6 +11,12 @@ void semilattice_join(cow_ptr_t<T> *a, const cow_ptr_t<T> &b) {
     semilattice_join(change.get(), *b);
 }
 
+template <class T>
+void semilattice_delta(const cow_ptr_t<T> &old_value, const cow_ptr_t<T> &new_value, cow_ptr_t<T> *delta_out) {
+    typename cow_ptr_t<T>::change_t change(delta_out);
+    semilattice_delta(*old_value, *new_value, change.get());
+}
+
 template <class T>
 bool operator==(const cow_ptr_t<T> &a, const cow_ptr_t<T> &b) {
     return *a == *b;
@@ -0,0 +1,23 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef RPC_SEMILATTICE_JOINS_DELTA_HPP_
+#define RPC_SEMILATTICE_JOINS_DELTA_HPP_
+
+#include "errors.hpp"
+
+/* `semilattice_delta(old_value, new_value, &delta)` is used when `new_value`
+was obtained by joining something into `old_value`. It fills in `delta`, which
+starts out default-constructed, with a value such that joining `delta` into
+`old_value` gives `new_value` again. `semilattice_manager_t` uses it to send its
+peers only the part of the metadata that a change touched.
+
+By default the delta is the whole new value. Containers define it to hold only
+the entries that changed (see "rpc/semilattice/joins/map.hpp"), and types that
+use `RDB_MAKE_SEMILATTICE_JOINABLE_*()` can get a field-by-field version from
+`RDB_MAKE_SEMILATTICE_DELTA_*()`. */
+
+template <class T>
+void semilattice_delta(UNUSED const T &old_value, const T &new_value, T *delta_out) {
+    *delta_out = new_value;
+}
+
+#endif /* RPC_SEMILATTICE_JOINS_DELTA_HPP_ */
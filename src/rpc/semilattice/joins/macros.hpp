@@ -2,6 +2,8 @@
 #ifndef RPC_SEMILATTICE_JOINS_MACROS_HPP_
 #define RPC_SEMILATTICE_JOINS_MACROS_HPP_
 
+#include "rpc/semilattice/joins/delta.hpp"
+
 /* This file is automatically generated by '../scripts/generate_join_macros.py'.
 Please modify '../scripts/generate_join_macros.py' instead of modifying this file.*/
 
@@ -25,12 +27,19 @@ You can also use this with templated types, but it's pretty hacky:
     };
     template<class T>
     RDB_MAKE_SEMILATTICE_JOINABLE_2(pair_t<T>, a, b)
+
+`RDB_MAKE_SEMILATTICE_DELTA_[n]()` takes the same parameters and defines
+`semilattice_delta()` (see "rpc/semilattice/joins/delta.hpp") field by field.
 */
 
 #define RDB_MAKE_SEMILATTICE_JOINABLE_0(type_t) \
     inline void semilattice_join(UNUSED type_t *_a_, UNUSED const type_t &_b_) { \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_0(type_t) \
+    inline void semilattice_delta(UNUSED const type_t &_old_, UNUSED const type_t &_new_, UNUSED type_t *_delta_) { \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_0(type_t) \
     inline bool operator==(UNUSED const type_t &_a_, UNUSED const type_t &_b_) { \
         return true; \
@@ -42,6 +51,11 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field1, _b_.field1); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_1(type_t, field1) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_1(type_t, field1) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1; \
@@ -54,6 +68,12 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field2, _b_.field2); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_2(type_t, field1, field2) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_2(type_t, field1, field2) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2; \
@@ -67,6 +87,13 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field3, _b_.field3); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_3(type_t, field1, field2, field3) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_3(type_t, field1, field2, field3) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3; \
@@ -81,6 +108,14 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field4, _b_.field4); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_4(type_t, field1, field2, field3, field4) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_4(type_t, field1, field2, field3, field4) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4; \
@@ -96,6 +131,15 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field5, _b_.field5); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_5(type_t, field1, field2, field3, field4, field5) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_5(type_t, field1, field2, field3, field4, field5) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5; \
@@ -112,6 +156,16 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field6, _b_.field6); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_6(type_t, field1, field2, field3, field4, field5, field6) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_6(type_t, field1, field2, field3, field4, field5, field6) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6; \
@@ -129,6 +183,17 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field7, _b_.field7); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_7(type_t, field1, field2, field3, field4, field5, field6, field7) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_7(type_t, field1, field2, field3, field4, field5, field6, field7) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7; \
@@ -147,6 +212,18 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field8, _b_.field8); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_8(type_t, field1, field2, field3, field4, field5, field6, field7, field8) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_8(type_t, field1, field2, field3, field4, field5, field6, field7, field8) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8; \
@@ -166,6 +243,19 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field9, _b_.field9); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_9(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_9(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9; \
@@ -186,6 +276,20 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field10, _b_.field10); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_10(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_10(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10; \
@@ -207,6 +311,21 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field11, _b_.field11); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_11(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_11(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11; \
@@ -229,6 +348,22 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field12, _b_.field12); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_12(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_12(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12; \
@@ -252,6 +387,23 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field13, _b_.field13); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_13(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_13(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13; \
@@ -276,6 +428,24 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field14, _b_.field14); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_14(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+        semilattice_delta(_old_.field14, _new_.field14, &_delta_->field14); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_14(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14; \
@@ -301,6 +471,25 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field15, _b_.field15); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_15(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+        semilattice_delta(_old_.field14, _new_.field14, &_delta_->field14); \
+        semilattice_delta(_old_.field15, _new_.field15, &_delta_->field15); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_15(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15; \
@@ -327,6 +516,26 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field16, _b_.field16); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_16(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+        semilattice_delta(_old_.field14, _new_.field14, &_delta_->field14); \
+        semilattice_delta(_old_.field15, _new_.field15, &_delta_->field15); \
+        semilattice_delta(_old_.field16, _new_.field16, &_delta_->field16); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_16(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16; \
@@ -354,6 +563,27 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field17, _b_.field17); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_17(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+        semilattice_delta(_old_.field14, _new_.field14, &_delta_->field14); \
+        semilattice_delta(_old_.field15, _new_.field15, &_delta_->field15); \
+        semilattice_delta(_old_.field16, _new_.field16, &_delta_->field16); \
+        semilattice_delta(_old_.field17, _new_.field17, &_delta_->field17); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_17(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16 && _a_.field17 == _b_.field17; \
@@ -382,6 +612,28 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field18, _b_.field18); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_18(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+        semilattice_delta(_old_.field14, _new_.field14, &_delta_->field14); \
+        semilattice_delta(_old_.field15, _new_.field15, &_delta_->field15); \
+        semilattice_delta(_old_.field16, _new_.field16, &_delta_->field16); \
+        semilattice_delta(_old_.field17, _new_.field17, &_delta_->field17); \
+        semilattice_delta(_old_.field18, _new_.field18, &_delta_->field18); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_18(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16 && _a_.field17 == _b_.field17 && _a_.field18 == _b_.field18; \
@@ -411,6 +663,29 @@ You can also use this with templated types, but it's pretty hacky:
         semilattice_join(&_a_->field19, _b_.field19); \
     } \
     extern int semilattice_joinable_force_semicolon_declaration
+#define RDB_MAKE_SEMILATTICE_DELTA_19(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18, field19) \
+    inline void semilattice_delta(const type_t &_old_, const type_t &_new_, type_t *_delta_) { \
+        semilattice_delta(_old_.field1, _new_.field1, &_delta_->field1); \
+        semilattice_delta(_old_.field2, _new_.field2, &_delta_->field2); \
+        semilattice_delta(_old_.field3, _new_.field3, &_delta_->field3); \
+        semilattice_delta(_old_.field4, _new_.field4, &_delta_->field4); \
+        semilattice_delta(_old_.field5, _new_.field5, &_delta_->field5); \
+        semilattice_delta(_old_.field6, _new_.field6, &_delta_->field6); \
+        semilattice_delta(_old_.field7, _new_.field7, &_delta_->field7); \
+        semilattice_delta(_old_.field8, _new_.field8, &_delta_->field8); \
+        semilattice_delta(_old_.field9, _new_.field9, &_delta_->field9); \
+        semilattice_delta(_old_.field10, _new_.field10, &_delta_->field10); \
+        semilattice_delta(_old_.field11, _new_.field11, &_delta_->field11); \
+        semilattice_delta(_old_.field12, _new_.field12, &_delta_->field12); \
+        semilattice_delta(_old_.field13, _new_.field13, &_delta_->field13); \
+        semilattice_delta(_old_.field14, _new_.field14, &_delta_->field14); \
+        semilattice_delta(_old_.field15, _new_.field15, &_delta_->field15); \
+        semilattice_delta(_old_.field16, _new_.field16, &_delta_->field16); \
+        semilattice_delta(_old_.field17, _new_.field17, &_delta_->field17); \
+        semilattice_delta(_old_.field18, _new_.field18, &_delta_->field18); \
+        semilattice_delta(_old_.field19, _new_.field19, &_delta_->field19); \
+    } \
+    extern int semilattice_joinable_force_semicolon_declaration
 #define RDB_MAKE_EQUALITY_COMPARABLE_19(type_t, field1, field2, field3, field4, field5, field6, field7, field8, field9, field10, field11, field12, field13, field14, field15, field16, field17, field18, field19) \
     inline bool operator==(const type_t &_a_, const type_t &_b_) { \
         return _a_.field1 == _b_.field1 && _a_.field2 == _b_.field2 && _a_.field3 == _b_.field3 && _a_.field4 == _b_.field4 && _a_.field5 == _b_.field5 && _a_.field6 == _b_.field6 && _a_.field7 == _b_.field7 && _a_.field8 == _b_.field8 && _a_.field9 == _b_.field9 && _a_.field10 == _b_.field10 && _a_.field11 == _b_.field11 && _a_.field12 == _b_.field12 && _a_.field13 == _b_.field13 && _a_.field14 == _b_.field14 && _a_.field15 == _b_.field15 && _a_.field16 == _b_.field16 && _a_.field17 == _b_.field17 && _a_.field18 == _b_.field18 && _a_.field19 == _b_.field19; \
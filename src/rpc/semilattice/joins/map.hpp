@@ -5,7 +5,8 @@
 #include <map>
 
 /* We join `std::map`s by taking their union and resolving conflicts by doing a
-semilattice join on the values. */
+semilattice join on the values. The delta between two versions of a map holds
+the entries that are new or differ; changed entries are included whole. */
 
 namespace std {
 
@@ -21,6 +22,22 @@ void semilattice_join(std::map<key_t, value_t> *a, const std::map<key_t, value_t
     }
 }
 
+template<class key_t, class value_t>
+void semilattice_delta(const std::map<key_t, value_t> &old_value,
+                       const std::map<key_t, value_t> &new_value,
+                       std::map<key_t, value_t> *delta_out) {
+    typename std::map<key_t, value_t>::const_iterator old_it = old_value.begin();
+    for (typename std::map<key_t, value_t>::const_iterator it = new_value.begin(); it != new_value.end(); it++) {
+        while (old_it != old_value.end() && old_value.key_comp()(old_it->first, it->first)) {
+            old_it++;
+        }
+        if (old_it == old_value.end() || old_value.key_comp()(it->first, old_it->first) ||
+                !(old_it->second == it->second)) {
+            delta_out->insert(delta_out->end(), *it);
+        }
+    }
+}
+
 }   /* namespace std */
 
 #endif /* RPC_SEMILATTICE_JOINS_MAP_HPP_ */
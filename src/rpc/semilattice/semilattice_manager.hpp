@@ -3,8 +3,10 @@
 #define RPC_SEMILATTICE_SEMILATTICE_MANAGER_HPP_
 
 #include <map>
+#include <set>
 #include <utility>
 
+#include "perfmon/perfmon.hpp"
 #include "rpc/mailbox/mailbox.hpp"
 #include "rpc/semilattice/view.hpp"
 
@@ -30,7 +32,12 @@ constraints:
     `*a` to the semilattice-join of `*a` and `b`.
 
 Currently it's not thread-safe at all; all accesses to the metadata must be on
-the home thread of the `semilattice_manager_t`. */
+the home thread of the `semilattice_manager_t`.
+
+A peer gets the whole metadata when it connects. After that, each change is sent
+as a delta (see "rpc/semilattice/joins/delta.hpp") that is based on the version
+before the change. A peer that keeps getting deltas based on a version it hasn't
+seen asks for the whole metadata again. */
 
 template<class metadata_t>
 class semilattice_manager_t : public home_thread_mixin_t, public message_handler_t, private peers_list_callback_t {
@@ -40,6 +47,10 @@ public:
 
     boost::shared_ptr<semilattice_readwrite_view_t<metadata_t> > get_root_view();
 
+    /* Counts and sizes of the metadata messages sent to other peers, for
+    adding to a stats collection. */
+    perfmon_collection_t *get_stats();
+
 private:
     typedef uint64_t metadata_version_t, sync_from_query_id_t, sync_to_query_id_t;
 
@@ -57,6 +68,8 @@ private:
     };
 
     class metadata_writer_t;
+    class delta_writer_t;
+    class resync_query_writer_t;
     class sync_from_query_writer_t;
     class sync_from_reply_writer_t;
     class sync_to_query_writer_t;
@@ -70,7 +83,10 @@ private:
 
     /* These are spawned in new coroutines. */
     void send_metadata_to_peer(peer_id_t, metadata_t, metadata_version_t, auto_drainer_t::lock_t);
+    void send_delta_to_peer(peer_id_t, metadata_t, metadata_version_t base_version, metadata_version_t, auto_drainer_t::lock_t);
     void deliver_metadata_on_home_thread(peer_id_t sender, metadata_t, metadata_version_t, auto_drainer_t::lock_t);
+    void deliver_delta_on_home_thread(peer_id_t sender, metadata_t, metadata_version_t base_version, metadata_version_t, auto_drainer_t::lock_t);
+    void deliver_resync_query_on_home_thread(peer_id_t sender, auto_drainer_t::lock_t);
     void deliver_sync_from_query_on_home_thread(peer_id_t sender, sync_from_query_id_t query_id, auto_drainer_t::lock_t);
     void deliver_sync_from_reply_on_home_thread(peer_id_t sender, sync_from_query_id_t query_id, metadata_version_t version, auto_drainer_t::lock_t);
     void deliver_sync_to_query_on_home_thread(peer_id_t sender, sync_to_query_id_t query_id, metadata_version_t version, auto_drainer_t::lock_t);
@@ -78,6 +94,7 @@ private:
 
     static void call_function_with_no_args(const boost::function<void()> &);
     void join_metadata_locally(metadata_t);
+    void update_version_from_peer(peer_id_t peer, metadata_version_t version);
     void wait_for_version_from_peer(peer_id_t peer, metadata_version_t version, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, sync_failed_exc_t);
 
     message_service_t *const message_service;
@@ -92,12 +109,30 @@ private:
     std::multimap<std::pair<peer_id_t, metadata_version_t>, cond_t *> version_waiters;
     mutex_assertion_t peer_version_mutex;
 
+    /* The version of the last metadata or delta we sent to each connected
+    peer. A change is sent as a delta only to peers that were sent the version
+    right before it. */
+    std::map<peer_id_t, metadata_version_t> last_versions_sent;
+
+    /* Versions of deltas that arrived from each peer before a delta they are
+    based on. */
+    std::map<peer_id_t, std::set<metadata_version_t> > deltas_ahead;
+
+    /* Peers we asked to resend the whole metadata and haven't heard back from. */
+    std::set<peer_id_t> resyncs_pending;
+
     sync_from_query_id_t next_sync_from_query_id;
     std::map<sync_from_query_id_t, promise_t<metadata_version_t> *> sync_from_waiters;
 
     sync_to_query_id_t next_sync_to_query_id;
     std::map<sync_to_query_id_t, cond_t *> sync_to_waiters;
 
+    perfmon_collection_t stats;
+    perfmon_counter_t full_messages_sent, full_bytes_sent;
+    perfmon_counter_t delta_messages_sent, delta_bytes_sent;
+    perfmon_counter_t resyncs_requested;
+    perfmon_multi_membership_t stats_membership;
+
     one_per_thread_t<auto_drainer_t> drainers;
 
     connectivity_service_t::peers_list_subscription_t event_watcher;
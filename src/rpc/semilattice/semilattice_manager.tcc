@@ -15,6 +15,7 @@
 #include "concurrency/promise.hpp"
 #include "concurrency/wait_any.hpp"
 #include "logger.hpp"
+#include "rpc/semilattice/joins/delta.hpp"
 
 template<class metadata_t>
 semilattice_manager_t<metadata_t>::semilattice_manager_t(message_service_t *ms, const metadata_t &initial_metadata) :
@@ -23,6 +24,13 @@ semilattice_manager_t<metadata_t>::semilattice_manager_t(message_service_t *ms,
     metadata_version(0),
     metadata(initial_metadata),
     next_sync_from_query_id(0), next_sync_to_query_id(0),
+    stats_membership(&stats,
+        &full_messages_sent, "full_messages_sent",
+        &full_bytes_sent, "full_bytes_sent",
+        &delta_messages_sent, "delta_messages_sent",
+        &delta_bytes_sent, "delta_bytes_sent",
+        &resyncs_requested, "resyncs_requested",
+        NULL),
     event_watcher(this) {
     ASSERT_FINITE_CORO_WAITING;
     connectivity_service_t::peers_list_freeze_t freeze(message_service->get_connectivity_service());
@@ -42,6 +50,11 @@ boost::shared_ptr<semilattice_readwrite_view_t<metadata_t> > semilattice_manager
     return root_view;
 }
 
+template<class metadata_t>
+perfmon_collection_t *semilattice_manager_t<metadata_t>::get_stats() {
+    return &stats;
+}
+
 template<class metadata_t>
 semilattice_manager_t<metadata_t>::root_view_t::root_view_t(semilattice_manager_t *p)
     : parent(p) {
@@ -60,25 +73,48 @@ void semilattice_manager_t<metadata_t>::root_view_t::join(const metadata_t &adde
     guarantee(parent, "accessing `semilattice_manager_t` root view when cluster no longer exists");
     parent->assert_thread();
 
+    const metadata_t old_metadata = parent->metadata;
     metadata_version_t new_version = ++parent->metadata_version;
     parent->join_metadata_locally(added_metadata);
 
+    /* Callers usually join the whole metadata back in after changing a small
+    part of it, so we only send the parts that actually changed. */
+    metadata_t delta;
+    semilattice_delta(old_metadata, parent->metadata, &delta);
+
     /* Distribute changes to all peers we can currently see. If we can't
     currently see a peer, that's OK; it will hear about the metadata change when
-    it reconnects, via the `semilattice_manager_t`'s `on_connect()` handler. */
+    it reconnects, via the `semilattice_manager_t`'s `on_connect()` handler. A
+    peer that wasn't sent the previous version (because it connected or asked
+    for a resync concurrently) gets the whole metadata instead of the delta. */
     DEBUG_VAR connectivity_service_t::peers_list_freeze_t freeze(parent->message_service->get_connectivity_service());
     std::set<peer_id_t> peers = parent->message_service->get_connectivity_service()->get_peers_list();
     for (std::set<peer_id_t>::iterator it = peers.begin(); it != peers.end(); it++) {
         if (*it != parent->message_service->get_connectivity_service()->get_me()) {
-            coro_t::spawn_sometime(boost::bind(
-                &semilattice_manager_t<metadata_t>::send_metadata_to_peer, parent,
-                *it, added_metadata, new_version,
-                auto_drainer_t::lock_t(parent->drainers.get())));
+            metadata_version_t &last_sent = parent->last_versions_sent[*it];
+            if (last_sent == new_version - 1) {
+                coro_t::spawn_sometime(boost::bind(
+                    &semilattice_manager_t<metadata_t>::send_delta_to_peer, parent,
+                    *it, delta, last_sent, new_version,
+                    auto_drainer_t::lock_t(parent->drainers.get())));
+            } else {
+                coro_t::spawn_sometime(boost::bind(
+                    &semilattice_manager_t<metadata_t>::send_metadata_to_peer, parent,
+                    *it, parent->metadata, new_version,
+                    auto_drainer_t::lock_t(parent->drainers.get())));
+            }
+            last_sent = new_version;
         }
     }
 }
 
 static const char message_code_metadata = 'M';
+static const char message_code_delta = 'D';
+static const char message_code_resync_query = 'R';
+
+/* How many deltas from a peer we hold on to while waiting for an earlier one
+before asking the peer to resend the whole metadata. */
+static const size_t max_deltas_ahead = 100;
 static const char message_code_sync_from_query = 'F';
 static const char message_code_sync_from_reply = 'f';
 static const char message_code_sync_to_query = 'T';
@@ -87,8 +123,8 @@ static const char message_code_sync_to_reply = 't';
 template <class metadata_t>
 class semilattice_manager_t<metadata_t>::metadata_writer_t : public send_message_write_callback_t {
 public:
-    metadata_writer_t(const metadata_t &_md, metadata_version_t _mdv) :
-        md(_md), mdv(_mdv) { }
+    metadata_writer_t(const metadata_t &_md, metadata_version_t _mdv, semilattice_manager_t *_parent) :
+        md(_md), mdv(_mdv), parent(_parent) { }
 
     void write(write_stream_t *stream) {
         write_message_t msg;
@@ -96,12 +132,53 @@ public:
         msg << code;
         msg << md;
         msg << mdv;
+        ++parent->full_messages_sent;
+        parent->full_bytes_sent += msg.size();
         int res = send_write_message(stream, &msg);
         if (res) { throw fake_archive_exc_t(); }
     }
 private:
     const metadata_t &md;
     metadata_version_t mdv;
+    semilattice_manager_t *parent;
+};
+
+template <class metadata_t>
+class semilattice_manager_t<metadata_t>::delta_writer_t : public send_message_write_callback_t {
+public:
+    delta_writer_t(const metadata_t &_delta, metadata_version_t _base_version, metadata_version_t _mdv, semilattice_manager_t *_parent) :
+        delta(_delta), base_version(_base_version), mdv(_mdv), parent(_parent) { }
+
+    void write(write_stream_t *stream) {
+        write_message_t msg;
+        uint8_t code = message_code_delta;
+        msg << code;
+        msg << delta;
+        msg << base_version;
+        msg << mdv;
+        ++parent->delta_messages_sent;
+        parent->delta_bytes_sent += msg.size();
+        int res = send_write_message(stream, &msg);
+        if (res) { throw fake_archive_exc_t(); }
+    }
+private:
+    const metadata_t &delta;
+    metadata_version_t base_version, mdv;
+    semilattice_manager_t *parent;
+};
+
+template <class metadata_t>
+class semilattice_manager_t<metadata_t>::resync_query_writer_t : public send_message_write_callback_t {
+public:
+    resync_query_writer_t() { }
+
+    void write(write_stream_t *stream) {
+        write_message_t msg;
+        uint8_t code = message_code_resync_query;
+        msg << code;
+        int res = send_write_message(stream, &msg);
+        if (res) { throw fake_archive_exc_t(); }
+    }
 };
 
 template <class metadata_t>
@@ -246,6 +323,28 @@ void semilattice_manager_t<metadata_t>::on_message(peer_id_t sender, read_stream
                 sender, added_metadata, change_version, auto_drainer_t::lock_t(drainers.get())));
             break;
         }
+        case message_code_delta: {
+            metadata_t delta;
+            metadata_version_t base_version, change_version;
+            {
+                int res = deserialize(stream, &delta);
+                if (res) { throw fake_archive_exc_t(); }
+                res = deserialize(stream, &base_version);
+                if (res) { throw fake_archive_exc_t(); }
+                res = deserialize(stream, &change_version);
+                if (res) { throw fake_archive_exc_t(); }
+            }
+            coro_t::spawn_sometime(boost::bind(
+                &semilattice_manager_t<metadata_t>::deliver_delta_on_home_thread, this,
+                sender, delta, base_version, change_version, auto_drainer_t::lock_t(drainers.get())));
+            break;
+        }
+        case message_code_resync_query: {
+            coro_t::spawn_sometime(boost::bind(
+                &semilattice_manager_t<metadata_t>::deliver_resync_query_on_home_thread, this,
+                sender, auto_drainer_t::lock_t(drainers.get())));
+            break;
+        }
         case message_code_sync_from_query: {
             sync_from_query_id_t query_id;
             {
@@ -309,6 +408,10 @@ template<class metadata_t>
 void semilattice_manager_t<metadata_t>::on_connect(peer_id_t peer) {
     assert_thread();
 
+    /* Changes made from now on are sent to the peer as deltas on top of this
+    version. */
+    last_versions_sent[peer] = metadata_version;
+
     /* We have to spawn this in a separate coroutine because `on_connect()` is
     not supposed to block. */
     coro_t::spawn_sometime(boost::bind(
@@ -317,15 +420,24 @@ void semilattice_manager_t<metadata_t>::on_connect(peer_id_t peer) {
 }
 
 template<class metadata_t>
-void semilattice_manager_t<metadata_t>::on_disconnect(peer_id_t) {
+void semilattice_manager_t<metadata_t>::on_disconnect(peer_id_t peer) {
     assert_thread();
 
-    /* ignore */
+    /* The peer gets the whole metadata again when it reconnects. */
+    last_versions_sent.erase(peer);
+    deltas_ahead.erase(peer);
+    resyncs_pending.erase(peer);
 }
 
 template<class metadata_t>
 void semilattice_manager_t<metadata_t>::send_metadata_to_peer(peer_id_t peer, metadata_t m, metadata_version_t mv, auto_drainer_t::lock_t) {
-    metadata_writer_t writer(m, mv);
+    metadata_writer_t writer(m, mv, this);
+    message_service->send_message(peer, &writer);
+}
+
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::send_delta_to_peer(peer_id_t peer, metadata_t delta, metadata_version_t base_mv, metadata_version_t mv, auto_drainer_t::lock_t) {
+    delta_writer_t writer(delta, base_mv, mv, this);
     message_service->send_message(peer, &writer);
 }
 
@@ -333,18 +445,48 @@ template<class metadata_t>
 void semilattice_manager_t<metadata_t>::deliver_metadata_on_home_thread(peer_id_t sender, metadata_t md, metadata_version_t mv, auto_drainer_t::lock_t) {
     on_thread_t thread_switcher(home_thread());
     join_metadata_locally(md);
-    DEBUG_VAR mutex_assertion_t::acq_t acq(&peer_version_mutex);
-    std::pair<typename std::map<peer_id_t, metadata_version_t>::iterator, bool> inserted =
-        last_versions_seen.insert(std::make_pair(sender, mv));
-    if (!inserted.second) {
-        inserted.first->second = std::max(inserted.first->second, mv);
+    resyncs_pending.erase(sender);
+    update_version_from_peer(sender, mv);
+}
+
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::deliver_delta_on_home_thread(peer_id_t sender, metadata_t delta, metadata_version_t base_mv, metadata_version_t mv, auto_drainer_t::lock_t) {
+    on_thread_t thread_switcher(home_thread());
+    /* Joining in a delta is always safe; we just can't claim to have the
+    sender's version `mv` unless we also have everything up to `base_mv`.
+    Deltas are sent from separate coroutines, so they may overtake each other;
+    we hold on to the versions of deltas that arrive early until the gap is
+    filled. If too many pile up, we assume the gap won't be filled and ask for
+    the whole metadata. */
+    rassert(mv == base_mv + 1);
+    join_metadata_locally(delta);
+    typename std::map<peer_id_t, metadata_version_t>::iterator it = last_versions_seen.find(sender);
+    if (it != last_versions_seen.end() && it->second >= base_mv) {
+        update_version_from_peer(sender, mv);
+    } else {
+        std::set<metadata_version_t> *ahead = &deltas_ahead[sender];
+        ahead->insert(mv);
+        if (ahead->size() > max_deltas_ahead && resyncs_pending.insert(sender).second) {
+            ++resyncs_requested;
+            resync_query_writer_t writer;
+            message_service->send_message(sender, &writer);
+        }
     }
-    for (typename std::multimap<std::pair<peer_id_t, metadata_version_t>, cond_t *>::iterator it = version_waiters.begin();
-            it != version_waiters.end(); it++) {
-        if (it->first.first == sender && it->first.second <= mv && !it->second->is_pulsed()) {
-            it->second->pulse();
+}
+
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::deliver_resync_query_on_home_thread(peer_id_t sender, auto_drainer_t::lock_t) {
+    on_thread_t thread_switcher(home_thread());
+    {
+        DEBUG_VAR connectivity_service_t::peers_list_freeze_t freeze(message_service->get_connectivity_service());
+        if (!message_service->get_connectivity_service()->get_peer_connected(sender)) {
+            return;
         }
+        last_versions_sent[sender] = metadata_version;
     }
+    metadata_t md = metadata;
+    metadata_writer_t writer(md, metadata_version, this);
+    message_service->send_message(sender, &writer);
 }
 
 template<class metadata_t>
@@ -408,6 +550,38 @@ void semilattice_manager_t<metadata_t>::join_metadata_locally(metadata_t added_m
     metadata_publisher.publish(&semilattice_manager_t<metadata_t>::call_function_with_no_args);
 }
 
+template<class metadata_t>
+void semilattice_manager_t<metadata_t>::update_version_from_peer(peer_id_t peer, metadata_version_t version) {
+    assert_thread();
+    DEBUG_VAR mutex_assertion_t::acq_t acq(&peer_version_mutex);
+    std::pair<typename std::map<peer_id_t, metadata_version_t>::iterator, bool> inserted =
+        last_versions_seen.insert(std::make_pair(peer, version));
+    if (!inserted.second) {
+        inserted.first->second = std::max(inserted.first->second, version);
+    }
+    version = inserted.first->second;
+
+    /* Catch up on deltas that arrived before the one we were missing. */
+    typename std::map<peer_id_t, std::set<metadata_version_t> >::iterator ahead = deltas_ahead.find(peer);
+    if (ahead != deltas_ahead.end()) {
+        std::set<metadata_version_t> *versions = &ahead->second;
+        while (!versions->empty() && *versions->begin() <= version + 1) {
+            version = std::max(version, *versions->begin());
+            versions->erase(versions->begin());
+        }
+        if (versions->empty()) {
+            deltas_ahead.erase(ahead);
+        }
+        inserted.first->second = version;
+    }
+    for (typename std::multimap<std::pair<peer_id_t, metadata_version_t>, cond_t *>::iterator it = version_waiters.begin();
+            it != version_waiters.end(); it++) {
+        if (it->first.first == peer && it->first.second <= version && !it->second->is_pulsed()) {
+            it->second->pulse();
+        }
+    }
+}
+
 template<class metadata_t>
 void semilattice_manager_t<metadata_t>::wait_for_version_from_peer(peer_id_t peer, metadata_version_t version, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t, sync_failed_exc_t) {
     assert_thread();
@@ -77,8 +77,10 @@ void data_block_manager_t::end_reconstruct() {
 void data_block_manager_t::start_existing(file_t *file, metablock_mixin_t *last_metablock) {
     rassert(state == state_unstarted);
     dbfile = file;
-    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE));
-    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH));
+    gc_io_account_nice.init(new file_account_t(file, GC_IO_PRIORITY_NICE, UNLIMITED_OUTSTANDING_REQUESTS,
+                                               stats->get_io_account_stats(GC_IO_PRIORITY_NICE)));
+    gc_io_account_high.init(new file_account_t(file, GC_IO_PRIORITY_HIGH, UNLIMITED_OUTSTANDING_REQUESTS,
+                                               stats->get_io_account_stats(GC_IO_PRIORITY_HIGH)));
 
     /* Reconstruct the active data block extents from the metablock. */
     for (unsigned int i = 0; i < MAX_ACTIVE_DATA_EXTENTS; i++) {
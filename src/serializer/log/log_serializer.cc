@@ -121,6 +121,7 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
       pm_serializer_old_garbage_blocks(),
       pm_serializer_old_total_blocks(),
       pm_serializer_lba_gcs(),
+      pm_io(&serializer_collection, "serializer_io"),
       parent_collection_membership(parent, &serializer_collection, "serializer"),
       stats_membership(&serializer_collection,
           &pm_serializer_block_reads, "serializer_block_reads",
@@ -142,6 +143,15 @@ log_serializer_stats_t::log_serializer_stats_t(perfmon_collection_t *parent)
           NULLPTR)
 { }
 
+io_account_stats_t *log_serializer_stats_t::get_io_account_stats(int priority) {
+    boost::ptr_map<int, io_account_stats_t>::iterator it = io_account_stats.find(priority);
+    if (it == io_account_stats.end()) {
+        it = io_account_stats.insert(priority, new io_account_stats_t(
+            &serializer_collection, strprintf("serializer_io_priority_%d", priority), &pm_io)).first;
+    }
+    return it->second;
+}
+
 void log_serializer_t::create(serializer_file_opener_t *file_opener, static_config_t static_config) {
     log_serializer_on_disk_static_config_t *on_disk_config = &static_config;
 
@@ -411,7 +421,8 @@ void log_serializer_t::free(void *ptr) {
 file_account_t *log_serializer_t::make_io_account(int priority, int outstanding_requests_limit) {
     assert_thread();
     rassert(dbfile);
-    return new file_account_t(dbfile, priority, outstanding_requests_limit);
+    return new file_account_t(dbfile, priority, outstanding_requests_limit,
+                              stats->get_io_account_stats(priority));
 }
 
 void log_serializer_t::block_read(const counted_t<ls_block_token_pointee_t>& token, void *buf, file_account_t *io_account) {
@@ -2,6 +2,10 @@
 #ifndef SERIALIZER_LOG_STATS_HPP_
 #define SERIALIZER_LOG_STATS_HPP_
 
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_map.hpp>
+
+#include "arch/io/disk/account_stats.hpp"
 #include "perfmon/perfmon.hpp"
 
 struct log_serializer_stats_t {
@@ -33,8 +37,17 @@ struct log_serializer_stats_t {
     /* used in serializer/log/lba/lba_list.cc */
     perfmon_counter_t pm_serializer_lba_gcs;
 
+    /* The I/O done through the file accounts of each priority (see
+    `make_io_account()` and the GC accounts), and in total. I/O done through the
+    file's default account, like metablock and LBA I/O, isn't counted. */
+    io_account_stats_t pm_io;
+    io_account_stats_t *get_io_account_stats(int priority);
+
     perfmon_membership_t parent_collection_membership;
     perfmon_multi_membership_t stats_membership;
+
+private:
+    boost::ptr_map<int, io_account_stats_t> io_account_stats;
 };
 
 #endif /* SERIALIZER_LOG_STATS_HPP_ */
@@ -0,0 +1,134 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/auto_drainer.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/semaphore.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+namespace {
+
+/* Plays the part of the backfiller: asks the window for room for a batch and
+then hands the batch off. */
+void send_batch(adjustable_semaphore_t *window, int num_chunks, int id,
+                std::vector<int> *granted_order, cond_t *granted,
+                auto_drainer_t::lock_t keepalive) {
+    try {
+        window->co_lock_interruptible(keepalive.get_drain_signal(), num_chunks);
+    } catch (const interrupted_exc_t &) {
+        return;
+    }
+    granted_order->push_back(id);
+    granted->pulse();
+}
+
+/* Spawns one sender per batch, in order, while the receiver applies the
+batches strictly in that same order and only then gives their room back, the
+way the backfillee does. If a later batch could take the room that an earlier
+one is waiting for, the receiver would get stuck. */
+void run_window_test(int capacity, const std::vector<int> &batch_sizes) {
+    adjustable_semaphore_t window(capacity);
+    scoped_array_t<cond_t> granted(batch_sizes.size());
+    std::vector<int> granted_order;
+    auto_drainer_t drainer;
+
+    for (size_t i = 0; i < batch_sizes.size(); ++i) {
+        coro_t::spawn_sometime(boost::bind(&send_batch, &window, batch_sizes[i], i,
+                                           &granted_order, &granted[i],
+                                           auto_drainer_t::lock_t(&drainer)));
+    }
+
+    for (size_t i = 0; i < batch_sizes.size(); ++i) {
+        try {
+            signal_timer_t timeout(1000);
+            wait_interruptible(&granted[i], &timeout);
+        } catch (const interrupted_exc_t &) {
+            ADD_FAILURE() << "batch " << i << " of " << batch_sizes[i] << " chunks never got room in the window";
+            return;
+        }
+        window.unlock(batch_sizes[i]);
+    }
+
+    ASSERT_EQ(batch_sizes.size(), granted_order.size());
+    for (size_t i = 0; i < granted_order.size(); ++i) {
+        EXPECT_EQ(static_cast<int>(i), granted_order[i]);
+    }
+}
+
+}   /* anonymous namespace */
+
+void run_large_batch_not_overtaken_test() {
+    /* The second batch has to wait for the first to be applied; the third
+    would fit next to the first, but it must not take that room. */
+    std::vector<int> batch_sizes;
+    batch_sizes.push_back(50);
+    batch_sizes.push_back(60);
+    batch_sizes.push_back(50);
+    run_window_test(100, batch_sizes);
+}
+
+TEST(AdjustableSemaphore, LargeBatchNotOvertaken) {
+    run_in_thread_pool(&run_large_batch_not_overtaken_test);
+}
+
+void run_mixed_batch_sizes_test() {
+    rng_t rng;
+    std::vector<int> batch_sizes;
+    for (int i = 0; i < 500; ++i) {
+        batch_sizes.push_back(1 + rng.randint(64));
+    }
+    run_window_test(100, batch_sizes);
+}
+
+TEST(AdjustableSemaphore, MixedBatchSizes) {
+    run_in_thread_pool(&run_mixed_batch_sizes_test);
+}
+
+void run_interrupted_waiter_test() {
+    /* When the request at the head of the queue gives up, the ones behind it
+    get their turn. */
+    adjustable_semaphore_t sem(10);
+    sem.lock_now(5);
+
+    cond_t small_granted;
+    std::vector<int> granted_order;
+    auto_drainer_t drainer;
+    /* The sender only runs once we block, so its request queues behind ours */
+    coro_t::spawn_sometime(boost::bind(&send_batch, &sem, 3, 1,
+                                       &granted_order, &small_granted,
+                                       auto_drainer_t::lock_t(&drainer)));
+    try {
+        signal_timer_t give_up(50);
+        sem.co_lock_interruptible(&give_up, 10);
+        ADD_FAILURE() << "got room that is still held";
+        return;
+    } catch (const interrupted_exc_t &) {
+    }
+
+    try {
+        signal_timer_t timeout(1000);
+        wait_interruptible(&small_granted, &timeout);
+    } catch (const interrupted_exc_t &) {
+        ADD_FAILURE() << "the request behind the interrupted one never got its turn";
+        return;
+    }
+    EXPECT_EQ(1u, granted_order.size());
+    sem.unlock(3);
+    sem.unlock(5);
+}
+
+TEST(AdjustableSemaphore, InterruptedWaiter) {
+    run_in_thread_pool(&run_interrupted_waiter_test);
+}
+
+}  // namespace unittest
@@ -1,4 +1,6 @@
 // Copyright 2010-2012 RethinkDB, all rights reserved.
+#include <string.h>
+
 #include <string>
 
 #include "unittest/gtest.hpp"
@@ -13,7 +15,7 @@ void dump_to_string(write_message_t *msg, std::string *out) {
 
     out->clear();
     for (write_buffer_t *p = buffers->head(); p; p = buffers->next(p)) {
-        out->append(p->data, p->data + p->size);
+        out->append(p->bytes(), p->bytes() + p->size);
     }
 }
 
@@ -36,6 +38,35 @@ TEST(WriteMessageTest, Variant) {
     ASSERT_EQ(22u, u.size());
 }
 
+TEST(WriteMessageTest, AppendBuffer) {
+    counted_t<data_buffer_t> small = data_buffer_t::create(3);
+    memcpy(small->buf(), "abc", 3);
+    counted_t<data_buffer_t> large = data_buffer_t::create(write_message_t::MIN_REFERENCED_BUFFER_SIZE);
+    memset(large->buf(), 'x', large->size());
+
+    write_message_t msg;
+    msg.append("<", 1);
+    msg.append_buffer(small);
+    msg.append_buffer(large);
+    msg.append(">", 1);
+
+    // The large buffer is held by reference, not copied.
+    intrusive_list_t<write_buffer_t> *buffers = msg.unsafe_expose_buffers();
+    int references = 0;
+    for (write_buffer_t *p = buffers->head(); p; p = buffers->next(p)) {
+        if (p->external.has()) {
+            ASSERT_EQ(large->buf(), p->bytes());
+            ++references;
+        }
+    }
+    ASSERT_EQ(1, references);
+
+    std::string s;
+    dump_to_string(&msg, &s);
+    ASSERT_EQ(std::string("<abc") + std::string(large->size(), 'x') + ">", s);
+    ASSERT_EQ(static_cast<int64_t>(s.size()), msg.size());
+}
+
 
 
 }  // namespace unittest
@@ -0,0 +1,56 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/runtime/runtime.hpp"
+#include "arch/runtime/starter.hpp"
+#include "arch/runtime/thread_pool.hpp"
+#include "arch/timing.hpp"
+#include "unittest/gtest.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+static const int num_round_trips = 20000;
+
+int64_t get_messages_received(int thread) {
+    on_thread_t th(thread);
+    return linux_thread_pool_t::thread->message_hub.get_messages_received();
+}
+
+/* Bounces a coroutine between threads 0 and 1, checking that thread 1 gets
+every message and only spins when busy polling is on. Then leaves thread 1
+idle, checking that its spinning stops within the busy polling bound rather
+than going on for as long as it is idle. */
+void run_round_trip_test(bool busy_poll) {
+    const double spin_secs_before = get_thread_spin_secs(1);
+    const int64_t received_before = get_messages_received(1);
+
+    for (int i = 0; i < num_round_trips; ++i) {
+        on_thread_t th(1);
+    }
+
+    EXPECT_LE(received_before + num_round_trips, get_messages_received(1));
+    const double spin_secs = get_thread_spin_secs(1) - spin_secs_before;
+    if (busy_poll) {
+        EXPECT_GT(spin_secs, 0);
+    } else {
+        EXPECT_EQ(0, spin_secs);
+    }
+
+    const double idle_secs = 0.2;
+    nap(10);
+    const double spin_secs_before_idle = get_thread_spin_secs(1);
+    nap(idle_secs * 1000);
+    EXPECT_LT(get_thread_spin_secs(1) - spin_secs_before_idle, idle_secs / 2);
+}
+
+TEST(BusyPoll, RoundTripWithoutBusyPolling) {
+    ::run_in_thread_pool(boost::bind(&run_round_trip_test, false), 2);
+}
+
+TEST(BusyPoll, RoundTripWithBusyPolling) {
+    ::run_in_thread_pool(boost::bind(&run_round_trip_test, true), 2, 1000);
+}
+
+}  // namespace unittest
@@ -1,5 +1,7 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
 #include "unittest/gtest.hpp"
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
 #include "clustering/immediate_consistency/branch/backfiller.hpp"
 #include "clustering/immediate_consistency/branch/backfillee.hpp"
 #include "containers/uuid.hpp"
@@ -166,4 +168,305 @@ TEST(ClusteringBackfill, BackfillTest) {
     unittest::run_in_thread_pool(&run_backfill_test);
 }
 
+namespace {
+
+class pausing_backfiller_store_t;
+
+/* Passes everything on to the backfiller's callback, recording which keys it
+sent. If the store says so, it stops the backfill after the first region is
+finished until the backfill is interrupted. */
+class pausing_send_backfill_callback_t : public send_backfill_callback_t<dummy_protocol_t> {
+public:
+    pausing_send_backfill_callback_t(send_backfill_callback_t<dummy_protocol_t> *_inner,
+                                     pausing_backfiller_store_t *_store)
+        : inner(_inner), store(_store) { }
+
+    bool should_backfill_impl(const dummy_protocol_t::store_t::metainfo_t &metainfo) {
+        return inner->should_backfill(metainfo);
+    }
+
+    void send_chunk(const dummy_protocol_t::backfill_chunk_t &chunk, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+    void finish_region(const dummy_protocol_t::region_t &region, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t);
+
+private:
+    send_backfill_callback_t<dummy_protocol_t> *inner;
+    pausing_backfiller_store_t *store;
+};
+
+class pausing_backfiller_store_t : public dummy_protocol_t::store_t {
+public:
+    pausing_backfiller_store_t() : pause_after_first_region(true) { }
+
+    bool send_backfill(const region_map_t<dummy_protocol_t, state_timestamp_t> &start_point,
+                       send_backfill_callback_t<dummy_protocol_t> *send_backfill_cb,
+                       traversal_progress_combiner_t *progress,
+                       read_token_pair_t *token_pair,
+                       signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+        pausing_send_backfill_callback_t cb(send_backfill_cb, this);
+        return dummy_protocol_t::store_t::send_backfill(start_point, &cb, progress, token_pair, interruptor);
+    }
+
+    bool pause_after_first_region;
+    std::set<std::string> keys_sent;
+
+    cond_t first_region_finished;
+    dummy_protocol_t::region_t first_finished_region;
+};
+
+void pausing_send_backfill_callback_t::send_chunk(const dummy_protocol_t::backfill_chunk_t &chunk, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+    store->keys_sent.insert(chunk.key);
+    inner->send_chunk(chunk, interruptor);
+}
+
+void pausing_send_backfill_callback_t::finish_region(const dummy_protocol_t::region_t &region, signal_t *interruptor) THROWS_ONLY(interrupted_exc_t) {
+    inner->finish_region(region, interruptor);
+    if (store->pause_after_first_region && !store->first_region_finished.is_pulsed()) {
+        store->first_finished_region = region;
+        store->first_region_finished.pulse();
+        cond_t never;
+        wait_interruptible(&never, interruptor);
+    }
+}
+
+region_map_t<dummy_protocol_t, version_range_t> get_version_map(store_view_t<dummy_protocol_t> *store,
+                                                                order_source_t *order_source) {
+    cond_t non_interruptor;
+    object_buffer_t<fifo_enforcer_sink_t::exit_read_t> token;
+    store->new_read_token(&token);
+    region_map_t<dummy_protocol_t, binary_blob_t> metainfo;
+    store->do_get_metainfo(order_source->check_in("get_version_map").with_read_mode(),
+                           &token, &non_interruptor, &metainfo);
+    return region_map_transform<dummy_protocol_t, binary_blob_t, version_range_t>(
+        metainfo, &binary_blob_t::get<version_range_t>);
+}
+
+void run_backfillee_until_interrupted(
+        mailbox_manager_t *mailbox_manager,
+        branch_history_manager_t<dummy_protocol_t> *branch_history_manager,
+        store_view_t<dummy_protocol_t> *store,
+        clone_ptr_t<watchable_t<boost::optional<boost::optional<backfiller_business_card_t<dummy_protocol_t> > > > > backfiller_metadata,
+        signal_t *interruptor,
+        cond_t *interrupted) {
+    try {
+        backfillee<dummy_protocol_t>(mailbox_manager, branch_history_manager, store,
+                                     store->get_region(), backfiller_metadata,
+                                     generate_uuid(), interruptor);
+    } catch (const interrupted_exc_t &) {
+        interrupted->pulse();
+    }
+}
+
+}   /* anonymous namespace */
+
+/* Interrupts a backfill after the backfiller has finished one of the two
+regions the backfillee asked for, and checks that the backfillee recorded that
+region as up to date and that the next backfill only sends the other one. */
+void run_interrupted_backfill_test() {
+
+    order_source_t order_source;
+
+    dummy_protocol_t::region_t region = mock::a_thru_z_region();
+    dummy_protocol_t::region_t first_half, second_half;
+    for (char c = 'a'; c <= 'z'; c++) {
+        (c <= 'm' ? &first_half : &second_half)->keys.insert(std::string(1, c));
+    }
+
+    pausing_backfiller_store_t backfiller_store;
+    dummy_protocol_t::store_t backfillee_store;
+
+    in_memory_branch_history_manager_t<mock::dummy_protocol_t> branch_history_manager;
+    branch_id_t dummy_branch_id = generate_uuid();
+    {
+        branch_birth_certificate_t<dummy_protocol_t> dummy_branch;
+        dummy_branch.region = region;
+        dummy_branch.initial_timestamp = state_timestamp_t::zero();
+        dummy_branch.origin = region_map_t<dummy_protocol_t, version_range_t>(
+            region, version_range_t(version_t(nil_uuid(), state_timestamp_t::zero())));
+        cond_t non_interruptor;
+        branch_history_manager.create_branch(dummy_branch_id, dummy_branch, &non_interruptor);
+    }
+
+    state_timestamp_t timestamp = state_timestamp_t::zero();
+    const version_t start_version(dummy_branch_id, timestamp);
+
+    /* The backfillee's metainfo is in two pieces, so it asks for two regions */
+    {
+        cond_t non_interruptor;
+        object_buffer_t<fifo_enforcer_sink_t::exit_write_t> token;
+        backfiller_store.new_write_token(&token);
+        backfiller_store.set_metainfo(
+            region_map_t<dummy_protocol_t, binary_blob_t>(region, binary_blob_t(version_range_t(start_version))),
+            order_source.check_in("backfiller_store.set_metainfo"),
+            &token,
+            &non_interruptor);
+    }
+    {
+        std::vector<std::pair<dummy_protocol_t::region_t, binary_blob_t> > pieces;
+        pieces.push_back(std::make_pair(first_half, binary_blob_t(version_range_t(start_version))));
+        pieces.push_back(std::make_pair(second_half, binary_blob_t(version_range_t(start_version))));
+        cond_t non_interruptor;
+        object_buffer_t<fifo_enforcer_sink_t::exit_write_t> token;
+        backfillee_store.new_write_token(&token);
+        backfillee_store.set_metainfo(
+            region_map_t<dummy_protocol_t, binary_blob_t>(pieces.begin(), pieces.end()),
+            order_source.check_in("backfillee_store.set_metainfo"),
+            &token,
+            &non_interruptor);
+    }
+
+    /* Write every key on the backfiller only, so both regions have chunks */
+    for (char c = 'a'; c <= 'z'; c++) {
+        dummy_protocol_t::write_t w;
+        dummy_protocol_t::write_response_t response;
+        w.values[std::string(1, c)] = strprintf("%c", c);
+
+        transition_timestamp_t ts = transition_timestamp_t::starting_from(timestamp);
+        timestamp = ts.timestamp_after();
+
+        cond_t non_interruptor;
+        write_token_pair_t token_pair;
+        backfiller_store.new_write_token_pair(&token_pair);
+
+#ifndef NDEBUG
+        equality_metainfo_checker_callback_t<dummy_protocol_t>
+            metainfo_checker_callback(binary_blob_t(version_range_t(version_t(dummy_branch_id, ts.timestamp_before()))));
+        metainfo_checker_t<dummy_protocol_t> metainfo_checker(&metainfo_checker_callback, region);
+#endif
+
+        backfiller_store.write(
+            DEBUG_ONLY(metainfo_checker, )
+            region_map_t<dummy_protocol_t, binary_blob_t>(
+                region,
+                binary_blob_t(version_range_t(version_t(dummy_branch_id, timestamp)))
+            ),
+            w,
+            &response, WRITE_DURABILITY_SOFT,
+            ts,
+            order_source.check_in("backfiller_store.write"),
+            &token_pair,
+            &non_interruptor);
+    }
+    const version_t end_version(dummy_branch_id, timestamp);
+
+    simple_mailbox_cluster_t cluster;
+
+    backfiller_t<dummy_protocol_t> backfiller(
+        cluster.get_mailbox_manager(),
+        &branch_history_manager,
+        &backfiller_store);
+
+    watchable_variable_t<boost::optional<backfiller_business_card_t<dummy_protocol_t> > > pseudo_directory(
+        boost::optional<backfiller_business_card_t<dummy_protocol_t> >(backfiller.get_business_card()));
+
+    /* Run a backfill until the backfiller has finished one region and the
+    backfillee has checkpointed it, then interrupt it */
+    {
+        cond_t interruptor, interrupted;
+        coro_t::spawn_sometime(boost::bind(&run_backfillee_until_interrupted,
+                                           cluster.get_mailbox_manager(),
+                                           &branch_history_manager,
+                                           &backfillee_store,
+                                           pseudo_directory.get_watchable()->subview(&wrap_in_optional),
+                                           &interruptor,
+                                           &interrupted));
+
+        backfiller_store.first_region_finished.wait_lazily_unordered();
+
+        const region_map_t<dummy_protocol_t, version_range_t> finished_checkpoint(
+            backfiller_store.first_finished_region, version_range_t(end_version));
+        for (int i = 0; i < 1000; ++i) {
+            if (get_version_map(&backfillee_store, &order_source).mask(backfiller_store.first_finished_region) == finished_checkpoint) {
+                break;
+            }
+            nap(10);
+        }
+
+        interruptor.pulse();
+        interrupted.wait_lazily_unordered();
+
+        region_map_t<dummy_protocol_t, version_range_t> metainfo = get_version_map(&backfillee_store, &order_source);
+        EXPECT_TRUE(metainfo.mask(backfiller_store.first_finished_region) == finished_checkpoint);
+
+        /* The unfinished region still says that it's somewhere in between */
+        std::vector<dummy_protocol_t::region_t> unfinished_regions = region_subtract_many(region,
+            std::vector<dummy_protocol_t::region_t>(1, backfiller_store.first_finished_region));
+        ASSERT_EQ(1u, unfinished_regions.size());
+        dummy_protocol_t::region_t unfinished_region = unfinished_regions[0];
+        const region_map_t<dummy_protocol_t, version_range_t> span(
+            unfinished_region, version_range_t(start_version, end_version));
+        EXPECT_TRUE(metainfo.mask(unfinished_region) == span);
+
+        for (std::set<std::string>::iterator it = backfiller_store.first_finished_region.keys.begin();
+             it != backfiller_store.first_finished_region.keys.end(); ++it) {
+            EXPECT_EQ(backfiller_store.values[*it], backfillee_store.values[*it]);
+        }
+    }
+
+    /* The next backfill only sends the region that didn't finish */
+    dummy_protocol_t::region_t finished_region = backfiller_store.first_finished_region;
+    backfiller_store.pause_after_first_region = false;
+    backfiller_store.keys_sent.clear();
+
+    cond_t interruptor;
+    backfillee<dummy_protocol_t>(
+        cluster.get_mailbox_manager(),
+        &branch_history_manager,
+        &backfillee_store,
+        backfillee_store.get_region(),
+        pseudo_directory.get_watchable()->subview(&wrap_in_optional),
+        generate_uuid(),
+        &interruptor);
+
+    EXPECT_FALSE(backfiller_store.keys_sent.empty());
+    for (std::set<std::string>::iterator it = backfiller_store.keys_sent.begin();
+         it != backfiller_store.keys_sent.end(); ++it) {
+        EXPECT_EQ(0u, finished_region.keys.count(*it)) << "resent " << *it;
+    }
+
+    for (char c = 'a'; c <= 'z'; c++) {
+        std::string key(1, c);
+        EXPECT_EQ(backfiller_store.values[key], backfillee_store.values[key]);
+        EXPECT_TRUE(backfiller_store.timestamps[key] == backfillee_store.timestamps[key]);
+    }
+    const region_map_t<dummy_protocol_t, version_range_t> backfilled(region, version_range_t(end_version));
+    EXPECT_TRUE(get_version_map(&backfillee_store, &order_source) == backfilled);
+}
+TEST(ClusteringBackfill, InterruptedBackfillResumes) {
+    unittest::run_in_thread_pool(&run_interrupted_backfill_test);
+}
+
+TEST(ClusteringBackfill, ChunkBatchRoundTrip) {
+    backfill_chunk_batch_t<dummy_protocol_t> batch;
+    EXPECT_TRUE(batch.empty());
+    for (int i = 0; i < 1000; ++i) {
+        dummy_protocol_t::backfill_chunk_t chunk;
+        chunk.key = strprintf("key%d", i);
+        chunk.value = std::string(i, 'v');
+        chunk.timestamp = state_timestamp_t::zero();
+        batch.add_chunk(chunk);
+    }
+    EXPECT_EQ(1000, batch.get_num_chunks());
+    batch.add_finished_region(mock::a_thru_z_region());
+
+    /* Send it through a message, the way the backfiller does */
+    write_message_t msg;
+    msg << batch;
+    vector_stream_t stream;
+    ASSERT_EQ(0, send_write_message(&stream, &msg));
+    vector_read_stream_t read_stream(&stream.vector());
+    backfill_chunk_batch_t<dummy_protocol_t> received;
+    ASSERT_EQ(ARCHIVE_SUCCESS, deserialize(&read_stream, &received));
+    EXPECT_EQ(batch.get_size_in_bytes(), received.get_size_in_bytes());
+
+    std::vector<dummy_protocol_t::backfill_chunk_t> chunks;
+    received.get_chunks(&chunks);
+    ASSERT_EQ(1000u, chunks.size());
+    for (int i = 0; i < 1000; ++i) {
+        EXPECT_EQ(strprintf("key%d", i), chunks[i].key);
+        EXPECT_EQ(std::string(i, 'v'), chunks[i].value);
+    }
+    ASSERT_EQ(1u, received.get_finished_regions().size());
+    EXPECT_TRUE(received.get_finished_regions()[0] == mock::a_thru_z_region());
+}
+
 }   /* namespace unittest */
@@ -318,4 +318,151 @@ TEST(ClusteringBranch, PartialBackfill) {
     run_in_thread_pool_with_broadcaster(&run_partial_backfill_test);
 }
 
+/* The `WriteBatching` tests keep as many writes outstanding as the
+broadcaster allows. The first `BROADCASTER_MAX_WRITE_BATCHES_OUT` go out one at
+a time and fill every mirror's window of batches; the rest queue up behind them
+and go out in full batches. Every write goes to one of a few keys, and each
+mirror's response says what the key held before, so we can tell if a mirror
+skipped a write or applied one out of order. */
+
+namespace {
+
+class ordered_write_callback_t : public broadcaster_t<dummy_protocol_t>::write_callback_t, public cond_t {
+public:
+    ordered_write_callback_t() : responses(0), unexpected_responses(0) { }
+
+    void on_response(peer_id_t, const dummy_protocol_t::write_response_t &response) {
+        ++responses;
+        std::map<std::string, std::string>::const_iterator it = response.old_values.find(key);
+        if (it == response.old_values.end() || it->second != previous_value) {
+            ++unexpected_responses;
+        }
+    }
+    void on_done() {
+        pulse();
+    }
+
+    std::string key;
+    std::string previous_value;
+    int responses;
+    int unexpected_responses;
+};
+
+/* Spawns writes `begin` through `end - 1`. Before each one it waits for the
+write `MAX_OUTSTANDING_WRITES` before it, so that no more writes are
+outstanding than the broadcaster allows. */
+void spawn_ordered_writes(broadcaster_t<dummy_protocol_t> *broadcaster, order_source_t *order_source,
+                          int begin, int end, std::map<std::string, std::string> *latest_values,
+                          scoped_array_t<ordered_write_callback_t> *callbacks) {
+    spawn_write_fake_ack_checker_t ack_checker;
+    const int max_outstanding = broadcaster_t<dummy_protocol_t>::MAX_OUTSTANDING_WRITES;
+    for (int i = begin; i < end; ++i) {
+        if (i >= max_outstanding) {
+            (*callbacks)[i - max_outstanding].wait_lazily_unordered();
+        }
+        ordered_write_callback_t *cb = &(*callbacks)[i];
+        cb->key = std::string(1, 'a' + i % 8);
+        cb->previous_value = (*latest_values)[cb->key];
+
+        dummy_protocol_t::write_t w;
+        w.values[cb->key] = (*latest_values)[cb->key] = strprintf("%d", i);
+
+        unittest::fake_fifo_enforcement_t enforce;
+        fifo_enforcer_sink_t::exit_write_t exiter(&enforce.sink, enforce.source.enter_write());
+        cond_t non_interruptor;
+        broadcaster->spawn_write(w, &exiter, order_source->check_in("unittest::spawn_ordered_writes"),
+                                 cb, &non_interruptor, &ack_checker);
+    }
+}
+
+const int num_ordered_writes = BROADCASTER_MAX_WRITE_BATCH * BROADCASTER_MAX_WRITE_BATCHES_OUT * 2 + 1;
+
+}   /* anonymous namespace */
+
+void run_write_batching_test(UNUSED io_backender_t *io_backender,
+                             simple_mailbox_cluster_t *cluster,
+                             branch_history_manager_t<dummy_protocol_t> *branch_history_manager,
+                             UNUSED clone_ptr_t<watchable_t<boost::optional<broadcaster_business_card_t<dummy_protocol_t> > > > broadcaster_metadata_view,
+                             scoped_ptr_t<broadcaster_t<dummy_protocol_t> > *broadcaster,
+                             test_store_t<dummy_protocol_t> *store,
+                             scoped_ptr_t<listener_t<dummy_protocol_t> > *initial_listener,
+                             order_source_t *order_source) {
+    /* The replier makes the mirror readable, so it sends responses */
+    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    let_stuff_happen();
+
+    std::map<std::string, std::string> latest_values;
+    scoped_array_t<ordered_write_callback_t> callbacks(num_ordered_writes);
+    spawn_ordered_writes(broadcaster->get(), order_source, 0, num_ordered_writes, &latest_values, &callbacks);
+
+    for (int i = 0; i < num_ordered_writes; ++i) {
+        callbacks[i].wait_lazily_unordered();
+        EXPECT_EQ(1, callbacks[i].responses) << "write " << i;
+        EXPECT_EQ(0, callbacks[i].unexpected_responses) << "write " << i;
+    }
+
+    for (std::map<std::string, std::string>::iterator it = latest_values.begin();
+         it != latest_values.end(); ++it) {
+        EXPECT_EQ(it->second, store->store.values[it->first]);
+    }
+}
+TEST(ClusteringBranch, WriteBatching) {
+    run_in_thread_pool_with_broadcaster(&run_write_batching_test);
+}
+
+void run_write_batching_new_listener_test(io_backender_t *io_backender,
+                                          simple_mailbox_cluster_t *cluster,
+                                          branch_history_manager_t<dummy_protocol_t> *branch_history_manager,
+                                          clone_ptr_t<watchable_t<boost::optional<broadcaster_business_card_t<dummy_protocol_t> > > > broadcaster_metadata_view,
+                                          scoped_ptr_t<broadcaster_t<dummy_protocol_t> > *broadcaster,
+                                          test_store_t<dummy_protocol_t> *store1,
+                                          scoped_ptr_t<listener_t<dummy_protocol_t> > *initial_listener,
+                                          order_source_t *order_source) {
+    replier_t<dummy_protocol_t> replier(initial_listener->get(), cluster->get_mailbox_manager(), branch_history_manager);
+    watchable_variable_t<boost::optional<replier_business_card_t<dummy_protocol_t> > > replier_directory_controller(
+        boost::optional<replier_business_card_t<dummy_protocol_t> >(replier.get_business_card()));
+    let_stuff_happen();
+
+    std::map<std::string, std::string> latest_values;
+    scoped_array_t<ordered_write_callback_t> callbacks(num_ordered_writes);
+    spawn_ordered_writes(broadcaster->get(), order_source, 0, num_ordered_writes / 2, &latest_values, &callbacks);
+
+    /* Add a second mirror while the first half of the writes is in flight.
+    The constructor backfills, so the writes keep going while it blocks. */
+    test_store_t<dummy_protocol_t> store2(io_backender, order_source, static_cast<dummy_protocol_t::context_t *>(NULL));
+    cond_t interruptor;
+    listener_t<dummy_protocol_t> listener2(
+        base_path_t("."),
+        io_backender,
+        cluster->get_mailbox_manager(),
+        broadcaster_metadata_view->subview(&wrap_broadcaster_in_optional),
+        branch_history_manager,
+        &store2.store,
+        replier_directory_controller.get_watchable()->subview(&wrap_replier_in_optional),
+        generate_uuid(),
+        &get_global_perfmon_collection(),
+        &interruptor,
+        order_source);
+    EXPECT_FALSE(listener2.get_broadcaster_lost_signal()->is_pulsed());
+
+    spawn_ordered_writes(broadcaster->get(), order_source, num_ordered_writes / 2, num_ordered_writes, &latest_values, &callbacks);
+
+    /* Only the first mirror is readable, so only it sends responses */
+    for (int i = 0; i < num_ordered_writes; ++i) {
+        callbacks[i].wait_lazily_unordered();
+        EXPECT_EQ(1, callbacks[i].responses) << "write " << i;
+        EXPECT_EQ(0, callbacks[i].unexpected_responses) << "write " << i;
+    }
+    let_stuff_happen();
+
+    for (std::map<std::string, std::string>::iterator it = latest_values.begin();
+         it != latest_values.end(); ++it) {
+        EXPECT_EQ(it->second, store1->store.values[it->first]);
+        EXPECT_EQ(it->second, store2.store.values[it->first]);
+    }
+}
+TEST(ClusteringBranch, WriteBatchingNewListener) {
+    run_in_thread_pool_with_broadcaster(&run_write_batching_new_listener_test);
+}
+
 }   /* namespace unittest */
@@ -57,4 +57,66 @@ TEST(ClusteringSuggester, NewNamespace) {
     EXPECT_EQ(machines.size(), blueprint.machines_roles.size());
 }
 
+TEST(ClusteringSuggester, SplitPointsByKeyCount) {
+    std::map<store_key_t, int64_t> key_counts;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        key_counts[store_key_t(std::string(1, c))] = c < 'e' ? 100 : 10;
+    }
+    std::map<store_key_t, double> no_traffic;
+
+    /* 'a' through 'd' hold 400 keys and the rest 220 */
+    std::vector<store_key_t> split_points = suggest_split_points(key_counts, no_traffic, 2, 0.5);
+    ASSERT_EQ(1u, split_points.size());
+    EXPECT_EQ(store_key_t("d"), split_points[0]);
+    EXPECT_LT(estimate_shard_imbalance(key_counts, no_traffic, split_points, 0.5), 1.2);
+
+    std::vector<store_key_t> even_split;
+    even_split.push_back(store_key_t("n"));
+    EXPECT_GT(estimate_shard_imbalance(key_counts, no_traffic, even_split, 0.5), 1.5);
+}
+
+TEST(ClusteringSuggester, SplitPointsByTraffic) {
+    std::map<store_key_t, int64_t> key_counts;
+    for (char c = 'a'; c <= 'z'; ++c) {
+        key_counts[store_key_t(std::string(1, c))] = 10;
+    }
+    std::map<store_key_t, double> traffic;
+    traffic[store_key_t("x")] = 1000;
+    traffic[store_key_t("y")] = 1000;
+
+    /* Counting only the keys, the middle is best */
+    std::vector<store_key_t> split_points = suggest_split_points(key_counts, traffic, 2, 0);
+    ASSERT_EQ(1u, split_points.size());
+    EXPECT_EQ(store_key_t("n"), split_points[0]);
+
+    /* Counting only the load, the two hot keys should be apart */
+    split_points = suggest_split_points(key_counts, traffic, 2, 1);
+    ASSERT_EQ(1u, split_points.size());
+    EXPECT_EQ(store_key_t("y"), split_points[0]);
+
+    /* Mixing them, the split moves towards the hot keys */
+    split_points = suggest_split_points(key_counts, traffic, 2, 0.5);
+    ASSERT_EQ(1u, split_points.size());
+    EXPECT_LT(store_key_t("n"), split_points[0]);
+    EXPECT_LT(estimate_shard_imbalance(key_counts, traffic, split_points, 0.5),
+              estimate_shard_imbalance(key_counts, traffic, std::vector<store_key_t>(1, store_key_t("n")), 0.5));
+}
+
+TEST(ClusteringSuggester, SplitPointsHotKey) {
+    std::map<store_key_t, int64_t> key_counts;
+    std::map<store_key_t, double> traffic;
+    traffic[store_key_t("a")] = 1;
+    traffic[store_key_t("m")] = 1000;
+    traffic[store_key_t("z")] = 1;
+
+    /* One key can't be split, so we get fewer shards than asked for, and they
+    must not be empty */
+    std::vector<store_key_t> split_points = suggest_split_points(key_counts, traffic, 4, 0.5);
+    ASSERT_EQ(2u, split_points.size());
+    EXPECT_EQ(store_key_t("m"), split_points[0]);
+    EXPECT_EQ(store_key_t("z"), split_points[1]);
+
+    EXPECT_TRUE(suggest_split_points(key_counts, std::map<store_key_t, double>(), 4, 0.5).empty());
+}
+
 }  // namespace unittest
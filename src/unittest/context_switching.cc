@@ -89,6 +89,41 @@ TEST(ContextSwitchingTest, SwitchBetweenContexts) {
     original_context = NULL;
 }
 
+__attribute__((noinline)) static void touch_stack(void) {
+    volatile char buffer[256 * 1024];
+    for (size_t i = 0; i < sizeof(buffer); i += 1024) {
+        buffer[i] = 1;
+    }
+}
+
+static void use_deep_stack(void) {
+    /* Touch a good chunk of the stack, then switch back once the stack is
+    shallow again. */
+    touch_stack();
+    context_switch(artificial_stack_1_context, original_context);
+    /* This will never get run */
+    test_int += 10000;
+}
+
+TEST(ContextSwitchingTest, ReleaseUnusedStackPages) {
+    scoped_ptr_t<context_ref_t> orig_context_local(new context_ref_t);
+    original_context = orig_context_local.get();
+    {
+        artificial_stack_t a(&use_deep_stack, 1024*1024);
+        artificial_stack_1_context = &a.context;
+
+        /* A fresh stack has hardly any committed pages. */
+        EXPECT_LT(a.committed_size(), 64 * 1024u);
+
+        context_switch(original_context, artificial_stack_1_context);
+        EXPECT_GE(a.committed_size(), 256 * 1024u);
+
+        a.release_unused_pages();
+        EXPECT_LT(a.committed_size(), 64 * 1024u);
+    }
+    original_context = NULL;
+}
+
 __attribute__((noreturn)) static void throw_an_exception() {
     throw std::runtime_error("This is a test exception");
 }
@@ -0,0 +1,174 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "arch/io/disk.hpp"
+#include "arch/timing.hpp"
+#include "clustering/administration/main/file_based_svs_by_namespace.hpp"
+#include "clustering/immediate_consistency/branch/multistore.hpp"
+#include "concurrency/pmap.hpp"
+#include "memcached/protocol.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* Does `num_writes` sets on the `i`th store of `svs`, on the store's thread,
+using only keys that belong to that store's hash sub-shard. */
+void write_to_store(int i, multistore_ptr_t<memcached_protocol_t> *svs, int num_writes) {
+    store_view_t<memcached_protocol_t> *store = svs->get_store(i);
+    on_thread_t th(store->home_thread());
+
+    memcached_protocol_t::region_t region = store->get_region();
+    order_source_t order_source;
+    state_timestamp_t timestamp = state_timestamp_t::zero();
+    cond_t non_interruptor;
+
+    int written = 0;
+    for (int k = 0; written < num_writes; ++k) {
+        store_key_t key(strprintf("key%d", k));
+        if (!region_contains_key(region, key)) {
+            continue;
+        }
+
+        sarc_mutation_t set;
+        set.key = key;
+        set.data = data_buffer_t::create(100);
+        memset(set.data->buf(), 'x', 100);
+        set.flags = 0;
+        set.exptime = 0;
+        set.add_policy = add_policy_yes;
+        set.replace_policy = replace_policy_yes;
+        memcached_protocol_t::write_t write(set, time(NULL), 12345);
+
+        transition_timestamp_t transition = transition_timestamp_t::starting_from(timestamp);
+        timestamp = transition.timestamp_after();
+
+#ifndef NDEBUG
+        trivial_metainfo_checker_callback_t<memcached_protocol_t> metainfo_checker_callback;
+        metainfo_checker_t<memcached_protocol_t> metainfo_checker(&metainfo_checker_callback, region);
+#endif
+
+        write_token_pair_t token_pair;
+        store->new_write_token_pair(&token_pair);
+        memcached_protocol_t::write_response_t response;
+        store->write(DEBUG_ONLY(metainfo_checker, )
+                     region_map_t<memcached_protocol_t, binary_blob_t>(region, binary_blob_t(timestamp)),
+                     write, &response, WRITE_DURABILITY_SOFT, transition,
+                     order_source.check_in("unittest::write_to_store"),
+                     &token_pair, &non_interruptor);
+        ++written;
+    }
+}
+
+/* Creates a table's stores with the given sharding factor, spreads
+`total_writes` writes over them and returns the writes per second. */
+double measure_write_throughput(file_based_svs_by_namespace_t<memcached_protocol_t> *svs_source,
+                                int cpu_sharding_factor, int total_writes) {
+    namespace_id_t namespace_id = generate_uuid();
+    memcached_protocol_t::context_t ctx;
+    perfmon_collection_t perfmon_collection;
+    double writes_per_sec;
+    {
+        stores_lifetimer_t<memcached_protocol_t> stores;
+        scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+        svs_source->get_svs(&perfmon_collection, namespace_id, GIGABYTE, cpu_sharding_factor,
+                            &stores, &svs, &ctx);
+        EXPECT_EQ(cpu_sharding_factor, svs->num_stores());
+
+        ticks_t start = get_ticks();
+        pmap(svs->num_stores(), boost::bind(&write_to_store, _1, svs.get(),
+                                            total_writes / svs->num_stores()));
+        writes_per_sec = total_writes / ticks_to_secs(get_ticks() - start);
+    }
+    svs_source->destroy_svs(namespace_id);
+    return writes_per_sec;
+}
+
+void run_store_count_test() {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender;
+    file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."));
+    namespace_id_t namespace_id = generate_uuid();
+    memcached_protocol_t::context_t ctx;
+    perfmon_collection_t perfmon_collection;
+
+    {
+        stores_lifetimer_t<memcached_protocol_t> stores;
+        scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+        svs_source.get_svs(&perfmon_collection, namespace_id, GIGABYTE, 3, &stores, &svs, &ctx);
+        ASSERT_EQ(3, svs->num_stores());
+
+        /* Each store should be on a thread of its own */
+        std::set<int> threads;
+        for (int i = 0; i < svs->num_stores(); ++i) {
+            threads.insert(svs->get_store(i)->home_thread());
+        }
+        EXPECT_EQ(3u, threads.size());
+    }
+
+    {
+        /* Once the table exists, its file decides how many stores it has */
+        stores_lifetimer_t<memcached_protocol_t> stores;
+        scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+        svs_source.get_svs(&perfmon_collection, namespace_id, GIGABYTE, 8, &stores, &svs, &ctx);
+        EXPECT_EQ(3, svs->num_stores());
+        EXPECT_EQ(memcached_protocol_t::region_t::universe(), svs->get_region());
+    }
+
+    svs_source.destroy_svs(namespace_id);
+}
+
+TEST(CpuSharding, StoreCount) {
+    run_in_thread_pool(&run_store_count_test, 4);
+}
+
+void run_store_placement_test() {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender;
+    file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."));
+    memcached_protocol_t::context_t ctx;
+    perfmon_collection_t perfmon_collection;
+    ASSERT_EQ(4, get_num_db_threads());
+
+    /* Each table's stores go on consecutive threads, starting where the
+    previous table's stores left off. */
+    int expected_thread = 0;
+    for (int factor = 1; factor <= 4; factor *= 2) {
+        namespace_id_t namespace_id = generate_uuid();
+        {
+            stores_lifetimer_t<memcached_protocol_t> stores;
+            scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+            svs_source.get_svs(&perfmon_collection, namespace_id, GIGABYTE, factor, &stores, &svs, &ctx);
+            ASSERT_EQ(factor, svs->num_stores());
+            EXPECT_EQ(memcached_protocol_t::region_t::universe(), svs->get_region());
+
+            for (int i = 0; i < svs->num_stores(); ++i) {
+                EXPECT_EQ(expected_thread, svs->get_store(i)->home_thread());
+                expected_thread = (expected_thread + 1) % get_num_db_threads();
+            }
+        }
+        svs_source.destroy_svs(namespace_id);
+    }
+}
+
+TEST(CpuSharding, StorePlacement) {
+    run_in_thread_pool(&run_store_placement_test, 4);
+}
+
+void run_write_scaling_benchmark() {
+    recreate_temporary_directory(base_path_t("."));
+    io_backender_t io_backender;
+    file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."));
+    const int total_writes = 40000;
+    for (int factor = 1; factor <= get_num_db_threads(); factor *= 2) {
+        double writes_per_sec = measure_write_throughput(&svs_source, factor, total_writes);
+        printf("cpu sharding factor %d: %.0f writes/sec\n", factor, writes_per_sec);
+    }
+}
+
+/* Not a correctness test, so it doesn't run by default; run it with
+`--gtest_also_run_disabled_tests` to see how write throughput scales. */
+TEST(CpuSharding, DISABLED_WriteScalingBenchmark) {
+    run_in_thread_pool(&run_write_scaling_benchmark, 8);
+}
+
+}  // namespace unittest
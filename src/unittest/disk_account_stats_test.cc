@@ -0,0 +1,129 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <stdlib.h>
+
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/io/disk/account_stats.hpp"
+#include "arch/io/disk/accounting.hpp"
+#include "arch/types.hpp"
+#include "containers/scoped.hpp"
+#include "perfmon/collect.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+namespace {
+
+/* Lays the stats out the way the serializer does: one set per priority, and
+`serializer_io` summing them all up. */
+struct io_stats_fixture_t {
+    io_stats_fixture_t()
+        : membership(&get_global_perfmon_collection(), &collection, "io_account_stats_test"),
+          totals(&collection, "serializer_io"),
+          low(&collection, "serializer_io_priority_1", &totals),
+          high(&collection, "serializer_io_priority_2", &totals) { }
+
+    perfmon_collection_t collection;
+    perfmon_membership_t membership;
+    io_account_stats_t totals, low, high;
+};
+
+const perfmon_result_t *get_stat(const perfmon_result_t *stats, const std::string &name) {
+    perfmon_result_t::const_iterator it = stats->get_map()->find(name);
+    guarantee(it != stats->end(), "no stat named %s", name.c_str());
+    return it->second;
+}
+
+int64_t get_io_stat(const perfmon_result_t *stats, const std::string &account, const std::string &name) {
+    const perfmon_result_t *test_stats = get_stat(stats, "io_account_stats_test");
+    return atoll(get_stat(get_stat(test_stats, account), name)->get_string()->c_str());
+}
+
+void count_done(int *done_count, UNUSED accounting_diskmgr_t::action_t *a) {
+    ++*done_count;
+}
+
+const char *const stat_names[] = { "queued", "in_flight", "reads", "writes", "read_bytes", "written_bytes" };
+
+}   /* anonymous namespace */
+
+void run_account_stats_test() {
+    io_stats_fixture_t fixture;
+
+    accounting_diskmgr_t diskmgr(1);
+    int done_count = 0;
+    diskmgr.done_fun = boost::bind(&count_done, &done_count, _1);
+
+    /* The second account may only have two requests out at once, so some of
+    its requests wait in the account before they even reach the queue. */
+    accounting_diskmgr_t::account_t low_account(&diskmgr, 1, UNLIMITED_OUTSTANDING_REQUESTS, &fixture.low);
+    accounting_diskmgr_t::account_t high_account(&diskmgr, 2, 2, &fixture.high);
+
+    const int num_actions = 20;
+    char buf[1];
+    scoped_array_t<accounting_diskmgr_t::action_t> actions(num_actions);
+    int64_t expected[2][4] = { { 0, 0, 0, 0 }, { 0, 0, 0, 0 } };
+    for (int i = 0; i < num_actions; ++i) {
+        const int which = i % 2;
+        const size_t count = (i + 1) * 512;
+        if (i % 3 == 0) {
+            actions[i].make_write(INVALID_FD, buf, count, 0);
+            expected[which][1] += 1;
+            expected[which][3] += count;
+        } else {
+            actions[i].make_read(INVALID_FD, buf, count, 0);
+            expected[which][0] += 1;
+            expected[which][2] += count;
+        }
+        actions[i].account = which == 0 ? &low_account : &high_account;
+        diskmgr.submit(&actions[i]);
+    }
+
+    {
+        scoped_ptr_t<perfmon_result_t> stats = perfmon_get_stats();
+        EXPECT_EQ(num_actions, get_io_stat(stats.get(), "serializer_io", "queued"));
+        EXPECT_EQ(0, get_io_stat(stats.get(), "serializer_io", "in_flight"));
+    }
+
+    /* Play the part of the disk: take whatever the accounting queue lets
+    through, then finish it all. */
+    while (done_count < num_actions) {
+        std::vector<accounting_payload_t *> in_flight;
+        while (diskmgr.producer->available->get()) {
+            in_flight.push_back(diskmgr.producer->pop());
+        }
+        ASSERT_FALSE(in_flight.empty());
+
+        scoped_ptr_t<perfmon_result_t> stats = perfmon_get_stats();
+        EXPECT_EQ(static_cast<int64_t>(in_flight.size()), get_io_stat(stats.get(), "serializer_io", "in_flight"));
+        EXPECT_EQ(num_actions - done_count - static_cast<int64_t>(in_flight.size()),
+                  get_io_stat(stats.get(), "serializer_io", "queued"));
+        EXPECT_GE(2, get_io_stat(stats.get(), "serializer_io_priority_2", "in_flight"));
+
+        for (size_t i = 0; i < in_flight.size(); ++i) {
+            diskmgr.done(in_flight[i]);
+        }
+    }
+
+    scoped_ptr_t<perfmon_result_t> stats = perfmon_get_stats();
+    const char *accounts[] = { "serializer_io_priority_1", "serializer_io_priority_2" };
+    for (size_t i = 0; i < sizeof(stat_names) / sizeof(stat_names[0]); ++i) {
+        int64_t sum = 0;
+        for (int a = 0; a < 2; ++a) {
+            int64_t value = get_io_stat(stats.get(), accounts[a], stat_names[i]);
+            EXPECT_EQ(i < 2 ? 0 : expected[a][i - 2], value) << accounts[a] << " " << stat_names[i];
+            sum += value;
+        }
+        EXPECT_EQ(sum, get_io_stat(stats.get(), "serializer_io", stat_names[i])) << stat_names[i];
+    }
+}
+
+TEST(DiskAccountStats, CountsMatchSubmitted) {
+    run_in_thread_pool(&run_account_stats_test);
+}
+
+}  // namespace unittest
@@ -7,6 +7,7 @@
 
 #include "arch/timing.hpp"
 #include "concurrency/auto_drainer.hpp"
+#include "concurrency/contention.hpp"
 #include "concurrency/fifo_enforcer_queue.hpp"
 #include "concurrency/wait_any.hpp"
 #include "unittest/unittest_utils.hpp"
@@ -148,5 +149,47 @@ TEST(FIFOEnforcer, QueueEquivalence) {
     unittest::run_in_thread_pool(&run_queue_equivalence_test);
 }
 
+/* Makes a token wait for the one before it, with the contention profiler on or
+off, and returns what the profiler recorded. */
+contention_stats_t wait_for_token(bool profile) {
+    contention_site_t site("unittest fifo enforcer");
+    const bool was_profiling = global_profile_contention;
+    global_profile_contention = profile;
+    {
+        fifo_enforcer_source_t source;
+        fifo_enforcer_sink_t sink(&site);
+        fifo_enforcer_write_token_t first = source.enter_write();
+        fifo_enforcer_write_token_t second = source.enter_write();
+        fifo_enforcer_sink_t::exit_write_t second_exit(&sink, second);
+        EXPECT_FALSE(second_exit.is_pulsed());
+        EXPECT_EQ(profile ? 1 : 0, site.get_thread_stats().waiters);
+        nap(5);
+        {
+            fifo_enforcer_sink_t::exit_write_t first_exit(&sink, first);
+            EXPECT_TRUE(first_exit.is_pulsed());
+        }
+        EXPECT_TRUE(second_exit.is_pulsed());
+    }
+    global_profile_contention = was_profiling;
+    return site.get_thread_stats();
+}
+
+void run_contention_profiler_test() {
+    contention_stats_t stats = wait_for_token(true);
+    EXPECT_EQ(1, stats.waits);
+    EXPECT_GT(stats.wait_ticks, 0);
+    EXPECT_EQ(stats.wait_ticks, stats.max_wait_ticks);
+    EXPECT_EQ(0, stats.waiters);
+    EXPECT_EQ(1, stats.max_waiters);
+
+    stats = wait_for_token(false);
+    EXPECT_EQ(0, stats.waits);
+    EXPECT_EQ(0, stats.max_waiters);
+}
+
+TEST(FIFOEnforcer, ContentionProfiler) {
+    unittest::run_in_thread_pool(&run_contention_profiler_test);
+}
+
 }   /* namespace unittest */
 
@@ -0,0 +1,74 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <string>
+#include <vector>
+
+#include "unittest/gtest.hpp"
+
+#include "containers/lz_compress.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+void check_round_trip(const std::string &data) {
+    std::vector<char> compressed;
+    lz_compress(data.data(), data.size(), &compressed);
+
+    std::vector<char> decompressed;
+    ASSERT_TRUE(lz_decompress(compressed.data(), compressed.size(), data.size(), &decompressed));
+    ASSERT_EQ(data, std::string(decompressed.begin(), decompressed.end()));
+}
+
+TEST(LzCompressTest, Empty) {
+    check_round_trip("");
+}
+
+TEST(LzCompressTest, Short) {
+    check_round_trip("a");
+    check_round_trip("abcdefgh");
+    check_round_trip("aaaaaaaaa");
+}
+
+TEST(LzCompressTest, Repetitive) {
+    std::string data;
+    for (int i = 0; i < 1000; ++i) {
+        data += strprintf("{\"id\": %d, \"name\": \"document\", \"tags\": [\"x\", \"y\"]}", i);
+    }
+    check_round_trip(data);
+
+    std::vector<char> compressed;
+    lz_compress(data.data(), data.size(), &compressed);
+    ASSERT_LT(compressed.size(), data.size() / 3);
+
+    /* Long runs need the extra length bytes for both literals and matches */
+    check_round_trip(std::string(100000, 'z'));
+}
+
+TEST(LzCompressTest, Random) {
+    rng_t rng;
+    std::string data;
+    for (int i = 0; i < 100000; ++i) {
+        data.push_back(static_cast<char>(rng.randint(256)));
+    }
+    check_round_trip(data);
+
+    std::vector<char> compressed;
+    lz_compress(data.data(), data.size(), &compressed);
+    ASSERT_LE(compressed.size(), data.size() + data.size() / 255 + 16);
+}
+
+TEST(LzCompressTest, Corrupt) {
+    std::string data(1000, 'q');
+    std::vector<char> compressed;
+    lz_compress(data.data(), data.size(), &compressed);
+
+    std::vector<char> out;
+    ASSERT_FALSE(lz_decompress(compressed.data(), compressed.size(), data.size() - 1, &out));
+    ASSERT_FALSE(lz_decompress(compressed.data(), compressed.size(), data.size() + 1, &out));
+    ASSERT_FALSE(lz_decompress(compressed.data(), compressed.size() - 1, data.size(), &out));
+
+    /* An offset that points before the start of the output */
+    const char bad_offset[] = { 0x10, 'a', 0x05, 0x00 };
+    ASSERT_FALSE(lz_decompress(bad_offset, sizeof(bad_offset), 5, &out));
+}
+
+}  // namespace unittest
@@ -0,0 +1,380 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <endian.h>
+
+#include <map>
+#include <string>
+#include <vector>
+
+#include "concurrency/cond_var.hpp"
+#include "memcached/binary_parser.hpp"
+#include "memcached/parser.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/memcached_utils.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+/* Feeds `input` to the memcached handler and collects what it writes back. */
+class string_memcached_interface_t : public memcached_interface_t {
+public:
+    explicit string_memcached_interface_t(const std::string &_input) : input(_input), position(0) { }
+
+    void write(const char *buffer, size_t bytes, UNUSED signal_t *interruptor) {
+        output.append(buffer, bytes);
+    }
+    void write_unbuffered(const char *buffer, size_t bytes, UNUSED signal_t *interruptor) {
+        output.append(buffer, bytes);
+    }
+    void flush_buffer(UNUSED signal_t *interruptor) { }
+    bool is_write_open() { return true; }
+
+    void read(void *buf, size_t nbytes, signal_t *interruptor) {
+        memcpy(buf, peek(nbytes, interruptor), nbytes);
+        position += nbytes;
+    }
+
+    void read_line(std::vector<char> *dest, UNUSED signal_t *interruptor) {
+        size_t end = input.find("\r\n", position);
+        if (end == std::string::npos) {
+            throw no_more_data_exc_t();
+        }
+        dest->assign(input.begin() + position, input.begin() + end + 2);
+        position = end + 2;
+    }
+
+    const char *peek(size_t nbytes, UNUSED signal_t *interruptor) {
+        if (input.size() - position < nbytes) {
+            throw no_more_data_exc_t();
+        }
+        return input.data() + position;
+    }
+
+    void pop(size_t nbytes, signal_t *interruptor) {
+        peek(nbytes, interruptor);
+        position += nbytes;
+    }
+
+    std::string output;
+
+private:
+    std::string input;
+    size_t position;
+};
+
+/* An in-memory table that only does what the binary protocol tests need: gets
+and plain sets. It remembers how many keys each read asked for. */
+class mock_memcached_namespace_interface_t : public namespace_interface_t<memcached_protocol_t> {
+public:
+    mock_memcached_namespace_interface_t() : num_writes(0) { }
+
+    void read(const memcached_protocol_t::read_t &read, memcached_protocol_t::read_response_t *response,
+              UNUSED order_token_t tok, UNUSED signal_t *interruptor)
+              THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+        const get_multi_query_t *get_multi = boost::get<get_multi_query_t>(&read.query);
+        guarantee(get_multi != NULL);
+        read_sizes.push_back(get_multi->keys.size());
+
+        get_multi_result_t result;
+        result.keys = get_multi->keys;
+        for (size_t i = 0; i < get_multi->keys.size(); ++i) {
+            std::map<store_key_t, std::string>::const_iterator it = values.find(get_multi->keys[i]);
+            if (it == values.end()) {
+                result.results.push_back(get_result_t());
+            } else {
+                counted_t<data_buffer_t> value = data_buffer_t::create(it->second.size());
+                memcpy(value->buf(), it->second.data(), it->second.size());
+                result.results.push_back(get_result_t(value, 0, 0));
+            }
+        }
+        response->result = result;
+    }
+
+    void read_outdated(const memcached_protocol_t::read_t &read, memcached_protocol_t::read_response_t *response,
+                       signal_t *interruptor)
+                       THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+        this->read(read, response, order_token_t::ignore, interruptor);
+    }
+
+    void write(const memcached_protocol_t::write_t &write, memcached_protocol_t::write_response_t *response,
+               UNUSED order_token_t tok, UNUSED signal_t *interruptor)
+               THROWS_ONLY(interrupted_exc_t, cannot_perform_query_exc_t) {
+        const sarc_mutation_t *set = boost::get<sarc_mutation_t>(&write.mutation);
+        guarantee(set != NULL);
+        ++num_writes;
+        values[set->key] = std::string(set->data->buf(), set->data->size());
+        response->result = sr_stored;
+    }
+
+    std::map<store_key_t, std::string> values;
+    std::vector<size_t> read_sizes;
+    int num_writes;
+};
+
+const uint8_t op_get = 0x00, op_set = 0x01, op_getq = 0x09, op_noop = 0x0a, op_getkq = 0x0d;
+const uint16_t status_ok = 0x0000, status_too_large = 0x0003, status_invalid_arguments = 0x0004,
+    status_unknown_command = 0x0081;
+
+std::string encode_uint16(uint16_t x) {
+    x = htobe16(x);
+    return std::string(reinterpret_cast<const char *>(&x), sizeof(x));
+}
+
+std::string encode_uint32(uint32_t x) {
+    x = htobe32(x);
+    return std::string(reinterpret_cast<const char *>(&x), sizeof(x));
+}
+
+/* A request header that claims a body of `body_size` bytes, whatever follows it */
+std::string request_header(uint8_t opcode, size_t key_size, size_t extras_size,
+                           size_t body_size, uint32_t opaque) {
+    std::string header;
+    header += static_cast<char>(memcached_binary_request_magic);
+    header += static_cast<char>(opcode);
+    header += encode_uint16(key_size);
+    header += static_cast<char>(extras_size);
+    header += std::string(3, '\0');   // Data type and vbucket
+    header += encode_uint32(body_size);
+    header += encode_uint32(opaque);
+    header += std::string(8, '\0');   // CAS
+    return header;
+}
+
+std::string request(uint8_t opcode, const std::string &key = "", const std::string &value = "",
+                    const std::string &extras = "", uint32_t opaque = 0) {
+    return request_header(opcode, key.size(), extras.size(), extras.size() + key.size() + value.size(), opaque)
+        + extras + key + value;
+}
+
+std::string set_request(const std::string &key, const std::string &value, uint32_t opaque = 0) {
+    // Flags and expiration time
+    return request(op_set, key, value, std::string(8, '\0'), opaque);
+}
+
+struct binary_response_t {
+    uint8_t opcode;
+    uint16_t status;
+    uint32_t opaque;
+    std::string key;
+    std::string value;
+};
+
+std::vector<binary_response_t> parse_responses(const std::string &output) {
+    std::vector<binary_response_t> responses;
+    size_t position = 0;
+    while (position < output.size()) {
+        if (output.size() - position < 24) {
+            ADD_FAILURE() << "truncated response header";
+            break;
+        }
+        const uint8_t *header = reinterpret_cast<const uint8_t *>(output.data() + position);
+        EXPECT_EQ(0x81, header[0]);
+        binary_response_t response;
+        response.opcode = header[1];
+        const size_t key_size = (header[2] << 8) | header[3];
+        const size_t extras_size = header[4];
+        response.status = (header[6] << 8) | header[7];
+        uint32_t body_size, opaque;
+        memcpy(&body_size, header + 8, sizeof(body_size));
+        memcpy(&opaque, header + 12, sizeof(opaque));
+        body_size = be32toh(body_size);
+        response.opaque = be32toh(opaque);
+        position += 24;
+        if (output.size() - position < body_size || body_size < extras_size + key_size) {
+            ADD_FAILURE() << "truncated response body";
+            break;
+        }
+        response.key = output.substr(position + extras_size, key_size);
+        response.value = output.substr(position + extras_size + key_size,
+                                       body_size - extras_size - key_size);
+        position += body_size;
+        responses.push_back(response);
+    }
+    return responses;
+}
+
+/* Runs `input` through the memcached handler against `nsi`, and returns the
+responses it sent back. */
+std::vector<binary_response_t> run_binary_session(const std::string &input,
+                                                  namespace_interface_t<memcached_protocol_t> *nsi) {
+    string_memcached_interface_t interface(input);
+    perfmon_collection_t stats_collection;
+    memcached_stats_t stats(&stats_collection);
+    cond_t interruptor;
+    handle_memcache(&interface, nsi, MAX_CONCURRENT_QUERIES_PER_CONNECTION, &stats, &interruptor);
+    return parse_responses(interface.output);
+}
+
+void run_body_shorter_than_key_test() {
+    mock_memcached_namespace_interface_t nsi;
+    // A 5-byte key in a 2-byte body, followed by a request that must never be
+    // looked at.
+    std::string input = request_header(op_get, 5, 0, 2, 0) + "abcde" + request(op_noop);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+    EXPECT_TRUE(responses.empty());
+    EXPECT_TRUE(nsi.read_sizes.empty());
+}
+
+TEST(MemcachedBinaryProtocol, BodyShorterThanKey) {
+    run_in_thread_pool(&run_body_shorter_than_key_test);
+}
+
+void run_unknown_opcode_test() {
+    mock_memcached_namespace_interface_t nsi;
+    // The body of the unknown request has to be skipped, or the no-op after it
+    // would be read from the middle of it.
+    std::string input = request(0x30, "key", "value", "", 1) + request(op_noop, "", "", "", 2);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ(0x30, responses[0].opcode);
+    EXPECT_EQ(status_unknown_command, responses[0].status);
+    EXPECT_EQ(1u, responses[0].opaque);
+    EXPECT_EQ(op_noop, responses[1].opcode);
+    EXPECT_EQ(status_ok, responses[1].status);
+    EXPECT_EQ(2u, responses[1].opaque);
+}
+
+TEST(MemcachedBinaryProtocol, UnknownOpcode) {
+    run_in_thread_pool(&run_unknown_opcode_test);
+}
+
+void run_wrong_extras_size_test() {
+    mock_memcached_namespace_interface_t nsi;
+    // Sets have 8 bytes of extras, not 4
+    std::string input = request(op_set, "key", "value", std::string(4, '\0'), 1) + request(op_noop, "", "", "", 2);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ(op_set, responses[0].opcode);
+    EXPECT_EQ(status_invalid_arguments, responses[0].status);
+    EXPECT_EQ(op_noop, responses[1].opcode);
+    EXPECT_EQ(status_ok, responses[1].status);
+    EXPECT_EQ(0, nsi.num_writes);
+}
+
+TEST(MemcachedBinaryProtocol, WrongExtrasSize) {
+    run_in_thread_pool(&run_wrong_extras_size_test);
+}
+
+void run_key_too_long_test() {
+    mock_memcached_namespace_interface_t nsi;
+    std::string input = request(op_get, std::string(MAX_KEY_SIZE + 1, 'k'), "", "", 1)
+        + request(op_get, std::string(MAX_KEY_SIZE, 'k'), "", "", 2);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ(status_invalid_arguments, responses[0].status);
+    EXPECT_EQ(1u, responses[0].opaque);
+    // The longest allowed key gets looked up, and isn't found.
+    EXPECT_EQ(0x0001, responses[1].status);
+    EXPECT_EQ(2u, responses[1].opaque);
+    ASSERT_EQ(1u, nsi.read_sizes.size());
+}
+
+TEST(MemcachedBinaryProtocol, KeyTooLong) {
+    run_in_thread_pool(&run_key_too_long_test);
+}
+
+void run_value_too_large_test() {
+    mock_memcached_namespace_interface_t nsi;
+    std::string input = set_request("big", std::string(MAX_VALUE_SIZE + 1, 'v'), 1)
+        + set_request("small", "v", 2);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ(status_too_large, responses[0].status);
+    EXPECT_EQ(1u, responses[0].opaque);
+    EXPECT_EQ(status_ok, responses[1].status);
+    EXPECT_EQ(2u, responses[1].opaque);
+    EXPECT_EQ(1, nsi.num_writes);
+    EXPECT_EQ(0u, nsi.values.count(store_key_t("big")));
+}
+
+TEST(MemcachedBinaryProtocol, ValueTooLarge) {
+    run_in_thread_pool(&run_value_too_large_test);
+}
+
+void run_quiet_gets_flushed_by_noop_test() {
+    mock_memcached_namespace_interface_t nsi;
+    nsi.values[store_key_t("a")] = "value-a";
+    nsi.values[store_key_t("c")] = "value-c";
+    std::string input = request(op_getq, "a", "", "", 1)
+        + request(op_getkq, "b", "", "", 2)
+        + request(op_getkq, "c", "", "", 3)
+        + request(op_noop, "", "", "", 4);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+
+    // All three gets go out as one read, and the miss isn't answered.
+    ASSERT_EQ(1u, nsi.read_sizes.size());
+    EXPECT_EQ(3u, nsi.read_sizes[0]);
+    ASSERT_EQ(3u, responses.size());
+    EXPECT_EQ(1u, responses[0].opaque);
+    EXPECT_EQ("", responses[0].key);
+    EXPECT_EQ("value-a", responses[0].value);
+    EXPECT_EQ(3u, responses[1].opaque);
+    EXPECT_EQ("c", responses[1].key);
+    EXPECT_EQ("value-c", responses[1].value);
+    EXPECT_EQ(op_noop, responses[2].opcode);
+    EXPECT_EQ(4u, responses[2].opaque);
+}
+
+TEST(MemcachedBinaryProtocol, QuietGetsFlushedByNoop) {
+    run_in_thread_pool(&run_quiet_gets_flushed_by_noop_test);
+}
+
+void run_quiet_gets_flushed_by_batch_limit_test() {
+    mock_memcached_namespace_interface_t nsi;
+    const size_t num_gets = 2 * MAX_BATCHED_BINARY_MEMCACHED_GETS + 5;
+    std::string input;
+    for (size_t i = 0; i < num_gets; ++i) {
+        input += request(op_getq, strprintf("key%zu", i), "", "", i);
+    }
+    input += request(op_noop, "", "", "", num_gets);
+    std::vector<binary_response_t> responses = run_binary_session(input, &nsi);
+
+    ASSERT_EQ(3u, nsi.read_sizes.size());
+    EXPECT_EQ(static_cast<size_t>(MAX_BATCHED_BINARY_MEMCACHED_GETS), nsi.read_sizes[0]);
+    EXPECT_EQ(static_cast<size_t>(MAX_BATCHED_BINARY_MEMCACHED_GETS), nsi.read_sizes[1]);
+    EXPECT_EQ(5u, nsi.read_sizes[2]);
+    // Every key is missing, so only the no-op is answered.
+    ASSERT_EQ(1u, responses.size());
+    EXPECT_EQ(op_noop, responses[0].opcode);
+}
+
+TEST(MemcachedBinaryProtocol, QuietGetsFlushedByBatchLimit) {
+    run_in_thread_pool(&run_quiet_gets_flushed_by_batch_limit_test);
+}
+
+/* The mock above answers every key on its own, so this runs a batch of quiet
+gets against real stores: several keys, one of them twice, in both shards. */
+void run_quiet_gets_against_store_test(namespace_interface_t<memcached_protocol_t> *nsi,
+                                       UNUSED order_source_t *order_source) {
+    std::vector<binary_response_t> responses = run_binary_session(
+        set_request("a", "value-a", 1) + set_request("z", "value-z", 2), nsi);
+    ASSERT_EQ(2u, responses.size());
+    EXPECT_EQ(status_ok, responses[0].status);
+    EXPECT_EQ(status_ok, responses[1].status);
+
+    std::string input = request(op_getq, "a", "", "", 3)
+        + request(op_getkq, "b", "", "", 4)
+        + request(op_getkq, "z", "", "", 5)
+        + request(op_getq, "a", "", "", 6)
+        + request(op_getkq, "c", "", "", 7)
+        + request(op_noop, "", "", "", 8);
+    responses = run_binary_session(input, nsi);
+
+    // The misses aren't answered.
+    ASSERT_EQ(4u, responses.size());
+    EXPECT_EQ(3u, responses[0].opaque);
+    EXPECT_EQ(status_ok, responses[0].status);
+    EXPECT_EQ("value-a", responses[0].value);
+    EXPECT_EQ(5u, responses[1].opaque);
+    EXPECT_EQ("z", responses[1].key);
+    EXPECT_EQ("value-z", responses[1].value);
+    EXPECT_EQ(6u, responses[2].opaque);
+    EXPECT_EQ("value-a", responses[2].value);
+    EXPECT_EQ(op_noop, responses[3].opcode);
+    EXPECT_EQ(8u, responses[3].opaque);
+}
+
+TEST(MemcachedBinaryProtocol, QuietGetsAgainstStore) {
+    run_in_thread_pool_with_namespace_interface(&run_quiet_gets_against_store_test);
+}
+
+}  // namespace unittest
@@ -9,6 +9,7 @@
 #include "serializer/translator.hpp"
 #include "unittest/gtest.hpp"
 #include "unittest/dummy_namespace_interface.hpp"
+#include "unittest/memcached_utils.hpp"
 
 namespace unittest {
 
@@ -123,6 +124,32 @@ void run_get_set_test(namespace_interface_t<memcached_protocol_t> *nsi, order_so
         }
     }
 
+    {
+        get_multi_query_t get_multi;
+        get_multi.keys.push_back(store_key_t("b"));
+        get_multi.keys.push_back(store_key_t("a"));
+        get_multi.keys.push_back(store_key_t("b"));
+        memcached_protocol_t::read_t read(get_multi, time(NULL));
+
+        cond_t interruptor;
+        memcached_protocol_t::read_response_t result;
+        nsi->read(read, &result, order_source->check_in("unittest::run_get_set_test(memcached_protocol.cc-D)").with_read_mode(), &interruptor);
+
+        if (get_multi_result_t *maybe_get_multi_result = boost::get<get_multi_result_t>(&result.result)) {
+            ASSERT_EQ(3u, maybe_get_multi_result->results.size());
+            EXPECT_TRUE(maybe_get_multi_result->results[0].value.get() == NULL);
+            EXPECT_TRUE(maybe_get_multi_result->results[2].value.get() == NULL);
+            const get_result_t &a_result = maybe_get_multi_result->results[1];
+            EXPECT_TRUE(a_result.value.get() != NULL);
+            if (a_result.value.get() != NULL && a_result.value->size() == 1) {
+                EXPECT_EQ('A', a_result.value->buf()[0]);
+            }
+            EXPECT_EQ(123u, a_result.flags);
+        } else {
+            ADD_FAILURE() << "got wrong type of result back";
+        }
+    }
+
     {
         rget_query_t rget(hash_region_t<key_range_t>::universe(), 1000);
         memcached_protocol_t::read_t read(rget, time(NULL));
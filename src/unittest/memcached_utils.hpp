@@ -0,0 +1,21 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#ifndef UNITTEST_MEMCACHED_UTILS_HPP_
+#define UNITTEST_MEMCACHED_UTILS_HPP_
+
+#include "errors.hpp"
+#include <boost/function.hpp>
+
+#include "memcached/protocol.hpp"
+#include "protocol_api.hpp"
+
+class order_source_t;
+
+namespace unittest {
+
+/* Runs `fun` in a thread pool against a namespace interface backed by real
+memcached stores on a temporary file, split into two shards at "n". */
+void run_in_thread_pool_with_namespace_interface(boost::function<void(namespace_interface_t<memcached_protocol_t> *, order_source_t *)> fun);
+
+}   /* namespace unittest */
+
+#endif  // UNITTEST_MEMCACHED_UTILS_HPP_
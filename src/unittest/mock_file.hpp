@@ -29,7 +29,8 @@ public:
     void read_blocking(size_t offset, size_t length, void *buf);
     void write_blocking(size_t offset, size_t length, const void *buf);
 
-    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit) {
+    void *create_account(UNUSED int priority, UNUSED int outstanding_requests_limit,
+                         UNUSED io_account_stats_t *stats) {
         // We don't care about accounts.  Return an arbitrary non-null pointer.
         return this;
     }
@@ -5,8 +5,13 @@
 
 #include <cmath>  // for std::isnan -- read the comment below.
 
+#include "arch/runtime/coroutines.hpp"
+#include "arch/timing.hpp"
+#include "perfmon/collect.hpp"
 #include "perfmon/perfmon.hpp"
+#include "perfmon/text.hpp"
 #include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
 
 namespace unittest {
 
@@ -57,4 +62,153 @@ TEST(PerfmonTest, StddevComputation) {
     }
 }
 
+TEST(PerfmonTest, HistogramBuckets) {
+    using namespace perfmon_histogram;  // NOLINT(build/namespaces)
+
+    /* Every value is in the bucket that claims it, and the buckets cover the
+    values without gaps */
+    uint64_t expected_low = 0;
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        ASSERT_EQ(expected_low, bucket_low(i));
+        ASSERT_EQ(i, bucket_for(bucket_low(i)));
+        ASSERT_EQ(i, bucket_for(bucket_low(i) + bucket_width(i) - 1));
+        expected_low = bucket_low(i) + bucket_width(i);
+    }
+
+    /* Small values are exact, and above that each bucket is narrow compared
+    with the values in it */
+    for (int i = 0; i < NUM_BUCKETS; ++i) {
+        if (i < (1 << SUB_BUCKET_BITS)) {
+            ASSERT_EQ(1u, bucket_width(i));
+        } else {
+            ASSERT_LE(bucket_width(i) << SUB_BUCKET_BITS, bucket_low(i));
+        }
+    }
+
+    /* Values that are too large go in the last bucket */
+    ASSERT_EQ(NUM_BUCKETS - 1, bucket_for(std::numeric_limits<uint64_t>::max()));
+}
+
+TEST(PerfmonTest, HistogramPercentiles) {
+    using namespace perfmon_histogram;  // NOLINT(build/namespaces)
+
+    stats_t stats;
+    for (uint64_t v = 1; v <= 100000; ++v) {
+        stats.record(v);
+    }
+    ASSERT_EQ(100000, stats.count);
+    ASSERT_EQ(1u, stats.min);
+    ASSERT_EQ(100000u, stats.max);
+
+    const double percentiles[] = { 0.5, 0.9, 0.99, 0.999 };
+    for (size_t i = 0; i < sizeof(percentiles) / sizeof(percentiles[0]); ++i) {
+        double expected = percentiles[i] * 100000;
+        double reported = stats.percentile(percentiles[i]);
+        EXPECT_LT(fabs(reported - expected) / expected, 1.0 / (1 << SUB_BUCKET_BITS));
+    }
+    ASSERT_EQ(100000u, stats.percentile(1.0));
+}
+
+TEST(PerfmonTest, HistogramAggregate) {
+    using namespace perfmon_histogram;  // NOLINT(build/namespaces)
+
+    /* A slow tail on one thread shows up in the merged percentiles */
+    stats_t fast, slow, merged;
+    for (int i = 0; i < 990; ++i) {
+        fast.record(1000);
+    }
+    for (int i = 0; i < 10; ++i) {
+        slow.record(1000000);
+    }
+    merged.aggregate(fast);
+    merged.aggregate(slow);
+    merged.aggregate(stats_t());
+    ASSERT_EQ(1000, merged.count);
+    EXPECT_LT(merged.percentile(0.5), 1100u);
+    EXPECT_LT(merged.percentile(0.99), 1100u);
+    EXPECT_GT(merged.percentile(0.999), 900000u);
+
+    merged.clear();
+    ASSERT_EQ(0, merged.count);
+    merged.record(5);
+    ASSERT_EQ(5u, merged.percentile(0.5));
+}
+
+const perfmon_result_t *get_stat(const perfmon_result_t *stats, const std::string &name) {
+    perfmon_result_t::const_iterator it = stats->get_map()->find(name);
+    guarantee(it != stats->end(), "no stat named %s", name.c_str());
+    return it->second;
+}
+
+void do_nothing() { }
+
+void run_runtime_stats_test() {
+    for (int i = 0; i < 10; ++i) {
+        coro_t::spawn_sometime(&do_nothing);
+    }
+    nap(10);
+
+    scoped_ptr_t<perfmon_result_t> stats = perfmon_get_stats();
+    const perfmon_result_t *runtime = get_stat(stats.get(), "runtime");
+    get_stat(runtime, "eventloop_lag");
+    get_stat(runtime, "blocker_pool_jobs");
+    const perfmon_result_t *thread = get_stat(get_stat(runtime, "threads"),
+                                              strprintf("%d", get_thread_id()));
+
+    /* The coroutines above, plus the one running this test. Collecting the
+    stats reuses one of the free ones. */
+    EXPECT_LE(11, atoi(get_stat(thread, "coroutines_spawned")->get_string()->c_str()));
+    EXPECT_LE(1, atoi(get_stat(thread, "coroutines_active")->get_string()->c_str()));
+    EXPECT_LE(9, atoi(get_stat(thread, "coroutines_free")->get_string()->c_str()));
+    EXPECT_LT(0, atof(get_stat(thread, "wait_time")->get_string()->c_str()));
+}
+
+TEST(PerfmonTest, RuntimeStats) {
+    run_in_thread_pool(&run_runtime_stats_test);
+}
+
+TEST(PerfmonTest, TextFormat) {
+    scoped_ptr_t<perfmon_result_t> serializer = perfmon_result_t::alloc_map_result();
+    serializer->insert("reads", new perfmon_result_t("12"));
+    serializer->insert("read-latency", new perfmon_result_t("0.000250"));
+    serializer->insert("name", new perfmon_result_t("a string"));
+    serializer->insert("rate", new perfmon_result_t("nan"));
+    scoped_ptr_t<perfmon_result_t> stats = perfmon_result_t::alloc_map_result();
+    stats->insert("uptime", new perfmon_result_t("3"));
+    stats->insert("serializer.0", serializer.release());
+
+    EXPECT_EQ("rethinkdb_serializer_0_read_latency 0.000250\n"
+              "rethinkdb_serializer_0_reads 12\n"
+              "rethinkdb_uptime 3\n",
+              perfmon_result_to_text(*stats, "rethinkdb"));
+}
+
+TEST(PerfmonTest, TextFormatCollisionsAndLabels) {
+    const std::string table = "01234567-89ab-cdef-0123-456789abcdef";
+    const std::string peer = "fedcba98-7654-3210-fedc-ba9876543210";
+
+    /* `read-latency` and `read_latency` would both be `read_latency` */
+    scoped_ptr_t<perfmon_result_t> serializer = perfmon_result_t::alloc_map_result();
+    serializer->insert("reads", new perfmon_result_t("12"));
+    serializer->insert("read-latency", new perfmon_result_t("0.000250"));
+    serializer->insert("read_latency", new perfmon_result_t("0.000500"));
+    scoped_ptr_t<perfmon_result_t> serializers = perfmon_result_t::alloc_map_result();
+    serializers->insert("serializer", serializer.release());
+    scoped_ptr_t<perfmon_result_t> table_stats = perfmon_result_t::alloc_map_result();
+    table_stats->insert("serializers", serializers.release());
+
+    scoped_ptr_t<perfmon_result_t> peer_stats = perfmon_result_t::alloc_map_result();
+    peer_stats->insert("bytes_sent", new perfmon_result_t("100"));
+    scoped_ptr_t<perfmon_result_t> connectivity = perfmon_result_t::alloc_map_result();
+    connectivity->insert(peer, peer_stats.release());
+
+    scoped_ptr_t<perfmon_result_t> stats = perfmon_result_t::alloc_map_result();
+    stats->insert(table, table_stats.release());
+    stats->insert("connectivity", connectivity.release());
+
+    EXPECT_EQ("rethinkdb_connectivity_bytes_sent{connectivity=\"" + peer + "\"} 100\n"
+              "rethinkdb_serializers_serializer_reads{table=\"" + table + "\"} 12\n",
+              perfmon_result_to_text(*stats, "rethinkdb"));
+}
+
 }  // namespace unittest
@@ -0,0 +1,129 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <string>
+
+#include "rdb_protocol/datum.hpp"
+#include "rdb_protocol/profile.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+namespace {
+
+rdb_protocol_t::read_stats_t shard_stats(int64_t blocks_acquired, int64_t blocks_loaded) {
+    rdb_protocol_t::read_stats_t stats;
+    stats.shards = 1;
+    stats.blocks_acquired = blocks_acquired;
+    stats.blocks_loaded = blocks_loaded;
+    return stats;
+}
+
+double get_num(counted_t<const ql::datum_t> span, const std::string &key) {
+    return span->get(key)->as_num();
+}
+
+bool has_field(counted_t<const ql::datum_t> span, const std::string &key) {
+    return span->get(key, ql::NOTHROW).has();
+}
+
+}   /* anonymous namespace */
+
+void run_profile_tree_test() {
+    ql::profile_t profile;
+    {
+        ql::profile_span_t table(&profile, "table");
+        for (int i = 0; i < 3; ++i) {
+            ql::profile_span_t map(&profile, "map");
+            profile.add_rows(1);
+            ql::profile_span_t func(&profile, "func");
+            profile.add_js_calls(2);
+        }
+        {
+            // One read that went to two shards, and another that went to one
+            ql::profile_span_t read(&profile, "read");
+            profile.add_read_stats(shard_stats(10, 3));
+            profile.add_read_stats(shard_stats(5, 1));
+        }
+        {
+            ql::profile_span_t read(&profile, "read");
+            profile.add_read_stats(shard_stats(4, 4));
+        }
+    }
+    {
+        ql::profile_span_t batch(&profile, "batch");
+    }
+
+    counted_t<const ql::datum_t> spans = profile.take_spans();
+    ASSERT_EQ(2u, spans->size());
+
+    counted_t<const ql::datum_t> table = spans->get(0);
+    EXPECT_EQ("table", table->get("name")->as_str());
+    EXPECT_EQ(1, get_num(table, "count"));
+    // Rows and reads belong to the innermost span, not to the ones around it
+    EXPECT_FALSE(has_field(table, "rows"));
+    EXPECT_FALSE(has_field(table, "shards"));
+    ASSERT_EQ(2u, table->get("children")->size());
+
+    counted_t<const ql::datum_t> map = table->get("children")->get(0);
+    EXPECT_EQ("map", map->get("name")->as_str());
+    EXPECT_EQ(3, get_num(map, "count"));
+    EXPECT_EQ(3, get_num(map, "rows"));
+    EXPECT_FALSE(has_field(map, "js_calls"));
+    ASSERT_EQ(1u, map->get("children")->size());
+    counted_t<const ql::datum_t> func = map->get("children")->get(0);
+    EXPECT_EQ("func", func->get("name")->as_str());
+    EXPECT_EQ(3, get_num(func, "count"));
+    EXPECT_EQ(6, get_num(func, "js_calls"));
+    EXPECT_FALSE(has_field(func, "children"));
+
+    // Both reads merge into one span, which sums what all three shards did
+    counted_t<const ql::datum_t> read = table->get("children")->get(1);
+    EXPECT_EQ("read", read->get("name")->as_str());
+    EXPECT_EQ(2, get_num(read, "count"));
+    EXPECT_EQ(3, get_num(read, "shards"));
+    EXPECT_EQ(11, get_num(read, "blocks_from_cache"));
+    EXPECT_EQ(8, get_num(read, "blocks_from_disk"));
+
+    // A span lasts at least as long as everything in it
+    EXPECT_GE(get_num(table, "duration_ms"), get_num(map, "duration_ms"));
+    EXPECT_GE(get_num(map, "duration_ms"), get_num(func, "duration_ms"));
+
+    counted_t<const ql::datum_t> batch = spans->get(1);
+    EXPECT_EQ("batch", batch->get("name")->as_str());
+    EXPECT_EQ(1, get_num(batch, "count"));
+}
+
+TEST(Profile, Tree) {
+    run_in_thread_pool(&run_profile_tree_test);
+}
+
+void run_profile_take_spans_test() {
+    ql::profile_t profile;
+    {
+        ql::profile_span_t batch(&profile, "batch");
+        profile.add_rows(5);
+    }
+    counted_t<const ql::datum_t> spans = profile.take_spans();
+    ASSERT_EQ(1u, spans->size());
+    EXPECT_EQ(5, get_num(spans->get(0), "rows"));
+
+    // Spans that were taken are forgotten, so a new one starts from scratch
+    EXPECT_EQ(0u, profile.take_spans()->size());
+    {
+        ql::profile_span_t batch(&profile, "batch");
+        profile.add_rows(2);
+    }
+    spans = profile.take_spans();
+    ASSERT_EQ(1u, spans->size());
+    EXPECT_EQ(1, get_num(spans->get(0), "count"));
+    EXPECT_EQ(2, get_num(spans->get(0), "rows"));
+
+    // Queries that aren't profiled don't record anything
+    ql::profile_span_t unprofiled(NULL, "batch");
+}
+
+TEST(Profile, TakeSpans) {
+    run_in_thread_pool(&run_profile_take_spans_test);
+}
+
+}  // namespace unittest
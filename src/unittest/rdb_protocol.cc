@@ -166,6 +166,37 @@ TEST(RDBProtocol, OvershardedGetSet) {
     run_in_thread_pool_with_namespace_interface(&run_get_set_test, true);
 }
 
+/* `ReadStats` checks that reads say how much work they did, for query
+profiles */
+void run_read_stats_test(namespace_interface_t<rdb_protocol_t> *nsi, order_source_t *osource) {
+    boost::shared_ptr<scoped_cJSON_t> data(new scoped_cJSON_t(cJSON_CreateNull()));
+    {
+        rdb_protocol_t::write_t write(rdb_protocol_t::point_write_t(store_key_t("a"), data),
+                                      DURABILITY_REQUIREMENT_DEFAULT);
+        rdb_protocol_t::write_response_t response;
+
+        cond_t interruptor;
+        nsi->write(write, &response, osource->check_in("unittest::run_read_stats_test(rdb_protocol.cc-A)"), &interruptor);
+    }
+
+    {
+        rdb_protocol_t::read_t read(rdb_protocol_t::point_read_t(store_key_t("a")));
+        rdb_protocol_t::read_response_t response;
+
+        cond_t interruptor;
+        nsi->read(read, &response, osource->check_in("unittest::run_read_stats_test(rdb_protocol.cc-B)"), &interruptor);
+
+        EXPECT_EQ(1, response.stats.shards);
+        EXPECT_LE(1, response.stats.blocks_acquired);
+        EXPECT_LE(response.stats.blocks_loaded, response.stats.blocks_acquired);
+        EXPECT_EQ(0, response.stats.js_calls);
+    }
+}
+
+TEST(RDBProtocol, ReadStats) {
+    run_in_thread_pool_with_namespace_interface(&run_read_stats_test, false);
+}
+
 std::string create_sindex(namespace_interface_t<rdb_protocol_t> *nsi,
                           order_source_t *osource) {
     std::string id = uuid_to_str(generate_uuid());
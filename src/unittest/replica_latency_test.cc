@@ -0,0 +1,59 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "clustering/reactor/replica_latency.hpp"
+#include "config/args.hpp"
+
+namespace unittest {
+
+const ticks_t MILLISECOND = 1000000;
+
+TEST(ReplicaLatencyTest, PrefersFaster) {
+    replica_latency_stats_t fast, slow;
+    ticks_t now = secs_to_ticks(1000);
+    for (int i = 0; i < 10; ++i) {
+        fast.record(now - 2 * MILLISECOND, now);
+        slow.record(now - 20 * MILLISECOND, now);
+    }
+    ASSERT_TRUE(fast.better_than(slow, now));
+    ASSERT_FALSE(slow.better_than(fast, now));
+
+    int64_t fast_delay, slow_delay;
+    ASSERT_TRUE(fast.hedge_delay_ms(&fast_delay));
+    ASSERT_TRUE(slow.hedge_delay_ms(&slow_delay));
+    ASSERT_EQ(OUTDATED_READ_HEDGE_MIN_MS, fast_delay);
+    ASSERT_LT(fast_delay, slow_delay);
+}
+
+TEST(ReplicaLatencyTest, ReadsInFlight) {
+    replica_latency_stats_t a, b;
+    ticks_t now = secs_to_ticks(1000);
+    a.record(now - 2 * MILLISECOND, now);
+    b.record(now - 3 * MILLISECOND, now);
+    ASSERT_TRUE(a.better_than(b, now));
+
+    /* Once `a` has enough reads waiting on it, `b` should get the next one */
+    replica_latency_stats_t::read_sentry_t read1(&a), read2(&a);
+    ASSERT_EQ(2, a.reads_in_flight());
+    ASSERT_TRUE(b.better_than(a, now));
+}
+
+TEST(ReplicaLatencyTest, UnknownAndStale) {
+    replica_latency_stats_t known, unknown;
+    ticks_t now = secs_to_ticks(1000);
+    known.record(now - MILLISECOND, now);
+
+    /* A replica we know nothing about gets tried */
+    ASSERT_TRUE(unknown.better_than(known, now));
+    int64_t delay;
+    ASSERT_FALSE(unknown.hedge_delay_ms(&delay));
+
+    /* So does one we haven't heard from in a while, however slow it was */
+    replica_latency_stats_t stale;
+    stale.record(now - 500 * MILLISECOND, now);
+    ticks_t later = now + (OUTDATED_READ_LATENCY_STALE_MS + 1) * MILLISECOND;
+    known.record(later - MILLISECOND, later);
+    ASSERT_TRUE(stale.better_than(known, later));
+}
+
+}  // namespace unittest
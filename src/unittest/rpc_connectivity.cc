@@ -1,4 +1,6 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <algorithm>
+
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
@@ -545,6 +547,90 @@ TEST(RPCConnectivityTest, BinaryDataMultiThread) {
     unittest::run_in_thread_pool(&run_binary_data_test, 3);
 }
 
+/* `Compression` sends big messages, some of which compress well and some of
+which don't, between nodes that use compression and nodes that don't. */
+
+class string_test_application_t : public home_thread_mixin_t, public message_handler_t {
+public:
+    explicit string_test_application_t(message_service_t *s) : service(s) { }
+    void send(const std::string &message, peer_id_t peer) {
+        class writer_t : public send_message_write_callback_t {
+        public:
+            explicit writer_t(const std::string &_data) : data(_data) { }
+            virtual ~writer_t() { }
+            void write(write_stream_t *stream) {
+                write_message_t msg;
+                msg << data;
+                int res = send_write_message(stream, &msg);
+                if (res) { throw fake_archive_exc_t(); }
+            }
+            const std::string &data;
+        } writer(message);
+        service->send_message(peer, &writer);
+    }
+    void on_message(UNUSED peer_id_t peer, read_stream_t *stream) {
+        std::string message;
+        int res = deserialize(stream, &message);
+        if (res) { throw fake_archive_exc_t(); }
+        on_thread_t th(home_thread());
+        inbox.push_back(message);
+    }
+    message_service_t *service;
+    std::vector<std::string> inbox;
+};
+
+void run_compression_test() {
+    connectivity_cluster_t c1, c2, c3;
+    string_test_application_t a1(&c1), a2(&c2), a3(&c3);
+    connectivity_cluster_t::run_t cr1(&c1, get_unittest_addresses(), ANY_PORT, &a1, 0, NULL, true);
+    connectivity_cluster_t::run_t cr2(&c2, get_unittest_addresses(), ANY_PORT, &a2, 0, NULL, true);
+    connectivity_cluster_t::run_t cr3(&c3, get_unittest_addresses(), ANY_PORT, &a3, 0, NULL, false);
+    cr2.join(c1.get_peer_address(c1.get_me()));
+    cr3.join(c1.get_peer_address(c1.get_me()));
+
+    let_stuff_happen();
+
+    std::vector<std::string> messages;
+    messages.push_back("small");
+    std::string repetitive;
+    for (int i = 0; i < 1000; ++i) {
+        repetitive += strprintf("{\"id\": %d, \"value\": \"aaaaaaaa\"}", i);
+    }
+    messages.push_back(repetitive);
+    rng_t rng;
+    std::string random;
+    for (int i = 0; i < 10000; ++i) {
+        random.push_back(static_cast<char>(rng.randint(256)));
+    }
+    messages.push_back(random);
+
+    for (size_t i = 0; i < messages.size(); ++i) {
+        a1.send(messages[i], c2.get_me());
+        a1.send(messages[i], c3.get_me());
+        a2.send(messages[i], c1.get_me());
+        a3.send(messages[i], c1.get_me());
+    }
+
+    let_stuff_happen();
+
+    std::vector<std::string> twice;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        twice.push_back(messages[i]);
+        twice.push_back(messages[i]);
+    }
+    std::sort(twice.begin(), twice.end());
+    std::sort(a1.inbox.begin(), a1.inbox.end());
+    EXPECT_TRUE(a1.inbox == twice);
+    EXPECT_TRUE(a2.inbox == messages);
+    EXPECT_TRUE(a3.inbox == messages);
+}
+TEST(RPCConnectivityTest, Compression) {
+    unittest::run_in_thread_pool(&run_compression_test);
+}
+TEST(RPCConnectivityTest, CompressionMultiThread) {
+    unittest::run_in_thread_pool(&run_compression_test, 3);
+}
+
 /* `PeerIDSemantics` makes sure that `peer_id_t::is_nil()` works as expected. */
 
 void run_peer_id_semantics_test() {
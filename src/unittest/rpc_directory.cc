@@ -1,7 +1,17 @@
 // Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <map>
+#include <string>
+#include <vector>
+
+#include "errors.hpp"
+#include <boost/ptr_container/ptr_vector.hpp>
+
 #include "unittest/gtest.hpp"
 
 #include "arch/timing.hpp"
+#include "concurrency/pmap.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "containers/scoped.hpp"
 #include "rpc/connectivity/cluster.hpp"
 #include "rpc/directory/read_manager.hpp"
 #include "rpc/directory/write_manager.hpp"
@@ -108,4 +118,120 @@ TEST(RPCDirectoryTest, DestructorRace) {
     unittest::run_in_thread_pool(&run_destructor_race_test, 1);
 }
 
+/* `LargeCluster` simulates a cluster with many nodes and a large directory
+value per node. It checks that a burst of small changes on one node reaches
+every other node, that the burst is coalesced into a few updates, and that the
+updates only carry the changed entries. */
+
+typedef std::map<int, std::string> big_directory_t;
+
+class big_directory_node_t {
+public:
+    explicit big_directory_node_t(const big_directory_t &initial) :
+        read_manager(&cluster),
+        value(initial),
+        write_manager(&cluster, value.get_watchable()),
+        run(&cluster, get_unittest_addresses(), ANY_PORT, &read_manager, 0, NULL) { }
+
+    connectivity_cluster_t cluster;
+    directory_read_manager_t<big_directory_t> read_manager;
+    watchable_variable_t<big_directory_t> value;
+    directory_write_manager_t<big_directory_t> write_manager;
+    connectivity_cluster_t::run_t run;
+};
+
+void visit_stats_on_thread(perfmon_t *perfmon, void *ctx, int thread) {
+    on_thread_t th(thread);
+    perfmon->visit_stats(ctx);
+}
+
+/* We can't use `perfmon_get_stats()` because all the test nodes register their
+connectivity stats under the same name in the global collection. */
+int64_t get_stat(perfmon_t *perfmon, const std::string &name) {
+    void *ctx = perfmon->begin_stats();
+    pmap(get_num_threads(), boost::bind(&visit_stats_on_thread, perfmon, ctx, _1));
+    scoped_ptr_t<perfmon_result_t> stats = perfmon->end_stats(ctx);
+    const perfmon_result_t::internal_map_t *stats_map = const_cast<const perfmon_result_t *>(stats.get())->get_map();
+    perfmon_result_t::const_iterator it = stats_map->find(name);
+    guarantee(it != stats_map->end());
+    return strtoll(it->second->get_string()->c_str(), NULL, 10);
+}
+
+/* Waits until every node sees `expected` as the directory value of `source`. */
+bool wait_for_directory_value(const std::vector<big_directory_node_t *> &nodes, peer_id_t source, const big_directory_t &expected) {
+    for (int tries = 0; tries < 1000; ++tries) {
+        bool all_match = true;
+        for (size_t i = 0; i < nodes.size() && all_match; ++i) {
+            std::map<peer_id_t, big_directory_t> view = nodes[i]->read_manager.get_root_view()->get();
+            std::map<peer_id_t, big_directory_t>::iterator it = view.find(source);
+            all_match = it != view.end() && it->second == expected;
+        }
+        if (all_match) {
+            return true;
+        }
+        nap(10);
+    }
+    return false;
+}
+
+void run_large_cluster_test() {
+    const int num_nodes = 12;
+    const int num_entries = 500;
+    big_directory_t initial;
+    for (int i = 0; i < num_entries; ++i) {
+        initial[i] = std::string(100, 'a' + i % 26);
+    }
+
+    boost::ptr_vector<big_directory_node_t> node_storage;
+    std::vector<big_directory_node_t *> nodes;
+    for (int i = 0; i < num_nodes; ++i) {
+        node_storage.push_back(new big_directory_node_t(initial));
+        nodes.push_back(&node_storage.back());
+    }
+    for (int i = 1; i < num_nodes; ++i) {
+        nodes[i]->run.join(nodes[0]->cluster.get_peer_address(nodes[0]->cluster.get_me()));
+    }
+    for (int i = 0; i < num_nodes; ++i) {
+        ASSERT_TRUE(wait_for_directory_value(nodes, nodes[i]->cluster.get_me(), initial));
+    }
+
+    perfmon_collection_t *stats = nodes[0]->write_manager.get_stats();
+    const int64_t initializations = get_stat(stats, "initializations_sent");
+    const int64_t initialization_bytes = get_stat(stats, "initialization_bytes_sent");
+    EXPECT_EQ(num_nodes, initializations);
+    EXPECT_EQ(0, get_stat(stats, "updates_sent"));
+
+    /* A burst of changes in quick succession, including added and removed
+    entries, like a reshard would cause. */
+    const int num_changes = 200;
+    big_directory_t value = initial;
+    for (int change = 0; change < num_changes; ++change) {
+        value[(change * 37) % (num_entries * 2)] = strprintf("change %d", change);
+        value.erase((change * 53) % num_entries);
+        nodes[0]->value.set_value(value);
+        if (change % 20 == 0) {
+            nap(1);
+        }
+    }
+    ASSERT_TRUE(wait_for_directory_value(nodes, nodes[0]->cluster.get_me(), value));
+
+    EXPECT_EQ(num_changes, get_stat(stats, "changes"));
+    const int64_t updates = get_stat(stats, "updates_sent");
+    const int64_t update_bytes = get_stat(stats, "update_bytes_sent");
+    EXPECT_EQ(initializations, get_stat(stats, "initializations_sent"));
+    EXPECT_LT(updates, num_changes * num_nodes / 4);
+    EXPECT_LT(update_bytes, initialization_bytes);
+    /* Each update only carries the entries that changed, so it is much
+    smaller than sending the whole value again. */
+    EXPECT_LT(update_bytes, updates * (initialization_bytes / initializations) / 4);
+}
+TEST(RPCDirectoryTest, LargeCluster) {
+    unittest::run_in_thread_pool(&run_large_cluster_test, 2);
+}
+
 }   /* namespace unittest */
+
+#include "rpc/directory/read_manager.tcc"
+#include "rpc/directory/write_manager.tcc"
+template class directory_read_manager_t<unittest::big_directory_t>;
+template class directory_write_manager_t<unittest::big_directory_t>;
@@ -2,7 +2,11 @@
 #include "errors.hpp"
 #include <boost/bind.hpp>
 
+#include "arch/runtime/runtime.hpp"
+#include "concurrency/pmap.hpp"
 #include "containers/archive/archive.hpp"
+#include "containers/archive/stl_types.hpp"
+#include "perfmon/perfmon.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "rpc/semilattice/semilattice_manager.hpp"
 #include "rpc/semilattice/joins/map.hpp"
@@ -28,6 +32,10 @@ inline void semilattice_join(sl_int_t *a, sl_int_t b) {
     a->i |= b.i;
 }
 
+inline bool operator==(const sl_int_t &a, const sl_int_t &b) {
+    return a.i == b.i;
+}
+
 class sl_pair_t {
 public:
     sl_pair_t(sl_int_t _x, sl_int_t _y) : x(_x), y(_y) { }
@@ -167,6 +175,100 @@ TEST(RPCSemilatticeTest, SyncFrom) {
     unittest::run_in_thread_pool(&run_sync_from_test, 2);
 }
 
+/* `DeltaExchange` makes sure that after the initial exchange, changes to a
+large metadata map are sent as deltas holding only the changed entries. */
+
+typedef std::map<int, sl_int_t> sl_map_t;
+
+void visit_stats_on_thread(perfmon_t *perfmon, void *ctx, int thread) {
+    on_thread_t th(thread);
+    perfmon->visit_stats(ctx);
+}
+
+/* We can't use `perfmon_get_stats()` because both test nodes register their
+connectivity stats under the same name in the global collection. */
+int64_t get_stat(perfmon_t *perfmon, const std::string &name) {
+    void *ctx = perfmon->begin_stats();
+    pmap(get_num_threads(), boost::bind(&visit_stats_on_thread, perfmon, ctx, _1));
+    scoped_ptr_t<perfmon_result_t> stats = perfmon->end_stats(ctx);
+    const perfmon_result_t::internal_map_t *stats_map = const_cast<const perfmon_result_t *>(stats.get())->get_map();
+    perfmon_result_t::const_iterator it = stats_map->find(name);
+    guarantee(it != stats_map->end());
+    return strtoll(it->second->get_string()->c_str(), NULL, 10);
+}
+
+void run_delta_exchange_test() {
+    const int num_entries = 1000;
+    sl_map_t initial_map;
+    for (int i = 0; i < num_entries; ++i) {
+        initial_map[i] = sl_int_t(1);
+    }
+
+    connectivity_cluster_t cluster1, cluster2;
+    semilattice_manager_t<sl_map_t> slm1(&cluster1, initial_map), slm2(&cluster2, sl_map_t());
+    connectivity_cluster_t::run_t run1(&cluster1, get_unittest_addresses(), ANY_PORT, &slm1, 0, NULL);
+    connectivity_cluster_t::run_t run2(&cluster2, get_unittest_addresses(), ANY_PORT, &slm2, 0, NULL);
+
+    run1.join(cluster2.get_peer_address(cluster2.get_me()));
+
+    /* Block until the connection is established */
+    {
+        struct : public cond_t, public peers_list_callback_t {
+            void on_connect(UNUSED peer_id_t peer) {
+                pulse();
+            }
+            void on_disconnect(UNUSED peer_id_t peer) { }
+        } connection_established;
+        connectivity_service_t::peers_list_subscription_t subs(&connection_established);
+
+        {
+            ASSERT_FINITE_CORO_WAITING;
+            connectivity_service_t::peers_list_freeze_t freeze(&cluster1);
+            if (!cluster1.get_peer_connected(cluster2.get_me())) {
+                subs.reset(&cluster1, &freeze);
+            } else {
+                connection_established.pulse();
+            }
+        }
+
+        connection_established.wait_lazily_unordered();
+    }
+
+    cond_t non_interruptor;
+    slm1.get_root_view()->sync_to(cluster2.get_me(), &non_interruptor);
+    EXPECT_EQ(static_cast<size_t>(num_entries), slm2.get_root_view()->get().size());
+
+    const int64_t full_messages = get_stat(slm1.get_stats(), "full_messages_sent");
+    const int64_t full_bytes = get_stat(slm1.get_stats(), "full_bytes_sent");
+    EXPECT_GT(full_messages, 0);
+
+    /* Join the whole map back in with a few entries changed, the way views
+    usually modify the metadata. */
+    const int num_changes = 10;
+    for (int change = 0; change < num_changes; ++change) {
+        sl_map_t map = slm1.get_root_view()->get();
+        map[change * 7].i |= 2;
+        slm1.get_root_view()->join(map);
+    }
+    slm1.get_root_view()->sync_to(cluster2.get_me(), &non_interruptor);
+
+    sl_map_t synced = slm2.get_root_view()->get();
+    for (int change = 0; change < num_changes; ++change) {
+        EXPECT_EQ(3u, synced[change * 7].i);
+    }
+    EXPECT_EQ(1u, synced[1].i);
+
+    EXPECT_EQ(full_messages, get_stat(slm1.get_stats(), "full_messages_sent"));
+    EXPECT_EQ(0, get_stat(slm2.get_stats(), "resyncs_requested"));
+    const int64_t delta_messages = get_stat(slm1.get_stats(), "delta_messages_sent");
+    const int64_t delta_bytes = get_stat(slm1.get_stats(), "delta_bytes_sent");
+    EXPECT_EQ(num_changes, delta_messages);
+    EXPECT_LT(delta_bytes * 50, full_bytes * num_changes);
+}
+TEST(RPCSemilatticeTest, DeltaExchange) {
+    unittest::run_in_thread_pool(&run_delta_exchange_test, 2);
+}
+
 /* `Watcher` makes sure that metadata watchers get notified when metadata
 changes. */
 
@@ -285,3 +387,4 @@ TEST(RPCSemilatticeTest, MemberViewMultiThread) {
 
 #include "rpc/semilattice/semilattice_manager.tcc"
 template class semilattice_manager_t<unittest::sl_int_t>;
+template class semilattice_manager_t<unittest::sl_map_t>;
@@ -0,0 +1,118 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include "unittest/gtest.hpp"
+
+#include "rdb_protocol/slow_query_log.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+namespace {
+
+Query make_string_query(const std::string &str) {
+    Query q;
+    q.set_type(Query::START);
+    q.set_token(1);
+    Term *t = q.mutable_query();
+    t->set_type(Term::DATUM);
+    Datum *d = t->mutable_datum();
+    d->set_type(Datum::R_STR);
+    d->set_r_str(str);
+    return q;
+}
+
+}   /* anonymous namespace */
+
+void run_slow_query_threshold_test() {
+    slow_query_log_t log(slow_query_log_config_t(10, 0, false));
+    ql::query_stats_t stats;
+
+    log.maybe_record(make_string_query("fast"), "fast", 9 * MILLION, stats);
+    EXPECT_EQ(0u, log.get_entries().size());
+
+    log.maybe_record(make_string_query("slow"), "slow", 10 * MILLION, stats);
+    std::vector<slow_query_t> entries = log.get_entries();
+    ASSERT_EQ(1u, entries.size());
+    EXPECT_EQ("slow", entries[0].client);
+    EXPECT_EQ("\"slow\"", entries[0].query);
+    EXPECT_EQ(static_cast<ticks_t>(10 * MILLION), entries[0].duration);
+    EXPECT_FALSE(entries[0].sampled);
+}
+
+TEST(SlowQueryLog, Threshold) {
+    run_in_thread_pool(&run_slow_query_threshold_test);
+}
+
+void run_slow_query_sampling_test() {
+    ql::query_stats_t stats;
+
+    /* Sampling every request records all the fast ones, marked as sampled */
+    slow_query_log_t sample_all(slow_query_log_config_t(1000, 1, false));
+    sample_all.maybe_record(make_string_query("fast"), "fast", 0, stats);
+    sample_all.maybe_record(make_string_query("slow"), "slow", 1000 * MILLION, stats);
+    std::vector<slow_query_t> entries = sample_all.get_entries();
+    ASSERT_EQ(2u, entries.size());
+    EXPECT_EQ("fast", entries[0].client);
+    EXPECT_TRUE(entries[0].sampled);
+    EXPECT_EQ("slow", entries[1].client);
+    EXPECT_FALSE(entries[1].sampled);
+
+    /* Sampling one in 1000 records only a few of them */
+    slow_query_log_t sample_some(slow_query_log_config_t(1000, 1000, false));
+    for (int i = 0; i < 10 * SLOW_QUERY_LOG_SIZE; ++i) {
+        sample_some.maybe_record(make_string_query("fast"), "fast", 0, stats);
+    }
+    EXPECT_LT(sample_some.get_entries().size(), static_cast<size_t>(SLOW_QUERY_LOG_SIZE));
+}
+
+TEST(SlowQueryLog, Sampling) {
+    run_in_thread_pool(&run_slow_query_sampling_test);
+}
+
+void run_slow_query_ring_bound_test() {
+    slow_query_log_t log(slow_query_log_config_t(0, 0, false));
+    ql::query_stats_t stats;
+
+    const int extra = 10;
+    for (int i = 0; i < SLOW_QUERY_LOG_SIZE + extra; ++i) {
+        log.maybe_record(make_string_query("q"), strprintf("%d", i), MILLION, stats);
+    }
+
+    /* Only the latest `SLOW_QUERY_LOG_SIZE` are kept, oldest first */
+    std::vector<slow_query_t> entries = log.get_entries();
+    ASSERT_EQ(static_cast<size_t>(SLOW_QUERY_LOG_SIZE), entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        EXPECT_EQ(strprintf("%zu", i + extra), entries[i].client);
+    }
+}
+
+TEST(SlowQueryLog, RingBound) {
+    run_in_thread_pool(&run_slow_query_ring_bound_test);
+}
+
+TEST(SlowQueryLog, PrintTermTruncation) {
+    Query short_query = make_string_query("abc");
+    EXPECT_EQ("\"abc\"", print_term_for_log(short_query.query(), 5));
+
+    Query long_query = make_string_query(std::string(100, 'x'));
+    std::string printed = print_term_for_log(long_query.query(), 20);
+    EXPECT_EQ("\"" + std::string(19, 'x') + "...", printed);
+
+    /* Terms past the limit aren't printed at all */
+    Query q;
+    q.set_type(Query::START);
+    Term *t = q.mutable_query();
+    t->set_type(Term::MAKE_ARRAY);
+    for (int i = 0; i < 1000; ++i) {
+        Term *arg = t->add_args();
+        arg->set_type(Term::DATUM);
+        arg->mutable_datum()->set_type(Datum::R_NUM);
+        arg->mutable_datum()->set_r_num(i);
+    }
+    printed = print_term_for_log(q.query(), 50);
+    ASSERT_EQ(53u, printed.size());
+    EXPECT_EQ("MAKE_ARRAY(0, 1, 2", printed.substr(0, 18));
+    EXPECT_EQ("...", printed.substr(50));
+}
+
+}  // namespace unittest
@@ -0,0 +1,115 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <sys/stat.h>
+#include <sys/types.h>
+
+#include "unittest/gtest.hpp"
+
+#include "arch/io/disk.hpp"
+#include "clustering/administration/main/file_based_svs_by_namespace.hpp"
+#include "clustering/immediate_consistency/branch/multistore.hpp"
+#include "memcached/protocol.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+bool file_exists(const base_path_t &directory, const std::string &name) {
+    return access(serializer_filepath_t(directory, name).permanent_path().c_str(), F_OK) == 0;
+}
+
+base_path_t make_stripe_directory() {
+    base_path_t path("stripe_" + uuid_to_str(generate_uuid()));
+    int res = mkdir(path.path().c_str(), 0755);
+    guarantee_err(res == 0, "mkdir of %s failed", path.path().c_str());
+    recreate_temporary_directory(path);
+    return path;
+}
+
+void remove_stripe_directory(const base_path_t &path) {
+    int res = rmdir((path.path() + "/" + TEMPORARY_DIRECTORY_NAME).c_str());
+    guarantee_err(res == 0, "rmdir failed");
+    res = rmdir(path.path().c_str());
+    guarantee_err(res == 0, "rmdir of %s failed", path.path().c_str());
+}
+
+void run_striping_test() {
+    recreate_temporary_directory(base_path_t("."));
+    std::vector<base_path_t> stripe_paths;
+    stripe_paths.push_back(make_stripe_directory());
+    stripe_paths.push_back(make_stripe_directory());
+
+    io_backender_t io_backender;
+    namespace_id_t namespace_id = generate_uuid();
+    const std::string name = uuid_to_str(namespace_id);
+    memcached_protocol_t::context_t ctx;
+    perfmon_collection_t perfmon_collection;
+
+    {
+        file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."), stripe_paths);
+        stores_lifetimer_t<memcached_protocol_t> stores;
+        scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+        svs_source.get_svs(&perfmon_collection, namespace_id, GIGABYTE, 4, &stores, &svs, &ctx);
+        EXPECT_EQ(4, svs->num_stores());
+
+        /* Three directories, so three files, one in each */
+        ASSERT_EQ(3, stores.files()->size());
+        EXPECT_TRUE(file_exists(base_path_t("."), name));
+        EXPECT_TRUE(file_exists(stripe_paths[0], name + "_1"));
+        EXPECT_TRUE(file_exists(stripe_paths[1], name + "_2"));
+    }
+
+    {
+        /* The files are found again, even in a different order of directories */
+        std::vector<base_path_t> reversed(stripe_paths.rbegin(), stripe_paths.rend());
+        file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."), reversed);
+        stores_lifetimer_t<memcached_protocol_t> stores;
+        scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+        svs_source.get_svs(&perfmon_collection, namespace_id, GIGABYTE, 1, &stores, &svs, &ctx);
+        EXPECT_EQ(4, svs->num_stores());
+        EXPECT_EQ(3, stores.files()->size());
+        EXPECT_EQ(memcached_protocol_t::region_t::universe(), svs->get_region());
+    }
+
+    {
+        file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."), stripe_paths);
+        svs_source.destroy_svs(namespace_id);
+    }
+    EXPECT_FALSE(file_exists(base_path_t("."), name));
+    EXPECT_FALSE(file_exists(stripe_paths[0], name + "_1"));
+    EXPECT_FALSE(file_exists(stripe_paths[1], name + "_2"));
+
+    remove_stripe_directory(stripe_paths[0]);
+    remove_stripe_directory(stripe_paths[1]);
+}
+
+TEST(TableStriping, FilesAcrossDirectories) {
+    run_in_thread_pool(&run_striping_test, 4);
+}
+
+void run_single_file_test() {
+    /* Tables with one store only ever get one file, however many directories
+    there are */
+    recreate_temporary_directory(base_path_t("."));
+    std::vector<base_path_t> stripe_paths;
+    stripe_paths.push_back(make_stripe_directory());
+
+    io_backender_t io_backender;
+    namespace_id_t namespace_id = generate_uuid();
+    memcached_protocol_t::context_t ctx;
+    perfmon_collection_t perfmon_collection;
+    file_based_svs_by_namespace_t<memcached_protocol_t> svs_source(&io_backender, base_path_t("."), stripe_paths);
+    {
+        stores_lifetimer_t<memcached_protocol_t> stores;
+        scoped_ptr_t<multistore_ptr_t<memcached_protocol_t> > svs;
+        svs_source.get_svs(&perfmon_collection, namespace_id, GIGABYTE, 1, &stores, &svs, &ctx);
+        EXPECT_EQ(1, stores.files()->size());
+        EXPECT_FALSE(file_exists(stripe_paths[0], uuid_to_str(namespace_id) + "_1"));
+    }
+    svs_source.destroy_svs(namespace_id);
+    remove_stripe_directory(stripe_paths[0]);
+}
+
+TEST(TableStriping, SingleStore) {
+    run_in_thread_pool(&run_single_file_test, 4);
+}
+
+}  // namespace unittest
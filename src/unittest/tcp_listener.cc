@@ -0,0 +1,123 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <set>
+
+#include "errors.hpp"
+#include <boost/bind.hpp>
+
+#include "arch/io/network.hpp"
+#include "arch/runtime/runtime.hpp"
+#include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
+#include "concurrency/pmap.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+
+namespace unittest {
+
+static const int num_test_threads = 4;
+static const int conns_per_thread = 500;
+static const int parallel_connects_per_thread = 16;
+
+/* Counts accepted connections per accepting thread. It is called on whatever
+thread accepted the connection, so it only uses atomic operations. */
+class accept_counter_t {
+public:
+    accept_counter_t() : total(0) {
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            per_thread[i] = 0;
+        }
+    }
+
+    void on_conn(scoped_ptr_t<tcp_conn_descriptor_t> &nconn) {
+        __sync_add_and_fetch(&per_thread[get_thread_id()], 1);
+        __sync_add_and_fetch(&total, 1);
+        // Dropping the connection closes it.
+        scoped_ptr_t<tcp_conn_t> conn;
+        nconn->make_overcomplicated(&conn);
+    }
+
+    int get_total() const {
+        return total;
+    }
+
+    int threads_used() const {
+        int used = 0;
+        for (int i = 0; i < MAX_THREADS; ++i) {
+            used += per_thread[i] != 0 ? 1 : 0;
+        }
+        return used;
+    }
+
+private:
+    volatile int total;
+    volatile int per_thread[MAX_THREADS];
+
+    DISABLE_COPYING(accept_counter_t);
+};
+
+class connector_t {
+public:
+    connector_t(const ip_address_t &_host, int _port) : host(_host), port(_port) { }
+
+    // Runs on `thread`, making `conns_per_thread` connections.
+    void connect_from_thread(int thread) const {
+        on_thread_t th(thread);
+        pmap(parallel_connects_per_thread,
+             boost::bind(&connector_t::connect_some, this, _1));
+    }
+
+private:
+    void connect_some(UNUSED int i) const {
+        cond_t non_interruptor;
+        for (int j = 0; j < conns_per_thread / parallel_connects_per_thread; ++j) {
+            tcp_conn_t conn(host, port, &non_interruptor);
+        }
+    }
+
+    ip_address_t host;
+    int port;
+};
+
+void run_accept_test(tcp_accept_mode_t accept_mode) {
+    accept_counter_t counter;
+    tcp_listener_t listener(get_unittest_addresses(), ANY_PORT,
+                            boost::bind(&accept_counter_t::on_conn, &counter, _1),
+                            accept_mode);
+
+    const int expected = num_test_threads *
+        (conns_per_thread / parallel_connects_per_thread) * parallel_connects_per_thread;
+
+    connector_t connector(*get_unittest_addresses().begin(), listener.get_port());
+    pmap(num_test_threads, boost::bind(&connector_t::connect_from_thread, &connector, _1));
+    // Every connect has returned, but the callbacks may still be running.
+    for (int tries = 0; tries < 10000 && counter.get_total() < expected; ++tries) {
+        nap(1);
+    }
+
+    EXPECT_EQ(expected, counter.get_total());
+    if (accept_mode == ACCEPT_ON_EVERY_THREAD) {
+        // The kernel hashes connections over the sockets, so with this many
+        // connections every thread should have gotten some.
+        EXPECT_GT(counter.threads_used(), 1);
+    } else {
+        EXPECT_EQ(1, counter.threads_used());
+    }
+}
+
+void run_accept_on_home_thread_test() {
+    run_accept_test(ACCEPT_ON_HOME_THREAD);
+}
+
+void run_accept_on_every_thread_test() {
+    run_accept_test(ACCEPT_ON_EVERY_THREAD);
+}
+
+TEST(TcpListener, AcceptsOnHomeThread) {
+    run_in_thread_pool(&run_accept_on_home_thread_test, num_test_threads);
+}
+
+TEST(TcpListener, AcceptsOnEveryThread) {
+    run_in_thread_pool(&run_accept_on_every_thread_test, num_test_threads);
+}
+
+}  // namespace unittest
@@ -0,0 +1,131 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <vector>
+
+#include "arch/runtime/thread_load.hpp"
+#include "arch/timing.hpp"
+#include "config/args.hpp"
+#include "unittest/gtest.hpp"
+#include "unittest/unittest_utils.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+static const ticks_t window_ticks = THREAD_LOAD_WINDOW_MS * MILLION;
+
+TEST(ThreadLoad, LoadOfLastWindow) {
+    thread_load_t load;
+    const ticks_t start = get_ticks();
+
+    // Busy for half of the window, in two pieces; the second one closes it.
+    load.record_busy_interval(start, start + window_ticks / 4);
+    load.record_wait_interval(start + window_ticks / 4, start + window_ticks * 3 / 4);
+    load.record_busy_interval(start + window_ticks * 3 / 4, start + window_ticks);
+
+    EXPECT_NEAR(0.5, load.get_recent_load(), 0.01);
+    EXPECT_EQ(window_ticks / 2, load.get_total_busy_ticks());
+    EXPECT_EQ(window_ticks / 2, load.get_total_wait_ticks());
+    EXPECT_EQ(0, load.get_total_spin_ticks());
+}
+
+void run_idle_thread_load_test() {
+    thread_load_t load;
+    const ticks_t start = get_ticks();
+    load.record_busy_interval(start, start + window_ticks);
+    EXPECT_NEAR(1.0, load.get_recent_load(), 0.01);
+
+    // A thread that sleeps in its event queue doesn't close any windows, but
+    // its load still drops.
+    nap(THREAD_LOAD_WINDOW_MS * 4);
+    EXPECT_GT(0.01, load.get_recent_load());
+}
+
+TEST(ThreadLoad, IdleThreadLoadDrops) {
+    run_in_thread_pool(&run_idle_thread_load_test);
+}
+
+TEST(ConnPlacement, LeastLoadedThreadWins) {
+    conn_placement_t placement(4);
+    std::vector<double> loads;
+    loads.push_back(0.5);
+    loads.push_back(0.1);
+    loads.push_back(0.9);
+    loads.push_back(0.3);
+
+    // Whichever thread the round-robin search starts at
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(1, placement.choose_thread_for_new_conn(loads));
+    }
+
+    // Connections don't outweigh a real difference in load
+    conn_placement_t::conn_t a(&placement, 1), b(&placement, 1), c(&placement, 1);
+    EXPECT_EQ(1, placement.choose_thread_for_new_conn(loads));
+}
+
+TEST(ConnPlacement, FewestConnsWinAmongSimilarLoads) {
+    conn_placement_t placement(4);
+    const double slack = CLIENT_CONN_PLACEMENT_LOAD_SLACK;
+    std::vector<double> loads;
+    loads.push_back(0.2);
+    loads.push_back(0.2 + slack / 4);
+    loads.push_back(0.2 + slack / 4);
+    loads.push_back(0.2 - slack / 4);
+
+    conn_placement_t::conn_t a(&placement, 0), b(&placement, 1), c(&placement, 3);
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(2, placement.choose_thread_for_new_conn(loads));
+    }
+
+    // Equal loads and equal connections take turns
+    conn_placement_t::conn_t d(&placement, 2);
+    std::vector<double> equal_loads(4, 0.2);
+    std::vector<int> chosen(4, 0);
+    for (int i = 0; i < 8; ++i) {
+        ++chosen[placement.choose_thread_for_new_conn(equal_loads)];
+    }
+    for (int i = 0; i < 4; ++i) {
+        EXPECT_EQ(2, chosen[i]) << "thread " << i;
+    }
+}
+
+TEST(ConnPlacement, CountsFollowConnectAndDisconnect) {
+    conn_placement_t placement(2);
+    std::vector<double> loads(2, 0.3);
+    EXPECT_EQ(0, placement.get_num_conns(0));
+    EXPECT_EQ(0, placement.get_num_conns(1));
+
+    {
+        conn_placement_t::conn_t a(&placement, 0);
+        conn_placement_t::conn_t b(&placement, 0);
+        EXPECT_EQ(2, placement.get_num_conns(0));
+        EXPECT_EQ(1, placement.choose_thread_for_new_conn(loads));
+        EXPECT_EQ(1, placement.choose_thread_for_new_conn(loads));
+
+        conn_placement_t::conn_t c(&placement, 1);
+        conn_placement_t::conn_t d(&placement, 1);
+        conn_placement_t::conn_t e(&placement, 1);
+        EXPECT_EQ(3, placement.get_num_conns(1));
+        EXPECT_EQ(0, placement.choose_thread_for_new_conn(loads));
+    }
+
+    // Once they disconnect, neither thread is preferred any more
+    EXPECT_EQ(0, placement.get_num_conns(0));
+    EXPECT_EQ(0, placement.get_num_conns(1));
+    const int first = placement.choose_thread_for_new_conn(loads);
+    EXPECT_NE(first, placement.choose_thread_for_new_conn(loads));
+}
+
+TEST(ConnPlacement, IdleConnsOnlyMoveForALargeGap) {
+    conn_placement_t placement(3);
+    const double gap = CLIENT_CONN_MIGRATION_LOAD_GAP;
+    std::vector<double> loads;
+    loads.push_back(0.9);
+    loads.push_back(0.9 - gap / 2);
+    loads.push_back(0.9 - gap / 2);
+    EXPECT_EQ(0, placement.choose_thread_for_idle_conn(0, loads));
+
+    loads[2] = 0.9 - gap * 1.5;
+    EXPECT_EQ(2, placement.choose_thread_for_idle_conn(0, loads));
+    EXPECT_EQ(2, placement.choose_thread_for_idle_conn(2, loads));
+}
+
+}  // namespace unittest
@@ -2,7 +2,9 @@
 #include "unittest/gtest.hpp"
 
 #include "arch/timing.hpp"
+#include "concurrency/cond_var.hpp"
 #include "concurrency/pmap.hpp"
+#include "containers/scoped.hpp"
 #include "unittest/unittest_utils.hpp"
 #include "utils.hpp"
 
@@ -33,6 +35,42 @@ TEST(TimerTest, TestApproximateWaitTimes) {
     unittest::run_in_thread_pool(run_TestApproximateWaitTimes);
 }
 
+// Destroys its own repeating timer the first time it rings.
+class self_canceling_ringee_t : public repeating_timer_callback_t {
+public:
+    self_canceling_ringee_t() : rings(0), timer(new repeating_timer_t(1, this)) { }
+
+    void on_ring() {
+        ++rings;
+        timer.reset();
+        canceled.pulse_if_not_already_pulsed();
+    }
+
+    int rings;
+    cond_t canceled;
+
+private:
+    scoped_ptr_t<repeating_timer_t> timer;
+};
+
+void run_TestCancelRepeatingTimerFromCallback() {
+    self_canceling_ringee_t ringee;
+    // Another repeating timer with the same period, so that the handler keeps
+    // processing the wheel after the canceled token is gone.
+    self_canceling_ringee_t neighbor;
+    ringee.canceled.wait();
+    neighbor.canceled.wait();
+
+    // Neither timer may ring again once it has been canceled.
+    nap(10);
+    ASSERT_EQ(1, ringee.rings);
+    ASSERT_EQ(1, neighbor.rings);
+}
+
+TEST(TimerTest, TestCancelRepeatingTimerFromCallback) {
+    unittest::run_in_thread_pool(run_TestCancelRepeatingTimerFromCallback);
+}
+
 
 
 
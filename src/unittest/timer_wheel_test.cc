@@ -0,0 +1,153 @@
+// Copyright 2010-2013 RethinkDB, all rights reserved.
+#include <map>
+#include <vector>
+
+#include "containers/intrusive_timer_wheel.hpp"
+#include "containers/scoped.hpp"
+#include "unittest/gtest.hpp"
+#include "utils.hpp"
+
+namespace unittest {
+
+class test_timer_t : public intrusive_timer_wheel_node_t<test_timer_t> {
+public:
+    test_timer_t() : in_wheel(false) { }
+    bool in_wheel;
+};
+
+typedef intrusive_timer_wheel_t<test_timer_t> test_wheel_t;
+
+TEST(TimerWheelTest, EmptyWheel) {
+    test_wheel_t wheel(1000);
+    EXPECT_TRUE(wheel.empty());
+    EXPECT_TRUE(wheel.pop_expired(1000000) == NULL);
+}
+
+TEST(TimerWheelTest, PastTimersExpireImmediately) {
+    test_wheel_t wheel(1000);
+    test_timer_t timer;
+    wheel.add(&timer, 10);
+    EXPECT_EQ(1000, wheel.next_tick_lower_bound());
+    EXPECT_EQ(&timer, wheel.pop_expired(1000));
+    EXPECT_TRUE(wheel.empty());
+}
+
+// Adds timers at distances that exercise every level and the overflow list, removes some of them,
+// and checks that the rest come out exactly at their expiration tick.
+TEST(TimerWheelTest, ExpiresOnTime) {
+    rng_t rng(12345);
+    const int64_t start_tick = 777;
+    test_wheel_t wheel(start_tick);
+
+    const size_t num_timers = 20000;
+    scoped_array_t<test_timer_t> timers(num_timers);
+    for (size_t i = 0; i < num_timers; ++i) {
+        const int bits = rng.randint(27);
+        const int64_t delta = rng.randint(1 << bits) + 1;
+        wheel.add(&timers[i], start_tick + delta);
+        timers[i].in_wheel = true;
+    }
+    for (size_t i = 0; i < num_timers; i += 3) {
+        wheel.remove(&timers[i]);
+        timers[i].in_wheel = false;
+    }
+
+    int64_t now = start_tick;
+    size_t expired = 0;
+    while (!wheel.empty()) {
+        const int64_t lower_bound = wheel.next_tick_lower_bound();
+        ASSERT_GT(lower_bound, now);
+        ASSERT_TRUE(wheel.pop_expired(lower_bound - 1) == NULL);
+
+        // Jump to the lower bound, sometimes overshooting a bit like a late OS timer would.
+        const int64_t previous = now;
+        now = lower_bound + (rng.randint(4) == 0 ? rng.randint(100) : 0);
+        while (test_timer_t *timer = wheel.pop_expired(now)) {
+            ASSERT_TRUE(timer->in_wheel);
+            ASSERT_GT(timer->get_expiration_tick(), previous);
+            ASSERT_LE(timer->get_expiration_tick(), now);
+            timer->in_wheel = false;
+            ++expired;
+        }
+    }
+
+    EXPECT_EQ(num_timers - (num_timers + 2) / 3, expired);
+}
+
+// Timers added while expired timers are being processed, the way repeating timers are re-added.
+TEST(TimerWheelTest, ReAddWhileExpiring) {
+    test_wheel_t wheel(0);
+    test_timer_t timer;
+    wheel.add(&timer, 5);
+
+    int rings = 0;
+    int64_t now = 0;
+    while (rings < 100) {
+        now = wheel.next_tick_lower_bound();
+        while (test_timer_t *t = wheel.pop_expired(now)) {
+            ++rings;
+            wheel.add(t, now + 97);
+        }
+    }
+    EXPECT_EQ(5 + 99 * 97, now);
+    wheel.remove(&timer);
+}
+
+// Schedules, cancels and reschedules a million timers, then drains the wheel in one call the way a
+// thread would after sleeping through all of them.
+TEST(TimerWheelTest, ScheduleCancelDrain) {
+    rng_t rng(54321);
+    const size_t num_timers = 1000000;
+    const int64_t last_tick = 3600 * 1000;
+    scoped_array_t<test_timer_t> timers(num_timers);
+    std::vector<int64_t> expirations(num_timers);
+    for (size_t i = 0; i < num_timers; ++i) {
+        // Between one millisecond and about an hour out.
+        expirations[i] = 1 + rng.randint(last_tick);
+    }
+
+    test_wheel_t wheel(0);
+    for (size_t i = 0; i < num_timers; ++i) {
+        wheel.add(&timers[i], expirations[i]);
+    }
+    ASSERT_EQ(num_timers, wheel.size());
+    for (size_t i = 0; i < num_timers; ++i) {
+        wheel.remove(&timers[i]);
+    }
+    ASSERT_TRUE(wheel.empty());
+
+    for (size_t i = 0; i < num_timers; ++i) {
+        wheel.add(&timers[i], expirations[i]);
+    }
+    size_t expired = 0;
+    int64_t previous = 0;
+    while (test_timer_t *timer = wheel.pop_expired(last_tick)) {
+        ASSERT_LE(previous, timer->get_expiration_tick());
+        previous = timer->get_expiration_tick();
+        ++expired;
+    }
+    EXPECT_EQ(num_timers, expired);
+    EXPECT_TRUE(wheel.empty());
+}
+
+// A few timers far apart, including one on the overflow list, found in one call after a long idle.
+TEST(TimerWheelTest, SparseTimersAfterIdle) {
+    const int64_t start_tick = 100;
+    test_wheel_t wheel(start_tick);
+    const int64_t expirations[] = { 130, 70000, 300000, 20000000, 40000000 };
+    const size_t num_timers = sizeof(expirations) / sizeof(expirations[0]);
+    scoped_array_t<test_timer_t> timers(num_timers);
+    for (size_t i = 0; i < num_timers; ++i) {
+        wheel.add(&timers[i], expirations[i]);
+    }
+
+    EXPECT_TRUE(wheel.pop_expired(129) == NULL);
+    for (size_t i = 0; i < num_timers; ++i) {
+        test_timer_t *timer = wheel.pop_expired(expirations[num_timers - 1] + 1000);
+        ASSERT_EQ(&timers[i], timer);
+    }
+    EXPECT_TRUE(wheel.pop_expired(INT64_MAX - 1) == NULL);
+    EXPECT_TRUE(wheel.empty());
+}
+
+}  // namespace unittest
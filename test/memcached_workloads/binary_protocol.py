@@ -0,0 +1,105 @@
+#!/usr/bin/python
+# Copyright 2010-2013 RethinkDB, all rights reserved.
+import sys, os, struct
+sys.path.append(os.path.abspath(os.path.join(os.path.dirname(__file__), os.path.pardir, 'common')))
+import memcached_workload_common
+from vcoptparse import *
+
+GET, SET, ADD, REPLACE, DELETE, INCREMENT, QUIT, GETQ, NOOP, VERSION, GETK, GETKQ, SETQ = \
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x07, 0x09, 0x0a, 0x0b, 0x0c, 0x0d, 0x11
+
+OK, KEY_NOT_FOUND, KEY_EXISTS = 0x0000, 0x0001, 0x0002
+
+def request(opcode, key = "", value = "", extras = "", opaque = 0, cas = 0):
+    header = struct.pack(">BBHBBHIIQ", 0x80, opcode, len(key), len(extras), 0, 0,
+                         len(extras) + len(key) + len(value), opaque, cas)
+    return header + extras + key + value
+
+def set_request(opcode, key, value, flags = 0, cas = 0, opaque = 0):
+    return request(opcode, key, value, struct.pack(">II", flags, 0), opaque, cas)
+
+def recv_exactly(s, size):
+    data = ""
+    while len(data) < size:
+        chunk = s.recv(size - len(data))
+        if not chunk:
+            raise ValueError("Connection closed after %d of %d bytes" % (len(data), size))
+        data += chunk
+    return data
+
+def read_response(s):
+    magic, opcode, key_size, extras_size, _, status, body_size, opaque, cas = \
+        struct.unpack(">BBHBBHIIQ", recv_exactly(s, 24))
+    if magic != 0x81:
+        raise ValueError("Bad response magic %#x" % magic)
+    body = recv_exactly(s, body_size)
+    return {"opcode": opcode, "status": status, "opaque": opaque, "cas": cas,
+            "extras": body[:extras_size],
+            "key": body[extras_size:extras_size + key_size],
+            "value": body[extras_size + key_size:]}
+
+def expect(response, opcode, status, **fields):
+    if response["opcode"] != opcode or response["status"] != status:
+        raise ValueError("Expected opcode %#x status %#x, got %r" % (opcode, status, response))
+    for name, value in fields.items():
+        if response[name] != value:
+            raise ValueError("Expected %s %r, got %r" % (name, value, response))
+
+op = memcached_workload_common.option_parser_for_socket()
+op["num_keys"] = IntFlag("--num-keys", 100)
+opts = op.parse(sys.argv)
+
+with memcached_workload_common.make_socket_connection(opts) as s:
+
+    print "Quiet sets"
+    keys = ["key%d" % i for i in range(opts["num_keys"])]
+    s.send("".join(set_request(SETQ, key, "value-" + key, flags = i) for i, key in enumerate(keys)))
+    s.send(request(NOOP, opaque = 1))
+    expect(read_response(s), NOOP, OK, opaque = 1)
+
+    print "Batched quiet gets"
+    # Every other key is missing, so only the others get responses.
+    batch = []
+    for i, key in enumerate(keys):
+        batch.append(request(GETKQ, key if i % 2 == 0 else "missing-" + key, opaque = i))
+    s.send("".join(batch) + request(NOOP, opaque = 12345))
+    for i, key in enumerate(keys):
+        if i % 2 == 0:
+            expect(read_response(s), GETKQ, OK, opaque = i, key = key, value = "value-" + key,
+                   extras = struct.pack(">I", i))
+    expect(read_response(s), NOOP, OK, opaque = 12345)
+
+    print "Quiet gets ended by a get"
+    s.send(request(GETQ, keys[0], opaque = 1) + request(GETQ, "missing", opaque = 2) +
+           request(GETK, "missing", opaque = 3))
+    expect(read_response(s), GETQ, OK, opaque = 1, key = "", value = "value-" + keys[0])
+    expect(read_response(s), GETK, KEY_NOT_FOUND, opaque = 3, key = "missing")
+
+    print "Add, replace and delete"
+    s.send(set_request(ADD, keys[0], "x"))
+    expect(read_response(s), ADD, KEY_EXISTS)
+    s.send(set_request(REPLACE, "missing", "x"))
+    expect(read_response(s), REPLACE, KEY_NOT_FOUND)
+    s.send(request(DELETE, keys[1]))
+    expect(read_response(s), DELETE, OK)
+    s.send(request(GET, keys[1]))
+    expect(read_response(s), GET, KEY_NOT_FOUND)
+
+    print "Increment"
+    s.send(set_request(SET, "counter", "10"))
+    expect(read_response(s), SET, OK)
+    s.send(request(INCREMENT, "counter", extras = struct.pack(">QQI", 5, 0, 0)))
+    expect(read_response(s), INCREMENT, OK, value = struct.pack(">Q", 15))
+
+    print "Set with a CAS"
+    s.send(set_request(SET, keys[2], "new", cas = 1))
+    expect(read_response(s), SET, KEY_EXISTS)
+
+    print "Version and quit"
+    s.send(request(VERSION))
+    response = read_response(s)
+    expect(response, VERSION, OK)
+    if not response["value"].startswith("rethinkdb-"):
+        raise ValueError("Bad version %r" % response["value"])
+    s.send(request(QUIT))
+    expect(read_response(s), QUIT, OK)